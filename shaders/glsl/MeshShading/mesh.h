@@ -1,7 +1,22 @@
+// Feature switches, defaults for shaders compiled without defines, ShaderProgramVariants overrides them per variant
+#ifndef DEBUG
 #define DEBUG 0
+#endif
+#ifndef CULL
 #define CULL 1
+#endif
+#ifndef CONE_CULL
+#define CONE_CULL 1
+#endif
+#ifndef MESH
 #define MESH 0
+#endif
+#ifndef BACK_CULL
 #define BACK_CULL 1
+#endif
+#ifndef OCCLUSION_CULL
+#define OCCLUSION_CULL 1
+#endif
 
 #include "../../../src/backend/EngineConfig.h"
 
@@ -35,7 +50,8 @@ struct CullData
 	float     screen_height;
 			float     depth_pyramid_width;
 			float     depth_pyramid_height;
-			float padding[3];
+	uint  statistics_enabled;           // non-zero when culling counters are written to CullStatisticsBuffer
+	float padding[2];
 };
 
 struct MeshInfo
@@ -73,7 +89,30 @@ struct MaterialParameters
 // Task payload for meshlet culling
 struct TaskPayload
 {
-	uint meshlet_indices[TASK_WGSIZE];
+	uint meshlet_indices[MAX_TASK_WGSIZE];
+};
+
+// Culling counters of one frame, must match MeshShadingRenderer::CullStatistics
+struct CullStatistics
+{
+	uint early_draws_tested;
+	uint early_draws_frustum_culled;
+	uint early_draws_visible;
+
+	uint late_draws_tested;
+	uint late_draws_frustum_culled;
+	uint late_draws_occlusion_culled;
+	uint late_draws_visible;        // visible now but not in the last frame, drawn by the late pass
+
+	uint meshlets_tested;
+	uint meshlets_cone_culled;
+	uint meshlets_frustum_culled;
+	uint meshlets_visible;
+
+	uint triangles_tested;
+	uint triangles_backface_culled;
+	uint triangles_small_culled;
+	uint triangles_visible;
 };
 
 struct MeshTaskDrawCommand
@@ -83,4 +122,54 @@ struct MeshTaskDrawCommand
 	uint group_count_z;
 
 	uint meshlet_offset;
+	uint meshlet_count;        // the last task workgroup of a draw is partially filled
+};
+
+// Scene buffers read through their device addresses instead of descriptors, shaders including this enable GL_EXT_buffer_reference
+layout(buffer_reference, scalar) readonly buffer VertexBuffer
+{
+	Vertex vertices[];
+};
+
+layout(buffer_reference, std430) readonly buffer MeshletBuffer
+{
+	Meshlet meshlets[];
+};
+
+layout(buffer_reference, std430) readonly buffer MeshletDataBuffer
+{
+	uint meshlet_data[];
+};
+
+layout(buffer_reference, std430) readonly buffer MeshInfoBuffer
+{
+	MeshInfo mesh_infos[];
+};
+
+layout(buffer_reference, scalar) readonly buffer MeshDrawBuffer
+{
+	MeshDraw mesh_draws[];
+};
+
+layout(buffer_reference, std430) readonly buffer MaterialParametersBuffer
+{
+	MaterialParameters material_parameters[];
+};
+
+// written by the culling passes, read by the task shader
+layout(buffer_reference, std430) buffer MeshTaskDrawCommandBuffer
+{
+	MeshTaskDrawCommand draw_cmds[];
+};
+
+// Addresses of the scene buffers for one frame, every UboData holds them after its CullData
+struct SceneBuffers
+{
+	VertexBuffer              vertices;
+	MeshletBuffer             meshlets;
+	MeshletDataBuffer         meshlet_data;
+	MeshInfoBuffer            mesh_infos;
+	MeshDrawBuffer            mesh_draws;
+	MaterialParametersBuffer  material_parameters;
+	MeshTaskDrawCommandBuffer draw_cmds;
 };
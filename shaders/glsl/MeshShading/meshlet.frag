@@ -1,6 +1,7 @@
 #version 450
 
 #extension GL_EXT_scalar_block_layout : require
+#extension GL_EXT_buffer_reference : require
 #extension GL_EXT_shader_16bit_storage: require
 #extension GL_EXT_shader_8bit_storage: require
 #extension GL_GOOGLE_include_directive : require
@@ -15,9 +16,10 @@ layout (location = 0) in vec4 color;
 layout (location = 1) in flat uint material_index;
 layout (location = 2) in vec2 texcoord;
 
-layout(set = 0, binding = 4) readonly buffer MaterialParametersBuffer
+layout(set = 0, binding = 0, scalar) uniform UboData
 {
-	MaterialParameters material_parameters[];
+	CullData     cull_data;
+	SceneBuffers scene;
 };
 
 // bindless texture
@@ -29,7 +31,7 @@ void main()
 	outColor = color;
 	return;
 #endif
-	MaterialParameters params = material_parameters[material_index];
+	MaterialParameters params = scene.material_parameters.material_parameters[material_index];
 	outColor = texture(textures[params.diffuse_texture_index], texcoord)  * params.base_color_factor;
 
 }
\ No newline at end of file
@@ -6,13 +6,18 @@
 // Define entry point macro for quick application entry point generation
 // Usage: LINGZE_MAIN(AppClassName)
 // Where AppClassName is the name of a class that inherits from lz::App
+// Command line options are forwarded to App::parse_command_line
 
 #define LINGZE_MAIN(AppClass)                            \
-	int main()                                           \
+	int main(int argc, char **argv)                      \
 	{                                                    \
 		try                                              \
 		{                                                \
 			AppClass app;                                \
+			if (!app.parse_command_line(argc, argv))     \
+			{                                            \
+				return -1;                               \
+			}                                            \
 			return app.run();                            \
 		}                                                \
 		catch (const std::exception &e)                  \
@@ -8,6 +8,7 @@ namespace lz::render
 GpuDrivenRenderer::GpuDrivenRenderer(lz::Core *core) :
     core_(core)
 {
+	pipeline_state_ = core_->get_pipeline_cache()->intern_graphics_pipeline_state({lz::BlendSettings::opaque()}, lz::VertexDeclaration());
 	reload_shaders();
 }
 
@@ -82,7 +83,9 @@ void GpuDrivenRenderer::render_frame(const lz::InFlightQueue::FrameInfo &frame_i
 		        auto visible_mesh_count_proxy = context.get_buffer(scene_resource_->visible_mesh_count_proxy_.get().id());
 		        storage_buffer_bindings.push_back(shader_data_set_info->make_storage_buffer_binding("VisibleMeshDrawCommandCount", visible_mesh_count_proxy));
 
-		        auto shader_data_set = core_->get_descriptor_set_cache()->get_descriptor_set(*shader_data_set_info, shader_data.uniform_buffer_bindings, storage_buffer_bindings, {});
+		        const auto set_bindings = lz::DescriptorSetBindings()
+		                                      .set_uniform_buffer_bindings(shader_data.uniform_buffer_bindings)
+		                                      .set_storage_buffer_bindings(storage_buffer_bindings);
 
 		        // Clear visible mesh count buffer
 		        context.get_command_buffer().fillBuffer(
@@ -101,10 +104,10 @@ void GpuDrivenRenderer::render_frame(const lz::InFlightQueue::FrameInfo &frame_i
 		            {clear_barrier},
 		            {});
 
-		        context.get_command_buffer().bindDescriptorSets(
-		            vk::PipelineBindPoint::eCompute,
-		            pipeline_info.pipeline_layout, k_shader_data_set_index,
-		            {shader_data_set}, {shader_data.dynamic_offset});
+		        core_->get_descriptor_set_cache()->bind_descriptor_set(
+		            context.get_command_buffer(), vk::PipelineBindPoint::eCompute,
+		            pipeline_info.pipeline_layout, pipeline_info.descriptor_buffer, k_shader_data_set_index,
+		            *shader_data_set_info, set_bindings, {shader_data.dynamic_offset});
 
 		        uint32_t dispatch_x = uint32_t((render_context.get_draw_count() + 31) / 32);
 		        context.get_command_buffer().dispatch(dispatch_x, 1, 1);
@@ -142,7 +145,7 @@ void GpuDrivenRenderer::render_frame(const lz::InFlightQueue::FrameInfo &frame_i
                     context.get_command_buffer(),
                     context.get_render_pass()->get_handle(),
                     lz::DepthSettings::enabled(),
-                    {lz::BlendSettings::opaque()}, lz::VertexDeclaration(),
+                    pipeline_state_,
                     vk::PrimitiveTopology::eTriangleList, shader_program);
 
 		        // set = 0 uniform buffer binding
@@ -185,13 +188,16 @@ void GpuDrivenRenderer::render_frame(const lz::InFlightQueue::FrameInfo &frame_i
 
 void GpuDrivenRenderer::reload_shaders()
 {
-	const auto &logical_device = core_->get_logical_device();
+	auto shaders = core_->get_shader_compiler()->create_shaders(core_->get_logical_device(),
+	                                                            {SHADER_GLSL_DIR "GpuDriven/BasicShape.vert",
+	                                                             SHADER_GLSL_DIR "GpuDriven/BasicShape.frag",
+	                                                             SHADER_GLSL_DIR "GpuDriven/Culling.comp"});
 
-	base_shape_shader_.vertex_shader.reset(new Shader(logical_device, SHADER_GLSL_DIR "GpuDriven/BasicShape.vert"));
-	base_shape_shader_.fragment_shader.reset(new Shader(logical_device, SHADER_GLSL_DIR "GpuDriven/BasicShape.frag"));
+	base_shape_shader_.vertex_shader   = std::move(shaders[0]);
+	base_shape_shader_.fragment_shader = std::move(shaders[1]);
 	base_shape_shader_.shader_program.reset(new ShaderProgram({base_shape_shader_.vertex_shader.get(), base_shape_shader_.fragment_shader.get()}));
 
-	culling_shader_.compute_shader.reset(new Shader(logical_device, SHADER_GLSL_DIR "GpuDriven/Culling.comp"));
+	culling_shader_.compute_shader = std::move(shaders[2]);
 }
 
 void GpuDrivenRenderer::change_view()
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "backend/PipelineCache.h"
 #include "backend/ShaderProgram.h"
 #include "render/BaseRenderer.h"
 #include "render/MipBuilder.h"
@@ -67,6 +68,8 @@ class GpuDrivenRenderer final : public BaseRenderer
 
 	std::map<lz::RenderGraph *, std::unique_ptr<ViewportResource>> viewport_resource_datum_;
 
+	lz::PipelineCache::GraphicsPipelineState pipeline_state_;
+
 	lz::Core *core_;
 };
 }        // namespace lz::render
@@ -47,6 +47,55 @@ void MeshShadingApp::render_ui()
 	ImGui::Begin("Camera Position");
 	ImGui::Text("Camera Position: %f, %f, %f", camera->pos.x, camera->pos.y, camera->pos.z);
 	ImGui::End();
+
+	render_cull_statistics_window();
+}
+
+void MeshShadingApp::render_cull_statistics_window()
+{
+	auto mesh_shading_renderer = static_cast<lz::render::MeshShadingRenderer *>(renderer_.get());
+
+	ImGui::Begin("Culling statistics");
+	bool enabled = mesh_shading_renderer->cull_statistics_enabled();
+	if (ImGui::Checkbox("Collect culling statistics", &enabled))
+	{
+		mesh_shading_renderer->set_cull_statistics_enabled(enabled);
+	}
+
+	// every combination is a shader variant, the first use of one compiles it
+	auto culling_settings = mesh_shading_renderer->get_culling_settings();
+	bool culling_changed  = ImGui::Checkbox("Cone culling", &culling_settings.cone_culling);
+	culling_changed |= ImGui::Checkbox("Backface and small triangle culling", &culling_settings.backface_culling);
+	culling_changed |= ImGui::Checkbox("Occlusion culling", &culling_settings.occlusion_culling);
+	if (culling_changed)
+	{
+		mesh_shading_renderer->set_culling_settings(culling_settings);
+	}
+
+	auto stats = mesh_shading_renderer->get_cull_statistics();
+	if (enabled && stats)
+	{
+		auto percent = [](uint32_t count, uint32_t total) {
+			return total > 0 ? 100.0f * float(count) / float(total) : 0.0f;
+		};
+
+		ImGui::Text("Early draws: %u tested, %u frustum culled (%.1f%%), %u visible", stats->early_draws_tested,
+		            stats->early_draws_frustum_culled, percent(stats->early_draws_frustum_culled, stats->early_draws_tested),
+		            stats->early_draws_visible);
+		ImGui::Text("Late draws: %u tested, %u frustum culled (%.1f%%), %u occlusion culled (%.1f%%), %u newly visible",
+		            stats->late_draws_tested, stats->late_draws_frustum_culled,
+		            percent(stats->late_draws_frustum_culled, stats->late_draws_tested), stats->late_draws_occlusion_culled,
+		            percent(stats->late_draws_occlusion_culled, stats->late_draws_tested), stats->late_draws_visible);
+		ImGui::Text("Meshlets: %u tested, %u cone culled (%.1f%%), %u frustum culled (%.1f%%), %u visible",
+		            stats->meshlets_tested, stats->meshlets_cone_culled, percent(stats->meshlets_cone_culled, stats->meshlets_tested),
+		            stats->meshlets_frustum_culled, percent(stats->meshlets_frustum_culled, stats->meshlets_tested),
+		            stats->meshlets_visible);
+		ImGui::Text("Triangles: %u tested, %u backface culled (%.1f%%), %u small culled (%.1f%%), %u visible",
+		            stats->triangles_tested, stats->triangles_backface_culled,
+		            percent(stats->triangles_backface_culled, stats->triangles_tested), stats->triangles_small_culled,
+		            percent(stats->triangles_small_culled, stats->triangles_tested), stats->triangles_visible);
+	}
+	ImGui::End();
 }
 
 std::unique_ptr<lz::render::BaseRenderer> MeshShadingApp::create_renderer()
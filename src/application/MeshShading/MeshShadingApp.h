@@ -27,6 +27,9 @@ class MeshShadingApp : public lz::App
 
 	virtual void render_ui() override;
 
+	// Show the culling counters read back from the GPU
+	void render_cull_statistics_window();
+
 	// Create renderer
 	virtual std::unique_ptr<lz::render::BaseRenderer> create_renderer() override;
 
@@ -5,13 +5,56 @@
 #include "backend/EngineConfig.h"
 #include "backend/Logging.h"
 #include "backend/MathUtils.h"
+#include "backend/ShaderBindings.h"
+
+#include "shader_bindings/MeshShading/depthreduce.comp.h"
+#include "shader_bindings/MeshShading/drawcull.comp.h"
+#include "shader_bindings/MeshShading/drawcull_late.comp.h"
+#include "shader_bindings/MeshShading/meshlet.frag.h"
+#include "shader_bindings/MeshShading/meshlet.mesh.h"
+#include "shader_bindings/MeshShading/meshlet.task.h"
+
+namespace depth_reduce   = lz::shader_bindings::mesh_shading::depthreduce_comp;
+namespace draw_cull      = lz::shader_bindings::mesh_shading::drawcull_comp;
+namespace draw_cull_late = lz::shader_bindings::mesh_shading::drawcull_late_comp;
+namespace meshlet_task   = lz::shader_bindings::mesh_shading::meshlet_task;
+namespace meshlet_mesh   = lz::shader_bindings::mesh_shading::meshlet_mesh;
+namespace meshlet_frag   = lz::shader_bindings::mesh_shading::meshlet_frag;
+
+// the buffers the render context and the material system fill have to match the layouts the shaders read
+static_assert(sizeof(lz::Vertex) == meshlet_mesh::VertexBuffer::array_stride);
+static_assert(sizeof(lz::render::Meshlet) == meshlet_mesh::MeshletBuffer::array_stride);
+static_assert(sizeof(lz::render::MeshInfo) == draw_cull::MeshInfoBuffer::array_stride);
+static_assert(sizeof(lz::render::MeshDraw) == draw_cull::MeshDrawBuffer::array_stride);
+static_assert(sizeof(lz::render::MeshDraw) == meshlet_task::MeshDrawBuffer::array_stride);
+static_assert(sizeof(lz::render::MeshTaskDrawCommand) == draw_cull::MeshTaskDrawCommandBuffer::array_stride);
+static_assert(sizeof(lz::MaterialParameters) == meshlet_frag::MaterialParametersBuffer::array_stride);
+static_assert(sizeof(lz::render::MeshShadingRenderer::CullStatistics) == draw_cull::CullStatisticsBuffer::pod_size);
 
 namespace lz::render
 {
+namespace
+{
+// the scene buffers are read through their device addresses, every pass writes the same table into its UboData and only
+// binds the per pass buffers and images with descriptors
+template <typename SceneBuffers>
+void set_scene_buffers(SceneBuffers &scene_buffers, lz::Core *core, lz::render::RenderContext &render_context, lz::Buffer *draw_commands_buffer)
+{
+	scene_buffers.vertices            = render_context.get_global_vertex_buffer().get_device_address();
+	scene_buffers.meshlets            = render_context.get_mesh_let_buffer().get_device_address();
+	scene_buffers.meshlet_data        = render_context.get_mesh_let_data_buffer().get_device_address();
+	scene_buffers.mesh_infos          = render_context.get_mesh_info_buffer().get_device_address();
+	scene_buffers.mesh_draws          = render_context.get_mesh_draw_buffer().get_device_address();
+	scene_buffers.material_parameters = core->get_material_parameters_buffer()->get_device_address();
+	scene_buffers.draw_cmds           = draw_commands_buffer->get_device_address();
+}
+}        // namespace
+
 MeshShadingRenderer::MeshShadingRenderer(lz::Core *core) :
     core_(core)
 {
 	depth_reduce_sampler_ = std::make_unique<Sampler>(core_->get_logical_device(), vk::SamplerAddressMode::eClampToEdge, vk::Filter::eLinear, vk::SamplerMipmapMode::eNearest, vk::SamplerReductionModeEXT::eMax);
+	pipeline_state_ = core_->get_pipeline_cache()->intern_graphics_pipeline_state({lz::BlendSettings::opaque()}, lz::VertexDeclaration());
 
 	reload_shaders();
 }
@@ -20,6 +63,17 @@ void MeshShadingRenderer::recreate_swapchain_resources(vk::Extent2D viewport_ext
 {
 	viewport_extent_ = viewport_extent;
 	frame_resource_datum_.clear();
+
+	// one readback buffer per frame in flight, a buffer is read when its frame slot comes around again
+	cull_statistics_readbacks_.clear();
+	cull_statistics_readbacks_.resize(in_flight_frames_count);
+	for (auto &readback : cull_statistics_readbacks_)
+	{
+		readback.buffer = std::make_unique<lz::Buffer>(core_->get_physical_device(), core_->get_logical_device(), sizeof(CullStatistics),
+		                                               vk::BufferUsageFlagBits::eTransferDst,
+		                                               vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+		readback.buffer->map();
+	}
 }
 
 void MeshShadingRenderer::recreate_render_context_resources(lz::render::RenderContext *render_context)
@@ -32,11 +86,6 @@ void MeshShadingRenderer::generate_depth_pyramid(const lz::InFlightQueue::FrameI
 	uint32_t mip_width  = depth_pyramid_proxy.base_size.x;
 	uint32_t mip_height = depth_pyramid_proxy.base_size.y;
 
-	struct PushData
-	{
-		glm::vec2 image_size;
-	};
-
 	for (size_t mip_index = 0; mip_index < depth_pyramid_proxy.mip_image_view_proxies.size(); ++mip_index)
 	{
 		auto dst_proxy_id = depth_pyramid_proxy.mip_image_view_proxies[mip_index]->id();
@@ -55,8 +104,8 @@ void MeshShadingRenderer::generate_depth_pyramid(const lz::InFlightQueue::FrameI
 			        uint32_t level_height = std::max(1u, mip_height >> mip_index);
 			        auto     shader_data  = frame_info.memory_pool->begin_set(shader_data_set_info);
 			        {
-				        auto push_data        = frame_info.memory_pool->get_uniform_buffer_data<PushData>("ImageData");
-				        push_data->image_size = {float(level_width), float(level_height)};
+				        auto image_data        = frame_info.memory_pool->get_uniform_buffer_data<depth_reduce::ImageData>();
+				        image_data->image_size = {float(level_width), float(level_height)};
 			        }
 			        frame_info.memory_pool->end_set();
 
@@ -64,28 +113,32 @@ void MeshShadingRenderer::generate_depth_pyramid(const lz::InFlightQueue::FrameI
 
 			        auto depth_image_view         = context.get_image_view(src_proxy_id);
 			        auto depth_pyramid_image_view = context.get_image_view(dst_proxy_id);
-			        image_sampler_bindings.push_back(shader_data_set_info->make_image_sampler_binding("in_image", depth_image_view, depth_reduce_sampler_.get()));
+			        image_sampler_bindings.push_back(lz::make_image_sampler_binding<depth_reduce::in_image>(depth_image_view, depth_reduce_sampler_.get()));
 
 			        std::vector<lz::StorageImageBinding> storage_image_sampler_bindings;
-			        storage_image_sampler_bindings.push_back(shader_data_set_info->make_storage_image_binding("out_image", depth_pyramid_image_view));
+			        storage_image_sampler_bindings.push_back(lz::make_storage_image_binding<depth_reduce::out_image>(depth_pyramid_image_view));
 
-			        auto shader_data_set = core_->get_descriptor_set_cache()->get_descriptor_set(*shader_data_set_info, shader_data.uniform_buffer_bindings, {}, storage_image_sampler_bindings, image_sampler_bindings);
+			        const auto set_bindings = lz::DescriptorSetBindings()
+			                                      .set_uniform_buffer_bindings(shader_data.uniform_buffer_bindings)
+			                                      .set_storage_image_bindings(storage_image_sampler_bindings)
+			                                      .set_image_sampler_bindings(image_sampler_bindings);
 
 			        // TODO: Support push constant
-			        /*PushData push_data;
+			        /*depth_reduce::ImageData push_data;
 			        push_data.image_size = {mip_width, mip_height};
 			        context.get_command_buffer().pushConstants(pipeline_info.pipeline_layout,
 			                                                   vk::ShaderStageFlagBits::eCompute,
 			                                                   0,
-			                                                   sizeof(PushData),
+			                                                   sizeof(depth_reduce::ImageData),
 			                                                   &push_data);*/
 
-			        context.get_command_buffer().bindDescriptorSets(
-			            vk::PipelineBindPoint::eCompute,
-			            pipeline_info.pipeline_layout, k_shader_data_set_index,
-			            {shader_data_set}, {shader_data.dynamic_offset});
+			        core_->get_descriptor_set_cache()->bind_descriptor_set(
+			            context.get_command_buffer(), vk::PipelineBindPoint::eCompute,
+			            pipeline_info.pipeline_layout, pipeline_info.descriptor_buffer, k_shader_data_set_index,
+			            *shader_data_set_info, set_bindings, {shader_data.dynamic_offset});
 
-			        context.get_command_buffer().dispatch(lz::math::get_group_count(level_width, COMPUTE_WGSIZE), lz::math::get_group_count(level_height, COMPUTE_WGSIZE), 1);
+			        const uint32_t workgroup_size = core_->get_shader_config().compute_workgroup_size;
+			        context.get_command_buffer().dispatch(lz::math::get_group_count(level_width, workgroup_size), lz::math::get_group_count(level_height, workgroup_size), 1);
 		        }));
 	}
 }
@@ -104,7 +157,7 @@ void MeshShadingRenderer::cull_last_frame_visible(const lz::InFlightQueue::Frame
 	// pass 1 : culling
 	render_graph->add_pass(
 	    lz::RenderGraph::ComputePassDesc()
-	        .set_storage_buffers({scene_resource_->mesh_proxy_.get().id(), scene_resource_->mesh_draw_proxy_.get().id(), scene_resource_->draw_visibility_buffer_proxy_.get().id(), scene_resource_->visible_meshtask_draw_proxy_.get().id()})
+	        .set_storage_buffers({scene_resource_->mesh_proxy_.get().id(), scene_resource_->mesh_draw_proxy_.get().id(), scene_resource_->draw_visibility_buffer_proxy_.get().id(), scene_resource_->visible_meshtask_draw_proxy_.get().id(), scene_resource_->cull_statistics_proxy_.get().id()})
 	        .set_indirect_buffers({scene_resource_->visible_meshtask_count_proxy_.get().id()})
 	        .set_profiler_info(lz::Colors::carrot, "DrawCullPass")
 	        .set_record_func([&](lz::RenderGraph::PassContext context) {
@@ -112,6 +165,8 @@ void MeshShadingRenderer::cull_last_frame_visible(const lz::InFlightQueue::Frame
 
 		        const lz::DescriptorSetLayoutKey *shader_data_set_info = draw_cull_shader_.compute_shader->get_set_info(k_shader_data_set_index);
 
+		        auto visible_meshtask_draw_proxy = context.get_buffer(scene_resource_->visible_meshtask_draw_proxy_.get().id());
+
 		        // uniform data
 		        auto shader_data = frame_info.memory_pool->begin_set(shader_data_set_info);
 		        {
@@ -121,39 +176,42 @@ void MeshShadingRenderer::cull_last_frame_visible(const lz::InFlightQueue::Frame
 			        glm::vec4 frustum_x     = glm::normalize(proj_matrix_t[3] + proj_matrix_t[0]);
 			        glm::vec4 frustum_y     = glm::normalize(proj_matrix_t[3] + proj_matrix_t[1]);
 
-			        auto cull_data         = frame_info.memory_pool->get_uniform_buffer_data<CullData>("UboData");
-			        cull_data->view_matrix = glm::inverse(main_camera->get_transform_matrix());
-			        cull_data->P00         = proj_matrix[0][0];
-			        cull_data->P11         = proj_matrix[1][1];
-			        cull_data->znear       = main_camera->get_near_plane();
-			        cull_data->zfar        = main_camera->get_far_plane();
-			        cull_data->frustum[0]  = frustum_x.x;
-			        cull_data->frustum[1]  = frustum_x.z;
-			        cull_data->frustum[2]  = frustum_y.y;
-			        cull_data->frustum[3]  = frustum_y.z;
-			        cull_data->draw_count  = uint32_t(render_context.get_draw_count());
+			        auto  ubo_data               = frame_info.memory_pool->get_uniform_buffer_data<draw_cull::UboData>();
+			        auto &cull_data              = ubo_data->cull_data;
+			        cull_data.view_matrix        = glm::inverse(main_camera->get_transform_matrix());
+			        cull_data.P00                = proj_matrix[0][0];
+			        cull_data.P11                = proj_matrix[1][1];
+			        cull_data.znear              = main_camera->get_near_plane();
+			        cull_data.zfar               = main_camera->get_far_plane();
+			        cull_data.frustum[0]         = frustum_x.x;
+			        cull_data.frustum[1]         = frustum_x.z;
+			        cull_data.frustum[2]         = frustum_y.y;
+			        cull_data.frustum[3]         = frustum_y.z;
+			        cull_data.draw_count         = uint32_t(render_context.get_draw_count());
+			        cull_data.statistics_enabled = record_cull_statistics_ ? 1 : 0;
+			        set_scene_buffers(ubo_data->scene, core_, render_context, visible_meshtask_draw_proxy);
 		        }
 
 		        frame_info.memory_pool->end_set();
 
 		        std::vector<lz::StorageBufferBinding> storage_buffer_bindings;
-		        storage_buffer_bindings.push_back(shader_data_set_info->make_storage_buffer_binding("MeshData", &render_context.get_mesh_info_buffer()));
-		        storage_buffer_bindings.push_back(shader_data_set_info->make_storage_buffer_binding("MeshDrawData", &render_context.get_mesh_draw_buffer()));
-		        auto visible_meshtask_draw_proxy = context.get_buffer(scene_resource_->visible_meshtask_draw_proxy_.get().id());
-		        storage_buffer_bindings.push_back(shader_data_set_info->make_storage_buffer_binding("VisibleMeshTaskDrawCommand", visible_meshtask_draw_proxy));
 		        auto visible_meshtask_count_proxy = context.get_buffer(scene_resource_->visible_meshtask_count_proxy_.get().id());
-		        storage_buffer_bindings.push_back(shader_data_set_info->make_storage_buffer_binding("VisibleMeshTaskDrawCommandCount", visible_meshtask_count_proxy));
+		        storage_buffer_bindings.push_back(lz::make_storage_buffer_binding<draw_cull::VisibleMeshTaskDrawCommandCount>(visible_meshtask_count_proxy));
 		        auto draw_visibility_buffer_proxy = context.get_buffer(scene_resource_->draw_visibility_buffer_proxy_.get().id());
-		        storage_buffer_bindings.push_back(shader_data_set_info->make_storage_buffer_binding("DrawVisibilityBuffer", draw_visibility_buffer_proxy));
-
-		        auto shader_data_set = core_->get_descriptor_set_cache()->get_descriptor_set(*shader_data_set_info, shader_data.uniform_buffer_bindings, storage_buffer_bindings, {});
-
-		        context.get_command_buffer().bindDescriptorSets(
-		            vk::PipelineBindPoint::eCompute,
-		            pipeline_info.pipeline_layout, k_shader_data_set_index,
-		            {shader_data_set}, {shader_data.dynamic_offset});
-
-		        uint32_t dispatch_x = uint32_t((render_context.get_draw_count() + COMPUTE_WGSIZE - 1) / COMPUTE_WGSIZE);
+		        storage_buffer_bindings.push_back(lz::make_storage_buffer_binding<draw_cull::DrawVisibilityBuffer>(draw_visibility_buffer_proxy));
+		        auto cull_statistics_proxy = context.get_buffer(scene_resource_->cull_statistics_proxy_.get().id());
+		        storage_buffer_bindings.push_back(lz::make_storage_buffer_binding<draw_cull::CullStatisticsBuffer>(cull_statistics_proxy));
+
+		        const auto set_bindings = lz::DescriptorSetBindings()
+		                                      .set_uniform_buffer_bindings(shader_data.uniform_buffer_bindings)
+		                                      .set_storage_buffer_bindings(storage_buffer_bindings);
+		        core_->get_descriptor_set_cache()->bind_descriptor_set(
+		            context.get_command_buffer(), vk::PipelineBindPoint::eCompute,
+		            pipeline_info.pipeline_layout, pipeline_info.descriptor_buffer, k_shader_data_set_index,
+		            *shader_data_set_info, set_bindings, {shader_data.dynamic_offset});
+
+		        const uint32_t workgroup_size = core_->get_shader_config().compute_workgroup_size;
+		        uint32_t       dispatch_x     = uint32_t((render_context.get_draw_count() + workgroup_size - 1) / workgroup_size);
 		        context.get_command_buffer().dispatch(dispatch_x, 1, 1);
 	        }));
 }
@@ -172,15 +230,17 @@ void MeshShadingRenderer::cull_last_frame_not_visible(const lz::InFlightQueue::F
 	// pass 1 : culling
 	render_graph->add_pass(
 	    lz::RenderGraph::ComputePassDesc()
-	        .set_storage_buffers({scene_resource_->visible_meshtask_draw_proxy_.get().id(), scene_resource_->draw_visibility_buffer_proxy_.get().id()})
+	        .set_storage_buffers({scene_resource_->visible_meshtask_draw_proxy_.get().id(), scene_resource_->draw_visibility_buffer_proxy_.get().id(), scene_resource_->cull_statistics_proxy_.get().id()})
 	        .set_indirect_buffers({scene_resource_->visible_meshtask_count_proxy_.get().id()})
 			.set_input_images({depth_pyramid_proxy.image_view_proxy.get().id()})
 	        .set_profiler_info(lz::Colors::carrot, "DrawCullPass")
 	        .set_record_func([&](lz::RenderGraph::PassContext context) {
-		        auto pipeline_info = core_->get_pipeline_cache()->bind_compute_pipeline(context.get_command_buffer(), draw_cull_late_shader_.compute_shader.get());
+		        auto pipeline_info = core_->get_pipeline_cache()->bind_compute_pipeline(context.get_command_buffer(), draw_cull_late_shader_.compute_shader);
 
 		        const lz::DescriptorSetLayoutKey *shader_data_set_info = draw_cull_late_shader_.compute_shader->get_set_info(k_shader_data_set_index);
 
+		        auto visible_meshtask_draw_proxy = context.get_buffer(scene_resource_->visible_meshtask_draw_proxy_.get().id());
+
 		        // uniform data
 		        auto shader_data = frame_info.memory_pool->begin_set(shader_data_set_info);
 		        {
@@ -190,46 +250,49 @@ void MeshShadingRenderer::cull_last_frame_not_visible(const lz::InFlightQueue::F
 			        glm::vec4 frustum_x     = glm::normalize(proj_matrix_t[3] + proj_matrix_t[0]);
 			        glm::vec4 frustum_y     = glm::normalize(proj_matrix_t[3] + proj_matrix_t[1]);
 
-			        auto cull_data         = frame_info.memory_pool->get_uniform_buffer_data<CullData>("UboData");
-			        cull_data->view_matrix = glm::inverse(main_camera->get_transform_matrix());
-			        cull_data->P00         = proj_matrix[0][0];
-			        cull_data->P11         = proj_matrix[1][1];
-			        cull_data->znear       = main_camera->get_near_plane();
-			        cull_data->zfar        = main_camera->get_far_plane();
-			        cull_data->frustum[0]  = frustum_x.x;
-			        cull_data->frustum[1]  = frustum_x.z;
-			        cull_data->frustum[2]  = frustum_y.y;
-			        cull_data->frustum[3]  = frustum_y.z;
-			        cull_data->draw_count  = uint32_t(render_context.get_draw_count());
-			        cull_data->depth_pyramid_width = depth_pyramid_proxy.base_size.x;
-			        cull_data->depth_pyramid_height = depth_pyramid_proxy.base_size.y;
-
+			        auto  ubo_data                 = frame_info.memory_pool->get_uniform_buffer_data<draw_cull_late::UboData>();
+			        auto &cull_data                = ubo_data->cull_data;
+			        cull_data.view_matrix          = glm::inverse(main_camera->get_transform_matrix());
+			        cull_data.P00                  = proj_matrix[0][0];
+			        cull_data.P11                  = proj_matrix[1][1];
+			        cull_data.znear                = main_camera->get_near_plane();
+			        cull_data.zfar                 = main_camera->get_far_plane();
+			        cull_data.frustum[0]           = frustum_x.x;
+			        cull_data.frustum[1]           = frustum_x.z;
+			        cull_data.frustum[2]           = frustum_y.y;
+			        cull_data.frustum[3]           = frustum_y.z;
+			        cull_data.draw_count           = uint32_t(render_context.get_draw_count());
+			        cull_data.statistics_enabled   = record_cull_statistics_ ? 1 : 0;
+			        cull_data.depth_pyramid_width  = depth_pyramid_proxy.base_size.x;
+			        cull_data.depth_pyramid_height = depth_pyramid_proxy.base_size.y;
+			        set_scene_buffers(ubo_data->scene, core_, render_context, visible_meshtask_draw_proxy);
 		        }
 
 		        frame_info.memory_pool->end_set();
 
 		        std::vector<lz::StorageBufferBinding> storage_buffer_bindings;
-		        storage_buffer_bindings.push_back(shader_data_set_info->make_storage_buffer_binding("MeshData", &render_context.get_mesh_info_buffer()));
-		        storage_buffer_bindings.push_back(shader_data_set_info->make_storage_buffer_binding("MeshDrawData", &render_context.get_mesh_draw_buffer()));
-		        auto visible_meshtask_draw_proxy = context.get_buffer(scene_resource_->visible_meshtask_draw_proxy_.get().id());
-		        storage_buffer_bindings.push_back(shader_data_set_info->make_storage_buffer_binding("VisibleMeshTaskDrawCommand", visible_meshtask_draw_proxy));
 		        auto visible_meshtask_count_proxy = context.get_buffer(scene_resource_->visible_meshtask_count_proxy_.get().id());
-		        storage_buffer_bindings.push_back(shader_data_set_info->make_storage_buffer_binding("VisibleMeshTaskDrawCommandCount", visible_meshtask_count_proxy));
+		        storage_buffer_bindings.push_back(lz::make_storage_buffer_binding<draw_cull_late::VisibleMeshTaskDrawCommandCount>(visible_meshtask_count_proxy));
 		        auto draw_visibility_buffer_proxy = context.get_buffer(scene_resource_->draw_visibility_buffer_proxy_.get().id());
-		        storage_buffer_bindings.push_back(shader_data_set_info->make_storage_buffer_binding("DrawVisibilityBuffer", draw_visibility_buffer_proxy));
+		        storage_buffer_bindings.push_back(lz::make_storage_buffer_binding<draw_cull_late::DrawVisibilityBuffer>(draw_visibility_buffer_proxy));
+		        auto cull_statistics_proxy = context.get_buffer(scene_resource_->cull_statistics_proxy_.get().id());
+		        storage_buffer_bindings.push_back(lz::make_storage_buffer_binding<draw_cull_late::CullStatisticsBuffer>(cull_statistics_proxy));
 
 				std::vector<lz::ImageSamplerBinding> image_sampler_bindings;
 		        auto                                 depth_pyramid_image_view = context.get_image_view(depth_pyramid_proxy.image_view_proxy.get().id());
-		        image_sampler_bindings.push_back(shader_data_set_info->make_image_sampler_binding("depth_pyramid", depth_pyramid_image_view, depth_reduce_sampler_.get()));
-
-		        auto shader_data_set = core_->get_descriptor_set_cache()->get_descriptor_set(*shader_data_set_info, shader_data.uniform_buffer_bindings, storage_buffer_bindings, {}, image_sampler_bindings);
-
-		        context.get_command_buffer().bindDescriptorSets(
-		            vk::PipelineBindPoint::eCompute,
-		            pipeline_info.pipeline_layout, k_shader_data_set_index,
-		            {shader_data_set}, {shader_data.dynamic_offset});
-
-		        uint32_t dispatch_x = uint32_t((render_context.get_draw_count() + COMPUTE_WGSIZE - 1) / COMPUTE_WGSIZE);
+		        image_sampler_bindings.push_back(lz::make_image_sampler_binding<draw_cull_late::depth_pyramid>(depth_pyramid_image_view, depth_reduce_sampler_.get()));
+
+		        const auto set_bindings = lz::DescriptorSetBindings()
+		                                      .set_uniform_buffer_bindings(shader_data.uniform_buffer_bindings)
+		                                      .set_storage_buffer_bindings(storage_buffer_bindings)
+		                                      .set_image_sampler_bindings(image_sampler_bindings);
+		        core_->get_descriptor_set_cache()->bind_descriptor_set(
+		            context.get_command_buffer(), vk::PipelineBindPoint::eCompute,
+		            pipeline_info.pipeline_layout, pipeline_info.descriptor_buffer, k_shader_data_set_index,
+		            *shader_data_set_info, set_bindings, {shader_data.dynamic_offset});
+
+		        const uint32_t workgroup_size = core_->get_shader_config().compute_workgroup_size;
+		        uint32_t       dispatch_x     = uint32_t((render_context.get_draw_count() + workgroup_size - 1) / workgroup_size);
 		        context.get_command_buffer().dispatch(dispatch_x, 1, 1);
 	        }));
 }
@@ -240,21 +303,20 @@ void MeshShadingRenderer::draw_mesh_task(const lz::InFlightQueue::FrameInfo &fra
 	    lz::RenderGraph::RenderPassDesc()
 	        .set_color_attachments({{frame_info.swapchain_image_view_proxy_id, late ? vk::AttachmentLoadOp::eLoad :vk::AttachmentLoadOp::eClear}})
 	        .set_depth_attachment(depth_stencil_proxy.image_view_proxy.get().id(),late ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eClear)
-	        .set_storage_buffers({scene_resource_->mesh_proxy_.get().id(), scene_resource_->mesh_draw_proxy_.get().id(),scene_resource_->visible_meshtask_draw_proxy_.get().id()})
+	        .set_storage_buffers({scene_resource_->mesh_proxy_.get().id(), scene_resource_->mesh_draw_proxy_.get().id(),scene_resource_->visible_meshtask_draw_proxy_.get().id(), scene_resource_->cull_statistics_proxy_.get().id()})
 	        .set_indirect_buffers({ scene_resource_->visible_meshtask_count_proxy_.get().id()})
 	        .set_render_area_extent(viewport_extent_)
 	        .set_profiler_info(lz::Colors::peter_river, "MeshShadingPass")
 	        .set_record_func([&](lz::RenderGraph::RenderPassContext context) {
 		        if (core_->mesh_shader_supported())
 		        {
-			        auto shader_program = meshlet_shader_.shader_program.get();
+			        auto shader_program = meshlet_shader_.shader_program;
 			        auto pipeline_info =
 			            core_->get_pipeline_cache()->bind_graphics_pipeline(
 			                context.get_command_buffer(),
 			                context.get_render_pass()->get_handle(),
 			                lz::DepthSettings::enabled(),
-			                {lz::BlendSettings::opaque()},
-			                lz::VertexDeclaration(),
+			                pipeline_state_,
 			                vk::PrimitiveTopology::eTriangleList, shader_program);
 
 			        auto visible_meshtask_draw_proxy  = context.get_buffer(scene_resource_->visible_meshtask_draw_proxy_.get().id());
@@ -273,29 +335,28 @@ void MeshShadingRenderer::draw_mesh_task(const lz::InFlightQueue::FrameInfo &fra
 						glm::vec4 frustum_x     = glm::normalize(proj_matrix_t[3] + proj_matrix_t[0]);
 						glm::vec4 frustum_y     = glm::normalize(proj_matrix_t[3] + proj_matrix_t[1]);
 
-						auto cull_data         = frame_info.memory_pool->get_uniform_buffer_data<CullData>("UboData");
-						cull_data->view_matrix = glm::inverse(main_camera->get_transform_matrix());
-						cull_data->proj_matrix = proj_matrix;
-						cull_data->P00         = proj_matrix[0][0];
-						cull_data->P11         = proj_matrix[1][1];
-						cull_data->znear       = main_camera->get_near_plane();
-						cull_data->zfar        = main_camera->get_far_plane();
-						cull_data->screen_width  = float(viewport_extent_.width);
-						cull_data->screen_height = float(viewport_extent_.height);
-						cull_data->frustum[0]  = frustum_x.x;
-						cull_data->frustum[1]  = frustum_x.z;
-						cull_data->frustum[2]  = frustum_y.y;
-						cull_data->frustum[3]  = frustum_y.z;
+						auto  ubo_data               = frame_info.memory_pool->get_uniform_buffer_data<meshlet_task::UboData>();
+						auto &cull_data              = ubo_data->cull_data;
+						cull_data.view_matrix        = glm::inverse(main_camera->get_transform_matrix());
+						cull_data.proj_matrix        = proj_matrix;
+						cull_data.P00                = proj_matrix[0][0];
+						cull_data.P11                = proj_matrix[1][1];
+						cull_data.znear              = main_camera->get_near_plane();
+						cull_data.zfar               = main_camera->get_far_plane();
+						cull_data.screen_width       = float(viewport_extent_.width);
+						cull_data.screen_height      = float(viewport_extent_.height);
+						cull_data.frustum[0]         = frustum_x.x;
+						cull_data.frustum[1]         = frustum_x.z;
+						cull_data.frustum[2]         = frustum_y.y;
+						cull_data.frustum[3]         = frustum_y.z;
+						cull_data.statistics_enabled = record_cull_statistics_ ? 1 : 0;
+						set_scene_buffers(ubo_data->scene, core_, render_context, visible_meshtask_draw_proxy);
 			        }
 			        frame_info.memory_pool->end_set();
 			        // create storage binding
 			        std::vector<lz::StorageBufferBinding> storage_buffer_bindings;
-			        storage_buffer_bindings.push_back(shader_data_set_info->make_storage_buffer_binding("Vertices", &render_context.get_global_vertex_buffer()));
-			        storage_buffer_bindings.push_back(shader_data_set_info->make_storage_buffer_binding("Meshlets", &render_context.get_mesh_let_buffer()));
-			        storage_buffer_bindings.push_back(shader_data_set_info->make_storage_buffer_binding("MeshletDataBuffer", &render_context.get_mesh_let_data_buffer()));
-			        storage_buffer_bindings.push_back(shader_data_set_info->make_storage_buffer_binding("MaterialParametersBuffer", core_->get_material_parameters_buffer()));
-			        storage_buffer_bindings.push_back(shader_data_set_info->make_storage_buffer_binding("VisibleMeshTaskDrawCommand", visible_meshtask_draw_proxy));
-			        storage_buffer_bindings.push_back(shader_data_set_info->make_storage_buffer_binding("MeshDraws", &render_context.get_mesh_draw_buffer()));
+			        auto cull_statistics_proxy = context.get_buffer(scene_resource_->cull_statistics_proxy_.get().id());
+			        storage_buffer_bindings.push_back(lz::make_storage_buffer_binding<meshlet_task::CullStatisticsBuffer>(cull_statistics_proxy));
 
 			        auto shader_data_set = core_->get_descriptor_set_cache()->get_descriptor_set(
 			            *shader_data_set_info,
@@ -336,25 +397,130 @@ void MeshShadingRenderer::render_frame(
 		glm::uvec2 size = {viewport_extent_.width, viewport_extent_.height};
 		frame_resource.reset(new FrameResource(render_graph, size));
 	}
+	read_cull_statistics(frame_info.frame_index);
+	select_culling_variants();
+
+	// the passes are recorded after the UI of this frame, which may toggle the statistics
+	record_cull_statistics_ = cull_statistics_enabled_;
+	if (record_cull_statistics_)
+	{
+		clear_cull_statistics(render_graph);
+	}
 	cull_last_frame_visible(frame_info, scene, render_context, render_graph);
 	draw_mesh_task(frame_info, scene, render_context, render_graph, frame_resource->depth_stencil_proxy, false);
 	generate_depth_pyramid(frame_info, scene, render_context, render_graph, frame_resource->depth_stencil_proxy, frame_resource->depth_pyramid_proxy);
 	cull_last_frame_not_visible(frame_info, scene, render_context, render_graph, frame_resource->depth_pyramid_proxy);
 	draw_mesh_task(frame_info, scene, render_context, render_graph, frame_resource->depth_stencil_proxy, true);
+	if (record_cull_statistics_)
+	{
+		copy_cull_statistics(frame_info, render_graph);
+	}
 }
 
-void MeshShadingRenderer::reload_shaders()
+void MeshShadingRenderer::clear_cull_statistics(lz::RenderGraph *render_graph)
+{
+	render_graph->add_pass(
+	    lz::RenderGraph::TransferPassDesc()
+	        .set_dst_buffers({scene_resource_->cull_statistics_proxy_.get().id()})
+	        .set_profiler_info(lz::Colors::carrot, "ClearCullStatisticsPass")
+	        .set_record_func([&](lz::RenderGraph::PassContext context) {
+		        auto cull_statistics_proxy = context.get_buffer(scene_resource_->cull_statistics_proxy_.get().id());
+		        context.get_command_buffer().fillBuffer(cull_statistics_proxy->get_handle(), 0, sizeof(CullStatistics), 0);
+	        }));
+}
+
+void MeshShadingRenderer::copy_cull_statistics(const lz::InFlightQueue::FrameInfo &frame_info, lz::RenderGraph *render_graph)
+{
+	auto &readback   = cull_statistics_readbacks_[frame_info.frame_index];
+	readback.pending = true;
+
+	lz::Buffer *readback_buffer = readback.buffer.get();
+
+	render_graph->add_pass(
+	    lz::RenderGraph::TransferPassDesc()
+	        .set_src_buffers({scene_resource_->cull_statistics_proxy_.get().id()})
+	        .set_profiler_info(lz::Colors::carrot, "CopyCullStatisticsPass")
+	        .set_record_func([this, readback_buffer](lz::RenderGraph::PassContext context) {
+		        auto cull_statistics_proxy = context.get_buffer(scene_resource_->cull_statistics_proxy_.get().id());
+		        context.get_command_buffer().copyBuffer(cull_statistics_proxy->get_handle(), readback_buffer->get_handle(),
+		                                                {vk::BufferCopy(0, 0, sizeof(CullStatistics))});
+
+		        // make the copy visible to the host once the frame fence is signaled
+		        auto host_barrier = vk::MemoryBarrier()
+		                                .setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+		                                .setDstAccessMask(vk::AccessFlagBits::eHostRead);
+		        context.get_command_buffer().pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost,
+		                                                     vk::DependencyFlags(), {host_barrier}, {}, {});
+	        }));
+}
+
+void MeshShadingRenderer::read_cull_statistics(size_t frame_index)
 {
-	const auto &logical_device = core_->get_logical_device();
+	// the in flight queue has waited for the fence of this frame slot, the copy recorded by it is complete
+	auto &readback = cull_statistics_readbacks_[frame_index];
+	if (readback.pending)
+	{
+		memcpy(&cull_statistics_, readback.buffer->get_mapped_data(), sizeof(CullStatistics));
+		cull_statistics_valid_ = true;
+		readback.pending       = false;
+	}
+}
 
-	draw_cull_shader_.compute_shader.reset(new Shader(logical_device, SHADER_GLSL_DIR "MeshShading/drawcull.comp"));
-	draw_cull_late_shader_.compute_shader.reset(new Shader(logical_device, SHADER_GLSL_DIR "MeshShading/drawcull_late.comp"));
-	depth_pyramid_shader_.compute_shader.reset(new Shader(logical_device, SHADER_GLSL_DIR "MeshShading/depthreduce.comp"));
+void MeshShadingRenderer::set_cull_statistics_enabled(bool enabled)
+{
+	cull_statistics_enabled_ = enabled;
+}
 
-	meshlet_shader_.task_shader.reset(new Shader(logical_device, SHADER_GLSL_DIR "MeshShading/meshlet.task"));
-	meshlet_shader_.mesh_shader.reset(new Shader(logical_device, SHADER_GLSL_DIR "MeshShading/meshlet.mesh"));
-	meshlet_shader_.fragment_shader.reset(new Shader(logical_device, SHADER_GLSL_DIR "MeshShading/meshlet.frag"));
-	meshlet_shader_.shader_program.reset(new ShaderProgram({meshlet_shader_.task_shader.get(), meshlet_shader_.mesh_shader.get(), meshlet_shader_.fragment_shader.get()}));
+bool MeshShadingRenderer::cull_statistics_enabled() const
+{
+	return cull_statistics_enabled_;
+}
+
+const MeshShadingRenderer::CullStatistics *MeshShadingRenderer::get_cull_statistics() const
+{
+	return cull_statistics_valid_ ? &cull_statistics_ : nullptr;
+}
+
+void MeshShadingRenderer::set_culling_settings(const CullingSettings &settings)
+{
+	culling_settings_ = settings;
+}
+
+const MeshShadingRenderer::CullingSettings &MeshShadingRenderer::get_culling_settings() const
+{
+	return culling_settings_;
+}
+
+void MeshShadingRenderer::select_culling_variants()
+{
+	// variants of previous frames stay cached, frames still in flight keep using their modules and pipelines
+	auto define = [](bool enabled) { return std::string(enabled ? "1" : "0"); };
+
+	draw_cull_late_shader_.compute_shader = draw_cull_late_shader_.variants->get_shader({{"OCCLUSION_CULL", define(culling_settings_.occlusion_culling)}});
+
+	// the mesh shader outputs are sized by the meshlet limits the render context built its meshlets with
+	auto meshlet_defines           = core_->get_shader_config().get_meshlet_defines();
+	meshlet_defines["CONE_CULL"]   = define(culling_settings_.cone_culling);
+	meshlet_defines["BACK_CULL"]   = define(culling_settings_.backface_culling);
+	meshlet_shader_.shader_program = meshlet_shader_.variants->get_program(meshlet_defines);
+}
+
+void MeshShadingRenderer::reload_shaders()
+{
+	// every stage is compiled in one batch, the program is only created once all of them are done
+	auto shaders = core_->get_shader_compiler()->create_shaders(core_->get_logical_device(),
+	                                                            {SHADER_GLSL_DIR "MeshShading/drawcull.comp",
+	                                                             SHADER_GLSL_DIR "MeshShading/depthreduce.comp"});
+
+	draw_cull_shader_.compute_shader     = std::move(shaders[0]);
+	depth_pyramid_shader_.compute_shader = std::move(shaders[1]);
+
+	// the culling toggles select a variant of these every frame
+	draw_cull_late_shader_.variants = std::make_unique<lz::ShaderProgramVariants>(core_, std::vector<std::string>{SHADER_GLSL_DIR "MeshShading/drawcull_late.comp"});
+	meshlet_shader_.variants        = std::make_unique<lz::ShaderProgramVariants>(core_, std::vector<std::string>{SHADER_GLSL_DIR "MeshShading/meshlet.task",
+	                                                                                                              SHADER_GLSL_DIR "MeshShading/meshlet.mesh",
+	                                                                                                              SHADER_GLSL_DIR "MeshShading/meshlet.frag"});
+	select_culling_variants();
 }
 
 void MeshShadingRenderer::change_view()
@@ -365,6 +531,7 @@ MeshShadingRenderer::SceneResource::SceneResource(lz::Core *core, lz::render::Re
 	visible_meshtask_draw_proxy_  = core->get_render_graph()->add_buffer<lz::render::MeshTaskDrawCommand>(uint32_t(render_context->get_meshlet_count()));
 	visible_meshtask_count_proxy_ = core->get_render_graph()->add_buffer<uint32_t>(1);
 	draw_visibility_buffer_proxy_ = core->get_render_graph()->add_buffer<uint32_t>(uint32_t(render_context->get_draw_count()));
+	cull_statistics_proxy_        = core->get_render_graph()->add_buffer<CullStatistics>(1);
 	mesh_draw_proxy_              = core->get_render_graph()->add_external_buffer(&render_context->get_mesh_draw_buffer());
 	mesh_proxy_                   = core->get_render_graph()->add_external_buffer(&render_context->get_mesh_info_buffer());
 }
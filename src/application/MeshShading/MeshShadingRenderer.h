@@ -1,7 +1,10 @@
 #pragma once
 
+#include "backend/Buffer.h"
+#include "backend/PipelineCache.h"
 #include "backend/Sampler.h"
 #include "backend/ShaderProgram.h"
+#include "backend/ShaderProgramVariants.h"
 #include "render/BaseRenderer.h"
 #include "render/MipBuilder.h"
 
@@ -22,6 +25,51 @@ class MeshShadingRenderer final : public BaseRenderer
 	virtual void reload_shaders() override;
 	virtual void change_view() override;
 
+	// CullStatistics: Culling counters of one frame, its size is checked against CullStatistics of mesh.h
+	struct CullStatistics
+	{
+		uint32_t early_draws_tested;
+		uint32_t early_draws_frustum_culled;
+		uint32_t early_draws_visible;
+
+		uint32_t late_draws_tested;
+		uint32_t late_draws_frustum_culled;
+		uint32_t late_draws_occlusion_culled;
+		uint32_t late_draws_visible;
+
+		uint32_t meshlets_tested;
+		uint32_t meshlets_cone_culled;
+		uint32_t meshlets_frustum_culled;
+		uint32_t meshlets_visible;
+
+		uint32_t triangles_tested;
+		uint32_t triangles_backface_culled;
+		uint32_t triangles_small_culled;
+		uint32_t triangles_visible;
+	};
+
+	// Culling counters are written by the GPU and read back once the frame that wrote them has retired
+	void set_cull_statistics_enabled(bool enabled);
+
+	bool cull_statistics_enabled() const;
+
+	// Returns the counters of the latest frame read back, nullptr until one is available
+	const CullStatistics *get_cull_statistics() const;
+
+	// CullingSettings: Culling tests compiled into the shaders, every combination is a shader variant
+	// - backface_culling also switches the small triangle test of the mesh shader
+	struct CullingSettings
+	{
+		bool cone_culling      = true;
+		bool backface_culling  = true;
+		bool occlusion_culling = true;
+	};
+
+	// A combination is compiled the first frame it is used, switching back to it later does not recompile
+	void set_culling_settings(const CullingSettings &settings);
+
+	const CullingSettings &get_culling_settings() const;
+
   private:
 	void generate_depth_pyramid(const lz::InFlightQueue::FrameInfo &frame_info, const lz::Scene &scene, lz::render::RenderContext &render_context, lz::RenderGraph *render_graph,
 	                            UnmippedImageProxy &depth_stencil_proxy, MippedImageProxy &depth_pyramid_proxy);
@@ -29,32 +77,24 @@ class MeshShadingRenderer final : public BaseRenderer
 	void cull_last_frame_not_visible(const lz::InFlightQueue::FrameInfo &frame_info, const lz::Scene &scene, lz::render::RenderContext &render_context, lz::RenderGraph *render_graph, MippedImageProxy &depth_pyramid_proxy);
 	void draw_mesh_task(const lz::InFlightQueue::FrameInfo &frame_info, const lz::Scene &scene, lz::render::RenderContext &render_context, lz::RenderGraph *render_graph,
 	                    UnmippedImageProxy &depth_stencil_proxy, bool late);
+	void clear_cull_statistics(lz::RenderGraph *render_graph);
+	void copy_cull_statistics(const lz::InFlightQueue::FrameInfo &frame_info, lz::RenderGraph *render_graph);
+	void read_cull_statistics(size_t frame_index);
+	void select_culling_variants();
 
 	constexpr static uint32_t k_shader_data_set_index    = 0;
 	constexpr static uint32_t k_draw_call_data_set_index = 1;
 
-	struct CullData
-	{
-		glm::mat4 view_matrix;
-		glm::mat4 proj_matrix;
-		float     P00, P11, znear, zfar;        // symmetirc projection parameters
-		float     frustum[4];                   // data for left / right / top / bottom
-		uint32_t  draw_count;                   // number of draw commands
-		float     screen_width;
-		float     screen_height;
-		float     depth_pyramid_width;
-		float     depth_pyramid_height;
-		float 	  pad[3];
-	};
-
 	struct DrawCullShader
 	{
 		std::unique_ptr<lz::Shader> compute_shader;
 	} draw_cull_shader_;
 
+	// variants selected by the culling settings, the pointers are the ones the passes of the current frame record with
 	struct DrawCullLateShader
 	{
-		std::unique_ptr<lz::Shader> compute_shader;
+		std::unique_ptr<lz::ShaderProgramVariants> variants;
+		lz::Shader                                *compute_shader = nullptr;
 	} draw_cull_late_shader_;
 
 	struct DepthPyramidShader
@@ -64,10 +104,8 @@ class MeshShadingRenderer final : public BaseRenderer
 
 	struct MeshletShader
 	{
-		std::unique_ptr<lz::Shader>        task_shader;
-		std::unique_ptr<lz::Shader>        mesh_shader;
-		std::unique_ptr<lz::Shader>        fragment_shader;
-		std::unique_ptr<lz::ShaderProgram> shader_program;
+		std::unique_ptr<lz::ShaderProgramVariants> variants;
+		lz::ShaderProgram                         *shader_program = nullptr;
 	} meshlet_shader_;
 
 	vk::Extent2D viewport_extent_;
@@ -92,6 +130,14 @@ class MeshShadingRenderer final : public BaseRenderer
 		lz::RenderGraph::BufferProxyUnique mesh_proxy_;
 		lz::RenderGraph::BufferProxyUnique visible_meshtask_count_proxy_;
 		lz::RenderGraph::BufferProxyUnique draw_visibility_buffer_proxy_;
+		lz::RenderGraph::BufferProxyUnique cull_statistics_proxy_;
+	};
+
+	// CullStatisticsReadback: Host visible copy of the counters written by one frame in flight
+	struct CullStatisticsReadback
+	{
+		std::unique_ptr<lz::Buffer> buffer;
+		bool                        pending = false;
 	};
 
 	std::unique_ptr<lz::Sampler> depth_reduce_sampler_;
@@ -100,6 +146,16 @@ class MeshShadingRenderer final : public BaseRenderer
 
 	std::map<lz::RenderGraph *, std::unique_ptr<FrameResource>> frame_resource_datum_;
 
+	std::vector<CullStatisticsReadback> cull_statistics_readbacks_;
+	CullStatistics                      cull_statistics_;
+	bool                                cull_statistics_valid_   = false;
+	bool                                cull_statistics_enabled_ = false;
+	bool                                record_cull_statistics_  = false;
+
+	CullingSettings culling_settings_;
+
+	lz::PipelineCache::GraphicsPipelineState pipeline_state_;
+
 	lz::Core *core_;
 };
 }        // namespace lz::render
@@ -7,6 +7,7 @@ namespace lz::render
 SimpleMeshShadingRenderer::SimpleMeshShadingRenderer(lz::Core *core) :
     core_(core)
 {
+	pipeline_state_ = core_->get_pipeline_cache()->intern_graphics_pipeline_state({lz::BlendSettings::opaque()}, lz::VertexDeclaration());
 	reload_shaders();
 }
 
@@ -29,8 +30,7 @@ void SimpleMeshShadingRenderer::render_frame(const lz::InFlightQueue::FrameInfo
                                        context.get_command_buffer(),
                                        context.get_render_pass()->get_handle(),
                                        lz::DepthSettings::disabled(),
-                                       {lz::BlendSettings::opaque()},
-                                       lz::VertexDeclaration(),
+                                       pipeline_state_,
                                        vk::PrimitiveTopology::eTriangleList,
                                        shader_program);
 
@@ -40,9 +40,14 @@ void SimpleMeshShadingRenderer::render_frame(const lz::InFlightQueue::FrameInfo
 
 void SimpleMeshShadingRenderer::reload_shaders()
 {
-	task_shader_.reset(new Shader(core_->get_logical_device(), SHADER_GLSL_DIR "Simple/ms.task"));
-	mesh_shader_.reset(new Shader(core_->get_logical_device(), SHADER_GLSL_DIR "Simple/ms.mesh"));
-	fragment_shader_.reset(new Shader(core_->get_logical_device(), SHADER_GLSL_DIR "Simple/ps.frag"));
+	auto shaders = core_->get_shader_compiler()->create_shaders(core_->get_logical_device(),
+	                                                            {SHADER_GLSL_DIR "Simple/ms.task",
+	                                                             SHADER_GLSL_DIR "Simple/ms.mesh",
+	                                                             SHADER_GLSL_DIR "Simple/ps.frag"});
+
+	task_shader_     = std::move(shaders[0]);
+	mesh_shader_     = std::move(shaders[1]);
+	fragment_shader_ = std::move(shaders[2]);
 	shader_program_.reset(new ShaderProgram({task_shader_.get(), mesh_shader_.get(), fragment_shader_.get()}));
 }
 
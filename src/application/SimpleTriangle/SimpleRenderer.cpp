@@ -7,6 +7,7 @@ namespace lz::render
 SimpleRenderer::SimpleRenderer(lz::Core *core) :
     core_(core)
 {
+	pipeline_state_ = core_->get_pipeline_cache()->intern_graphics_pipeline_state({lz::BlendSettings::opaque()}, lz::VertexDeclaration());
 	reload_shaders();
 }
 
@@ -28,8 +29,7 @@ void SimpleRenderer::render_frame(const lz::InFlightQueue::FrameInfo &frame_info
                                        context.get_command_buffer(),
                                        context.get_render_pass()->get_handle(),
                                        lz::DepthSettings::disabled(),
-                                       {lz::BlendSettings::opaque()},
-                                       lz::VertexDeclaration(),
+                                       pipeline_state_,
                                        vk::PrimitiveTopology::eTriangleList,
                                        shader_program);
 
@@ -39,8 +39,12 @@ void SimpleRenderer::render_frame(const lz::InFlightQueue::FrameInfo &frame_info
 
 void SimpleRenderer::reload_shaders()
 {
-	vertex_shader_.reset(new lz::Shader(core_->get_logical_device(), SHADER_GLSL_DIR "Simple/Simple.vert"));
-	fragment_shader_.reset(new lz::Shader(core_->get_logical_device(), SHADER_GLSL_DIR "Simple/Simple.frag"));
+	auto shaders = core_->get_shader_compiler()->create_shaders(core_->get_logical_device(),
+	                                                            {SHADER_GLSL_DIR "Simple/Simple.vert",
+	                                                             SHADER_GLSL_DIR "Simple/Simple.frag"});
+
+	vertex_shader_   = std::move(shaders[0]);
+	fragment_shader_ = std::move(shaders[1]);
 	shader_program_.reset(new lz::ShaderProgram({vertex_shader_.get(), fragment_shader_.get()}));
 }
 void SimpleRenderer::change_view()
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "backend/PipelineCache.h"
 #include "backend/ShaderProgram.h"
 #include "backend/VertexDeclaration.h"
 #include "render/BaseRenderer.h"
@@ -25,6 +26,8 @@ class SimpleRenderer : public BaseRenderer
 
 	vk::Extent2D viewport_extent_;
 
+	lz::PipelineCache::GraphicsPipelineState pipeline_state_;
+
 	lz::Core *core_;
 };
 }        // namespace lz::render
\ No newline at end of file
@@ -1,11 +1,18 @@
 ﻿#include "backend/App.h"
+#include "backend/CpuProfiler.h"
 #include "backend/Logging.h"
+#include "backend/MemoryTracker.h"
+#include "backend/RenderGraph.h"
+#include "backend/ShaderHotReloader.h"
+#include "backend/StartupProfiler.h"
+#include "backend/EngineConfig.h"
 #include "scene/Entity.h"
 
 #include "App.h"
 #include "imgui.h"
 #include <chrono>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <scene/CameraComponent.h>
 #include <sstream>
@@ -25,6 +32,9 @@ void App::framebuffer_resize_callback(GLFWwindow *window, int width, int height)
 App::App(const std::string &app_name, int width, int height) :
     app_name_(app_name), window_width_(width), window_height_(height)
 {
+	StartupProfiler::get().begin();
+	CpuProfiler::get().set_thread_name("Main");
+
 	// Add default instance extensions required by GLFW
 	add_instance_extension("VK_KHR_surface");
 	add_instance_extension("VK_KHR_win32_surface");
@@ -68,17 +78,150 @@ void App::clear_device_extensions()
 	device_extensions_.clear();
 }
 
+// Parse command line options
+bool App::parse_command_line(int argc, char **argv)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string option = argv[i];
+		if (i + 1 >= argc)
+		{
+			LOGE("Missing value for command line option {}", option);
+			return false;
+		}
+		const std::string value = argv[++i];
+
+		try
+		{
+			if (option == "--benchmark")
+			{
+				benchmark_requested_                 = true;
+				benchmark_settings_.camera_path_file = value;
+			}
+			else if (option == "--warmup")
+				benchmark_settings_.warmup_frames = uint32_t(std::stoul(value));
+			else if (option == "--frames")
+				benchmark_settings_.frames_count = uint32_t(std::stoul(value));
+			else if (option == "--report")
+				benchmark_settings_.report_file = value;
+			else if (option == "--baseline")
+				benchmark_settings_.baseline_file = value;
+			else if (option == "--threshold")
+				benchmark_settings_.regression_threshold = std::stof(value);
+			else if (option == "--compare")
+				compare_report_file_ = value;
+			else if (option == "--startup-report")
+				startup_report_file_ = value;
+			else if (option == "--spike-budget")
+				spike_settings_.budget_ms = std::stof(value);
+			else if (option == "--spike-multiple")
+				spike_settings_.median_multiple = std::stof(value);
+			else if (option == "--spike-history")
+				spike_settings_.history_frames = uint32_t(std::stoul(value));
+			else if (option == "--spike-dir")
+				spike_settings_.output_directory = value;
+			else if (option == "--autotune")
+			{
+				autotune_requested_                 = true;
+				autotune_settings_.camera_path_file = value;
+			}
+			else if (option == "--autotune-warmup")
+				autotune_settings_.warmup_frames = uint32_t(std::stoul(value));
+			else if (option == "--autotune-frames")
+				autotune_settings_.frames_count = uint32_t(std::stoul(value));
+			else if (option == "--autotune-profile")
+				autotune_settings_.profile_file = value;
+			else if (option == "--autotune-report")
+				autotune_settings_.report_file = value;
+			else if (option == "--device")
+				preferred_device_name_ = value;
+			else
+			{
+				LOGE("Unknown command line option {}", option);
+				return false;
+			}
+		}
+		catch (const std::exception &)
+		{
+			LOGE("Invalid value {} for command line option {}", value, option);
+			return false;
+		}
+	}
+
+	if (!compare_report_file_.empty() && benchmark_settings_.baseline_file.empty())
+	{
+		LOGE("--compare needs a --baseline report");
+		return false;
+	}
+	if (autotune_requested_ && benchmark_requested_)
+	{
+		LOGE("--autotune and --benchmark both drive the camera, pass only one of them");
+		return false;
+	}
+	return true;
+}
+
+int App::compare_benchmark_reports() const
+{
+	Json::Value report;
+	Json::Value baseline;
+	if (!BenchmarkRunner::load_report(compare_report_file_, report) || !BenchmarkRunner::load_report(benchmark_settings_.baseline_file, baseline))
+	{
+		return -1;
+	}
+
+	Json::Value regressions;
+	size_t      regressions_count = BenchmarkRunner::compare_reports(baseline, report, benchmark_settings_.regression_threshold, regressions);
+	LOGI("{} regressions of {} against {}", regressions_count, compare_report_file_, benchmark_settings_.baseline_file);
+	return regressions_count > 0 ? 1 : 0;
+}
+
 // Run the application
 int App::run()
 {
+	if (!compare_report_file_.empty())
+	{
+		return compare_benchmark_reports();
+	}
+
+	int exit_code = 0;
 	try
 	{
-		if (!init())
+		bool initialized = false;
+		{
+			StartupProfiler::ScopedPhase startup_phase("Initialization");
+			initialized = init();
+		}
+		if (!initialized)
 		{
 			LOGE("Application initialization failed!");
 			return -1;
 		}
 
+		if (benchmark_requested_)
+		{
+			benchmark_runner_ = std::make_unique<BenchmarkRunner>(benchmark_settings_);
+			if (!benchmark_runner_->begin())
+			{
+				return -1;
+			}
+		}
+
+		if (autotune_requested_)
+		{
+			auto_tuner_ = std::make_unique<AutoTuner>(autotune_settings_);
+			if (!auto_tuner_->begin(core_->get_shader_limits()))
+			{
+				return -1;
+			}
+			apply_shader_config(auto_tuner_->get_config());
+		}
+
+		spike_capture_ = std::make_unique<FrameSpikeCapture>(spike_settings_);
+
+		// edited shaders are recompiled in the background and swapped in at the start of a frame
+		ShaderHotReloader::get().start(core_.get());
+
 		auto prev_frame_time = std::chrono::system_clock::now();
 
 		// Main loop
@@ -88,12 +231,59 @@ int App::run()
 			delta_time_          = std::chrono::duration<float>(curr_frame_time - prev_frame_time).count();
 			prev_frame_time      = curr_frame_time;
 
+			// startup ends once the first frame, which uploads the pending textures, has been submitted
+			const size_t first_frame_phase = StartupProfiler::get().begin_phase("First frame");
+
 			glfwPollEvents();
 			recreate_swapchain();
+			ShaderHotReloader::get().update();
 			update(delta_time_);
 			process_input();
 			render_frame();
-			
+
+			if (StartupProfiler::get().is_recording())
+			{
+				StartupProfiler::get().end_phase(first_frame_phase);
+				StartupProfiler::get().finish(startup_report_file_);
+			}
+
+			if (in_flight_queue_)
+			{
+				spike_capture_->record_frame(in_flight_queue_->get_last_frame_cpu_profiler_data(),
+				                             in_flight_queue_->get_last_frame_gpu_profiler_data(),
+				                             core_->get_render_graph()->get_last_executed_passes());
+			}
+
+			if (benchmark_runner_ && in_flight_queue_)
+			{
+				const auto &descriptor_set_stats = core_->get_descriptor_set_cache()->get_last_frame_stats();
+				benchmark_runner_->record_counter("descriptor_set_lookups", double(descriptor_set_stats.lookups_count));
+				benchmark_runner_->record_counter("descriptor_set_allocations", double(descriptor_set_stats.allocations_count));
+				benchmark_runner_->record_counter("descriptor_writes", double(descriptor_set_stats.writes_count));
+				benchmark_runner_->record_counter("descriptor_buffer_sets", double(descriptor_set_stats.descriptor_buffer_sets_count));
+				benchmark_runner_->record_frame(delta_time_, in_flight_queue_->get_last_frame_cpu_profiler_data(),
+				                                in_flight_queue_->get_last_frame_gpu_resolved_frames());
+				if (benchmark_runner_->is_finished())
+				{
+					exit_code = benchmark_runner_->finish() > 0 ? 1 : 0;
+					break;
+				}
+			}
+
+			if (auto_tuner_ && in_flight_queue_)
+			{
+				const bool next_config = auto_tuner_->record_frame(delta_time_, in_flight_queue_->get_last_frame_cpu_profiler_data(),
+				                                                   in_flight_queue_->get_last_frame_gpu_resolved_frames());
+				if (auto_tuner_->is_finished())
+				{
+					exit_code = auto_tuner_->finish(core_->get_physical_device()) ? 0 : -1;
+					break;
+				}
+				if (next_config)
+				{
+					apply_shader_config(auto_tuner_->get_config());
+				}
+			}
 		}
 
 		// Wait for the device to be idle before exiting
@@ -108,31 +298,35 @@ int App::run()
 		return -1;
 	}
 
-	return 0;
+	return exit_code;
 }
 
 // Initialize the application
 bool App::init()
 {
-	// Initialize GLFW
-	if (!glfwInit())
+	// Initialize GLFW and create the window
 	{
-		LOGE("GLFW initialization failed");
-		return false;
-	}
+		StartupProfiler::ScopedPhase startup_phase("Window creation");
 
-	// Setup GLFW window
-	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-	window_ = glfwCreateWindow(window_width_, window_height_, app_name_.c_str(), nullptr, nullptr);
-	if (!window_)
-	{
-		LOGE("GLFW window creation failed");
-		glfwTerminate();
-		return false;
-	}
+		if (!glfwInit())
+		{
+			LOGE("GLFW initialization failed");
+			return false;
+		}
+
+		// Setup GLFW window
+		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+		window_ = glfwCreateWindow(window_width_, window_height_, app_name_.c_str(), nullptr, nullptr);
+		if (!window_)
+		{
+			LOGE("GLFW window creation failed");
+			glfwTerminate();
+			return false;
+		}
 
-	// Set window resize callback function
-	glfwSetFramebufferSizeCallback(window_, framebuffer_resize_callback);
+		// Set window resize callback function
+		glfwSetFramebufferSizeCallback(window_, framebuffer_resize_callback);
+	}
 
 	// Prepare instance extensions
 	std::vector<const char *> instance_extension_names;
@@ -163,12 +357,16 @@ bool App::init()
 	}
 
 	// Create the Core with our extension lists
-	core_ = std::make_unique<Core>(
-	    instance_extension_names.data(),
-	    static_cast<uint32_t>(instance_extension_names.size()),
-	    &window_desc,
-	    enable_debugging,
-	    device_extension_names);
+	{
+		StartupProfiler::ScopedPhase startup_phase("Vulkan core creation");
+		core_ = std::make_unique<Core>(
+		    instance_extension_names.data(),
+		    static_cast<uint32_t>(instance_extension_names.size()),
+		    &window_desc,
+		    enable_debugging,
+		    device_extension_names,
+		    preferred_device_name_);
+	}
 
 	// Create render context
 	render_context_ = std::make_unique<render::RenderContext>(core_.get());
@@ -177,24 +375,33 @@ bool App::init()
 	scene_ = std::make_unique<Scene>();
 
 	// Prepare scene
-	prepare_render_context();
+	{
+		StartupProfiler::ScopedPhase startup_phase("Render context preparation");
+		prepare_render_context();
+	}
 
 	// Setup scene and camera
 	setup_scene();
 
 	// Create renderer
-	renderer_ = create_renderer();
-	if (!renderer_)
 	{
-		LOGE("Renderer creation failed");
-		return false;
-	}
+		StartupProfiler::ScopedPhase startup_phase("Renderer creation");
+		renderer_ = create_renderer();
+		if (!renderer_)
+		{
+			LOGE("Renderer creation failed");
+			return false;
+		}
 
-	// Create scene resources
-	renderer_->recreate_render_context_resources(render_context_.get());
+		// Create scene resources
+		renderer_->recreate_render_context_resources(render_context_.get());
+	}
 
 	// Initialize ImGui renderer
-	imgui_renderer_ = std::make_unique<render::ImGuiRenderer>(core_.get(), window_);
+	{
+		StartupProfiler::ScopedPhase startup_phase("ImGui initialization");
+		imgui_renderer_ = std::make_unique<render::ImGuiRenderer>(core_.get(), window_);
+	}
 
 	glfwGetCursorPos(window_, &mouse_pos_.x, &mouse_pos_.y);
 	prev_mouse_pos_ = mouse_pos_;
@@ -235,13 +442,21 @@ void App::setup_scene()
 // Update logic
 void App::update(float deltaTime)
 {
+	if (benchmark_runner_)
+	{
+		benchmark_runner_->update_camera(scene_->get_main_camera());
+	}
+	if (auto_tuner_)
+	{
+		auto_tuner_->update_camera(scene_->get_main_camera());
+	}
+	record_camera_path(deltaTime);
+
 	// Update scene
 	if (scene_)
 	{
 		scene_->update(deltaTime);
 	}
-	// update material system
-	core_->process_pending_material_updates();
 }
 
 // Process input
@@ -258,7 +473,8 @@ void App::process_input()
 		imgui_io.DisplaySize.x = float(in_flight_queue_->get_image_size().width);
 		imgui_io.DisplaySize.y = float(in_flight_queue_->get_image_size().height);
 
-		if (!ImGui::IsWindowFocused(ImGuiFocusedFlags_AnyWindow))
+		// the benchmark and the auto-tuner own the camera
+		if (!benchmark_runner_ && !auto_tuner_ && !ImGui::IsWindowFocused(ImGuiFocusedFlags_AnyWindow))
 		{
 			glm::vec3 dir = glm::vec3(0.0f, 0.0f, 0.0f);
 
@@ -322,9 +538,7 @@ void App::process_input()
 
 			if (glfwGetKey(window_, GLFW_KEY_V))
 			{
-				renderer_->reload_shaders();
-				core_->wait_idle();
-				core_->get_pipeline_cache()->clear();
+				ShaderHotReloader::get().reload_all();
 			}
 		}
 	}
@@ -336,13 +550,201 @@ void App::render_ui()
 	ImGui::Begin("Demo controls", 0, ImGuiWindowFlags_NoScrollbar);
 	{
 		ImGui::Text("wasd, q, e: move camera");
-		ImGui::Text("v: live reload shaders");
+		ImGui::Text("v: reload all shaders, edited ones reload by themselves");
 
 		ImGui::Checkbox("Show performance", &show_performance);
+		ImGui::Checkbox("Show memory", &show_memory);
+
+		if (ImGui::Checkbox("Record camera path", &recording_camera_path_))
+		{
+			if (recording_camera_path_)
+			{
+				recorded_camera_path_.clear();
+				recording_time_ = 0.0f;
+			}
+			else if (recorded_camera_path_.save("camera_path.json"))
+			{
+				LOGI("Camera path written to camera_path.json");
+			}
+		}
 
 		// TODO: Add more status
 	}
 	ImGui::End();
+
+	if (show_memory)
+	{
+		render_memory_window();
+	}
+}
+
+void App::render_memory_window()
+{
+	constexpr float mb = 1024.0f * 1024.0f;
+
+	ImGui::Begin("Memory", &show_memory);
+	{
+		auto &tracker    = MemoryTracker::get();
+		auto  categories = tracker.get_category_stats();
+
+		ImGui::Text("Tracked: %.1f MB", float(tracker.get_total_bytes()) / mb);
+		ImGui::Columns(4, "categories");
+		ImGui::Text("Subsystem");
+		ImGui::NextColumn();
+		ImGui::Text("Allocations");
+		ImGui::NextColumn();
+		ImGui::Text("MB");
+		ImGui::NextColumn();
+		ImGui::Text("Peak MB");
+		ImGui::NextColumn();
+		for (size_t i = 0; i < categories.size(); i++)
+		{
+			ImGui::Text("%s", MemoryTracker::get_category_name(MemoryCategory(i)));
+			ImGui::NextColumn();
+			ImGui::Text("%zu", categories[i].allocations_count);
+			ImGui::NextColumn();
+			ImGui::Text("%.1f", float(categories[i].bytes) / mb);
+			ImGui::NextColumn();
+			ImGui::Text("%.1f", float(categories[i].peak_bytes) / mb);
+			ImGui::NextColumn();
+		}
+		ImGui::Columns(1);
+
+		if (in_flight_queue_)
+		{
+			auto memory_pool = in_flight_queue_->get_memory_pool();
+			ImGui::Text("Shader memory: %.2f MB used last frame, %.2f MB peak, %.1f MB allocated",
+			            float(memory_pool->get_last_frame_used_size()) / mb, float(memory_pool->get_peak_used_size()) / mb,
+			            float(memory_pool->get_allocated_size()) / mb);
+		}
+
+		auto cache_stats = core_->get_render_graph()->get_cache_stats();
+		ImGui::Text("Render graph cache: %zu images (%.1f MB), %zu buffers (%.1f MB), %zu retiring",
+		            cache_stats.images_count, float(cache_stats.images_bytes) / mb,
+		            cache_stats.buffers_count, float(cache_stats.buffers_bytes) / mb,
+		            cache_stats.retired_count);
+
+		const auto &descriptor_set_stats = core_->get_descriptor_set_cache()->get_last_frame_stats();
+		ImGui::Text("Descriptor sets last frame: %zu lookups, %zu allocated, %zu descriptors written",
+		            descriptor_set_stats.lookups_count, descriptor_set_stats.allocations_count, descriptor_set_stats.writes_count);
+		if (core_->get_descriptor_buffer())
+		{
+			ImGui::Text("Descriptor buffer last frame: %zu sets written, %.2f MB allocated",
+			            descriptor_set_stats.descriptor_buffer_sets_count, float(core_->get_descriptor_buffer()->get_allocated_size()) / mb);
+		}
+
+		bool budget_supported = core_->memory_budget_supported();
+		auto heaps            = tracker.query_heaps(core_->get_physical_device(), budget_supported);
+		for (size_t i = 0; i < heaps.size(); i++)
+		{
+			const char *heap_type = (heaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal) ? "device" : "host";
+			if (budget_supported && heaps[i].budget > 0)
+			{
+				ImGui::Text("Heap %zu (%s): tracked %.1f MB, usage %.1f / %.1f MB", i, heap_type,
+				            float(heaps[i].tracked_bytes) / mb, float(heaps[i].usage) / mb, float(heaps[i].budget) / mb);
+				ImGui::ProgressBar(float(heaps[i].usage) / float(heaps[i].budget));
+			}
+			else
+			{
+				ImGui::Text("Heap %zu (%s): tracked %.1f / %.1f MB", i, heap_type,
+				            float(heaps[i].tracked_bytes) / mb, float(heaps[i].size) / mb);
+			}
+		}
+
+		if (ImGui::Button("Dump memory report"))
+		{
+			dump_memory_report("memory_report.json");
+		}
+	}
+	ImGui::End();
+}
+
+void App::dump_memory_report(const std::string &file_path) const
+{
+	Json::Value report = MemoryTracker::get().dump(core_->get_physical_device(), core_->memory_budget_supported());
+
+	std::ofstream file(file_path);
+	if (!file.is_open())
+	{
+		LOGE("Failed to write memory report to {}", file_path);
+		return;
+	}
+	file << report.toStyledString();
+	LOGI("Memory report written to {}", file_path);
+}
+
+void App::record_camera_path(float delta_time)
+{
+	if (!recording_camera_path_)
+	{
+		return;
+	}
+
+	// a keyframe every 100ms keeps the file small, the path is interpolated on replay
+	constexpr float keyframe_interval = 0.1f;
+
+	const bool first_keyframe = recorded_camera_path_.empty();
+	recording_time_ += first_keyframe ? 0.0f : delta_time;
+	if (first_keyframe || recording_time_ >= recorded_camera_path_.get_duration() + keyframe_interval)
+	{
+		auto camera = scene_->get_main_camera();
+		recorded_camera_path_.add_keyframe({recording_time_, camera->pos, camera->hor_angle, camera->vert_angle});
+	}
+}
+
+void App::apply_shader_config(const ShaderConfig &shader_config)
+{
+	core_->wait_idle();
+	core_->set_shader_config(shader_config);
+
+	// the meshlets are split with the new limits, the renderer recompiles its shaders and rebinds the new scene buffers
+	render_context_->rebuild_meshlets();
+	renderer_->reload_shaders();
+	renderer_->recreate_render_context_resources(render_context_.get());
+}
+
+void App::dump_profiler_report(const std::string &file_path)
+{
+	auto write_tasks = [](const std::vector<lz::ProfilerTask> &tasks, bool write_threads, Json::Value &json_tasks) {
+		for (const auto &task : tasks)
+		{
+			Json::Value json_task;
+			json_task["name"]        = task.name;
+			json_task["start_ms"]    = task.start_time * 1000.0;
+			json_task["duration_ms"] = task.get_length() * 1000.0;
+			if (write_threads)
+			{
+				const char *thread_name  = CpuProfiler::get().get_thread_name(task.thread_index);
+				json_task["thread"]      = task.thread_index;
+				json_task["thread_name"] = thread_name ? thread_name : "";
+				json_task["depth"]       = task.depth;
+			}
+			if (task.has_pipeline_statistics)
+			{
+				for (size_t i = 0; i < task.pipeline_statistics.size(); i++)
+				{
+					json_task["pipeline_statistics"][lz::get_pipeline_statistic_name(lz::PipelineStatistic(i))] =
+					    Json::UInt64(task.pipeline_statistics[i]);
+				}
+			}
+			json_tasks.append(json_task);
+		}
+	};
+
+	Json::Value report;
+	write_tasks(in_flight_queue_->get_last_frame_gpu_profiler_data(), false, report["gpu_tasks"]);
+	write_tasks(in_flight_queue_->get_last_frame_cpu_profiler_data(), true, report["cpu_tasks"]);
+	report["cpu_dropped_events"] = Json::UInt64(CpuProfiler::get().get_dropped_events_count());
+	report["gpu_missing_frames"] = Json::UInt64(in_flight_queue_->get_gpu_profiler().get_missing_frames_count());
+
+	std::ofstream file(file_path);
+	if (!file.is_open())
+	{
+		LOGE("Failed to write profiler report to {}", file_path);
+		return;
+	}
+	file << report.toStyledString();
+	LOGI("Profiler report written to {}", file_path);
 }
 
 void App::recreate_swapchain()
@@ -369,7 +771,7 @@ void App::recreate_swapchain()
 				WindowDesc window_desc = {};
 				window_desc.h_instance = GetModuleHandle(NULL);
 				window_desc.h_wnd      = glfwGetWin32Window(window_);
-				in_flight_queue_       = std::make_unique<InFlightQueue>(core_.get(), window_desc, 2, vk::PresentModeKHR::eMailbox);
+				in_flight_queue_       = std::make_unique<InFlightQueue>(core_.get(), window_desc, MAX_FRAMES_IN_FLIGHT, vk::PresentModeKHR::eMailbox);
 				renderer_->recreate_swapchain_resources(in_flight_queue_->get_image_size(), in_flight_queue_->get_in_flight_frames_count());
 				imgui_renderer_->recreate_swapchain_resources(in_flight_queue_->get_image_size(), in_flight_queue_->get_in_flight_frames_count());
 			}
@@ -380,7 +782,7 @@ void App::recreate_swapchain()
 			WindowDesc window_desc = {};
 			window_desc.h_instance = GetModuleHandle(NULL);
 			window_desc.h_wnd      = glfwGetWin32Window(window_);
-			in_flight_queue_       = std::make_unique<InFlightQueue>(core_.get(), window_desc, 2, vk::PresentModeKHR::eMailbox);
+			in_flight_queue_       = std::make_unique<InFlightQueue>(core_.get(), window_desc, MAX_FRAMES_IN_FLIGHT, vk::PresentModeKHR::eMailbox);
 			renderer_->recreate_swapchain_resources(in_flight_queue_->get_image_size(), in_flight_queue_->get_in_flight_frames_count());
 			imgui_renderer_->recreate_swapchain_resources(in_flight_queue_->get_image_size(), in_flight_queue_->get_in_flight_frames_count());
 		}
@@ -422,6 +824,12 @@ void App::render_frame()
 					    "Performance rendering", lz::Colors::belize_hole);
 					profiler_window_.render();
 				}
+
+				in_flight_queue_->get_gpu_profiler().set_pipeline_statistics_enabled(profiler_window_.show_pipeline_statistics);
+				if (profiler_window_.dump_report_requested)
+				{
+					dump_profiler_report("profiler_report.json");
+				}
 			}
 
 			render_ui();
@@ -453,6 +861,9 @@ void App::cleanup()
 		core_->wait_idle();
 	}
 
+	// retired shader modules and pipelines have to go before the device
+	ShaderHotReloader::get().stop();
+
 	if (window_)
 	{
 		glfwDestroyWindow(window_);
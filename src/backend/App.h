@@ -25,8 +25,11 @@
 #include <string>
 #include <vector>
 
+#include "backend/AutoTuner.h"
+#include "backend/BenchmarkRunner.h"
 #include "backend/Camera.h"
 #include "backend/Core.h"
+#include "backend/FrameSpikeCapture.h"
 #include "imgui.h"
 #include "render/BaseRenderer.h"
 #include "render/ImGuiProfilerRenderer.h"
@@ -57,7 +60,18 @@ class App
 	// Destructor
 	virtual ~App();
 
-	// Run the application
+	// Parse command line options, returns false if they are invalid
+	// --benchmark <camera_path.json> [--warmup N] [--frames N] [--report file] [--baseline file] [--threshold ratio]
+	// --compare <report.json> --baseline <file> [--threshold ratio] compares two reports without rendering
+	// --startup-report <file> sets where the startup phase timings are written
+	// --spike-budget <ms> [--spike-multiple ratio] [--spike-history N] [--spike-dir dir] configure frame spike captures,
+	// a zero budget and multiple turn them off
+	// --autotune <camera_path.json> [--autotune-warmup N] [--autotune-frames N] [--autotune-profile file]
+	// [--autotune-report file] measures the shader configurations and writes the fastest as the device profile
+	// --device <name> prefers the device whose name contains name, e.g. llvmpipe for functional runs on lavapipe
+	bool parse_command_line(int argc, char **argv);
+
+	// Run the application, returns 1 if a benchmark regressed against its baseline
 	int run();
 
 	// Add instance extension
@@ -95,6 +109,24 @@ class App
 	virtual void render_ui();
 	void         recreate_swapchain();
 
+	// Render device memory usage per subsystem and per heap
+	void render_memory_window();
+
+	// Write the memory report as JSON
+	void dump_memory_report(const std::string &file_path) const;
+
+	// Write the timings and pipeline statistics of the last profiled frame as JSON
+	void dump_profiler_report(const std::string &file_path);
+
+	// Compare a benchmark report to the baseline given on the command line
+	int compare_benchmark_reports() const;
+
+	// Append the camera pose to the recorded path while recording is enabled
+	void record_camera_path(float delta_time);
+
+	// Switch to another shader config, rebuilding the meshlets, shaders and pipelines that depend on it
+	void apply_shader_config(const ShaderConfig &shader_config);
+
 	// Process input
 	virtual void process_input();
 
@@ -121,8 +153,33 @@ class App
 	std::unique_ptr<InFlightQueue> in_flight_queue_;
 
 	bool                        show_performance = false;
+	bool                        show_memory      = false;
 	ImGuiUtils::ProfilersWindow profiler_window_;
 
+	// Benchmark mode replays a camera path instead of reading input
+	BenchmarkSettings                benchmark_settings_;
+	std::unique_ptr<BenchmarkRunner> benchmark_runner_;
+	bool                             benchmark_requested_ = false;
+	std::string                      compare_report_file_;
+
+	// Auto-tuning mode replays a camera path once per shader configuration
+	AutoTuneSettings           autotune_settings_;
+	std::unique_ptr<AutoTuner> auto_tuner_;
+	bool                       autotune_requested_ = false;
+
+	std::string preferred_device_name_;
+
+	// Startup phases are recorded until the first frame has been submitted
+	std::string startup_report_file_ = "startup_report.json";
+
+	// Frames that take too long are written to disk with the frames around them
+	FrameSpikeSettings                 spike_settings_;
+	std::unique_ptr<FrameSpikeCapture> spike_capture_;
+
+	CameraPath recorded_camera_path_;
+	bool       recording_camera_path_ = false;
+	float      recording_time_        = 0.0f;
+
 	float        delta_time_;
 	glm::f64vec2 mouse_pos_;
 	glm::f64vec2 prev_mouse_pos_;
@@ -0,0 +1,208 @@
+#include "AutoTuner.h"
+
+#include "Logging.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace lz
+{
+namespace
+{
+// the grid, meshlet limits are kept below the 8 bit counts of Meshlet and triangle limits are multiples of 4
+constexpr uint32_t meshlet_vertices_options[]    = {32, 64, 96, 128};
+constexpr uint32_t meshlet_triangles_options[]   = {64, 96, 124};
+constexpr float    meshlet_cone_weight_options[] = {0.0f, 0.25f, 0.5f};
+constexpr uint32_t mesh_workgroup_size_options[] = {32, 64, 128};
+
+// GPU frame time of a benchmark report, CPU frame time when the device wrote no timestamps
+double get_frame_time_ms(const Json::Value &report)
+{
+	const Json::Value &gpu_frame_time = report["gpu_frame_time_ms"];
+	if (gpu_frame_time["samples"].asUInt64() > 0)
+	{
+		return gpu_frame_time["mean"].asDouble();
+	}
+	return report["frame_time_ms"]["mean"].asDouble();
+}
+}        // namespace
+
+AutoTuner::AutoTuner(const AutoTuneSettings &settings) :
+    settings_(settings),
+    candidate_index_(0)
+{
+}
+
+std::vector<ShaderConfig> AutoTuner::build_candidates(const ShaderConfig::DeviceLimits &limits)
+{
+	const ShaderConfig base_config = ShaderConfig::select(limits);
+
+	// the ballot compaction allows task workgroups of one subgroup or a smaller power of two
+	std::vector<uint32_t> task_workgroup_sizes = {base_config.task_workgroup_size};
+	if (base_config.task_workgroup_size >= 2)
+	{
+		task_workgroup_sizes.push_back(base_config.task_workgroup_size / 2);
+	}
+
+	std::vector<ShaderConfig> candidates;
+	for (const uint32_t max_vertices : meshlet_vertices_options)
+	{
+		for (const uint32_t max_triangles : meshlet_triangles_options)
+		{
+			for (const float cone_weight : meshlet_cone_weight_options)
+			{
+				for (const uint32_t task_workgroup_size : task_workgroup_sizes)
+				{
+					for (const uint32_t mesh_workgroup_size : mesh_workgroup_size_options)
+					{
+						// threads beyond the larger meshlet limit would only idle
+						if (mesh_workgroup_size > mesh_workgroup_size_options[0] && mesh_workgroup_size > std::max(max_vertices, max_triangles))
+						{
+							continue;
+						}
+
+						ShaderConfig config          = base_config;
+						config.task_workgroup_size   = task_workgroup_size;
+						config.mesh_workgroup_size   = std::min(mesh_workgroup_size, limits.max_mesh_workgroup_size);
+						config.meshlet_max_vertices  = max_vertices;
+						config.meshlet_max_triangles = max_triangles;
+						config.meshlet_cone_weight   = cone_weight;
+						if (!config.fits(limits))
+						{
+							continue;
+						}
+
+						// clamping to the device limits may repeat a configuration
+						const bool duplicate = std::any_of(candidates.begin(), candidates.end(), [&](const ShaderConfig &candidate) {
+							return candidate.to_json() == config.to_json();
+						});
+						if (!duplicate)
+						{
+							candidates.push_back(config);
+						}
+					}
+				}
+			}
+		}
+	}
+	return candidates;
+}
+
+bool AutoTuner::begin(const ShaderConfig::DeviceLimits &limits)
+{
+	candidates_ = build_candidates(limits);
+	if (candidates_.empty())
+	{
+		LOGE("No auto-tuning configuration fits the device limits");
+		return false;
+	}
+
+	LOGI("Auto-tuning {} configurations, {} frames each", candidates_.size(), settings_.warmup_frames + settings_.frames_count);
+	candidate_index_ = 0;
+	reports_.clear();
+	return start_candidate();
+}
+
+const ShaderConfig &AutoTuner::get_config() const
+{
+	assert(candidate_index_ < candidates_.size());
+	return candidates_[candidate_index_];
+}
+
+void AutoTuner::update_camera(lz::Camera *camera) const
+{
+	if (runner_)
+	{
+		runner_->update_camera(camera);
+	}
+}
+
+bool AutoTuner::record_frame(float frame_time, const std::vector<lz::ProfilerTask> &cpu_tasks,
+                             const std::vector<std::vector<lz::ProfilerTask>> &gpu_frames)
+{
+	if (!runner_)
+	{
+		return false;
+	}
+
+	runner_->record_frame(frame_time, cpu_tasks, gpu_frames);
+	if (!runner_->is_finished())
+	{
+		return false;
+	}
+
+	Json::Value report      = runner_->build_report();
+	report["shader_config"] = candidates_[candidate_index_].to_json();
+	LOGI("Auto-tuning configuration {}/{}: {:.3f} ms", candidate_index_ + 1, candidates_.size(), get_frame_time_ms(report));
+	reports_.push_back(report);
+	runner_.reset();
+
+	if (candidate_index_ + 1 >= candidates_.size())
+	{
+		return false;
+	}
+	candidate_index_++;
+	return start_candidate();
+}
+
+bool AutoTuner::is_finished() const
+{
+	return !runner_;
+}
+
+bool AutoTuner::finish(vk::PhysicalDevice physical_device)
+{
+	if (reports_.empty())
+	{
+		LOGE("Auto-tuning measured no configuration");
+		return false;
+	}
+
+	const auto best_report = std::min_element(reports_.begin(), reports_.end(), [](const Json::Value &a, const Json::Value &b) {
+		return get_frame_time_ms(a) < get_frame_time_ms(b);
+	});
+	const ShaderConfig &best_config = candidates_[size_t(best_report - reports_.begin())];
+
+	Json::Value report;
+	report["camera_path"]    = settings_.camera_path_file;
+	report["configurations"] = Json::Value(Json::arrayValue);
+	for (const auto &configuration_report : reports_)
+	{
+		report["configurations"].append(configuration_report);
+	}
+	report["best"] = *best_report;
+	BenchmarkRunner::save_report(settings_.report_file, report);
+
+	Json::Value measurements;
+	measurements["camera_path"]   = settings_.camera_path_file;
+	measurements["frame_time_ms"] = get_frame_time_ms(*best_report);
+
+	const std::string profile_file = settings_.profile_file.empty() ? ShaderConfig::get_device_profile_path(physical_device) : settings_.profile_file;
+	if (!best_config.save_profile(profile_file, physical_device, measurements))
+	{
+		return false;
+	}
+
+	LOGI("Auto-tuning finished: {:.3f} ms with task workgroup {}, mesh workgroup {}, meshlets of {} vertices and {} triangles, cone weight {}",
+	     get_frame_time_ms(*best_report), best_config.task_workgroup_size, best_config.mesh_workgroup_size,
+	     best_config.meshlet_max_vertices, best_config.meshlet_max_triangles, best_config.meshlet_cone_weight);
+	LOGI("Device profile written to {}, report written to {}", profile_file, settings_.report_file);
+	return true;
+}
+
+bool AutoTuner::start_candidate()
+{
+	BenchmarkSettings benchmark_settings;
+	benchmark_settings.camera_path_file = settings_.camera_path_file;
+	benchmark_settings.warmup_frames    = settings_.warmup_frames;
+	benchmark_settings.frames_count     = settings_.frames_count;
+
+	runner_ = std::make_unique<BenchmarkRunner>(benchmark_settings);
+	if (!runner_->begin())
+	{
+		runner_.reset();
+		return false;
+	}
+	return true;
+}
+}        // namespace lz
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "BenchmarkRunner.h"
+#include "ProfilerTask.h"
+#include "ShaderConfig.h"
+
+#include "json/json.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lz
+{
+class Camera;
+
+// AutoTuneSettings: Parameters of one auto-tuning run, filled from the command line
+struct AutoTuneSettings
+{
+	std::string camera_path_file;
+
+	// the device profile the engine loads at startup when empty
+	std::string profile_file;
+	std::string report_file = "autotune_report.json";
+
+	// frames rendered after switching configurations, they rebuild pipelines and flush the GPU timings of the previous
+	// configuration, and measured frames the camera path is spread over
+	uint32_t warmup_frames = 30;
+	uint32_t frames_count  = 120;
+};
+
+// AutoTuner: Measures the GPU frame time of a grid of shader configurations over a camera path and keeps the fastest
+// - The grid spans meshlet vertex and triangle limits, the meshlet cone weight and the task and mesh workgroup sizes,
+//   configurations that do not fit the device limits are skipped
+// - Every configuration is replayed with a BenchmarkRunner, the caller applies the configuration get_config() returns
+//   whenever record_frame() starts a new one, which rebuilds the meshlets, shaders and pipelines
+// - Runs on any Vulkan device, the timings come from the GPU profiler and fall back to CPU frame times when the device
+//   has no timestamp queries
+class AutoTuner
+{
+  public:
+	explicit AutoTuner(const AutoTuneSettings &settings);
+
+	// BuildCandidates: Every configuration of the grid that fits the limits, the compute workgroup keeps its selected size
+	static std::vector<ShaderConfig> build_candidates(const ShaderConfig::DeviceLimits &limits);
+
+	// Begin: Loads the camera path and builds the grid, returns false if there is nothing to measure
+	bool begin(const ShaderConfig::DeviceLimits &limits);
+
+	// GetConfig: The configuration that is being measured
+	const ShaderConfig &get_config() const;
+
+	// UpdateCamera: Moves the camera to the pose of the next frame
+	void update_camera(lz::Camera *camera) const;
+
+	// RecordFrame: Adds the timings of a finished frame and of the GPU frames resolved meanwhile, returns true when the
+	// next configuration has to be applied
+	bool record_frame(float frame_time, const std::vector<lz::ProfilerTask> &cpu_tasks,
+	                  const std::vector<std::vector<lz::ProfilerTask>> &gpu_frames);
+
+	bool is_finished() const;
+
+	// Finish: Writes the report of every configuration and the profile of the fastest one
+	bool finish(vk::PhysicalDevice physical_device);
+
+  private:
+	// StartCandidate: Starts a new BenchmarkRunner for the configuration at candidate_index_
+	bool start_candidate();
+
+	AutoTuneSettings settings_;
+
+	std::vector<ShaderConfig>        candidates_;
+	size_t                           candidate_index_;
+	std::unique_ptr<BenchmarkRunner> runner_;
+
+	// the benchmark report of every configuration measured so far
+	std::vector<Json::Value> reports_;
+};
+}        // namespace lz
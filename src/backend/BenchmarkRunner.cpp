@@ -0,0 +1,343 @@
+#include "BenchmarkRunner.h"
+
+#include "Camera.h"
+#include "Logging.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+
+namespace lz
+{
+// differences below this are treated as noise regardless of the relative threshold
+static constexpr double k_min_regression_ms = 0.05;
+
+bool CameraPath::load(const std::string &file_path)
+{
+	Json::Value root;
+	if (!BenchmarkRunner::load_report(file_path, root))
+	{
+		return false;
+	}
+
+	keyframes_.clear();
+	for (const auto &json_keyframe : root["keyframes"])
+	{
+		Keyframe keyframe;
+		keyframe.time       = json_keyframe["time"].asFloat();
+		keyframe.position   = glm::vec3(json_keyframe["position"][0].asFloat(), json_keyframe["position"][1].asFloat(),
+		                                json_keyframe["position"][2].asFloat());
+		keyframe.hor_angle  = json_keyframe["hor_angle"].asFloat();
+		keyframe.vert_angle = json_keyframe["vert_angle"].asFloat();
+		add_keyframe(keyframe);
+	}
+	return !keyframes_.empty();
+}
+
+bool CameraPath::save(const std::string &file_path) const
+{
+	Json::Value root;
+	root["keyframes"] = Json::Value(Json::arrayValue);
+	for (const auto &keyframe : keyframes_)
+	{
+		Json::Value json_keyframe;
+		json_keyframe["time"] = keyframe.time;
+		for (int i = 0; i < 3; i++)
+		{
+			json_keyframe["position"].append(keyframe.position[i]);
+		}
+		json_keyframe["hor_angle"]  = keyframe.hor_angle;
+		json_keyframe["vert_angle"] = keyframe.vert_angle;
+		root["keyframes"].append(json_keyframe);
+	}
+	return BenchmarkRunner::save_report(file_path, root);
+}
+
+void CameraPath::add_keyframe(const Keyframe &keyframe)
+{
+	assert(keyframes_.empty() || keyframes_.back().time <= keyframe.time);
+	keyframes_.push_back(keyframe);
+}
+
+void CameraPath::clear()
+{
+	keyframes_.clear();
+}
+
+void CameraPath::apply(float time, lz::Camera *camera) const
+{
+	if (keyframes_.empty())
+	{
+		return;
+	}
+
+	auto next = std::upper_bound(keyframes_.begin(), keyframes_.end(), time,
+	                             [](float value, const Keyframe &keyframe) { return value < keyframe.time; });
+	if (next == keyframes_.begin())
+	{
+		next++;
+	}
+	if (next == keyframes_.end())
+	{
+		next--;
+	}
+	const Keyframe &prev_keyframe = next == keyframes_.begin() ? *next : *(next - 1);
+	const Keyframe &next_keyframe = *next;
+
+	const float span  = next_keyframe.time - prev_keyframe.time;
+	const float ratio = span > 0.0f ? glm::clamp((time - prev_keyframe.time) / span, 0.0f, 1.0f) : 1.0f;
+
+	camera->pos        = glm::mix(prev_keyframe.position, next_keyframe.position, ratio);
+	camera->hor_angle  = glm::mix(prev_keyframe.hor_angle, next_keyframe.hor_angle, ratio);
+	camera->vert_angle = glm::mix(prev_keyframe.vert_angle, next_keyframe.vert_angle, ratio);
+}
+
+float CameraPath::get_duration() const
+{
+	return keyframes_.empty() ? 0.0f : keyframes_.back().time - keyframes_.front().time;
+}
+
+bool CameraPath::empty() const
+{
+	return keyframes_.empty();
+}
+
+BenchmarkRunner::BenchmarkRunner(const BenchmarkSettings &settings) :
+    settings_(settings),
+    frame_index_(0)
+{
+}
+
+bool BenchmarkRunner::begin()
+{
+	if (!camera_path_.load(settings_.camera_path_file))
+	{
+		LOGE("Benchmark camera path {} could not be loaded", settings_.camera_path_file);
+		return false;
+	}
+	if (settings_.frames_count == 0)
+	{
+		LOGE("Benchmark needs at least one measured frame");
+		return false;
+	}
+
+	frame_times_.reserve(settings_.frames_count);
+	gpu_frame_times_.reserve(settings_.frames_count);
+
+	LOGI("Benchmark started: {} warm-up frames, {} measured frames over a {}s camera path", settings_.warmup_frames,
+	     settings_.frames_count, camera_path_.get_duration());
+	return true;
+}
+
+void BenchmarkRunner::update_camera(lz::Camera *camera) const
+{
+	// the camera stays at the start of the path during warm-up
+	float progress = 0.0f;
+	if (frame_index_ >= settings_.warmup_frames && settings_.frames_count > 1)
+	{
+		progress = float(frame_index_ - settings_.warmup_frames) / float(settings_.frames_count - 1);
+	}
+	camera_path_.apply(glm::min(progress, 1.0f) * camera_path_.get_duration(), camera);
+}
+
+void BenchmarkRunner::record_frame(float frame_time, const std::vector<lz::ProfilerTask> &cpu_tasks,
+                                   const std::vector<std::vector<lz::ProfilerTask>> &gpu_frames)
+{
+	const bool measured = frame_index_ >= settings_.warmup_frames;
+	frame_index_++;
+	if (!measured)
+	{
+		return;
+	}
+
+	auto add_pass_times = [](const std::vector<lz::ProfilerTask> &tasks, std::map<std::string, std::vector<double>> &pass_times) {
+		// passes recorded several times per frame are summed
+		std::map<std::string, double> frame_pass_times;
+		for (const auto &task : tasks)
+		{
+			frame_pass_times[task.name] += task.get_length() * 1000.0;
+		}
+		for (const auto &[name, time] : frame_pass_times)
+		{
+			pass_times[name].push_back(time);
+		}
+	};
+
+	frame_times_.push_back(double(frame_time) * 1000.0);
+	add_pass_times(cpu_tasks, cpu_pass_times_);
+
+	// gpu results arrive a few frames late, the warm-up covers that latency, a call may bring none or several of them
+	for (const auto &gpu_tasks : gpu_frames)
+	{
+		if (!gpu_tasks.empty())
+		{
+			gpu_frame_times_.push_back(gpu_tasks.back().end_time * 1000.0);
+			add_pass_times(gpu_tasks, gpu_pass_times_);
+		}
+	}
+}
+
+void BenchmarkRunner::record_counter(const std::string &name, double value)
+{
+	if (frame_index_ >= settings_.warmup_frames)
+	{
+		counters_[name].push_back(value);
+	}
+}
+
+bool BenchmarkRunner::is_finished() const
+{
+	return frame_index_ >= settings_.warmup_frames + settings_.frames_count;
+}
+
+size_t BenchmarkRunner::finish()
+{
+	Json::Value report = build_report();
+
+	size_t regressions_count = 0;
+	if (!settings_.baseline_file.empty())
+	{
+		Json::Value baseline;
+		if (load_report(settings_.baseline_file, baseline))
+		{
+			regressions_count   = compare_reports(baseline, report, settings_.regression_threshold, report["regressions"]);
+			report["baseline"]  = settings_.baseline_file;
+			report["regressed"] = regressions_count > 0;
+		}
+	}
+
+	save_report(settings_.report_file, report);
+	LOGI("Benchmark finished: frame time mean {:.3f} ms, p50 {:.3f} ms, p95 {:.3f} ms, p99 {:.3f} ms",
+	     report["frame_time_ms"]["mean"].asDouble(), report["frame_time_ms"]["p50"].asDouble(),
+	     report["frame_time_ms"]["p95"].asDouble(), report["frame_time_ms"]["p99"].asDouble());
+	LOGI("Benchmark report written to {}", settings_.report_file);
+	return regressions_count;
+}
+
+Json::Value BenchmarkRunner::build_report() const
+{
+	Json::Value report;
+	report["camera_path"]       = settings_.camera_path_file;
+	report["warmup_frames"]     = settings_.warmup_frames;
+	report["frames_count"]      = settings_.frames_count;
+	report["frame_time_ms"]     = make_timing_stats(frame_times_);
+	report["gpu_frame_time_ms"] = make_timing_stats(gpu_frame_times_);
+
+	for (const auto &[name, times] : cpu_pass_times_)
+	{
+		report["cpu_passes"][name] = make_timing_stats(times);
+	}
+	for (const auto &[name, times] : gpu_pass_times_)
+	{
+		report["gpu_passes"][name] = make_timing_stats(times);
+	}
+	for (const auto &[name, values] : counters_)
+	{
+		report["counters"][name] = make_timing_stats(values);
+	}
+	return report;
+}
+
+size_t BenchmarkRunner::compare_reports(const Json::Value &baseline, const Json::Value &current, float threshold,
+                                        Json::Value &regressions)
+{
+	size_t regressions_count = 0;
+
+	auto compare_stats = [&](const std::string &metric, const Json::Value &baseline_stats, const Json::Value &current_stats,
+	                         std::initializer_list<const char *> keys) {
+		for (const char *key : keys)
+		{
+			if (!baseline_stats.isMember(key) || !current_stats.isMember(key))
+			{
+				continue;
+			}
+			const double baseline_value = baseline_stats[key].asDouble();
+			const double current_value  = current_stats[key].asDouble();
+			if (current_value > baseline_value * (1.0 + threshold) && current_value - baseline_value > k_min_regression_ms)
+			{
+				Json::Value regression;
+				regression["metric"]   = metric + "." + key;
+				regression["baseline"] = baseline_value;
+				regression["current"]  = current_value;
+				regressions.append(regression);
+				regressions_count++;
+
+				LOGW("Regression in {}.{}: {:.3f} ms -> {:.3f} ms", metric, key, baseline_value, current_value);
+			}
+		}
+	};
+
+	compare_stats("frame_time_ms", baseline["frame_time_ms"], current["frame_time_ms"], {"mean", "p50", "p95", "p99"});
+	compare_stats("gpu_frame_time_ms", baseline["gpu_frame_time_ms"], current["gpu_frame_time_ms"], {"mean", "p50", "p95", "p99"});
+
+	for (const char *passes : {"cpu_passes", "gpu_passes"})
+	{
+		for (const auto &name : current[passes].getMemberNames())
+		{
+			if (baseline[passes].isMember(name))
+			{
+				compare_stats(std::string(passes) + "." + name, baseline[passes][name], current[passes][name], {"mean", "p95"});
+			}
+		}
+	}
+	return regressions_count;
+}
+
+bool BenchmarkRunner::load_report(const std::string &file_path, Json::Value &report)
+{
+	std::ifstream file(file_path);
+	if (!file.is_open())
+	{
+		LOGE("Failed to open {}", file_path);
+		return false;
+	}
+
+	Json::CharReaderBuilder reader;
+	std::string             errors;
+	if (!Json::parseFromStream(reader, file, &report, &errors))
+	{
+		LOGE("Failed to parse {}: {}", file_path, errors);
+		return false;
+	}
+	return true;
+}
+
+bool BenchmarkRunner::save_report(const std::string &file_path, const Json::Value &report)
+{
+	std::ofstream file(file_path);
+	if (!file.is_open())
+	{
+		LOGE("Failed to write {}", file_path);
+		return false;
+	}
+	file << report.toStyledString();
+	return true;
+}
+
+Json::Value BenchmarkRunner::make_timing_stats(std::vector<double> samples)
+{
+	Json::Value stats;
+	stats["samples"] = Json::UInt64(samples.size());
+	if (samples.empty())
+	{
+		return stats;
+	}
+
+	std::sort(samples.begin(), samples.end());
+	auto percentile = [&samples](double p) {
+		// nearest rank
+		size_t rank = size_t(std::ceil(p * double(samples.size())));
+		return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+	};
+
+	stats["mean"] = std::accumulate(samples.begin(), samples.end(), 0.0) / double(samples.size());
+	stats["min"]  = samples.front();
+	stats["max"]  = samples.back();
+	stats["p50"]  = percentile(0.50);
+	stats["p95"]  = percentile(0.95);
+	stats["p99"]  = percentile(0.99);
+	return stats;
+}
+}        // namespace lz
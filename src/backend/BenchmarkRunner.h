@@ -0,0 +1,118 @@
+#pragma once
+
+#include "ProfilerTask.h"
+
+#include "glm/glm.hpp"
+#include "json/json.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace lz
+{
+class Camera;
+
+// CameraPath: Keyframed camera positions and angles, linearly interpolated over time
+// - Stored as JSON: {"keyframes": [{"time": 0.0, "position": [x, y, z], "hor_angle": 0.0, "vert_angle": 0.0}, ...]}
+// - Paths are either written by hand or recorded from an interactive session
+class CameraPath
+{
+  public:
+	struct Keyframe
+	{
+		float     time;
+		glm::vec3 position;
+		float     hor_angle;
+		float     vert_angle;
+	};
+
+	bool load(const std::string &file_path);
+
+	bool save(const std::string &file_path) const;
+
+	// AddKeyframe: Appends a keyframe, time must not decrease
+	void add_keyframe(const Keyframe &keyframe);
+
+	void clear();
+
+	// Apply: Moves the camera to the interpolated pose at the given time, clamped to the path
+	void apply(float time, lz::Camera *camera) const;
+
+	float get_duration() const;
+
+	bool empty() const;
+
+  private:
+	std::vector<Keyframe> keyframes_;
+};
+
+// BenchmarkSettings: Parameters of one benchmark run, filled from the command line
+struct BenchmarkSettings
+{
+	std::string camera_path_file;
+	std::string report_file = "benchmark_report.json";
+
+	// compared against when not empty
+	std::string baseline_file;
+
+	// frames rendered before measuring starts and measured frames, the camera path is spread over the latter
+	uint32_t warmup_frames = 60;
+	uint32_t frames_count  = 600;
+
+	// relative slowdown reported as a regression
+	float regression_threshold = 0.05f;
+};
+
+// BenchmarkRunner: Replays a camera path for a fixed number of frames and reports frame and pass timings
+// - The camera advances by a fixed step per frame so runs are comparable regardless of frame rate
+// - Reports hold mean, p50, p95 and p99 of CPU and GPU frame times and of every CPU and GPU pass
+// - Per frame counters such as descriptor set allocations are reported with the same statistics, they are not compared
+//   against the baseline
+class BenchmarkRunner
+{
+  public:
+	explicit BenchmarkRunner(const BenchmarkSettings &settings);
+
+	// Begin: Loads the camera path, returns false if it can not be used
+	bool begin();
+
+	// UpdateCamera: Moves the camera to the pose of the next frame
+	void update_camera(lz::Camera *camera) const;
+
+	// RecordFrame: Adds the timings of a finished frame, frames during warm-up are only counted
+	// - gpu_frames holds the GPU frames resolved since the previous call, each of them is recorded once
+	void record_frame(float frame_time, const std::vector<lz::ProfilerTask> &cpu_tasks,
+	                  const std::vector<std::vector<lz::ProfilerTask>> &gpu_frames);
+
+	// RecordCounter: Adds a counter of the frame record_frame() is called for next, ignored during warm-up
+	void record_counter(const std::string &name, double value);
+
+	bool is_finished() const;
+
+	// Finish: Writes the report and compares it to the baseline, returns the number of regressions
+	size_t finish();
+
+	Json::Value build_report() const;
+
+	// CompareReports: Appends every metric of current that is slower than baseline by more than threshold to regressions
+	static size_t compare_reports(const Json::Value &baseline, const Json::Value &current, float threshold, Json::Value &regressions);
+
+	static bool load_report(const std::string &file_path, Json::Value &report);
+
+	static bool save_report(const std::string &file_path, const Json::Value &report);
+
+  private:
+	static Json::Value make_timing_stats(std::vector<double> samples);
+
+	BenchmarkSettings settings_;
+	CameraPath        camera_path_;
+	uint32_t          frame_index_;
+
+	std::vector<double>                        frame_times_;
+	std::vector<double>                        gpu_frame_times_;
+	std::map<std::string, std::vector<double>> cpu_pass_times_;
+	std::map<std::string, std::vector<double>> gpu_pass_times_;
+	std::map<std::string, std::vector<double>> counters_;
+};
+}        // namespace lz
@@ -1,5 +1,9 @@
 #include "Buffer.h"
 
+#include "MemoryTracker.h"
+
+#include <cassert>
+
 namespace lz
 {
 vk::Buffer Buffer::get_handle()
@@ -45,15 +49,50 @@ Buffer::Buffer(const vk::PhysicalDevice physical_device, const vk::Device logica
 	const vk::MemoryRequirements buffer_mem_requirements = logical_device.getBufferMemoryRequirements(buffer_handle_.get());
 
 	// Allocate memory for the buffer
-	const auto alloc_info = vk::MemoryAllocateInfo()
-	                            .setAllocationSize(buffer_mem_requirements.size)
-	                            .setMemoryTypeIndex(find_memory_type_index(physical_device,
-	                                                                       buffer_mem_requirements.memoryTypeBits,
-	                                                                       memory_visibility));
+	auto alloc_info = vk::MemoryAllocateInfo()
+	                      .setAllocationSize(buffer_mem_requirements.size)
+	                      .setMemoryTypeIndex(find_memory_type_index(physical_device,
+	                                                                 buffer_mem_requirements.memoryTypeBits,
+	                                                                 memory_visibility));
+
+	// buffers addressed by shaders need memory allocated with device addresses
+	const bool device_address   = bool(usage_flags & vk::BufferUsageFlagBits::eShaderDeviceAddress);
+	const auto alloc_flags_info = vk::MemoryAllocateFlagsInfo().setFlags(vk::MemoryAllocateFlagBits::eDeviceAddress);
+	if (device_address)
+	{
+		alloc_info.setPNext(&alloc_flags_info);
+	}
 
 	buffer_memory_ = logical_device.allocateMemoryUnique(alloc_info);
+	memory_size_   = buffer_mem_requirements.size;
+
+	const uint32_t heap_index = physical_device.getMemoryProperties().memoryTypes[alloc_info.memoryTypeIndex].heapIndex;
+	MemoryTracker::get().register_allocation(buffer_memory_.get(), memory_size_, heap_index);
 
 	// Bind the buffer to the allocated memory
 	logical_device.bindBufferMemory(buffer_handle_.get(), buffer_memory_.get(), 0);
+
+	device_address_ = device_address ? logical_device.getBufferAddress(vk::BufferDeviceAddressInfo().setBuffer(buffer_handle_.get())) : 0;
+}
+
+Buffer::~Buffer()
+{
+	MemoryTracker::get().unregister_allocation(buffer_memory_.get());
+}
+
+vk::DeviceSize Buffer::get_size() const
+{
+	return size_;
+}
+
+vk::DeviceSize Buffer::get_memory_size() const
+{
+	return memory_size_;
+}
+
+vk::DeviceAddress Buffer::get_device_address() const
+{
+	assert(device_address_ != 0);
+	return device_address_;
 }
 }        // namespace lz
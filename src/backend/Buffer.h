@@ -59,11 +59,26 @@ class Buffer
 	Buffer(vk::PhysicalDevice physical_device, vk::Device logical_device, vk::DeviceSize size,
 	       vk::BufferUsageFlags usage_flags, vk::MemoryPropertyFlags memory_visibility);
 
+	// Destructor: Removes the allocation from the memory tracker
+	~Buffer();
+
+	// GetSize: Returns the requested size of the buffer in bytes
+	vk::DeviceSize get_size() const;
+
+	// GetMemorySize: Returns the size of the device memory allocation in bytes
+	vk::DeviceSize get_memory_size() const;
+
+	// GetDeviceAddress: Returns the address shaders reach the buffer at through GL_EXT_buffer_reference
+	// - The buffer must have been created with eShaderDeviceAddress usage
+	vk::DeviceAddress get_device_address() const;
+
   private:
 	vk::UniqueBuffer       buffer_handle_;         // Native Vulkan buffer handle
 	vk::UniqueDeviceMemory buffer_memory_;         // Device memory allocation for this buffer
 	vk::Device             logical_device_;        // Logical device for buffer operations
 	vk::DeviceSize         size_;                  // Size of the buffer in bytes
+	vk::DeviceSize         memory_size_;           // Size of the memory allocation in bytes
+	vk::DeviceAddress      device_address_;        // Shader address, 0 without eShaderDeviceAddress usage
 	void                  *mapped_data_;
 	friend class Core;
 };
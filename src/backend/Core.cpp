@@ -5,7 +5,9 @@
 #include <set>
 #include <vector>
 
+#include "DescriptorBuffer.h"
 #include "DescriptorSetCache.h"
+#include "EngineConfig.h"
 #include "Image.h"
 #include "Logging.h"
 #include "PipelineCache.h"
@@ -18,7 +20,8 @@ namespace lz
 Core::Core(const char **instance_extensions, const uint32_t instance_extensions_count,
            const WindowDesc                *compatible_window_desc,
            const bool                       enable_debugging,
-           const std::vector<const char *> &device_extensions_input)
+           const std::vector<const char *> &device_extensions_input,
+           const std::string               &preferred_device_name)
 {
 	std::vector<const char *> res_instance_extensions(instance_extensions, instance_extensions + instance_extensions_count);
 	std::vector<const char *> validation_layers;
@@ -38,7 +41,7 @@ Core::Core(const char **instance_extensions, const uint32_t instance_extensions_
 		this->debug_utils_messenger_ = create_debug_utils_messenger(instance_.get(), debug_message_callback,
 		                                                            loader_);
 	}
-	this->physical_device_ = find_physical_device(instance_.get());
+	this->physical_device_ = find_physical_device(instance_.get(), preferred_device_name);
 
 	if (compatible_window_desc)
 	{
@@ -69,6 +72,24 @@ Core::Core(const char **instance_extensions, const uint32_t instance_extensions_
 		device_extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
 	}
 
+	// Memory budget, extended dynamic state and descriptor buffers are optional, enable them whenever the device exposes them
+	for (const char *optional_extension : {VK_EXT_MEMORY_BUDGET_EXTENSION_NAME, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME, VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME})
+	{
+		bool has_extension = false;
+		for (const auto &ext : device_extensions)
+		{
+			has_extension |= strcmp(ext, optional_extension) == 0;
+		}
+		for (const auto &ext : physical_device_.enumerateDeviceExtensionProperties())
+		{
+			if (!has_extension && strcmp(ext.extensionName, optional_extension) == 0)
+			{
+				device_extensions.push_back(optional_extension);
+				break;
+			}
+		}
+	}
+
 	this->logical_device_ = create_logical_device(physical_device_, queue_family_indices_, device_extensions, validation_layers);
 	this->graphics_queue_ = get_device_queue(logical_device_.get(), queue_family_indices_.graphics_family_index);
 	this->present_queue_  = get_device_queue(logical_device_.get(), queue_family_indices_.present_family_index);
@@ -76,7 +97,44 @@ Core::Core(const char **instance_extensions, const uint32_t instance_extensions_
 
 	this->descriptor_set_cache_.reset(new lz::DescriptorSetCache(logical_device_.get(), bindless_supported_));
 	this->pipeline_cache_.reset(new lz::PipelineCache(logical_device_.get(), this->descriptor_set_cache_.get()));
-	this->render_graph_.reset(new lz::RenderGraph(physical_device_, logical_device_.get(), loader_));
+	if (extended_dynamic_state_supported_)
+	{
+		this->pipeline_cache_->enable_extended_dynamic_state(loader_);
+	}
+	if (descriptor_buffer_supported_)
+	{
+		this->descriptor_buffer_.reset(new lz::DescriptorBuffer(physical_device_, logical_device_.get(), loader_, MAX_FRAMES_IN_FLIGHT));
+		this->descriptor_set_cache_->set_descriptor_buffer(this->descriptor_buffer_.get());
+		this->pipeline_cache_->enable_descriptor_buffer();
+		LOGI("Compute passes bind their descriptors from a descriptor buffer");
+	}
+	this->shader_compiler_.reset(new lz::ShaderCompiler());
+
+	this->shader_limits_ = lz::ShaderConfig::query_limits(physical_device_, mesh_shader_supported_);
+	this->shader_config_ = lz::ShaderConfig::select(shader_limits_);
+
+	// a profile written by the auto-tuner for this device replaces the selected config
+	const std::string profile_path = lz::ShaderConfig::get_device_profile_path(physical_device_);
+	lz::ShaderConfig  profile_config;
+	if (lz::ShaderConfig::load_profile(profile_path, profile_config))
+	{
+		if (profile_config.fits(shader_limits_))
+		{
+			this->shader_config_ = profile_config;
+			LOGI("Loaded tuned shader config from {}", profile_path);
+		}
+		else
+		{
+			LOGW("Ignoring device profile {}, its shader config does not fit the device limits", profile_path);
+		}
+	}
+
+	this->pipeline_cache_->set_specialization_constants(shader_config_.get_specialization_constants());
+	LOGI("Shader config: task workgroup {}, mesh workgroup {}, compute workgroup {}, meshlets of {} vertices and {} triangles, cone weight {}",
+	     shader_config_.task_workgroup_size, shader_config_.mesh_workgroup_size, shader_config_.compute_workgroup_size,
+	     shader_config_.meshlet_max_vertices, shader_config_.meshlet_max_triangles, shader_config_.meshlet_cone_weight);
+
+	this->render_graph_.reset(new lz::RenderGraph(physical_device_, logical_device_.get(), loader_, this->descriptor_set_cache_.get(), extended_dynamic_state_supported_));
 
 	if (bindless_supported_)
 	{
@@ -194,11 +252,38 @@ lz::DescriptorSetCache *Core::get_descriptor_set_cache() const
 	return descriptor_set_cache_.get();
 }
 
+lz::DescriptorBuffer *Core::get_descriptor_buffer() const
+{
+	return descriptor_buffer_.get();
+}
+
 lz::PipelineCache *Core::get_pipeline_cache() const
 {
 	return pipeline_cache_.get();
 }
 
+lz::ShaderCompiler *Core::get_shader_compiler() const
+{
+	return shader_compiler_.get();
+}
+
+const lz::ShaderConfig &Core::get_shader_config() const
+{
+	return shader_config_;
+}
+
+const lz::ShaderConfig::DeviceLimits &Core::get_shader_limits() const
+{
+	return shader_limits_;
+}
+
+void Core::set_shader_config(const lz::ShaderConfig &shader_config)
+{
+	shader_config_ = shader_config;
+	pipeline_cache_->set_specialization_constants(shader_config_.get_specialization_constants());
+	pipeline_cache_->clear();
+}
+
 bool Core::mesh_shader_supported() const
 {
 	return mesh_shader_supported_;
@@ -214,6 +299,26 @@ bool Core::bindless_supported() const
 	return bindless_supported_;
 }
 
+bool Core::memory_budget_supported() const
+{
+	return memory_budget_supported_;
+}
+
+bool Core::extended_dynamic_state_supported() const
+{
+	return extended_dynamic_state_supported_;
+}
+
+bool Core::descriptor_buffer_supported() const
+{
+	return descriptor_buffer_supported_;
+}
+
+vk::QueryPipelineStatisticFlags Core::get_pipeline_statistic_flags() const
+{
+	return pipeline_statistic_flags_;
+}
+
 void Core::register_material(const std::shared_ptr<lz::Material> &material)
 {
 	if (material_system_)
@@ -222,6 +327,14 @@ void Core::register_material(const std::shared_ptr<lz::Material> &material)
 	}
 }
 
+void Core::release_material(const std::string &material_name)
+{
+	if (material_system_)
+	{
+		material_system_->release_material(material_name);
+	}
+}
+
 void Core::process_pending_material_updates()
 {
 	if (material_system_)
@@ -290,7 +403,7 @@ VKAPI_ATTR VkBool32 VKAPI_CALL Core::debug_message_callback(
 	return VK_FALSE;
 }
 
-vk::PhysicalDevice Core::find_physical_device(const vk::Instance instance)
+vk::PhysicalDevice Core::find_physical_device(const vk::Instance instance, const std::string &preferred_device_name)
 {
 	const std::vector<vk::PhysicalDevice> physical_devices = instance.enumeratePhysicalDevices();
 	LOGI("Found {} physical device(s)", physical_devices.size());
@@ -377,6 +490,12 @@ vk::PhysicalDevice Core::find_physical_device(const vk::Instance instance)
 				break;
 		}
 
+		// a device asked for by name, e.g. a software rasterizer for functional runs, outranks every other
+		if (!preferred_device_name.empty() && std::string(device_properties.deviceName.data()).find(preferred_device_name) != std::string::npos)
+		{
+			score += 100000;
+		}
+
 		// Score based on device limits
 		score += device_properties.limits.maxImageDimension2D / 1024;        // Image dimension limits
 
@@ -569,6 +688,21 @@ vk::UniqueDevice Core::create_logical_device(vk::PhysicalDevice physical_device,
 				{
 					bindless_supported_ = true;
 				}
+
+				if (strcmp(ext_name, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0)
+				{
+					memory_budget_supported_ = true;
+				}
+
+				if (strcmp(ext_name, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME) == 0)
+				{
+					extended_dynamic_state_supported_ = true;
+				}
+
+				if (strcmp(ext_name, VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME) == 0)
+				{
+					descriptor_buffer_supported_ = true;
+				}
 				break;
 			}
 		}
@@ -583,11 +717,22 @@ vk::UniqueDevice Core::create_logical_device(vk::PhysicalDevice physical_device,
 	vk::PhysicalDeviceFeatures device_features;
 	device_features.setMultiDrawIndirect(true);
 
+	// pipeline statistics are optional, the profiler only records them when the device can
+	if (physical_device.getFeatures().pipelineStatisticsQuery)
+	{
+		device_features.setPipelineStatisticsQuery(true);
+		pipeline_statistic_flags_ = vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations |
+		                            vk::QueryPipelineStatisticFlagBits::eClippingPrimitives |
+		                            vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations |
+		                            vk::QueryPipelineStatisticFlagBits::eComputeShaderInvocations;
+	}
+
 	vk::PhysicalDeviceVulkan12Features device_vulkan12_features;
 	device_vulkan12_features.setScalarBlockLayout(true);
 	device_vulkan12_features.setDrawIndirectCount(true);
 	device_vulkan12_features.setStorageBuffer8BitAccess(true);
 	device_vulkan12_features.setSamplerFilterMinmax(true);
+	device_vulkan12_features.setBufferDeviceAddress(true);
 
 	if (bindless_supported_)
 	{
@@ -621,9 +766,49 @@ vk::UniqueDevice Core::create_logical_device(vk::PhysicalDevice physical_device,
 	void *pNext = &device_vulkan12_features;
 	if (mesh_shader_supported_)
 	{
+		auto features_chain = physical_device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceMeshShaderFeaturesEXT>();
+		if (pipeline_statistic_flags_ && features_chain.get<vk::PhysicalDeviceMeshShaderFeaturesEXT>().meshShaderQueries)
+		{
+			mesh_shader_features.setMeshShaderQueries(true);
+			pipeline_statistic_flags_ |= vk::QueryPipelineStatisticFlagBits::eTaskShaderInvocationsEXT |
+			                             vk::QueryPipelineStatisticFlagBits::eMeshShaderInvocationsEXT;
+		}
+
 		mesh_shader_features.pNext = pNext;
 		pNext                      = &mesh_shader_features;
 	}
+
+	vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT extended_dynamic_state_features;
+	if (extended_dynamic_state_supported_)
+	{
+		auto features_chain = physical_device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT>();
+		if (features_chain.get<vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT>().extendedDynamicState)
+		{
+			extended_dynamic_state_features.setExtendedDynamicState(true);
+			extended_dynamic_state_features.pNext = pNext;
+			pNext                                 = &extended_dynamic_state_features;
+		}
+		else
+		{
+			extended_dynamic_state_supported_ = false;
+		}
+	}
+
+	vk::PhysicalDeviceDescriptorBufferFeaturesEXT descriptor_buffer_features;
+	if (descriptor_buffer_supported_)
+	{
+		auto features_chain = physical_device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceDescriptorBufferFeaturesEXT>();
+		if (features_chain.get<vk::PhysicalDeviceDescriptorBufferFeaturesEXT>().descriptorBuffer)
+		{
+			descriptor_buffer_features.setDescriptorBuffer(true);
+			descriptor_buffer_features.pNext = pNext;
+			pNext                            = &descriptor_buffer_features;
+		}
+		else
+		{
+			descriptor_buffer_supported_ = false;
+		}
+	}
 	device_create_info.setPNext(pNext);
 
 	return physical_device.createDeviceUnique(device_create_info);
@@ -1,10 +1,13 @@
 #pragma once
 #include <iostream>
 
+#include "DescriptorBuffer.h"
 #include "DescriptorSetCache.h"
 #include "PipelineCache.h"
 #include "QueueIndices.h"
 #include "RenderGraph.h"
+#include "ShaderCompiler.h"
+#include "ShaderConfig.h"
 #include "Surface.h"
 #include "render/BaseRenderer.h"
 #include "render/MaterialSystem.h"
@@ -24,10 +27,12 @@ class Core
 	// - compatibleWindowDesc: Window descriptor for surface compatibility check
 	// - enableDebugging: Whether to enable Vulkan validation layers
 	// - deviceExtensions: Optional list of device extensions to enable
+	// - preferredDeviceName: Picks the device whose name contains it over the highest scored one, e.g. "llvmpipe"
 	Core(const char **instance_extensions, uint32_t instance_extensions_count,
 	     const WindowDesc                *compatible_window_desc,
 	     bool                             enable_debugging,
-	     const std::vector<const char *> &device_extensions = {});
+	     const std::vector<const char *> &device_extensions     = {},
+	     const std::string               &preferred_device_name = std::string());
 
 	// Destructor: Cleans up Vulkan resources
 	~Core();
@@ -112,9 +117,26 @@ class Core
 	// GetDescriptorSetCache: Returns the descriptor set cache
 	lz::DescriptorSetCache *get_descriptor_set_cache() const;
 
+	// GetDescriptorBuffer: Returns the descriptor buffer compute passes bind their sets from, nullptr without
+	// VK_EXT_descriptor_buffer
+	lz::DescriptorBuffer *get_descriptor_buffer() const;
+
 	// GetPipelineCache: Returns the pipeline cache
 	lz::PipelineCache *get_pipeline_cache() const;
 
+	// GetShaderCompiler: Returns the job queue renderers compile their shaders with
+	lz::ShaderCompiler *get_shader_compiler() const;
+
+	// GetShaderConfig: Returns the workgroup sizes and meshlet limits selected for the device
+	const lz::ShaderConfig &get_shader_config() const;
+
+	// GetShaderLimits: Returns the device limits the shader config has to fit
+	const lz::ShaderConfig::DeviceLimits &get_shader_limits() const;
+
+	// SetShaderConfig: Replaces the shader config and drops the pipelines specialized with the previous one
+	// - The device must be idle, meshlets and shaders built with the previous limits have to be rebuilt by the caller
+	void set_shader_config(const lz::ShaderConfig &shader_config);
+
 	// check if the device supports mesh shader extension
 	bool mesh_shader_supported() const;
 
@@ -122,8 +144,23 @@ class Core
 
 	bool bindless_supported() const;
 
+	// check if VK_EXT_memory_budget is enabled, used by MemoryTracker to query heap budgets
+	bool memory_budget_supported() const;
+
+	// check if VK_EXT_extended_dynamic_state is enabled, pipelines then take cull mode and depth state from the command buffer
+	bool extended_dynamic_state_supported() const;
+
+	// check if VK_EXT_descriptor_buffer is enabled, compute pipelines then bind their sets from the descriptor buffer
+	bool descriptor_buffer_supported() const;
+
+	// statistics the GPU profiler can collect, empty when pipelineStatisticsQuery is not supported
+	vk::QueryPipelineStatisticFlags get_pipeline_statistic_flags() const;
+
 	void register_material(const std::shared_ptr<lz::Material> &material);
 
+	void release_material(const std::string &material_name);
+
+	// Called by the in-flight queue once per frame after the fence of the frame signaled
 	void process_pending_material_updates();
 
 	const vk::UniqueDescriptorSet *get_bindless_descriptor_set() const;
@@ -153,7 +190,7 @@ class Core
 	friend class Swapchain;
 
 	// FindPhysicalDevice: Selects an appropriate physical device
-	vk::PhysicalDevice find_physical_device(vk::Instance instance);
+	vk::PhysicalDevice find_physical_device(vk::Instance instance, const std::string &preferred_device_name);
 
 	// FindQueueFamilyIndices: Finds queue families for graphics and presentation
 	QueueFamilyIndices find_queue_family_indices(vk::PhysicalDevice physical_device, vk::SurfaceKHR surface);
@@ -171,8 +208,13 @@ class Core
 	vk::UniqueCommandPool create_command_pool(vk::Device logical_device, uint32_t family_index);
 
 	// check if the device supports mesh shader extension
-	bool mesh_shader_supported_ = false;
-	bool bindless_supported_    = false;
+	bool mesh_shader_supported_            = false;
+	bool bindless_supported_               = false;
+	bool memory_budget_supported_          = false;
+	bool extended_dynamic_state_supported_ = false;
+	bool descriptor_buffer_supported_      = false;
+
+	vk::QueryPipelineStatisticFlags pipeline_statistic_flags_;
 
 	// Core Vulkan objects
 	vk::UniqueInstance        instance_;
@@ -189,10 +231,14 @@ class Core
 	vk::UniqueHandle<vk::DebugUtilsMessengerEXT, vk::DispatchLoaderDynamic> debug_utils_messenger_;
 
 	// Resource caches and managers
+	std::unique_ptr<lz::DescriptorBuffer>   descriptor_buffer_;
 	std::unique_ptr<lz::DescriptorSetCache> descriptor_set_cache_;
 	std::unique_ptr<lz::PipelineCache>      pipeline_cache_;
+	std::unique_ptr<lz::ShaderCompiler>     shader_compiler_;
 	std::unique_ptr<lz::RenderGraph>        render_graph_;
 
-	QueueFamilyIndices queue_family_indices_;
+	lz::ShaderConfig               shader_config_;
+	lz::ShaderConfig::DeviceLimits shader_limits_;
+	QueueFamilyIndices             queue_family_indices_;
 };
 }        // namespace lz
@@ -1,41 +1,56 @@
 #include "CpuProfiler.h"
 
+#include <algorithm>
+#include <tuple>
+#include <unordered_set>
+
 namespace lz
 {
+CpuProfiler &CpuProfiler::get()
+{
+	static CpuProfiler profiler;
+	return profiler;
+}
+
 CpuProfiler::CpuProfiler()
 {
-	frame_index_ = 0;
+	epoch_                = clock::now();
+	frame_index_          = 0;
+	frame_start_ns_       = 0;
+	dropped_events_count_ = 0;
 }
 
-size_t CpuProfiler::start_task(const std::string &task_name, const uint32_t task_color)
+const char *CpuProfiler::intern_name(const std::string &name)
 {
-	lz::ProfilerTask task;
-	task.color           = task_color;
-	task.name            = task_name;
-	task.start_time      = get_curr_frame_time_seconds();
-	task.end_time        = -1.0;
-	const size_t task_id = profiler_tasks_.size();
-	profiler_tasks_.push_back(task);
-	return task_id;
+	// node based set, element addresses stay valid on insertion
+	static std::mutex                      names_mutex;
+	static std::unordered_set<std::string> names;
+
+	std::lock_guard<std::mutex> lock(names_mutex);
+	return names.insert(name).first->c_str();
 }
 
-ProfilerTask CpuProfiler::end_task(const size_t task_id)
+void CpuProfiler::set_thread_name(const char *name)
 {
-	assert(profiler_tasks_.size() == task_id + 1 && profiler_tasks_.back().end_time < 0.0);
-	profiler_tasks_.back().end_time = get_curr_frame_time_seconds();
-	return profiler_tasks_.back();
+	get_thread_buffer()->name.store(name, std::memory_order_release);
+}
+
+const char *CpuProfiler::get_thread_name(const uint32_t thread_index) const
+{
+	std::lock_guard<std::mutex> lock(buffers_mutex_);
+	return thread_index < buffers_.size() ? buffers_[thread_index]->name.load(std::memory_order_acquire) : nullptr;
 }
 
 size_t CpuProfiler::start_frame()
 {
-	profiler_tasks_.clear();
-	frame_start_time_ = hrc::now();
+	frame_start_ns_ = get_time_ns();
 	return frame_index_;
 }
 
 void CpuProfiler::end_frame(const size_t frame_id)
 {
 	assert(frame_id == frame_index_);
+	gather_events();
 	frame_index_++;
 }
 
@@ -44,20 +59,147 @@ const std::vector<ProfilerTask> &CpuProfiler::get_profiler_tasks()
 	return profiler_tasks_;
 }
 
-double CpuProfiler::get_curr_frame_time_seconds() const
+uint64_t CpuProfiler::get_dropped_events_count() const
+{
+	std::lock_guard<std::mutex> lock(buffers_mutex_);
+	return dropped_events_count_;
+}
+
+void CpuProfiler::end_task(const TaskHandleInfo &task_info)
+{
+	const int64_t end_ns = get_time_ns();
+	ThreadBuffer *buffer = get_thread_buffer();
+	assert(buffer->open_count == task_info.depth + 1);
+	buffer->open_count--;
+
+	const uint64_t event_index = buffer->written_count.load(std::memory_order_relaxed);
+	Event         &event       = buffer->events[event_index % ThreadBuffer::events_capacity];
+	event.name                 = task_info.name;
+	event.color                = task_info.color;
+	event.depth                = task_info.depth;
+	event.start_ns             = task_info.start_ns;
+	event.end_ns               = end_ns;
+	buffer->written_count.store(event_index + 1, std::memory_order_release);
+}
+
+int64_t CpuProfiler::get_time_ns() const
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - epoch_).count();
+}
+
+CpuProfiler::ThreadBuffer *CpuProfiler::get_thread_buffer()
 {
-	return double(std::chrono::duration_cast<std::chrono::microseconds>(hrc::now() - frame_start_time_).count()) / 1e6;
+	// hands the buffer back when the thread exits, gather_events() frees it once it is drained
+	struct ThreadSlot
+	{
+		ThreadBuffer *buffer = nullptr;
+
+		~ThreadSlot()
+		{
+			if (buffer)
+			{
+				buffer->retired.store(true, std::memory_order_release);
+			}
+		}
+	};
+	static thread_local ThreadSlot slot;
+
+	if (!slot.buffer)
+	{
+		std::lock_guard<std::mutex> lock(buffers_mutex_);
+		for (auto &buffer : buffers_)
+		{
+			if (buffer->is_free)
+			{
+				buffer->is_free    = false;
+				buffer->open_count = 0;
+				buffer->name.store(nullptr, std::memory_order_relaxed);
+				buffer->retired.store(false, std::memory_order_relaxed);
+				slot.buffer = buffer.get();
+				break;
+			}
+		}
+		if (!slot.buffer)
+		{
+			buffers_.push_back(std::make_unique<ThreadBuffer>());
+			slot.buffer = buffers_.back().get();
+		}
+	}
+	return slot.buffer;
+}
+
+void CpuProfiler::gather_events()
+{
+	std::lock_guard<std::mutex> lock(buffers_mutex_);
+
+	profiler_tasks_.clear();
+	for (size_t buffer_index = 0; buffer_index < buffers_.size(); buffer_index++)
+	{
+		auto &buffer = *buffers_[buffer_index];
+		if (buffer.is_free)
+		{
+			continue;
+		}
+
+		// retired is read first, every event of a retired thread is then covered by written_count
+		const bool     retired       = buffer.retired.load(std::memory_order_acquire);
+		const uint64_t written_count = buffer.written_count.load(std::memory_order_acquire);
+
+		uint64_t first_index = buffer.read_count;
+		if (written_count - first_index > ThreadBuffer::events_capacity)
+		{
+			first_index = written_count - ThreadBuffer::events_capacity;
+		}
+
+		const size_t first_task_index = profiler_tasks_.size();
+		for (uint64_t event_index = first_index; event_index < written_count; event_index++)
+		{
+			const Event event = buffer.events[event_index % ThreadBuffer::events_capacity];
+
+			lz::ProfilerTask task;
+			task.name         = event.name;
+			task.color        = event.color;
+			task.thread_index = uint32_t(buffer_index);
+			task.depth        = event.depth;
+			task.start_time   = double(std::max<int64_t>(event.start_ns - frame_start_ns_, 0)) / 1e9;
+			task.end_time     = std::max(double(event.end_ns - frame_start_ns_) / 1e9, task.start_time);
+			profiler_tasks_.push_back(task);
+		}
+
+		// events the thread wrapped around onto while they were copied may be torn, drop them, this includes the slot of
+		// the event it may be writing right now, which written_count does not cover yet
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const uint64_t rewritten_count = buffer.written_count.load(std::memory_order_relaxed);
+		if (rewritten_count + 1 - first_index > ThreadBuffer::events_capacity)
+		{
+			const uint64_t torn_count = std::min(rewritten_count + 1 - ThreadBuffer::events_capacity, written_count) - first_index;
+			profiler_tasks_.erase(profiler_tasks_.begin() + first_task_index, profiler_tasks_.begin() + first_task_index + torn_count);
+			first_index += torn_count;
+		}
+
+		dropped_events_count_ += first_index - buffer.read_count;
+		buffer.read_count = written_count;
+		buffer.is_free    = retired;
+	}
+
+	std::sort(profiler_tasks_.begin(), profiler_tasks_.end(), [](const ProfilerTask &left, const ProfilerTask &right) {
+		return std::tie(left.thread_index, left.start_time, left.depth) < std::tie(right.thread_index, right.start_time, right.depth);
+	});
 }
 
-CpuProfiler::TaskHandleInfo::TaskHandleInfo(CpuProfiler *profiler, const size_t task_id)
+CpuProfiler::TaskHandleInfo::TaskHandleInfo(CpuProfiler *profiler, const char *name, const uint32_t color,
+                                            const uint32_t depth, const int64_t start_ns)
 {
 	this->profiler = profiler;
-	this->task_id  = task_id;
+	this->name     = name;
+	this->color    = color;
+	this->depth    = depth;
+	this->start_ns = start_ns;
 }
 
 void CpuProfiler::TaskHandleInfo::reset() const
 {
-	profiler->end_task(task_id);
+	profiler->end_task(*this);
 }
 
 CpuProfiler::FrameHandleInfo::FrameHandleInfo(CpuProfiler *profiler, const size_t frame_id)
@@ -71,9 +213,15 @@ void CpuProfiler::FrameHandleInfo::reset() const
 	profiler->end_frame(frame_id);
 }
 
-CpuProfiler::ScopedTask CpuProfiler::start_scoped_task(const std::string &task_name, uint32_t task_color)
+CpuProfiler::ScopedTask CpuProfiler::start_scoped_task(const char *task_name, const uint32_t task_color)
+{
+	const uint32_t depth = get_thread_buffer()->open_count++;
+	return ScopedTask(TaskHandleInfo(this, task_name, task_color, depth, get_time_ns()), true);
+}
+
+CpuProfiler::ScopedTask CpuProfiler::start_scoped_task(const std::string &task_name, const uint32_t task_color)
 {
-	return ScopedTask(TaskHandleInfo(this, start_task(task_name, task_color)), true);
+	return start_scoped_task(intern_name(task_name), task_color);
 }
 
 CpuProfiler::ScopedFrame CpuProfiler::start_scoped_frame()
@@ -1,7 +1,11 @@
 #pragma once
 #include "Handles.h"
 #include <assert.h>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #include "ProfilerTask.h"
@@ -9,31 +13,79 @@
 
 namespace lz
 {
+// CpuProfiler: Records nested CPU tasks from any thread into per-thread event buffers
+// - Recording is lock-free, a task is written to the buffer of its thread when it ends
+// - Task names are not copied, pass string literals or names returned by intern_name()
+// - end_frame() gathers the tasks of every thread that ended during the frame,
+//   tasks of other threads are clamped to the frame they ended in
+// - Threads are numbered by buffer slot, the slot of a thread that exited is reused by the next new thread
 class CpuProfiler
 {
   public:
-	CpuProfiler();
+	// Get: Returns the process-wide profiler, loaders and worker threads have no access to InFlightQueue
+	static CpuProfiler &get();
+
+	// InternName: Returns a copy of the name that lives until exit, equal names share one copy
+	static const char *intern_name(const std::string &name);
 
-	size_t start_task(const std::string &task_name, uint32_t task_color);
+	// SetThreadName: Names the calling thread in reports, App names the main thread first so it is thread 0
+	void set_thread_name(const char *name);
 
-	ProfilerTask end_task(size_t task_id);
+	// GetThreadName: Returns the name of a thread slot, nullptr for unnamed threads
+	const char *get_thread_name(uint32_t thread_index) const;
 
 	size_t start_frame();
 
 	void end_frame(size_t frame_id);
 
+	// GetProfilerTasks: Tasks of the last ended frame sorted by thread, then start time, then depth
 	const std::vector<ProfilerTask> &get_profiler_tasks();
 
+	// GetDroppedEventsCount: Tasks lost because a thread recorded more than a buffer holds between two frames
+	uint64_t get_dropped_events_count() const;
+
   private:
-	double get_curr_frame_time_seconds() const;
+	CpuProfiler();
+
+	using clock = std::chrono::steady_clock;
+
+	struct Event
+	{
+		const char *name;
+		uint32_t    color;
+		uint32_t    depth;
+		int64_t     start_ns;
+		int64_t     end_ns;
+	};
+
+	// ThreadBuffer: Ring of ended tasks, written by its thread and read by end_frame()
+	struct ThreadBuffer
+	{
+		static constexpr size_t events_capacity = 4096;
+
+		std::array<Event, events_capacity> events;
+		std::atomic<uint64_t>              written_count{0};
+		std::atomic<const char *>          name{nullptr};
+		std::atomic<bool>                  retired{false};        // set when the owning thread exits
+
+		// touched by the owning thread only
+		uint32_t open_count = 0;
+
+		// touched by the reader only, under buffers_mutex_
+		uint64_t read_count = 0;
+		bool     is_free    = false;
+	};
 
 	struct TaskHandleInfo
 	{
-		TaskHandleInfo(CpuProfiler *profiler, size_t task_id);
+		TaskHandleInfo(CpuProfiler *profiler, const char *name, uint32_t color, uint32_t depth, int64_t start_ns);
 
 		void         reset() const;
 		CpuProfiler *profiler;
-		size_t       task_id;
+		const char  *name;
+		uint32_t     color;
+		uint32_t     depth;
+		int64_t      start_ns;
 	};
 	struct FrameHandleInfo
 	{
@@ -44,17 +96,30 @@ class CpuProfiler
 		size_t       frame_id;
 	};
 
+	void end_task(const TaskHandleInfo &task_info);
+
+	int64_t get_time_ns() const;
+
+	ThreadBuffer *get_thread_buffer();
+
+	void gather_events();
+
   public:
 	using ScopedTask = UniqueHandle<TaskHandleInfo, CpuProfiler>;
+	ScopedTask start_scoped_task(const char *task_name, uint32_t task_color);
 	ScopedTask start_scoped_task(const std::string &task_name, uint32_t task_color);
 	using ScopedFrame = UniqueHandle<FrameHandleInfo, CpuProfiler>;
 	ScopedFrame start_scoped_frame();
 
   private:
-	using hrc = std::chrono::high_resolution_clock;
+	clock::time_point             epoch_;
 	size_t                        frame_index_;
+	int64_t                       frame_start_ns_;
 	std::vector<lz::ProfilerTask> profiler_tasks_;
-	hrc::time_point               frame_start_time_;
+
+	mutable std::mutex                         buffers_mutex_;
+	std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+	uint64_t                                   dropped_events_count_;
 	friend struct UniqueHandle<TaskHandleInfo, CpuProfiler>;
 };
 }        // namespace lz
@@ -0,0 +1,217 @@
+#include "DescriptorBuffer.h"
+
+#include "DescriptorSetCache.h"
+#include "EngineConfig.h"
+#include "ImageView.h"
+#include "Logging.h"
+#include "MemoryTracker.h"
+#include "Sampler.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace lz
+{
+namespace
+{
+vk::DeviceSize align_offset(vk::DeviceSize offset, vk::DeviceSize alignment)
+{
+	return (offset + alignment - 1) / alignment * alignment;
+}
+}        // namespace
+
+DescriptorBuffer::DescriptorBuffer(vk::PhysicalDevice physical_device, vk::Device logical_device, const vk::DispatchLoaderDynamic &loader, uint32_t frames_count) :
+    physical_device_(physical_device),
+    logical_device_(logical_device),
+    loader_(loader),
+    properties_(physical_device.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceDescriptorBufferPropertiesEXT>()
+                    .get<vk::PhysicalDeviceDescriptorBufferPropertiesEXT>()),
+    ring_(frames_count, properties_.descriptorBufferOffsetAlignment, DESCRIPTOR_BUFFER_INITIAL_BLOCK_SIZE,
+          [this](vk::DeviceSize size) { return create_block(size); })
+{
+}
+
+DescriptorBuffer::~DescriptorBuffer()
+{
+	ring_.release([](std::vector<Block> &blocks) { release_blocks(blocks); });
+}
+
+void DescriptorBuffer::begin_frame(uint32_t frame_index)
+{
+	ring_.begin_frame(
+	    frame_index, [this](vk::DeviceSize size) { return create_block(size); },
+	    [](std::vector<Block> &blocks) { release_blocks(blocks); });
+}
+
+size_t DescriptorBuffer::bind_set(vk::CommandBuffer                command_buffer,
+                                  vk::PipelineBindPoint            bind_point,
+                                  vk::PipelineLayout               pipeline_layout,
+                                  uint32_t                         set_index,
+                                  vk::DescriptorSetLayout          set_layout,
+                                  const lz::DescriptorSetBindings &set_bindings,
+                                  const std::vector<uint32_t>     &dynamic_offsets)
+{
+	LayoutInfo &layout_info = get_layout_info(set_layout);
+
+	const auto   allocation  = ring_.allocate_set(command_buffer, bind_point, pipeline_layout, set_index, layout_info.size,
+	                                              [this](vk::DeviceSize size) { return create_block(size); });
+	const size_t descriptors = write_descriptors(allocation.data, layout_info, set_bindings, dynamic_offsets);
+
+	if (allocation.bind_block)
+	{
+		bind_block(command_buffer);
+	}
+	else
+	{
+		const uint32_t buffer_index = 0;
+		command_buffer.setDescriptorBufferOffsetsEXT(bind_point, pipeline_layout, set_index, buffer_index, allocation.offset, loader_);
+	}
+	return descriptors;
+}
+
+void DescriptorBuffer::clear_layouts()
+{
+	layout_infos_.clear();
+}
+
+vk::DeviceSize DescriptorBuffer::get_allocated_size() const
+{
+	return ring_.get_allocated_size();
+}
+
+DescriptorBuffer::LayoutInfo &DescriptorBuffer::get_layout_info(vk::DescriptorSetLayout set_layout)
+{
+	auto it = layout_infos_.find(set_layout);
+	if (it == layout_infos_.end())
+	{
+		LayoutInfo layout_info;
+		layout_info.layout = set_layout;
+		layout_info.size   = align_offset(logical_device_.getDescriptorSetLayoutSizeEXT(set_layout, loader_), properties_.descriptorBufferOffsetAlignment);
+		it                 = layout_infos_.emplace(set_layout, layout_info).first;
+	}
+	return it->second;
+}
+
+vk::DeviceSize DescriptorBuffer::get_binding_offset(LayoutInfo &layout_info, uint32_t binding)
+{
+	auto it = layout_info.binding_offsets.find(binding);
+	if (it == layout_info.binding_offsets.end())
+	{
+		it = layout_info.binding_offsets.emplace(binding, logical_device_.getDescriptorSetLayoutBindingOffsetEXT(layout_info.layout, binding, loader_)).first;
+	}
+	return it->second;
+}
+
+void DescriptorBuffer::bind_block(vk::CommandBuffer command_buffer)
+{
+	const Block &block        = ring_.get_current_block();
+	const auto   binding_info = vk::DescriptorBufferBindingInfoEXT()
+	                              .setAddress(block.buffer->get_device_address())
+	                              .setUsage(vk::BufferUsageFlagBits::eResourceDescriptorBufferEXT | vk::BufferUsageFlagBits::eSamplerDescriptorBufferEXT);
+	command_buffer.bindDescriptorBuffersEXT(binding_info, loader_);
+
+	// replayed in the order they were bound so sets disturbed by an incompatible layout stay disturbed, the set being
+	// bound is the last one
+	const uint32_t buffer_index = 0;
+	for (const auto &bound_set : ring_.get_bound_sets())
+	{
+		command_buffer.setDescriptorBufferOffsetsEXT(bound_set.bind_point, bound_set.pipeline_layout, bound_set.set_index, buffer_index, bound_set.offset, loader_);
+	}
+}
+
+size_t DescriptorBuffer::write_descriptors(char *dst, LayoutInfo &layout_info, const lz::DescriptorSetBindings &set_bindings,
+                                           const std::vector<uint32_t> &dynamic_offsets)
+{
+	const auto get_binding_dst = [&](uint32_t binding) {
+		return dst + get_binding_offset(layout_info, binding);
+	};
+
+	// dynamic offsets follow the binding order of the uniform buffers, as for bindDescriptorSets
+	assert(dynamic_offsets.size() == set_bindings.uniform_buffer_bindings.size());
+	std::vector<const lz::UniformBufferBinding *> uniform_bindings;
+	for (const auto &uniform_binding : set_bindings.uniform_buffer_bindings)
+	{
+		uniform_bindings.push_back(&uniform_binding);
+	}
+	std::sort(uniform_bindings.begin(), uniform_bindings.end(), [](const lz::UniformBufferBinding *a, const lz::UniformBufferBinding *b) {
+		return a->shader_binding_id < b->shader_binding_id;
+	});
+	for (size_t uniform_index = 0; uniform_index < uniform_bindings.size(); uniform_index++)
+	{
+		const auto &uniform_binding = *uniform_bindings[uniform_index];
+		const auto  address_info    = vk::DescriptorAddressInfoEXT()
+		                              .setAddress(uniform_binding.buffer->get_device_address() + uniform_binding.offset + dynamic_offsets[uniform_index])
+		                              .setRange(uniform_binding.size);
+		const auto get_info = vk::DescriptorGetInfoEXT()
+		                          .setType(vk::DescriptorType::eUniformBuffer)
+		                          .setData(vk::DescriptorDataEXT().setPUniformBuffer(&address_info));
+		write_descriptor(get_binding_dst(uniform_binding.shader_binding_id), get_info, properties_.uniformBufferDescriptorSize);
+	}
+
+	for (const auto &storage_binding : set_bindings.storage_buffer_bindings)
+	{
+		const vk::DeviceSize range        = storage_binding.size == VK_WHOLE_SIZE ? storage_binding.buffer->get_size() - storage_binding.offset : storage_binding.size;
+		const auto           address_info = vk::DescriptorAddressInfoEXT()
+		                              .setAddress(storage_binding.buffer->get_device_address() + storage_binding.offset)
+		                              .setRange(range);
+		const auto get_info = vk::DescriptorGetInfoEXT()
+		                          .setType(vk::DescriptorType::eStorageBuffer)
+		                          .setData(vk::DescriptorDataEXT().setPStorageBuffer(&address_info));
+		write_descriptor(get_binding_dst(storage_binding.shader_binding_id), get_info, properties_.storageBufferDescriptorSize);
+	}
+
+	for (const auto &image_sampler_binding : set_bindings.image_sampler_bindings)
+	{
+		const auto image_info = vk::DescriptorImageInfo()
+		                            .setImageView(image_sampler_binding.image_view->get_handle())
+		                            .setSampler(image_sampler_binding.sampler->get_handle())
+		                            .setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+		const auto get_info = vk::DescriptorGetInfoEXT()
+		                          .setType(vk::DescriptorType::eCombinedImageSampler)
+		                          .setData(vk::DescriptorDataEXT().setPCombinedImageSampler(&image_info));
+		write_descriptor(get_binding_dst(image_sampler_binding.shader_binding_id), get_info, properties_.combinedImageSamplerDescriptorSize);
+	}
+
+	for (const auto &storage_image_binding : set_bindings.storage_image_bindings)
+	{
+		const auto image_info = vk::DescriptorImageInfo()
+		                            .setImageView(storage_image_binding.image_view->get_handle())
+		                            .setImageLayout(vk::ImageLayout::eGeneral);
+		const auto get_info = vk::DescriptorGetInfoEXT()
+		                          .setType(vk::DescriptorType::eStorageImage)
+		                          .setData(vk::DescriptorDataEXT().setPStorageImage(&image_info));
+		write_descriptor(get_binding_dst(storage_image_binding.shader_binding_id), get_info, properties_.storageImageDescriptorSize);
+	}
+
+	return set_bindings.uniform_buffer_bindings.size() + set_bindings.storage_buffer_bindings.size() +
+	       set_bindings.image_sampler_bindings.size() + set_bindings.storage_image_bindings.size();
+}
+
+void DescriptorBuffer::write_descriptor(char *dst, const vk::DescriptorGetInfoEXT &get_info, size_t descriptor_size)
+{
+	logical_device_.getDescriptorEXT(&get_info, descriptor_size, dst, loader_);
+}
+
+DescriptorBuffer::Block DescriptorBuffer::create_block(vk::DeviceSize size)
+{
+	MemoryTracker::ScopedCategory memory_category(MemoryCategory::eShaderMemory);
+	LOGD("Descriptor buffer allocates a block of {} bytes", size);
+
+	Block block;
+	block.size   = size;
+	block.buffer = std::make_unique<lz::Buffer>(
+	    physical_device_, logical_device_, size,
+	    vk::BufferUsageFlagBits::eResourceDescriptorBufferEXT | vk::BufferUsageFlagBits::eSamplerDescriptorBufferEXT | vk::BufferUsageFlagBits::eShaderDeviceAddress,
+	    vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+	block.mapped_data = static_cast<char *>(block.buffer->map());
+	return block;
+}
+
+void DescriptorBuffer::release_blocks(std::vector<Block> &blocks)
+{
+	for (auto &block : blocks)
+	{
+		block.buffer->unmap();
+	}
+}
+}        // namespace lz
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "Buffer.h"
+#include "Config.h"
+#include "DescriptorRing.h"
+#include "ShaderProgram.h"
+
+#include <map>
+
+namespace lz
+{
+struct DescriptorSetBindings;
+
+// DescriptorBuffer: Per-frame ring of descriptors written straight into host visible memory, VK_EXT_descriptor_buffer
+// - Sets are never allocated or cached, every bind writes the descriptors of the set at the next aligned offset of the
+//   ring and points the set index of the bound pipeline at it
+// - Every frame in flight owns a chain of persistently mapped blocks that is rewound when the frame begins, a set that
+//   does not fit moves to the next block of the chain, a new block twice the size is added if needed
+// - A frame that needed several blocks gets them merged into one large enough block the next time it begins
+// - Only layouts created with eDescriptorBufferEXT and pipelines created with eDescriptorBufferEXT can use it, uniform
+//   buffers are plain eUniformBuffer descriptors with the dynamic offset folded into their address
+// - The chain and bound set bookkeeping lives in DescriptorRing, this class creates the buffers and writes the descriptors
+class DescriptorBuffer
+{
+  public:
+	DescriptorBuffer(vk::PhysicalDevice physical_device, vk::Device logical_device, const vk::DispatchLoaderDynamic &loader, uint32_t frames_count);
+	~DescriptorBuffer();
+
+	// BeginFrame: Rewinds the chain of the given frame, its previous GPU work must be complete
+	void begin_frame(uint32_t frame_index);
+
+	// BindSet: Writes the descriptors of a set into the ring and binds them to set_index of the pipeline layout
+	// - dynamic_offsets: One per uniform buffer binding in binding order, the way bindDescriptorSets takes them
+	// Returns: Number of descriptors written
+	size_t bind_set(vk::CommandBuffer                command_buffer,
+	                vk::PipelineBindPoint            bind_point,
+	                vk::PipelineLayout               pipeline_layout,
+	                uint32_t                         set_index,
+	                vk::DescriptorSetLayout          set_layout,
+	                const lz::DescriptorSetBindings &set_bindings,
+	                const std::vector<uint32_t>     &dynamic_offsets);
+
+	// ClearLayouts: Forgets the sizes and binding offsets queried for layouts, called when the layouts are destroyed
+	void clear_layouts();
+
+	// GetAllocatedSize: Returns the total size of all blocks of all frames
+	vk::DeviceSize get_allocated_size() const;
+
+  private:
+	struct Block
+	{
+		std::unique_ptr<lz::Buffer> buffer;
+		char                       *mapped_data;
+		vk::DeviceSize              size;
+	};
+
+	// LayoutInfo: Size of a set of the layout in the ring and the offset of every binding in it
+	struct LayoutInfo
+	{
+		vk::DescriptorSetLayout            layout;
+		vk::DeviceSize                     size;
+		std::map<uint32_t, vk::DeviceSize> binding_offsets;
+	};
+
+	LayoutInfo    &get_layout_info(vk::DescriptorSetLayout set_layout);
+	vk::DeviceSize get_binding_offset(LayoutInfo &layout_info, uint32_t binding);
+	void           bind_block(vk::CommandBuffer command_buffer);
+	size_t         write_descriptors(char *dst, LayoutInfo &layout_info, const lz::DescriptorSetBindings &set_bindings,
+	                                 const std::vector<uint32_t> &dynamic_offsets);
+	void           write_descriptor(char *dst, const vk::DescriptorGetInfoEXT &get_info, size_t descriptor_size);
+	Block          create_block(vk::DeviceSize size);
+	static void    release_blocks(std::vector<Block> &blocks);
+
+	vk::PhysicalDevice        physical_device_;
+	vk::Device                logical_device_;
+	vk::DispatchLoaderDynamic loader_;
+
+	vk::PhysicalDeviceDescriptorBufferPropertiesEXT properties_;
+
+	lz::DescriptorRing<Block>                     ring_;
+	std::map<vk::DescriptorSetLayout, LayoutInfo> layout_infos_;
+};
+}        // namespace lz
@@ -0,0 +1,229 @@
+#pragma once
+
+#include "Config.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace lz
+{
+// DescriptorRing: Per-frame chains of descriptor blocks and the sets bound from them, the bookkeeping of DescriptorBuffer
+// - Every frame in flight owns a chain of mapped blocks that is rewound when the frame begins, every set gets the next
+//   aligned range of the current block
+// - A set that does not fit moves to the next block of the chain, a new block twice the size is added if needed, the sets
+//   already bound in the command buffer are copied along since binding another block invalidates their offsets
+// - A frame that needed several blocks gets them merged into one large enough block the next time it begins
+// - Block needs char *mapped_data and vk::DeviceSize size members, blocks are made and freed by the caller's callbacks so
+//   nothing here touches the device
+template <typename Block>
+class DescriptorRing
+{
+  public:
+	// BoundSet: Set of the current command buffer living in the current block, rebound if the chain moves on
+	struct BoundSet
+	{
+		vk::PipelineBindPoint bind_point;
+		vk::PipelineLayout    pipeline_layout;
+		uint32_t              set_index;
+		vk::DeviceSize        offset;
+		vk::DeviceSize        size;
+	};
+
+	struct Allocation
+	{
+		char          *data;               // where the descriptors of the set are written
+		vk::DeviceSize offset;             // offset of the set in the current block
+		bool           bind_block;         // the current block has to be bound and get_bound_sets() replayed
+	};
+
+	template <typename CreateFunc>
+	DescriptorRing(uint32_t frames_count, vk::DeviceSize alignment, vk::DeviceSize initial_block_size, CreateFunc &&create) :
+	    alignment_(alignment),
+	    initial_block_size_(initial_block_size)
+	{
+		frames_.resize(frames_count);
+		for (auto &frame : frames_)
+		{
+			frame.blocks.push_back(create(initial_block_size_));
+		}
+
+		// sets bound before the first frame begins, e.g. by an ExecuteOnceQueue, use the chain of the first frame
+		curr_frame_ = &frames_[0];
+	}
+
+	// BeginFrame: Rewinds the chain of the given frame, create makes a Block of a size and release frees a vector of them
+	template <typename CreateFunc, typename ReleaseFunc>
+	void begin_frame(uint32_t frame_index, CreateFunc &&create, ReleaseFunc &&release_blocks)
+	{
+		FrameChain &chain = frames_[frame_index];
+
+		if (chain.blocks.size() > 1)
+		{
+			// the frame overflowed its first block last time, merge the chain into one block with some headroom
+			vk::DeviceSize merged_size = initial_block_size_;
+			while (merged_size < chain.used_size + chain.used_size / 4)
+			{
+				merged_size *= 2;
+			}
+			release_blocks(chain.blocks);
+			chain.blocks.clear();
+			chain.blocks.push_back(create(merged_size));
+		}
+
+		chain.used_size        = 0;
+		curr_frame_            = &chain;
+		curr_block_index_      = 0;
+		prev_blocks_used_size_ = 0;
+		curr_offset_           = 0;
+
+		// command buffers are reused by later frames, nothing is bound in them until the first set of the frame
+		bound_command_buffer_ = nullptr;
+		bound_block_index_    = size_t(-1);
+		bound_sets_.clear();
+	}
+
+	// AllocateSet: Range of a set of size bytes bound to set_index of the pipeline layout in command_buffer, the set
+	// becomes the last of get_bound_sets()
+	template <typename CreateFunc>
+	Allocation allocate_set(vk::CommandBuffer     command_buffer,
+	                        vk::PipelineBindPoint bind_point,
+	                        vk::PipelineLayout    pipeline_layout,
+	                        uint32_t              set_index,
+	                        vk::DeviceSize        size,
+	                        CreateFunc          &&create)
+	{
+		if (command_buffer != bound_command_buffer_)
+		{
+			bound_command_buffer_ = command_buffer;
+			bound_block_index_    = size_t(-1);
+			bound_sets_.clear();
+		}
+
+		// a set replaced by this bind does not have to move along with the others
+		bound_sets_.erase(std::remove_if(bound_sets_.begin(), bound_sets_.end(), [&](const BoundSet &bound_set) {
+			                  return bound_set.bind_point == bind_point && bound_set.set_index == set_index;
+		                  }),
+		                  bound_sets_.end());
+
+		vk::DeviceSize offset = align_offset(curr_offset_);
+		if (offset + size > curr_frame_->blocks[curr_block_index_].size)
+		{
+			move_to_next_block(size, create);
+			offset = align_offset(curr_offset_);
+		}
+		curr_offset_           = offset + size;
+		curr_frame_->used_size = prev_blocks_used_size_ + curr_offset_;
+		bound_sets_.push_back({bind_point, pipeline_layout, set_index, offset, size});
+
+		Allocation allocation;
+		allocation.data       = curr_frame_->blocks[curr_block_index_].mapped_data + offset;
+		allocation.offset     = offset;
+		allocation.bind_block = bound_block_index_ != curr_block_index_;
+		bound_block_index_    = curr_block_index_;
+		return allocation;
+	}
+
+	// Release: Frees the blocks of every frame
+	template <typename ReleaseFunc>
+	void release(ReleaseFunc &&release_blocks)
+	{
+		for (auto &frame : frames_)
+		{
+			release_blocks(frame.blocks);
+			frame.blocks.clear();
+		}
+	}
+
+	// GetBoundSets: Sets bound in the current command buffer in the order they were bound, replayed after a block bind so
+	// sets disturbed by an incompatible layout stay disturbed
+	const std::vector<BoundSet> &get_bound_sets() const
+	{
+		return bound_sets_;
+	}
+
+	// GetCurrentBlock: Block the last set was allocated from
+	const Block &get_current_block() const
+	{
+		return curr_frame_->blocks[curr_block_index_];
+	}
+
+	size_t get_blocks_count(uint32_t frame_index) const
+	{
+		return frames_[frame_index].blocks.size();
+	}
+
+	vk::DeviceSize get_allocated_size() const
+	{
+		vk::DeviceSize allocated_size = 0;
+		for (const auto &frame : frames_)
+		{
+			for (const auto &block : frame.blocks)
+			{
+				allocated_size += block.size;
+			}
+		}
+		return allocated_size;
+	}
+
+  private:
+	struct FrameChain
+	{
+		std::vector<Block> blocks;
+		vk::DeviceSize     used_size = 0;
+	};
+
+	vk::DeviceSize align_offset(vk::DeviceSize offset) const
+	{
+		return (offset + alignment_ - 1) / alignment_ * alignment_;
+	}
+
+	template <typename CreateFunc>
+	void move_to_next_block(vk::DeviceSize required_size, CreateFunc &&create)
+	{
+		// binding another buffer invalidates the offsets of the sets already bound, they are copied along and rebound
+		vk::DeviceSize moved_size = required_size;
+		for (const auto &bound_set : bound_sets_)
+		{
+			moved_size += bound_set.size;
+		}
+
+		prev_blocks_used_size_ += curr_offset_;
+		curr_block_index_++;
+		if (curr_block_index_ == curr_frame_->blocks.size())
+		{
+			vk::DeviceSize block_size = curr_frame_->blocks.back().size * 2;
+			while (block_size < moved_size)
+			{
+				block_size *= 2;
+			}
+			curr_frame_->blocks.push_back(create(block_size));
+		}
+		curr_offset_ = 0;
+
+		// the push_back may have moved the blocks, not their mapped memory
+		const char  *prev_block_data = curr_frame_->blocks[curr_block_index_ - 1].mapped_data;
+		const Block &next_block      = curr_frame_->blocks[curr_block_index_];
+		assert(next_block.size >= moved_size);
+		for (auto &bound_set : bound_sets_)
+		{
+			const vk::DeviceSize offset = align_offset(curr_offset_);
+			std::copy_n(prev_block_data + bound_set.offset, bound_set.size, next_block.mapped_data + offset);
+			bound_set.offset = offset;
+			curr_offset_     = offset + bound_set.size;
+		}
+	}
+
+	vk::DeviceSize          alignment_;
+	vk::DeviceSize          initial_block_size_;
+	std::vector<FrameChain> frames_;
+	FrameChain             *curr_frame_            = nullptr;
+	size_t                  curr_block_index_      = 0;
+	vk::DeviceSize          prev_blocks_used_size_ = 0;
+	vk::DeviceSize          curr_offset_           = 0;
+
+	vk::CommandBuffer     bound_command_buffer_ = nullptr;
+	size_t                bound_block_index_    = size_t(-1);
+	std::vector<BoundSet> bound_sets_;
+};
+}        // namespace lz
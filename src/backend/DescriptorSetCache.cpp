@@ -1,5 +1,6 @@
 #include "DescriptorSetCache.h"
 
+#include "DescriptorBuffer.h"
 #include "ImageView.h"
 #include "Sampler.h"
 #include "ShaderProgram.h"
@@ -38,7 +39,8 @@ DescriptorSetBindings &DescriptorSetBindings::set_storage_image_bindings(
 }
 
 DescriptorSetCache::DescriptorSetCache(const vk::Device logical_device, bool bindless_supported) :
-    logical_device_(logical_device)
+    logical_device_(logical_device),
+    descriptor_buffer_(nullptr)
 {
 	std::vector<vk::DescriptorPoolSize> pool_sizes;
 
@@ -87,9 +89,12 @@ static uint32_t check_for_bindless_resources(uint32_t set_id, uint32_t set_bindi
 }
 
 vk::DescriptorSetLayout DescriptorSetCache::get_descriptor_set_layout(
-    const lz::DescriptorSetLayoutKey &descriptor_set_layout_key)
+    const lz::DescriptorSetLayoutKey &descriptor_set_layout_key, bool descriptor_buffer)
 {
-	auto &descriptor_set_layout = descriptor_set_layout_cache_[descriptor_set_layout_key];
+	// the bindless set is updated after bind, which descriptor buffers have no equivalent for
+	assert(!descriptor_buffer || descriptor_set_layout_key.get_set_id() != BINDLESS_SET_ID);
+
+	auto &descriptor_set_layout = descriptor_buffer ? descriptor_buffer_layout_cache_[descriptor_set_layout_key] : descriptor_set_layout_cache_[descriptor_set_layout_key];
 	bool  has_bindless          = false;
 	if (!descriptor_set_layout)
 	{
@@ -107,7 +112,7 @@ vk::DescriptorSetLayout DescriptorSetCache::get_descriptor_set_layout(
 			auto buffer_layout_binding = vk::DescriptorSetLayoutBinding()
 			                                 .setBinding(buffer_info.shader_binding_index)
 			                                 .setDescriptorCount(descriptor_count)        // if this is an array of buffers
-			                                 .setDescriptorType(vk::DescriptorType::eUniformBufferDynamic)
+			                                 .setDescriptorType(descriptor_buffer ? vk::DescriptorType::eUniformBuffer : vk::DescriptorType::eUniformBufferDynamic)
 			                                 .setStageFlags(buffer_info.stage_flags);
 			layout_bindings.push_back(buffer_layout_binding);
 
@@ -236,6 +241,10 @@ vk::DescriptorSetLayout DescriptorSetCache::get_descriptor_set_layout(
 			descriptor_layout_info.setFlags(vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool);
 			descriptor_layout_info.setPNext(&binding_flags_info);
 		}
+		if (descriptor_buffer)
+		{
+			descriptor_layout_info.setFlags(vk::DescriptorSetLayoutCreateFlagBits::eDescriptorBufferEXT);
+		}
 
 		descriptor_set_layout = logical_device_.createDescriptorSetLayoutUnique(descriptor_layout_info);
 	}
@@ -260,9 +269,12 @@ vk::DescriptorSet DescriptorSetCache::get_descriptor_set(const lz::DescriptorSet
 	key.bindings = set_bindings;
 	key.layout   = get_descriptor_set_layout(set_layout_key);
 
+	curr_frame_stats_.lookups_count++;
 	auto &descriptor_set = descriptor_set_cache_[key];
 	if (!descriptor_set)
 	{
+		curr_frame_stats_.allocations_count++;
+
 		auto set_alloc_info = vk::DescriptorSetAllocateInfo()
 		                          .setDescriptorPool(this->descriptor_pool_.get())
 		                          .setDescriptorSetCount(1)
@@ -464,14 +476,97 @@ vk::DescriptorSet DescriptorSetCache::get_descriptor_set(const lz::DescriptorSet
 			set_writes.push_back(set_write);
 		}
 		logical_device_.updateDescriptorSets(set_writes, {});
+		curr_frame_stats_.writes_count += set_writes.size();
 	}
 	return descriptor_set.get();
 }
 
+void DescriptorSetCache::bind_descriptor_set(vk::CommandBuffer                 command_buffer,
+                                             vk::PipelineBindPoint             bind_point,
+                                             vk::PipelineLayout                pipeline_layout,
+                                             bool                              descriptor_buffer,
+                                             uint32_t                          set_index,
+                                             const lz::DescriptorSetLayoutKey &set_layout_key,
+                                             const lz::DescriptorSetBindings  &set_bindings,
+                                             const std::vector<uint32_t>      &dynamic_offsets)
+{
+	if (descriptor_buffer)
+	{
+		assert(descriptor_buffer_);
+		const vk::DescriptorSetLayout set_layout = get_descriptor_set_layout(set_layout_key, true);
+		curr_frame_stats_.writes_count += descriptor_buffer_->bind_set(command_buffer, bind_point, pipeline_layout, set_index, set_layout, set_bindings, dynamic_offsets);
+		curr_frame_stats_.descriptor_buffer_sets_count++;
+		return;
+	}
+
+	const vk::DescriptorSet descriptor_set = get_descriptor_set(set_layout_key, set_bindings);
+	command_buffer.bindDescriptorSets(bind_point, pipeline_layout, set_index, {descriptor_set}, dynamic_offsets);
+}
+
+void DescriptorSetCache::set_descriptor_buffer(lz::DescriptorBuffer *descriptor_buffer)
+{
+	descriptor_buffer_ = descriptor_buffer;
+}
+
 void DescriptorSetCache::clear()
 {
 	this->descriptor_set_cache_.clear();
 	this->descriptor_set_layout_cache_.clear();
+	this->descriptor_buffer_layout_cache_.clear();
+	if (descriptor_buffer_)
+	{
+		descriptor_buffer_->clear_layouts();
+	}
+}
+
+void DescriptorSetCache::end_frame()
+{
+	last_frame_stats_ = curr_frame_stats_;
+	curr_frame_stats_ = FrameStats();
+}
+
+const DescriptorSetCache::FrameStats &DescriptorSetCache::get_last_frame_stats() const
+{
+	return last_frame_stats_;
+}
+
+void DescriptorSetCache::evict_descriptor_sets(const std::set<const lz::ImageView *> &image_views, const std::set<const lz::Buffer *> &buffers)
+{
+	if (image_views.empty() && buffers.empty())
+	{
+		return;
+	}
+
+	for (auto it = descriptor_set_cache_.begin(); it != descriptor_set_cache_.end();)
+	{
+		const auto &bindings   = it->first.bindings;
+		bool        referenced = false;
+		for (const auto &binding : bindings.uniform_buffer_bindings)
+		{
+			referenced |= buffers.count(binding.buffer) > 0;
+		}
+		for (const auto &binding : bindings.storage_buffer_bindings)
+		{
+			referenced |= buffers.count(binding.buffer) > 0;
+		}
+		for (const auto &binding : bindings.storage_image_bindings)
+		{
+			referenced |= image_views.count(binding.image_view) > 0;
+		}
+		for (const auto &binding : bindings.image_sampler_bindings)
+		{
+			referenced |= image_views.count(binding.image_view) > 0;
+		}
+
+		if (referenced)
+		{
+			it = descriptor_set_cache_.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
 }
 
 bool DescriptorSetCache::DescriptorSetKey::operator<(const DescriptorSetKey &other) const
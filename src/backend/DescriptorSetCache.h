@@ -1,12 +1,15 @@
 #pragma once
 
 #include <map>
+#include <set>
 
 #include "Config.h"
 #include "ShaderProgram.h"
 
 namespace lz
 {
+class DescriptorBuffer;
+
 struct DescriptorSetBindings
 {
 	std::vector<UniformBufferBinding> uniform_buffer_bindings;
@@ -25,7 +28,9 @@ class DescriptorSetCache
   public:
 	explicit DescriptorSetCache(vk::Device logical_device, bool bindless_supported = false);
 
-	vk::DescriptorSetLayout get_descriptor_set_layout(const lz::DescriptorSetLayoutKey &descriptor_set_layout_key);
+	// GetDescriptorSetLayout: Layouts for the descriptor buffer are created with eDescriptorBufferEXT and plain uniform
+	// buffers, they are cached apart from the layouts sets are allocated with
+	vk::DescriptorSetLayout get_descriptor_set_layout(const lz::DescriptorSetLayoutKey &descriptor_set_layout_key, bool descriptor_buffer = false);
 
 	vk::DescriptorSet get_descriptor_set(
 	    const lz::DescriptorSetLayoutKey        &set_layout_key,
@@ -36,9 +41,42 @@ class DescriptorSetCache
 
 	vk::DescriptorSet get_descriptor_set(const lz::DescriptorSetLayoutKey &set_layout_key, const lz::DescriptorSetBindings &set_bindings);
 
+	// BindDescriptorSet: Binds a set to a pipeline bound through PipelineCache
+	// - descriptor_buffer: PipelineInfo::descriptor_buffer of the pipeline, its descriptors are then written into the
+	//   descriptor buffer instead of looking a set up in the cache
+	// - dynamic_offsets: One per uniform buffer binding, as for bindDescriptorSets
+	void bind_descriptor_set(vk::CommandBuffer                 command_buffer,
+	                         vk::PipelineBindPoint             bind_point,
+	                         vk::PipelineLayout                pipeline_layout,
+	                         bool                              descriptor_buffer,
+	                         uint32_t                          set_index,
+	                         const lz::DescriptorSetLayoutKey &set_layout_key,
+	                         const lz::DescriptorSetBindings  &set_bindings,
+	                         const std::vector<uint32_t>      &dynamic_offsets = {});
+
+	// SetDescriptorBuffer: Descriptor buffer the sets of descriptor buffer pipelines are written to, owned by Core
+	void set_descriptor_buffer(lz::DescriptorBuffer *descriptor_buffer);
+
 	void clear();
 
-  private:
+	// frees descriptor sets that reference any of the given resources, they must not be in use by the GPU
+	void evict_descriptor_sets(const std::set<const lz::ImageView *> &image_views, const std::set<const lz::Buffer *> &buffers);
+
+	// FrameStats: Descriptor set traffic of one frame, every lookup that misses the cache allocates and writes a set
+	struct FrameStats
+	{
+		size_t lookups_count                = 0;
+		size_t allocations_count            = 0;
+		size_t writes_count                 = 0;        // descriptors written to newly allocated sets and the descriptor buffer
+		size_t descriptor_buffer_sets_count = 0;        // sets written to the descriptor buffer, never cached
+	};
+
+	// EndFrame: Keeps the counters of the frame that was recorded and starts counting the next one
+	void end_frame();
+
+	const FrameStats &get_last_frame_stats() const;
+
+	// Key descriptor sets are cached by, only compared on the CPU
 	struct DescriptorSetKey
 	{
 		vk::DescriptorSetLayout   layout;
@@ -46,9 +84,15 @@ class DescriptorSetCache
 		bool                      operator<(const DescriptorSetKey &other) const;
 	};
 
+  private:
 	std::map<lz::DescriptorSetLayoutKey, vk::UniqueDescriptorSetLayout> descriptor_set_layout_cache_;
+	std::map<lz::DescriptorSetLayoutKey, vk::UniqueDescriptorSetLayout> descriptor_buffer_layout_cache_;
 	vk::UniqueDescriptorPool                                            descriptor_pool_;
 	std::map<DescriptorSetKey, vk::UniqueDescriptorSet>                 descriptor_set_cache_;
 	vk::Device                                                          logical_device_;
+	lz::DescriptorBuffer                                               *descriptor_buffer_;
+
+	FrameStats curr_frame_stats_;
+	FrameStats last_frame_stats_;
 };
 }        // namespace lz
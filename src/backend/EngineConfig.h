@@ -1,17 +1,33 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+// Defaults of the sizes below, ShaderConfig fits them to the device at startup
+// - Workgroup sizes are specialization constants, the ids are the constant_id the shaders declare them with
+// - Meshlet limits size the mesh shader outputs and are overridden with defines
+
 // Workgroup size for task shader; each task shader thread produces up to one meshlet
 #define TASK_WGSIZE 32
+#define TASK_WGSIZE_ID 0
+
+// Upper bound of the task workgroup size, sizes the task payload
+#define MAX_TASK_WGSIZE 128
 
 // Workgroup size for mesh shader; mesh shader workgroup processes the entire meshlet in parallel
 #define MESH_WGSIZE 32
+#define MESH_WGSIZE_ID 1
 
 // Workgroup size for compute shader; compute shader workgroup processes the entire meshlet in parallel
 #define COMPUTE_WGSIZE 32
+#define COMPUTE_WGSIZE_ID 2
+// square workgroups take their height from a constant of their own, every constant_id names a single constant
+#define COMPUTE_WGSIZE_Y_ID 3
 
+#ifndef MESHLET_MAX_VERTICES
 #define MESHLET_MAX_VERTICES 64
+#endif
+#ifndef MESHLET_MAX_TRIANGLES
 #define MESHLET_MAX_TRIANGLES 124        // we use 4 bytes to store indices, so the max triangle count is 124 that is divisible by 4
+#endif
 #define MESHLET_CONE_WEIGHT 0.5f
 
 #define BINDLESS_SET_ID 1
@@ -23,4 +39,18 @@
 
 #define COMMON_RESOURCE_COUNT 1024
 
+// Number of frames the CPU may record ahead of the GPU; resources released by the CPU are kept alive this many frames
+#define MAX_FRAMES_IN_FLIGHT 2
+
+// Transient render graph images and buffers unused for this many frames are released
+#define RENDER_GRAPH_EVICTION_FRAMES 120
+
+// Dynamic uniform memory per frame in flight starts at this size and grows on demand
+#define SHADER_MEMORY_INITIAL_BLOCK_SIZE (1u << 20)
+// Shader memory blocks used below a quarter of their size for this many frames are halved
+#define SHADER_MEMORY_SHRINK_FRAMES 600
+
+// Descriptor buffer memory per frame in flight starts at this size and grows on demand
+#define DESCRIPTOR_BUFFER_INITIAL_BLOCK_SIZE (1u << 16)
+
 #endif        // CONFIG_H
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace lz
+{
+// HashCombine: Mixes the hash of a value into a seed
+template <typename T>
+void hash_combine(size_t &seed, const T &value)
+{
+	seed ^= std::hash<T>()(value) + size_t(0x9e3779b97f4a7c15ull) + (seed << 6) + (seed >> 2);
+}
+
+// FlatHashMap: Open addressing hash map for lookups on hot paths
+// - Entries live in one dense vector in insertion order, the slots only hold the hash and the index of their entry so a
+//   probe reads one small array and compares keys only when the hashes match
+// - Linear probing over a power of two slot count kept at most half full, the hash is spread with Fibonacci hashing so
+//   hashers can return raw handles or precomputed hashes
+// - Entries are only removed by erase_if, which compacts them and rebuilds the slots, pointers to values stay valid
+//   until the next insertion or erase_if
+template <typename Key, typename Value, typename Hasher = std::hash<Key>>
+class FlatHashMap
+{
+  public:
+	struct Entry
+	{
+		Key   key;
+		Value value;
+	};
+
+	// Find: Returns the value of the key, nullptr if the map does not have it
+	Value *find(const Key &key)
+	{
+		const uint32_t entry_index = find_entry_index(key);
+		return entry_index == empty_slot ? nullptr : &entries_[entry_index].value;
+	}
+
+	const Value *find(const Key &key) const
+	{
+		const uint32_t entry_index = find_entry_index(key);
+		return entry_index == empty_slot ? nullptr : &entries_[entry_index].value;
+	}
+
+	// Operator[]: Returns the value of the key, a default constructed one is inserted if the map does not have it
+	Value &operator[](const Key &key)
+	{
+		if ((entries_.size() + 1) * 2 > slots_.size())
+		{
+			rehash(slots_.empty() ? min_slots_count : slots_.size() * 2);
+		}
+
+		const size_t hash = Hasher()(key);
+		Slot        &slot = slots_[find_slot_index(key, hash)];
+		if (slot.entry_index == empty_slot)
+		{
+			slot.hash        = hash;
+			slot.entry_index = uint32_t(entries_.size());
+			entries_.push_back(Entry{key, Value()});
+		}
+		return entries_[slot.entry_index].value;
+	}
+
+	// EraseIf: Removes every entry the predicate returns true for, the predicate may move the value out
+	// Returns: Number of entries removed
+	template <typename Predicate>
+	size_t erase_if(Predicate predicate)
+	{
+		size_t kept_count = 0;
+		for (size_t entry_index = 0; entry_index < entries_.size(); entry_index++)
+		{
+			if (predicate(entries_[entry_index]))
+			{
+				continue;
+			}
+			if (kept_count != entry_index)
+			{
+				entries_[kept_count] = std::move(entries_[entry_index]);
+			}
+			kept_count++;
+		}
+
+		const size_t erased_count = entries_.size() - kept_count;
+		if (erased_count > 0)
+		{
+			entries_.erase(entries_.begin() + kept_count, entries_.end());
+			rehash(slots_.size());
+		}
+		return erased_count;
+	}
+
+	// Reserve: Sizes the slots so entries_count entries are inserted without rehashing
+	void reserve(size_t entries_count)
+	{
+		size_t slots_count = min_slots_count;
+		while (slots_count < entries_count * 2)
+		{
+			slots_count *= 2;
+		}
+		entries_.reserve(entries_count);
+		if (slots_count > slots_.size())
+		{
+			rehash(slots_count);
+		}
+	}
+
+	void clear()
+	{
+		entries_.clear();
+		slots_.clear();
+	}
+
+	size_t size() const
+	{
+		return entries_.size();
+	}
+
+	bool empty() const
+	{
+		return entries_.empty();
+	}
+
+	typename std::vector<Entry>::iterator begin()
+	{
+		return entries_.begin();
+	}
+
+	typename std::vector<Entry>::iterator end()
+	{
+		return entries_.end();
+	}
+
+	typename std::vector<Entry>::const_iterator begin() const
+	{
+		return entries_.begin();
+	}
+
+	typename std::vector<Entry>::const_iterator end() const
+	{
+		return entries_.end();
+	}
+
+  private:
+	static constexpr uint32_t empty_slot      = uint32_t(-1);
+	static constexpr size_t   min_slots_count = 16;
+
+	struct Slot
+	{
+		size_t   hash        = 0;
+		uint32_t entry_index = empty_slot;
+	};
+
+	size_t get_home_slot_index(size_t hash) const
+	{
+		return size_t((uint64_t(hash) * 0x9e3779b97f4a7c15ull) >> slot_index_shift_);
+	}
+
+	// FindSlotIndex: Slot holding the key, or the empty slot it is inserted at
+	size_t find_slot_index(const Key &key, size_t hash) const
+	{
+		const size_t slot_index_mask = slots_.size() - 1;
+		for (size_t slot_index = get_home_slot_index(hash);; slot_index = (slot_index + 1) & slot_index_mask)
+		{
+			const Slot &slot = slots_[slot_index];
+			if (slot.entry_index == empty_slot || (slot.hash == hash && entries_[slot.entry_index].key == key))
+			{
+				return slot_index;
+			}
+		}
+	}
+
+	uint32_t find_entry_index(const Key &key) const
+	{
+		if (slots_.empty())
+		{
+			return empty_slot;
+		}
+		return slots_[find_slot_index(key, Hasher()(key))].entry_index;
+	}
+
+	void rehash(size_t slots_count)
+	{
+		assert((slots_count & (slots_count - 1)) == 0);
+		slots_.assign(slots_count, Slot());
+		slot_index_shift_ = 64;
+		for (size_t count = slots_count; count > 1; count /= 2)
+		{
+			slot_index_shift_--;
+		}
+
+		const size_t slot_index_mask = slots_count - 1;
+		for (uint32_t entry_index = 0; entry_index < uint32_t(entries_.size()); entry_index++)
+		{
+			const size_t hash       = Hasher()(entries_[entry_index].key);
+			size_t       slot_index = get_home_slot_index(hash);
+			while (slots_[slot_index].entry_index != empty_slot)
+			{
+				slot_index = (slot_index + 1) & slot_index_mask;
+			}
+			slots_[slot_index].hash        = hash;
+			slots_[slot_index].entry_index = entry_index;
+		}
+	}
+
+	std::vector<Entry> entries_;
+	std::vector<Slot>  slots_;
+	uint32_t           slot_index_shift_ = 64;
+};
+}        // namespace lz
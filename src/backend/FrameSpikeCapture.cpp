@@ -0,0 +1,173 @@
+#include "FrameSpikeCapture.h"
+
+#include "Logging.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+namespace lz
+{
+namespace
+{
+// frames the rolling median needs before it is trusted, the first frames upload textures and compile pipelines
+constexpr uint32_t min_median_frames_count = 60;
+
+Json::Value tasks_to_json(const std::vector<lz::ProfilerTask> &tasks, bool write_threads)
+{
+	Json::Value json_tasks(Json::arrayValue);
+	for (const auto &task : tasks)
+	{
+		Json::Value json_task;
+		json_task["name"]        = task.name;
+		json_task["start_ms"]    = task.start_time * 1000.0;
+		json_task["duration_ms"] = task.get_length() * 1000.0;
+		if (write_threads)
+		{
+			json_task["thread"] = task.thread_index;
+			json_task["depth"]  = task.depth;
+		}
+		json_tasks.append(json_task);
+	}
+	return json_tasks;
+}
+}        // namespace
+
+FrameSpikeCapture::FrameSpikeCapture(const FrameSpikeSettings &settings) :
+    settings_(settings),
+    frames_count_(0),
+    prev_frame_time_(clock::now()),
+    frame_times_ms_(settings.median_window_frames),
+    capture_pending_(false),
+    spike_frame_index_(0),
+    next_detection_frame_index_(0),
+    captures_count_(0)
+{
+	records_.resize(size_t(settings_.history_frames) + settings_.frames_after + 1);
+}
+
+void FrameSpikeCapture::record_frame(const std::vector<lz::ProfilerTask> &cpu_tasks, const std::vector<lz::ProfilerTask> &gpu_tasks,
+                                     const std::vector<RenderGraph::ExecutedPass> &passes)
+{
+	if (settings_.budget_ms <= 0.0f && settings_.median_multiple <= 0.0f)
+	{
+		return;
+	}
+
+	const auto   curr_frame_time = clock::now();
+	const double frame_time_ms   = std::chrono::duration<double, std::milli>(curr_frame_time - prev_frame_time_).count();
+	prev_frame_time_             = curr_frame_time;
+
+	// records are assigned in place so the ring reuses its allocations
+	const uint64_t frame_index = frames_count_++;
+	FrameRecord   &record      = records_[frame_index % records_.size()];
+	record.frame_index         = frame_index;
+	record.frame_time_ms       = frame_time_ms;
+	record.cpu_tasks           = cpu_tasks;
+	record.gpu_tasks           = gpu_tasks;
+	record.passes              = passes;
+	record.memory              = MemoryTracker::get().get_category_stats();
+	record.memory_total_bytes  = MemoryTracker::get().get_total_bytes();
+
+	if (!capture_pending_ && frame_index >= next_detection_frame_index_)
+	{
+		spike_reason_ = detect_spike(frame_time_ms);
+		if (!spike_reason_.empty())
+		{
+			capture_pending_   = true;
+			spike_frame_index_ = frame_index;
+			LOGW("Frame {} took {:.2f} ms, {}", frame_index, frame_time_ms, spike_reason_);
+		}
+	}
+	frame_times_ms_.add_sample(frame_index, frame_time_ms);
+	frame_times_ms_.expire(frame_index);
+
+	if (capture_pending_ && frame_index >= spike_frame_index_ + settings_.frames_after)
+	{
+		write_capture();
+		captures_count_++;
+		capture_pending_            = false;
+		next_detection_frame_index_ = frame_index + settings_.history_frames;
+	}
+}
+
+size_t FrameSpikeCapture::get_captures_count() const
+{
+	return captures_count_;
+}
+
+std::string FrameSpikeCapture::detect_spike(const double frame_time_ms) const
+{
+	if (settings_.budget_ms > 0.0f && frame_time_ms > settings_.budget_ms)
+	{
+		return fmt::format("over the {:.2f} ms budget", settings_.budget_ms);
+	}
+
+	if (settings_.median_multiple > 0.0f && frame_times_ms_.get_samples_count() >= std::min(settings_.median_window_frames, min_median_frames_count))
+	{
+		const double median_ms = frame_times_ms_.get_percentile(0.5);
+		if (median_ms > 0.0 && frame_time_ms > median_ms * settings_.median_multiple)
+		{
+			return fmt::format("{:.1f}x the rolling median of {:.2f} ms", frame_time_ms / median_ms, median_ms);
+		}
+	}
+	return std::string();
+}
+
+void FrameSpikeCapture::write_capture() const
+{
+	std::error_code error;
+	std::filesystem::create_directories(settings_.output_directory, error);
+	const std::string file_path = (std::filesystem::path(settings_.output_directory) /
+	                               ("spike_frame_" + std::to_string(spike_frame_index_) + ".json"))
+	                                  .string();
+
+	Json::Value capture;
+	capture["spike_frame"]     = Json::UInt64(spike_frame_index_);
+	capture["reason"]          = spike_reason_;
+	capture["budget_ms"]       = settings_.budget_ms;
+	capture["median_multiple"] = settings_.median_multiple;
+	capture["median_ms"]       = frame_times_ms_.get_percentile(0.5);
+	capture["frames"]          = Json::Value(Json::arrayValue);
+
+	const uint64_t first_frame_index = frames_count_ > records_.size() ? frames_count_ - records_.size() : 0;
+	for (uint64_t frame_index = first_frame_index; frame_index < frames_count_; frame_index++)
+	{
+		const FrameRecord &record = records_[frame_index % records_.size()];
+
+		Json::Value frame;
+		frame["frame"]         = Json::UInt64(record.frame_index);
+		frame["frame_time_ms"] = record.frame_time_ms;
+		frame["spike"]         = record.frame_index == spike_frame_index_;
+		frame["cpu_tasks"]     = tasks_to_json(record.cpu_tasks, true);
+		frame["gpu_tasks"]     = tasks_to_json(record.gpu_tasks, false);
+
+		frame["passes"] = Json::Value(Json::arrayValue);
+		for (const auto &pass : record.passes)
+		{
+			Json::Value json_pass;
+			json_pass["type"] = pass.type;
+			json_pass["name"] = pass.name;
+			frame["passes"].append(json_pass);
+		}
+
+		frame["memory"]["total_bytes"] = Json::UInt64(record.memory_total_bytes);
+		for (size_t category_index = 0; category_index < record.memory.size(); category_index++)
+		{
+			Json::Value &category         = frame["memory"]["categories"][MemoryTracker::get_category_name(MemoryCategory(category_index))];
+			category["allocations_count"] = Json::UInt64(record.memory[category_index].allocations_count);
+			category["bytes"]             = Json::UInt64(record.memory[category_index].bytes);
+		}
+		capture["frames"].append(frame);
+	}
+
+	std::ofstream file(file_path);
+	if (!file.is_open())
+	{
+		LOGE("Failed to write spike capture to {}", file_path);
+		return;
+	}
+	file << capture.toStyledString();
+	LOGI("Spike capture of frames {} to {} written to {}", first_frame_index, frames_count_ - 1, file_path);
+}
+}        // namespace lz
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "MemoryTracker.h"
+#include "ProfilerTask.h"
+#include "RenderGraph.h"
+#include "RollingStatistics.h"
+
+#include "json/json.h"
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace lz
+{
+// FrameSpikeSettings: When a frame counts as a spike and how much history a capture holds, filled from the command line
+struct FrameSpikeSettings
+{
+	std::string output_directory = "spike_captures";
+
+	// frames kept before the spike, and frames recorded after it so late GPU timings of the spike make it in
+	uint32_t history_frames = 120;
+	uint32_t frames_after   = 8;
+
+	// a frame is a spike when it takes longer than budget_ms or median_multiple times the rolling median,
+	// zero disables either check, capturing is off when both are zero
+	float    budget_ms            = 0.0f;
+	float    median_multiple      = 3.0f;
+	uint32_t median_window_frames = 300;
+};
+
+// FrameSpikeCapture: Keeps the last frames of profiler data and writes them to disk around frames that take too long
+// - Every frame keeps its CPU and GPU tasks, the executed render graph passes and the tracked device memory
+// - GPU tasks are the ones read back during the frame, they belong to a frame a few frames earlier
+// - After a capture is written no new spike is detected for history_frames frames, so a slow stretch such as
+//   a window resize produces one capture instead of one per frame
+class FrameSpikeCapture
+{
+  public:
+	explicit FrameSpikeCapture(const FrameSpikeSettings &settings);
+
+	// RecordFrame: Adds the frame that just ended, its time is measured from the previous call
+	void record_frame(const std::vector<lz::ProfilerTask> &cpu_tasks, const std::vector<lz::ProfilerTask> &gpu_tasks,
+	                  const std::vector<RenderGraph::ExecutedPass> &passes);
+
+	size_t get_captures_count() const;
+
+  private:
+	using clock = std::chrono::steady_clock;
+
+	using MemoryStats = std::array<MemoryTracker::CategoryStats, size_t(MemoryCategory::eCount)>;
+
+	struct FrameRecord
+	{
+		uint64_t                               frame_index;
+		double                                 frame_time_ms;
+		std::vector<lz::ProfilerTask>          cpu_tasks;
+		std::vector<lz::ProfilerTask>          gpu_tasks;
+		std::vector<RenderGraph::ExecutedPass> passes;
+		MemoryStats                            memory;
+		vk::DeviceSize                         memory_total_bytes;
+	};
+
+	// DetectSpike: Returns a description of why the frame is a spike, empty if it is not
+	std::string detect_spike(double frame_time_ms) const;
+
+	void write_capture() const;
+
+	FrameSpikeSettings settings_;
+
+	// ring of the last history_frames + frames_after + 1 frames, indexed by frame_index modulo its size
+	std::vector<FrameRecord> records_;
+	uint64_t                 frames_count_;
+	clock::time_point        prev_frame_time_;
+	RollingStatistics        frame_times_ms_;
+
+	bool        capture_pending_;
+	uint64_t    spike_frame_index_;
+	std::string spike_reason_;
+	uint64_t    next_detection_frame_index_;
+	size_t      captures_count_;
+};
+}        // namespace lz
@@ -2,56 +2,123 @@
 
 namespace lz
 {
-GpuProfiler::GpuProfiler(const vk::PhysicalDevice physical_device, const vk::Device logical_device, const uint32_t max_timestamps_count) :
-    logical_device_(logical_device),
-    timestamp_query_(physical_device, logical_device, max_timestamps_count)
+GpuProfiler::GpuProfiler(const vk::PhysicalDevice physical_device, const vk::Device logical_device, const uint32_t max_timestamps_count,
+                         const uint32_t frames_count, const vk::QueryPipelineStatisticFlags pipeline_statistic_flags) :
+    logical_device_(logical_device)
 {
-	frame_index_ = 0;
+	frame_queries_.resize(frames_count);
+	for (auto &frame_query : frame_queries_)
+	{
+		frame_query.timestamp_query = std::make_unique<TimestampQuery>(physical_device, logical_device, max_timestamps_count);
+		if (pipeline_statistic_flags)
+		{
+			frame_query.statistics_query = std::make_unique<PipelineStatisticsQuery>(logical_device, max_timestamps_count,
+			                                                                         pipeline_statistic_flags);
+		}
+	}
+	frame_index_                 = 0;
+	oldest_pending_frame_        = 0;
+	missing_frames_count_        = 0;
+	pipeline_statistics_enabled_ = false;
+	curr_frame_query_            = nullptr;
 }
 
 size_t GpuProfiler::start_task(const std::string &task_name, const uint32_t task_color,
                                const vk::PipelineStageFlagBits pipeline_stage_flags)
 {
-	timestamp_query_.add_timestamp(frame_command_buffer_, profiler_tasks_.size(), pipeline_stage_flags);
+	auto &tasks = curr_frame_query_->tasks;
+	curr_frame_query_->timestamp_query->add_timestamp(frame_command_buffer_, tasks.size(), pipeline_stage_flags);
 
 	lz::ProfilerTask task;
 	task.color           = task_color;
 	task.name            = task_name;
 	task.start_time      = -1.0;
 	task.end_time        = -1.0;
-	const size_t task_id = profiler_tasks_.size();
-	profiler_tasks_.push_back(task);
+	const size_t task_id = tasks.size();
+	tasks.push_back(task);
+
+	if (curr_frame_query_->has_statistics)
+	{
+		curr_frame_query_->statistics_query->begin_query(frame_command_buffer_, task_id);
+	}
 
 	return task_id;
 }
 
-void GpuProfiler::end_task(const size_t task_id) const
+void GpuProfiler::end_task(const size_t task_id)
 {
-	assert(profiler_tasks_.size() == task_id + 1 && profiler_tasks_.back().end_time < 0.0);
+	assert(curr_frame_query_->tasks.size() == task_id + 1 && curr_frame_query_->tasks.back().end_time < 0.0);
+
+	if (curr_frame_query_->has_statistics)
+	{
+		curr_frame_query_->statistics_query->end_query(frame_command_buffer_);
+	}
 }
 
 size_t GpuProfiler::start_frame(const vk::CommandBuffer command_buffer)
 {
 	this->frame_command_buffer_ = command_buffer;
-	profiler_tasks_.clear();
-	timestamp_query_.reset_query_pool(frame_command_buffer_);
+
+	// the pool of this frame may still hold a frame that never became available in time
+	curr_frame_query_ = &frame_queries_[frame_index_ % frame_queries_.size()];
+	if (curr_frame_query_->pending)
+	{
+		missing_frames_count_++;
+		oldest_pending_frame_ = frame_index_ - frame_queries_.size() + 1;
+	}
+
+	curr_frame_query_->tasks.clear();
+	curr_frame_query_->pending        = false;
+	curr_frame_query_->has_statistics = pipeline_statistics_enabled_;
+	curr_frame_query_->timestamp_query->reset_query_pool(frame_command_buffer_);
+	if (curr_frame_query_->has_statistics)
+	{
+		curr_frame_query_->statistics_query->reset_query_pool(frame_command_buffer_);
+	}
 	return frame_index_;
 }
 
 void GpuProfiler::end_frame(const size_t frame_id)
 {
-	timestamp_query_.add_timestamp(frame_command_buffer_, profiler_tasks_.size(),
-	                               vk::PipelineStageFlagBits::eBottomOfPipe);
+	curr_frame_query_->timestamp_query->add_timestamp(frame_command_buffer_, curr_frame_query_->tasks.size(),
+	                                                  vk::PipelineStageFlagBits::eBottomOfPipe);
+	curr_frame_query_->pending = true;
 
 	assert(frame_id == frame_index_);
 	frame_index_++;
 }
 
+size_t GpuProfiler::get_missing_frames_count() const
+{
+	return missing_frames_count_;
+}
+
+void GpuProfiler::set_pipeline_statistics_enabled(const bool enabled)
+{
+	pipeline_statistics_enabled_ = enabled && pipeline_statistics_supported();
+}
+
+bool GpuProfiler::pipeline_statistics_enabled() const
+{
+	return pipeline_statistics_enabled_;
+}
+
+bool GpuProfiler::pipeline_statistics_supported() const
+{
+	return !frame_queries_.empty() && frame_queries_[0].statistics_query != nullptr;
+}
+
 const std::vector<ProfilerTask> &GpuProfiler::get_profiler_tasks()
 {
 	return profiler_tasks_;
 }
 
+void GpuProfiler::take_resolved_frames(std::vector<std::vector<ProfilerTask>> &resolved_frames)
+{
+	resolved_frames.clear();
+	std::swap(resolved_frames, resolved_frames_);
+}
+
 GpuProfiler::TaskHandleInfo::TaskHandleInfo(GpuProfiler *profiler, const size_t task_id)
 {
 	this->profiler = profiler;
@@ -92,17 +159,52 @@ const std::vector<lz::ProfilerTask> &GpuProfiler::get_profiler_data()
 
 void GpuProfiler::gather_timestamps()
 {
-	if (!profiler_tasks_.empty())
+	// frames complete in submission order, stop at the first one that is not available yet
+	while (oldest_pending_frame_ < frame_index_)
+	{
+		auto &frame_query = frame_queries_[oldest_pending_frame_ % frame_queries_.size()];
+		if (frame_query.pending && !try_resolve(frame_query))
+		{
+			break;
+		}
+		oldest_pending_frame_++;
+	}
+}
+
+bool GpuProfiler::try_resolve(FrameQuery &frame_query)
+{
+	const lz::TimestampQuery::QueryResult res = frame_query.timestamp_query->query_results(logical_device_);
+	if (!res.available)
 	{
-		const lz::TimestampQuery::QueryResult res = timestamp_query_.query_results(logical_device_);
-		assert(res.size == this->profiler_tasks_.size() + 1);        // 1 is because of end-of-frame timestamp
+		return false;
+	}
+	assert(res.size == frame_query.tasks.size() + 1);        // 1 is because of end-of-frame timestamp
 
-		for (size_t task_index = 0; task_index < profiler_tasks_.size(); task_index++)
+	lz::PipelineStatisticsQuery::QueryResult statistics_res = {};
+	if (frame_query.has_statistics && !frame_query.tasks.empty())
+	{
+		statistics_res = frame_query.statistics_query->query_results(logical_device_);
+		if (!statistics_res.available)
+		{
+			return false;
+		}
+		assert(statistics_res.size == frame_query.tasks.size());
+	}
+
+	for (size_t task_index = 0; task_index < frame_query.tasks.size(); task_index++)
+	{
+		auto &task      = frame_query.tasks[task_index];
+		task.start_time = res.data[task_index].time;
+		task.end_time   = res.data[task_index + 1].time;
+		if (frame_query.has_statistics)
 		{
-			auto &task      = profiler_tasks_[task_index];
-			task.start_time = res.data[task_index].time;
-			task.end_time   = res.data[task_index + 1].time;
+			task.has_pipeline_statistics = true;
+			task.pipeline_statistics     = statistics_res.data[task_index].statistics;
 		}
 	}
+	profiler_tasks_     = frame_query.tasks;
+	frame_query.pending = false;
+	resolved_frames_.push_back(frame_query.tasks);
+	return true;
 }
 }        // namespace lz
@@ -2,26 +2,48 @@
 #include <chrono>
 
 #include "Handles.h"
+#include "PipelineStatisticsQuery.h"
 #include "ProfilerTask.h"
 #include "TimestampQuery.h"
 
 namespace lz
 {
+// GpuProfiler: Records per-task GPU timestamps
+// - Every frame writes into its own query pool from a ring of frames_count pools
+// - Results are read back without waiting, so they arrive one or two frames after recording
+// - A frame whose pool has to be reused before its results are available is dropped and counted as missing
+// - Optionally every task also gets a pipeline statistics query for the statistics in pipeline_statistic_flags
 class GpuProfiler
 {
   public:
-	GpuProfiler(vk::PhysicalDevice physical_device, vk::Device logical_device, uint32_t max_timestamps_count);
+	GpuProfiler(vk::PhysicalDevice physical_device, vk::Device logical_device, uint32_t max_timestamps_count, uint32_t frames_count,
+	            vk::QueryPipelineStatisticFlags pipeline_statistic_flags = {});
 
 	size_t start_task(const std::string &task_name, uint32_t task_color, vk::PipelineStageFlagBits pipeline_stage_flags);
 
-	void end_task(size_t task_id) const;
+	void end_task(size_t task_id);
 
 	size_t start_frame(vk::CommandBuffer command_buffer);
 
 	void end_frame(size_t frame_id);
 
+	// Returns the tasks of the most recent frame whose results are available
 	const std::vector<ProfilerTask> &get_profiler_tasks();
 
+	// TakeResolvedFrames: Moves out the tasks of every frame resolved since the previous call, oldest first, so each
+	// frame is handed out exactly once
+	void take_resolved_frames(std::vector<std::vector<ProfilerTask>> &resolved_frames);
+
+	// Returns the number of frames dropped because their results were not ready in time
+	size_t get_missing_frames_count() const;
+
+	// Pipeline statistics queries are recorded from the next frame on, only if the device exposes any statistic
+	void set_pipeline_statistics_enabled(bool enabled);
+
+	bool pipeline_statistics_enabled() const;
+
+	bool pipeline_statistics_supported() const;
+
   private:
 	struct TaskHandleInfo
 	{
@@ -54,14 +76,32 @@ class GpuProfiler
 
 	const std::vector<lz::ProfilerTask> &get_profiler_data();
 
+	// Publishes every recorded frame whose timestamps are available, never blocks
 	void gather_timestamps();
 
   private:
+	struct FrameQuery
+	{
+		std::unique_ptr<TimestampQuery>          timestamp_query;
+		std::unique_ptr<PipelineStatisticsQuery> statistics_query;
+		std::vector<lz::ProfilerTask>            tasks;
+		bool                                     pending        = false;
+		bool                                     has_statistics = false;
+	};
+
+	bool try_resolve(FrameQuery &frame_query);
+
 	vk::Device                    logical_device_;
-	TimestampQuery                timestamp_query_;
+	std::vector<FrameQuery>       frame_queries_;
 	size_t                        frame_index_;
+	size_t                        oldest_pending_frame_;
+	size_t                        missing_frames_count_;
+	bool                          pipeline_statistics_enabled_;
+	FrameQuery                   *curr_frame_query_;
 	std::vector<lz::ProfilerTask> profiler_tasks_;
 	vk::CommandBuffer             frame_command_buffer_;
+
+	std::vector<std::vector<lz::ProfilerTask>> resolved_frames_;
 	friend struct UniqueHandle<TaskHandleInfo, GpuProfiler>;
 };
 }        // namespace lz
@@ -1,6 +1,7 @@
 #include "Image.h"
 
 #include "Buffer.h"
+#include "MemoryTracker.h"
 
 namespace lz
 {
@@ -112,6 +113,16 @@ vk::DeviceMemory Image::get_memory()
 	return image_memory_.get();
 }
 
+Image::~Image()
+{
+	MemoryTracker::get().unregister_allocation(image_memory_.get());
+}
+
+vk::DeviceSize Image::get_memory_size() const
+{
+	return memory_size_;
+}
+
 vk::ImageCreateInfo Image::create_info_2d(const glm::uvec2 size, const uint32_t mips_count, const uint32_t array_layers_count,
                                           const vk::Format format, const vk::ImageUsageFlags usage)
 {
@@ -191,6 +202,10 @@ Image::Image(const vk::PhysicalDevice physical_device, const vk::Device logical_
 	                                                    mem_flags));
 
 	image_memory_ = logical_device.allocateMemoryUnique(allocInfo);
+	memory_size_  = imageMemRequirements.size;
+
+	const uint32_t heap_index = physical_device.getMemoryProperties().memoryTypes[allocInfo.memoryTypeIndex].heapIndex;
+	MemoryTracker::get().register_allocation(image_memory_.get(), memory_size_, heap_index);
 
 	// Bind the image to the allocated memory
 	logical_device.bindImageMemory(image_handle_.get(), image_memory_.get(), 0);
@@ -118,10 +118,16 @@ class Image
 	Image(vk::PhysicalDevice physical_device, vk::Device logical_device, const vk::ImageCreateInfo &image_info,
 	      vk::MemoryPropertyFlags mem_flags = vk::MemoryPropertyFlagBits::eDeviceLocal);
 
+	// Destructor: Removes the allocation from the memory tracker
+	~Image();
+
 	lz::ImageData *get_image_data() const;
 
 	vk::DeviceMemory get_memory();
 
+	// Size of the device memory allocation backing this image, in bytes
+	vk::DeviceSize get_memory_size() const;
+
 	static vk::ImageCreateInfo create_info_2d(glm::uvec2 size, uint32_t mips_count, uint32_t array_layers_count,
 	                                          vk::Format format, vk::ImageUsageFlags usage);
 
@@ -134,6 +140,7 @@ class Image
   private:
 	vk::UniqueImage                image_handle_;        // Native Vulkan image handle
 	vk::UniqueDeviceMemory         image_memory_;        // Device memory allocation for this image
+	vk::DeviceSize                 memory_size_ = 0;     // Size of the memory allocation in bytes
 	std::unique_ptr<lz::ImageData> image_data_;          // Image metadata and layout tracking
 };
 }        // namespace lz
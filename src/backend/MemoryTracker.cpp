@@ -0,0 +1,162 @@
+#include "MemoryTracker.h"
+
+#include <algorithm>
+
+namespace lz
+{
+static thread_local MemoryCategory current_category = MemoryCategory::eGeneral;
+
+MemoryTracker::ScopedCategory::ScopedCategory(const MemoryCategory category) :
+    prev_category_(current_category)
+{
+	current_category = category;
+}
+
+MemoryTracker::ScopedCategory::~ScopedCategory()
+{
+	current_category = prev_category_;
+}
+
+MemoryTracker &MemoryTracker::get()
+{
+	static MemoryTracker tracker;
+	return tracker;
+}
+
+void MemoryTracker::register_allocation(const vk::DeviceMemory memory, const vk::DeviceSize size, const uint32_t heap_index)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	allocations_[memory] = {size, heap_index, current_category};
+
+	CategoryStats &stats = category_stats_[size_t(current_category)];
+	stats.allocations_count++;
+	stats.bytes += size;
+	stats.peak_bytes = std::max(stats.peak_bytes, stats.bytes);
+
+	heap_bytes_[heap_index] += size;
+}
+
+void MemoryTracker::unregister_allocation(const vk::DeviceMemory memory)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	auto it = allocations_.find(memory);
+	if (it == allocations_.end())
+	{
+		return;
+	}
+
+	CategoryStats &stats = category_stats_[size_t(it->second.category)];
+	stats.allocations_count--;
+	stats.bytes -= it->second.size;
+
+	heap_bytes_[it->second.heap_index] -= it->second.size;
+	allocations_.erase(it);
+}
+
+std::array<MemoryTracker::CategoryStats, size_t(MemoryCategory::eCount)> MemoryTracker::get_category_stats() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return category_stats_;
+}
+
+vk::DeviceSize MemoryTracker::get_total_bytes() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	vk::DeviceSize total_bytes = 0;
+	for (const auto &stats : category_stats_)
+	{
+		total_bytes += stats.bytes;
+	}
+	return total_bytes;
+}
+
+std::vector<MemoryTracker::HeapStats> MemoryTracker::query_heaps(const vk::PhysicalDevice physical_device, const bool budget_supported) const
+{
+	vk::PhysicalDeviceMemoryProperties          memory_properties;
+	vk::PhysicalDeviceMemoryBudgetPropertiesEXT budget_properties;
+	if (budget_supported)
+	{
+		auto properties_chain = physical_device.getMemoryProperties2<vk::PhysicalDeviceMemoryProperties2, vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+		memory_properties     = properties_chain.get<vk::PhysicalDeviceMemoryProperties2>().memoryProperties;
+		budget_properties     = properties_chain.get<vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+	}
+	else
+	{
+		memory_properties = physical_device.getMemoryProperties();
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	std::vector<HeapStats> heaps(memory_properties.memoryHeapCount);
+	for (uint32_t i = 0; i < memory_properties.memoryHeapCount; i++)
+	{
+		heaps[i].size          = memory_properties.memoryHeaps[i].size;
+		heaps[i].flags         = memory_properties.memoryHeaps[i].flags;
+		heaps[i].tracked_bytes = heap_bytes_[i];
+		if (budget_supported)
+		{
+			heaps[i].budget = budget_properties.heapBudget[i];
+			heaps[i].usage  = budget_properties.heapUsage[i];
+		}
+	}
+	return heaps;
+}
+
+Json::Value MemoryTracker::dump(const vk::PhysicalDevice physical_device, const bool budget_supported) const
+{
+	Json::Value report;
+
+	auto categories = get_category_stats();
+	for (size_t i = 0; i < categories.size(); i++)
+	{
+		Json::Value category;
+		category["name"]              = get_category_name(MemoryCategory(i));
+		category["allocations_count"] = Json::UInt64(categories[i].allocations_count);
+		category["bytes"]             = Json::UInt64(categories[i].bytes);
+		category["peak_bytes"]        = Json::UInt64(categories[i].peak_bytes);
+		report["categories"].append(category);
+	}
+
+	auto heaps = query_heaps(physical_device, budget_supported);
+	for (size_t i = 0; i < heaps.size(); i++)
+	{
+		Json::Value heap;
+		heap["index"]         = Json::UInt64(i);
+		heap["device_local"]  = bool(heaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal);
+		heap["size"]          = Json::UInt64(heaps[i].size);
+		heap["tracked_bytes"] = Json::UInt64(heaps[i].tracked_bytes);
+		if (budget_supported)
+		{
+			heap["budget"] = Json::UInt64(heaps[i].budget);
+			heap["usage"]  = Json::UInt64(heaps[i].usage);
+		}
+		report["heaps"].append(heap);
+	}
+
+	report["total_bytes"]      = Json::UInt64(get_total_bytes());
+	report["budget_supported"] = budget_supported;
+	return report;
+}
+
+const char *MemoryTracker::get_category_name(const MemoryCategory category)
+{
+	switch (category)
+	{
+		case MemoryCategory::eGeneral:
+			return "General";
+		case MemoryCategory::eRenderGraph:
+			return "Render graph";
+		case MemoryCategory::eMaterials:
+			return "Materials";
+		case MemoryCategory::eShaderMemory:
+			return "Shader memory";
+		case MemoryCategory::eScene:
+			return "Scene";
+		default:
+			return "Unknown";
+	}
+}
+}        // namespace lz
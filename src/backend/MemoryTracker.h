@@ -0,0 +1,104 @@
+#pragma once
+
+#include "Config.h"
+
+#include "json/json.h"
+
+#include <array>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lz
+{
+// MemoryCategory: Subsystem a device memory allocation is attributed to
+enum class MemoryCategory : uint32_t
+{
+	eGeneral,
+	eRenderGraph,
+	eMaterials,
+	eShaderMemory,
+	eScene,
+	eCount
+};
+
+// MemoryTracker: Central registry of device memory allocations
+// - Buffer and Image register their allocations on creation and remove them on destruction
+// - Allocations are attributed to the category set by the innermost ScopedCategory on the allocating thread
+// - Heap usage and budget are queried from VK_EXT_memory_budget when the device supports it
+class MemoryTracker
+{
+  public:
+	// CategoryStats: Live and peak totals of one category
+	struct CategoryStats
+	{
+		size_t         allocations_count = 0;
+		vk::DeviceSize bytes             = 0;
+		vk::DeviceSize peak_bytes        = 0;
+	};
+
+	// HeapStats: Tracked bytes of one memory heap compared to what the driver reports
+	struct HeapStats
+	{
+		vk::DeviceSize      size = 0;
+		vk::MemoryHeapFlags flags;
+		vk::DeviceSize      tracked_bytes = 0;
+		vk::DeviceSize      budget        = 0;        // zero when VK_EXT_memory_budget is not available
+		vk::DeviceSize      usage         = 0;        // process-wide usage reported by the driver
+	};
+
+	// ScopedCategory: Attributes allocations made by this thread to a category while alive
+	class ScopedCategory
+	{
+	  public:
+		ScopedCategory(MemoryCategory category);
+		~ScopedCategory();
+
+		ScopedCategory(const ScopedCategory &)            = delete;
+		ScopedCategory &operator=(const ScopedCategory &) = delete;
+
+	  private:
+		MemoryCategory prev_category_;
+	};
+
+	// Get: Returns the process-wide tracker, Buffer and Image have no access to Core
+	static MemoryTracker &get();
+
+	// RegisterAllocation: Records a device memory allocation under the current category
+	void register_allocation(vk::DeviceMemory memory, vk::DeviceSize size, uint32_t heap_index);
+
+	// UnregisterAllocation: Removes a previously registered allocation
+	void unregister_allocation(vk::DeviceMemory memory);
+
+	// GetCategoryStats: Returns totals for every category, indexed by MemoryCategory
+	std::array<CategoryStats, size_t(MemoryCategory::eCount)> get_category_stats() const;
+
+	// GetTotalBytes: Returns the sum of all live tracked allocations
+	vk::DeviceSize get_total_bytes() const;
+
+	// QueryHeaps: Returns per-heap tracked bytes, with driver budget and usage if budget_supported
+	std::vector<HeapStats> query_heaps(vk::PhysicalDevice physical_device, bool budget_supported) const;
+
+	// Dump: Builds a machine-readable report of categories and heaps
+	Json::Value dump(vk::PhysicalDevice physical_device, bool budget_supported) const;
+
+	// GetCategoryName: Returns a printable name of a category
+	static const char *get_category_name(MemoryCategory category);
+
+  private:
+	MemoryTracker() = default;
+
+	struct Allocation
+	{
+		vk::DeviceSize size;
+		uint32_t       heap_index;
+		MemoryCategory category;
+	};
+
+	mutable std::mutex                                        mutex_;
+	std::unordered_map<VkDeviceMemory, Allocation>            allocations_;
+	std::array<CategoryStats, size_t(MemoryCategory::eCount)> category_stats_;
+	std::array<vk::DeviceSize, VK_MAX_MEMORY_HEAPS>           heap_bytes_{};
+};
+}        // namespace lz
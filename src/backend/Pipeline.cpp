@@ -1,10 +1,47 @@
 #include "Pipeline.h"
 
 #include "PipelineCache.h"
+#include "StartupProfiler.h"
 #include "VertexDeclaration.h"
 
+#include <memory>
+
 namespace lz
 {
+namespace
+{
+// StageSpecialization: vk::SpecializationInfo of one stage with the entries and data it points to, not movable once filled
+struct StageSpecialization
+{
+	explicit StageSpecialization(const SpecializationConstants &specialization_constants)
+	{
+		for (const auto &[constant_id, value] : specialization_constants)
+		{
+			map_entries.emplace_back(constant_id, uint32_t(data.size() * sizeof(uint32_t)), sizeof(uint32_t));
+			data.push_back(value);
+		}
+		info = vk::SpecializationInfo()
+		           .setMapEntryCount(uint32_t(map_entries.size()))
+		           .setPMapEntries(map_entries.data())
+		           .setDataSize(data.size() * sizeof(uint32_t))
+		           .setPData(data.data());
+	}
+
+	StageSpecialization(const StageSpecialization &)            = delete;
+	StageSpecialization &operator=(const StageSpecialization &) = delete;
+
+	// nullptr for stages without constants
+	const vk::SpecializationInfo *get_info() const
+	{
+		return map_entries.empty() ? nullptr : &info;
+	}
+
+	std::vector<vk::SpecializationMapEntry> map_entries;
+	std::vector<uint32_t>                   data;
+	vk::SpecializationInfo                  info;
+};
+}        // namespace
+
 vk::Pipeline GraphicsPipeline::get_handle()
 {
 	return pipeline_.get();
@@ -17,18 +54,21 @@ vk::PipelineLayout GraphicsPipeline::get_layout() const
 
 GraphicsPipeline::GraphicsPipeline(vk::Device logical_device, const std::vector<lz::ShaderStageInfo> &shader_stages,
                                    const lz::VertexDeclaration &vertex_decl, vk::PipelineLayout pipeline_layout, DepthSettings depth_settings,
-                                   const std::vector<BlendSettings> &attachment_blend_settings, vk::PrimitiveTopology primitive_topology,
-                                   vk::RenderPass render_pass)
+                                   vk::CullModeFlags cull_mode, const std::vector<BlendSettings> &attachment_blend_settings, vk::PrimitiveTopology primitive_topology,
+                                   vk::RenderPass render_pass, bool extended_dynamic_state)
 {
 	this->pipeline_layout_ = pipeline_layout;
 
-	std::vector<vk::PipelineShaderStageCreateInfo> shader_stage_infos;
+	std::vector<std::unique_ptr<StageSpecialization>> stage_specializations;
+	std::vector<vk::PipelineShaderStageCreateInfo>    shader_stage_infos;
 	for (auto &shader_stage : shader_stages)
 	{
+		stage_specializations.push_back(std::make_unique<StageSpecialization>(shader_stage.specialization_constants));
 		auto shader_stage_create_info = vk::PipelineShaderStageCreateInfo()
 		                                    .setStage(shader_stage.stage)
 		                                    .setModule(shader_stage.module)
-		                                    .setPName("main");
+		                                    .setPName("main")
+		                                    .setPSpecializationInfo(stage_specializations.back()->get_info());
 		shader_stage_infos.push_back(shader_stage_create_info);
 	}
 
@@ -49,7 +89,7 @@ GraphicsPipeline::GraphicsPipeline(vk::Device logical_device, const std::vector<
 	                                    .setDepthClampEnable(false)
 	                                    .setPolygonMode(vk::PolygonMode::eFill)
 	                                    .setLineWidth(1.0f)
-	                                    .setCullMode(vk::CullModeFlagBits::eNone)
+	                                    .setCullMode(cull_mode)
 	                                    .setFrontFace(vk::FrontFace::eCounterClockwise)
 	                                    .setDepthBiasEnable(false);
 
@@ -78,11 +118,16 @@ GraphicsPipeline::GraphicsPipeline(vk::Device logical_device, const std::vector<
 	                               .setDepthWriteEnable(depth_settings.write_enable)
 	                               .setDepthBoundsTestEnable(false);
 
-	// Configure dynamic state (viewport and scissor)
-	vk::DynamicState dynamic_states[]   = {vk::DynamicState::eViewport, vk::DynamicState::eScissor};
-	auto             dynamic_state_info = vk::PipelineDynamicStateCreateInfo()
-	                              .setDynamicStateCount(2)
-	                              .setPDynamicStates(dynamic_states);
+	// Configure dynamic state (viewport and scissor, cull mode and depth state with VK_EXT_extended_dynamic_state)
+	std::vector<vk::DynamicState> dynamic_states = {vk::DynamicState::eViewport, vk::DynamicState::eScissor};
+	if (extended_dynamic_state)
+	{
+		dynamic_states.insert(dynamic_states.end(), {vk::DynamicState::eCullModeEXT, vk::DynamicState::eDepthTestEnableEXT,
+		                                             vk::DynamicState::eDepthWriteEnableEXT, vk::DynamicState::eDepthCompareOpEXT});
+	}
+	auto dynamic_state_info = vk::PipelineDynamicStateCreateInfo()
+	                              .setDynamicStateCount(uint32_t(dynamic_states.size()))
+	                              .setPDynamicStates(dynamic_states.data());
 
 	auto viewport_state = vk::PipelineViewportStateCreateInfo()
 	                          .setScissorCount(1)
@@ -104,6 +149,7 @@ GraphicsPipeline::GraphicsPipeline(vk::Device logical_device, const std::vector<
 	                                .setBasePipelineHandle(nullptr)        // use later
 	                                .setBasePipelineIndex(-1);
 
+	StartupProfiler::ScopedPhase startup_phase("Pipeline creation");
 	pipeline_ = logical_device.createGraphicsPipelineUnique(nullptr, pipeline_create_info).value;
 }
 
@@ -118,21 +164,27 @@ vk::PipelineLayout ComputePipeline::get_layout() const
 }
 
 ComputePipeline::ComputePipeline(vk::Device logical_device, vk::ShaderModule compute_shader,
-                                 vk::PipelineLayout pipeline_layout)
+                                 vk::PipelineLayout pipeline_layout, const SpecializationConstants &specialization_constants,
+                                 bool descriptor_buffer)
 {
-	this->pipeline_layout_               = pipeline_layout;
+	this->pipeline_layout_ = pipeline_layout;
+
+	const StageSpecialization specialization(specialization_constants);
+
 	const auto compute_stage_create_info = vk::PipelineShaderStageCreateInfo()
 	                                           .setStage(vk::ShaderStageFlagBits::eCompute)
 	                                           .setModule(compute_shader)
-	                                           .setPName("main");
+	                                           .setPName("main")
+	                                           .setPSpecializationInfo(specialization.get_info());
 
 	auto pipeline_create_info = vk::ComputePipelineCreateInfo()
-	                                .setFlags(vk::PipelineCreateFlags())
+	                                .setFlags(descriptor_buffer ? vk::PipelineCreateFlagBits::eDescriptorBufferEXT : vk::PipelineCreateFlags())
 	                                .setStage(compute_stage_create_info)
 	                                .setLayout(pipeline_layout)
 	                                .setBasePipelineHandle(nullptr)        // use later
 	                                .setBasePipelineIndex(-1);
 
+	StartupProfiler::ScopedPhase startup_phase("Pipeline creation");
 	pipeline_ = logical_device.createComputePipelineUnique(nullptr, pipeline_create_info).value;
 }
 }        // namespace lz
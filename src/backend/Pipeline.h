@@ -41,6 +41,11 @@ struct DepthSettings
 	{
 		return std::tie(depth_func, write_enable) < std::tie(other.depth_func, other.write_enable);
 	}
+
+	bool operator==(const DepthSettings &other) const
+	{
+		return depth_func == other.depth_func && write_enable == other.write_enable;
+	}
 };
 
 // BlendSettings: Structure for configuring color blending
@@ -120,6 +125,12 @@ struct BlendSettings
 		                other.blend_state.srcColorBlendFactor, other.blend_state.dstColorBlendFactor);
 	}
 
+	// Equality compares the whole state, write mask and alpha factors included
+	bool operator==(const BlendSettings &other) const
+	{
+		return blend_state == other.blend_state;
+	}
+
 	vk::PipelineColorBlendAttachmentState blend_state;        // Native Vulkan blend state
 };
 
@@ -149,15 +160,20 @@ class GraphicsPipeline
 	vk::PipelineLayout get_layout() const;
 
 	// Constructor: Creates a new graphics pipeline with the specified parameters
+	// - Viewport and scissor are always dynamic, the render graph sets them from the render area of every pass
+	// - With extended_dynamic_state the cull mode and the depth state are dynamic too and cull_mode and depth_settings are
+	//   ignored, the command buffer has to set them before drawing
 	GraphicsPipeline(
 	    vk::Device                          logical_device,
 	    const std::vector<ShaderStageInfo> &shader_stages,
 	    const lz::VertexDeclaration        &vertex_decl,
 	    vk::PipelineLayout                  pipeline_layout,
 	    DepthSettings                       depth_settings,
+	    vk::CullModeFlags                   cull_mode,
 	    const std::vector<BlendSettings>   &attachment_blend_settings,
 	    vk::PrimitiveTopology               primitive_topology,
-	    vk::RenderPass                      render_pass);
+	    vk::RenderPass                      render_pass,
+	    bool                                extended_dynamic_state = false);
 
   private:
 	vk::PipelineLayout pipeline_layout_;
@@ -172,10 +188,14 @@ class ComputePipeline
 
 	vk::PipelineLayout get_layout() const;
 
+	// - With descriptor_buffer the pipeline binds its sets from the descriptor buffer, its layout has to be made of
+	//   descriptor buffer set layouts
 	ComputePipeline(
-	    vk::Device         logical_device,
-	    vk::ShaderModule   compute_shader,
-	    vk::PipelineLayout pipeline_layout);
+	    vk::Device                     logical_device,
+	    vk::ShaderModule               compute_shader,
+	    vk::PipelineLayout             pipeline_layout,
+	    const SpecializationConstants &specialization_constants = SpecializationConstants(),
+	    bool                           descriptor_buffer        = false);
 
   private:
 	vk::PipelineLayout pipeline_layout_;
@@ -1,70 +1,291 @@
 #include "PipelineCache.h"
 
 #include "DescriptorSetCache.h"
+#include "EngineConfig.h"
 #include "Pipeline.h"
 #include "ShaderModule.h"
 #include "ShaderProgram.h"
 
+#include <algorithm>
+#include <cassert>
+
 namespace lz
 {
 PipelineCache::PipelineCache(vk::Device logical_device, DescriptorSetCache *descriptor_set_cache) :
     logical_device_(logical_device),
-    descriptor_set_cache_(descriptor_set_cache)
+    descriptor_set_cache_(descriptor_set_cache),
+    extended_dynamic_state_(false),
+    descriptor_buffer_(false)
 {
 }
 
-PipelineCache::PipelineInfo PipelineCache::bind_graphics_pipeline(vk::CommandBuffer command_buffer,
-                                                                  vk::RenderPass    render_pass,
-                                                                  lz::DepthSettings depth_settings,
-                                                                  const std::vector<lz::BlendSettings>                          &
-                                                                      attachment_blend_settings,
-                                                                  const lz::VertexDeclaration &vertex_declaration,
-                                                                  vk::PrimitiveTopology        topology,
-                                                                  const lz::ShaderProgram     *shader_program)
+PipelineCache::GraphicsPipelineState PipelineCache::intern_graphics_pipeline_state(
+    const std::vector<lz::BlendSettings> &attachment_blend_settings,
+    const lz::VertexDeclaration          &vertex_declaration,
+    vk::CullModeFlags                     cull_mode)
 {
-	GraphicsPipelineKey pipeline_key;
+	GraphicsPipelineState pipeline_state;
+	pipeline_state.vertex_decl_id               = intern_vertex_declaration(vertex_declaration);
+	pipeline_state.attachment_blend_settings_id = intern_blend_settings(attachment_blend_settings);
+	pipeline_state.cull_mode                    = cull_mode;
+	return pipeline_state;
+}
 
-	for (const auto shader : shader_program->shaders)
+PipelineCache::PipelineInfo PipelineCache::bind_graphics_pipeline(vk::CommandBuffer        command_buffer,
+                                                                  vk::RenderPass           render_pass,
+                                                                  lz::DepthSettings        depth_settings,
+                                                                  GraphicsPipelineState    pipeline_state,
+                                                                  vk::PrimitiveTopology    topology,
+                                                                  const lz::ShaderProgram *shader_program)
+{
+	const GraphicsPipelineKey pipeline_key =
+	    make_graphics_pipeline_key(render_pass, depth_settings, pipeline_state, topology, intern_program(shader_program));
+
+	lz::GraphicsPipeline *pipeline = get_graphics_pipeline(pipeline_key);
+
+	command_buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline->get_handle());
+
+	// the render graph only set the defaults of the pass, the cull mode and depth state follow the pipeline
+	if (extended_dynamic_state_)
 	{
-		ShaderStageInfo stage_info;
-		stage_info.stage  = shader->get_stage_bits();
-		stage_info.module = shader->get_module()->get_handle();
-		pipeline_key.shader_stages.push_back(stage_info);
+		command_buffer.setCullModeEXT(pipeline_state.cull_mode, loader_);
+		command_buffer.setDepthTestEnableEXT(depth_settings.depth_func != vk::CompareOp::eAlways, loader_);
+		command_buffer.setDepthWriteEnableEXT(depth_settings.write_enable, loader_);
+		command_buffer.setDepthCompareOpEXT(depth_settings.depth_func, loader_);
 	}
 
-	pipeline_key.vertex_decl               = vertex_declaration;
-	pipeline_key.depth_settings            = depth_settings;
-	pipeline_key.attachment_blend_settings = attachment_blend_settings;
-	pipeline_key.topology                  = topology;
+	PipelineInfo pipeline_info;
+	pipeline_info.pipeline_layout = pipeline->get_layout();
+	return pipeline_info;
+}
+
+PipelineCache::PipelineInfo PipelineCache::bind_compute_pipeline(vk::CommandBuffer command_buffer,
+                                                                 lz::Shader       *compute_shader)
+{
+	const ComputePipelineKey pipeline_key = make_compute_pipeline_key(intern_compute_shader(compute_shader));
+
+	lz::ComputePipeline *pipeline = get_compute_pipeline(pipeline_key);
+
+	command_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline->get_handle());
 
 	PipelineInfo pipeline_info;
+	pipeline_info.pipeline_layout   = pipeline->get_layout();
+	pipeline_info.descriptor_buffer = interned_programs_[pipeline_key.program_id].descriptor_buffer;
+	return pipeline_info;
+}
 
-	PipelineLayoutKey pipeline_layout_key;
-	for (auto &set_layout_key : shader_program->combined_descriptor_set_layout_keys)
+PipelineCache::GraphicsPipelineKey PipelineCache::make_graphics_pipeline_key(vk::RenderPass        render_pass,
+                                                                              lz::DepthSettings     depth_settings,
+                                                                              GraphicsPipelineState pipeline_state,
+                                                                              vk::PrimitiveTopology topology,
+                                                                              uint32_t              program_id) const
+{
+	GraphicsPipelineKey pipeline_key;
+	pipeline_key.program_id                   = program_id;
+	pipeline_key.vertex_decl_id               = pipeline_state.vertex_decl_id;
+	pipeline_key.attachment_blend_settings_id = pipeline_state.attachment_blend_settings_id;
+	pipeline_key.render_pass                  = render_pass;
+	pipeline_key.depth_settings               = get_pipeline_depth_settings(depth_settings);
+	pipeline_key.cull_mode                    = get_pipeline_cull_mode(pipeline_state.cull_mode);
+	pipeline_key.topology                     = topology;
+	pipeline_key.update_hash();
+	return pipeline_key;
+}
+
+PipelineCache::ComputePipelineKey PipelineCache::make_compute_pipeline_key(uint32_t program_id) const
+{
+	ComputePipelineKey pipeline_key;
+	pipeline_key.program_id = program_id;
+	pipeline_key.update_hash();
+	return pipeline_key;
+}
+
+const std::vector<ShaderStageInfo> &PipelineCache::get_program_stages(uint32_t program_id) const
+{
+	return interned_programs_[program_id].shader_stages;
+}
+
+void PipelineCache::clear()
+{
+	this->compute_pipeline_cache_.clear();
+	this->graphics_pipeline_cache_.clear();
+	this->pipeline_layout_cache_.clear();
+	this->program_ids_.clear();
+	this->compute_shader_ids_.clear();
+	this->interned_programs_.clear();
+	this->free_program_ids_.clear();
+}
+
+void PipelineCache::enable_extended_dynamic_state(const vk::DispatchLoaderDynamic &loader)
+{
+	assert(graphics_pipeline_cache_.empty());
+	extended_dynamic_state_ = true;
+	loader_                 = loader;
+}
+
+void PipelineCache::enable_descriptor_buffer()
+{
+	assert(compute_pipeline_cache_.empty());
+	descriptor_buffer_ = true;
+}
+
+lz::DepthSettings PipelineCache::get_pipeline_depth_settings(lz::DepthSettings depth_settings) const
+{
+	return extended_dynamic_state_ ? lz::DepthSettings::disabled() : depth_settings;
+}
+
+vk::CullModeFlags PipelineCache::get_pipeline_cull_mode(vk::CullModeFlags cull_mode) const
+{
+	return extended_dynamic_state_ ? vk::CullModeFlags(vk::CullModeFlagBits::eNone) : cull_mode;
+}
+
+size_t PipelineCache::get_graphics_pipelines_count() const
+{
+	return graphics_pipeline_cache_.size();
+}
+
+void PipelineCache::set_specialization_constants(const SpecializationConstants &specialization_constants)
+{
+	// interned stages carry the previous values, the caller clears the pipelines built with them, until then their
+	// programs keep their slots and the others are recycled
+	specialization_constants_ = specialization_constants;
+	program_ids_.clear();
+	compute_shader_ids_.clear();
+
+	std::vector<bool> keyed_programs(interned_programs_.size(), false);
+	for (const auto &entry : graphics_pipeline_cache_)
 	{
-		pipeline_layout_key.set_layouts.push_back(descriptor_set_cache_->get_descriptor_set_layout(set_layout_key));
+		keyed_programs[entry.key.program_id] = true;
+	}
+	for (const auto &entry : compute_pipeline_cache_)
+	{
+		keyed_programs[entry.key.program_id] = true;
+	}
+	for (uint32_t program_id = 0; program_id < uint32_t(interned_programs_.size()); program_id++)
+	{
+		if (!keyed_programs[program_id] && !interned_programs_[program_id].modules.empty())
+			recycle_program(program_id);
 	}
+}
 
-	pipeline_key.pipeline_layout = get_pipeline_layout(pipeline_layout_key);
+const SpecializationConstants &PipelineCache::get_specialization_constants() const
+{
+	return specialization_constants_;
+}
 
-	pipeline_key.render_pass = render_pass;
+SpecializationConstants PipelineCache::get_stage_specialization_constants(const lz::Shader *shader) const
+{
+	// constants without a configured value keep the default compiled into the shader
+	SpecializationConstants stage_constants;
+	for (const uint32_t constant_id : shader->get_specialization_constant_ids())
+	{
+		const auto constant_it = specialization_constants_.find(constant_id);
+		if (constant_it != specialization_constants_.end())
+		{
+			stage_constants.insert(*constant_it);
+		}
+	}
+	return stage_constants;
+}
 
-	lz::GraphicsPipeline *pipeline = get_graphics_pipeline(pipeline_key);
+void PipelineCache::evict_pipelines(const std::set<vk::ShaderModule>                     &shader_modules,
+                                    std::vector<std::unique_ptr<lz::GraphicsPipeline>> &graphics_pipelines,
+                                    std::vector<std::unique_ptr<lz::ComputePipeline>>  &compute_pipelines)
+{
+	const auto uses_module = [&](uint32_t program_id) {
+		const auto &modules = interned_programs_[program_id].modules;
+		return std::any_of(modules.begin(), modules.end(), [&](vk::ShaderModule module) { return shader_modules.count(module) > 0; });
+	};
 
-	command_buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline->get_handle());
+	graphics_pipeline_cache_.erase_if([&](auto &entry) {
+		if (!uses_module(entry.key.program_id))
+			return false;
+		graphics_pipelines.push_back(std::move(entry.value));
+		return true;
+	});
 
-	pipeline_info.pipeline_layout = pipeline->get_layout();
-	return pipeline_info;
+	compute_pipeline_cache_.erase_if([&](auto &entry) {
+		if (!uses_module(entry.key.program_id))
+			return false;
+		compute_pipelines.push_back(std::move(entry.value));
+		return true;
+	});
+
+	// a module created later may get the handle of an evicted one, the programs must not match it
+	program_ids_.erase_if([&](const auto &entry) { return uses_module(entry.value); });
+	compute_shader_ids_.erase_if([&](const auto &entry) { return uses_module(entry.value); });
+
+	// no pipeline is keyed by these programs anymore
+	for (uint32_t program_id = 0; program_id < uint32_t(interned_programs_.size()); program_id++)
+	{
+		if (uses_module(program_id))
+			recycle_program(program_id);
+	}
 }
 
-PipelineCache::PipelineInfo PipelineCache::bind_compute_pipeline(vk::CommandBuffer command_buffer,
-                                                                 lz::Shader       *compute_shader)
+uint32_t PipelineCache::intern_program(const lz::ShaderProgram *shader_program)
 {
-	ComputePipelineKey pipeline_key;
-	pipeline_key.compute_shader = compute_shader->get_module()->get_handle();
+	const uint32_t *program_id = program_ids_.find(shader_program);
+	if (program_id)
+	{
+		const auto &modules  = interned_programs_[*program_id].modules;
+		bool        is_valid = modules.size() == shader_program->shaders.size();
+		for (size_t shader_index = 0; is_valid && shader_index < modules.size(); shader_index++)
+		{
+			is_valid = modules[shader_index] == shader_program->shaders[shader_index]->get_module()->get_handle();
+		}
+		if (is_valid)
+			return *program_id;
+	}
 
-	PipelineInfo pipeline_info;
-	lz::Shader  *target_shader = compute_shader;
+	InternedProgram program;
+	for (const auto shader : shader_program->shaders)
+	{
+		ShaderStageInfo stage_info;
+		stage_info.stage                    = shader->get_stage_bits();
+		stage_info.module                   = shader->get_module()->get_handle();
+		stage_info.specialization_constants = get_stage_specialization_constants(shader);
+		program.modules.push_back(stage_info.module);
+		program.shader_stages.push_back(stage_info);
+	}
+
+	PipelineLayoutKey pipeline_layout_key;
+	for (auto &set_layout_key : shader_program->combined_descriptor_set_layout_keys)
+	{
+		pipeline_layout_key.set_layouts.push_back(descriptor_set_cache_->get_descriptor_set_layout(set_layout_key));
+	}
+	pipeline_layout_key.update_hash();
+	program.pipeline_layout = get_pipeline_layout(pipeline_layout_key);
+
+	const uint32_t new_program_id = add_interned_program(std::move(program));
+	program_ids_[shader_program]  = new_program_id;
+	return new_program_id;
+}
+
+uint32_t PipelineCache::intern_compute_shader(lz::Shader *compute_shader)
+{
+	const vk::ShaderModule module     = compute_shader->get_module()->get_handle();
+	const uint32_t        *program_id = compute_shader_ids_.find(compute_shader);
+	if (program_id && interned_programs_[*program_id].modules[0] == module)
+		return *program_id;
+
+	InternedProgram program;
+	program.modules = {module};
+
+	ShaderStageInfo stage_info;
+	stage_info.stage                    = vk::ShaderStageFlagBits::eCompute;
+	stage_info.module                   = module;
+	stage_info.specialization_constants = get_stage_specialization_constants(compute_shader);
+	program.shader_stages.push_back(stage_info);
+
+	// the bindless set is updated after bind and stays a descriptor set, shaders using it bind all their sets as sets
+	program.descriptor_buffer = descriptor_buffer_;
+	for (size_t set_index = 0; set_index < compute_shader->get_sets_count(); set_index++)
+	{
+		const auto compute_set_info = compute_shader->get_set_info(set_index);
+		if (!compute_set_info->is_empty() && compute_set_info->get_set_id() == BINDLESS_SET_ID)
+			program.descriptor_buffer = false;
+	}
 
 	PipelineLayoutKey pipeline_layout_key;
 	pipeline_layout_key.set_layouts.resize(compute_shader->get_sets_count());
@@ -73,30 +294,109 @@ PipelineCache::PipelineInfo PipelineCache::bind_compute_pipeline(vk::CommandBuff
 		vk::DescriptorSetLayout set_layout_handle = nullptr;
 		const auto              compute_set_info  = compute_shader->get_set_info(set_index);
 		if (!compute_set_info->is_empty())
-			set_layout_handle = descriptor_set_cache_->get_descriptor_set_layout(*compute_set_info);
+			set_layout_handle = descriptor_set_cache_->get_descriptor_set_layout(*compute_set_info, program.descriptor_buffer);
 
 		pipeline_layout_key.set_layouts[set_index] = set_layout_handle;
 	}
-	pipeline_key.pipeline_layout = get_pipeline_layout(pipeline_layout_key);
+	pipeline_layout_key.update_hash();
+	program.pipeline_layout = get_pipeline_layout(pipeline_layout_key);
 
-	lz::ComputePipeline *pipeline = get_compute_pipeline(pipeline_key);
+	const uint32_t new_program_id       = add_interned_program(std::move(program));
+	compute_shader_ids_[compute_shader] = new_program_id;
+	return new_program_id;
+}
 
-	command_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline->get_handle());
+uint32_t PipelineCache::add_interned_program(InternedProgram program)
+{
+	if (free_program_ids_.empty())
+	{
+		interned_programs_.push_back(std::move(program));
+		return uint32_t(interned_programs_.size() - 1);
+	}
 
-	pipeline_info.pipeline_layout = pipeline->get_layout();
-	return pipeline_info;
+	const uint32_t program_id = free_program_ids_.back();
+	free_program_ids_.pop_back();
+	interned_programs_[program_id] = std::move(program);
+	return program_id;
 }
 
-void PipelineCache::clear()
+void PipelineCache::recycle_program(uint32_t program_id)
 {
-	this->compute_pipeline_cache_.clear();
-	this->graphics_pipeline_cache_.clear();
-	this->pipeline_layout_cache_.clear();
+	interned_programs_[program_id] = InternedProgram();
+	free_program_ids_.push_back(program_id);
+}
+
+uint32_t PipelineCache::intern_vertex_declaration(const lz::VertexDeclaration &vertex_declaration)
+{
+	if (const uint32_t *vertex_decl_id = vertex_declaration_ids_.find(vertex_declaration))
+		return *vertex_decl_id;
+
+	const uint32_t new_vertex_decl_id           = uint32_t(vertex_declarations_.size());
+	vertex_declaration_ids_[vertex_declaration] = new_vertex_decl_id;
+	vertex_declarations_.push_back(vertex_declaration);
+	return new_vertex_decl_id;
+}
+
+uint32_t PipelineCache::intern_blend_settings(const std::vector<lz::BlendSettings> &attachment_blend_settings)
+{
+	if (const uint32_t *blend_settings_id = blend_settings_ids_.find(attachment_blend_settings))
+		return *blend_settings_id;
+
+	const uint32_t new_blend_settings_id           = uint32_t(attachment_blend_settings_.size());
+	blend_settings_ids_[attachment_blend_settings] = new_blend_settings_id;
+	attachment_blend_settings_.push_back(attachment_blend_settings);
+	return new_blend_settings_id;
+}
+
+size_t PipelineCache::VertexDeclarationHash::operator()(const lz::VertexDeclaration &vertex_declaration) const
+{
+	size_t hash = 0;
+	for (const auto &binding : vertex_declaration.get_binding_descriptors())
+	{
+		hash_combine(hash, binding.binding);
+		hash_combine(hash, binding.stride);
+		hash_combine(hash, binding.inputRate);
+	}
+	for (const auto &attribute : vertex_declaration.get_vertex_attributes())
+	{
+		hash_combine(hash, attribute.location);
+		hash_combine(hash, attribute.binding);
+		hash_combine(hash, attribute.format);
+		hash_combine(hash, attribute.offset);
+	}
+	return hash;
+}
+
+size_t PipelineCache::BlendSettingsHash::operator()(const std::vector<lz::BlendSettings> &attachment_blend_settings) const
+{
+	size_t hash = attachment_blend_settings.size();
+	for (const auto &blend_settings : attachment_blend_settings)
+	{
+		const auto &blend_state = blend_settings.blend_state;
+		hash_combine(hash, blend_state.blendEnable);
+		hash_combine(hash, blend_state.srcColorBlendFactor);
+		hash_combine(hash, blend_state.dstColorBlendFactor);
+		hash_combine(hash, blend_state.colorBlendOp);
+		hash_combine(hash, blend_state.srcAlphaBlendFactor);
+		hash_combine(hash, blend_state.dstAlphaBlendFactor);
+		hash_combine(hash, blend_state.alphaBlendOp);
+		hash_combine(hash, VkColorComponentFlags(blend_state.colorWriteMask));
+	}
+	return hash;
+}
+
+void PipelineCache::PipelineLayoutKey::update_hash()
+{
+	hash = set_layouts.size();
+	for (const auto set_layout : set_layouts)
+	{
+		hash_combine(hash, set_layout);
+	}
 }
 
-bool PipelineCache::PipelineLayoutKey::operator<(const PipelineLayoutKey &other) const
+bool PipelineCache::PipelineLayoutKey::operator==(const PipelineLayoutKey &other) const
 {
-	return std::tie(set_layouts) < std::tie(other.set_layouts);
+	return set_layouts == other.set_layouts;
 }
 
 vk::UniquePipelineLayout PipelineCache::create_pipeline_layout(
@@ -121,43 +421,77 @@ vk::PipelineLayout PipelineCache::get_pipeline_layout(const PipelineLayoutKey &k
 
 PipelineCache::GraphicsPipelineKey::GraphicsPipelineKey()
 {
-	render_pass = nullptr;
+	program_id                   = 0;
+	vertex_decl_id               = 0;
+	attachment_blend_settings_id = 0;
+	render_pass                  = nullptr;
+	depth_settings               = lz::DepthSettings::disabled();
+	cull_mode                    = vk::CullModeFlagBits::eNone;
+	topology                     = vk::PrimitiveTopology::eTriangleList;
+	hash                         = 0;
 }
 
-bool PipelineCache::GraphicsPipelineKey::operator<(const GraphicsPipelineKey &other) const
+void PipelineCache::GraphicsPipelineKey::update_hash()
 {
-	return std::tie(shader_stages, vertex_decl, pipeline_layout, render_pass, depth_settings,
-	                attachment_blend_settings, topology) <
-	       std::tie(shader_stages, other.vertex_decl, other.pipeline_layout,
-	                other.render_pass, other.depth_settings, other.attachment_blend_settings, topology);
+	hash = 0;
+	hash_combine(hash, program_id);
+	hash_combine(hash, vertex_decl_id);
+	hash_combine(hash, attachment_blend_settings_id);
+	hash_combine(hash, render_pass);
+	hash_combine(hash, depth_settings.depth_func);
+	hash_combine(hash, depth_settings.write_enable);
+	hash_combine(hash, VkCullModeFlags(cull_mode));
+	hash_combine(hash, topology);
+}
+
+bool PipelineCache::GraphicsPipelineKey::operator==(const GraphicsPipelineKey &other) const
+{
+	return program_id == other.program_id && vertex_decl_id == other.vertex_decl_id &&
+	       attachment_blend_settings_id == other.attachment_blend_settings_id && render_pass == other.render_pass &&
+	       depth_settings == other.depth_settings && cull_mode == other.cull_mode && topology == other.topology;
 }
 
 lz::GraphicsPipeline *PipelineCache::get_graphics_pipeline(const GraphicsPipelineKey &key)
 {
 	auto &pipeline = graphics_pipeline_cache_[key];
 	if (!pipeline)
-		pipeline = std::make_unique<lz::GraphicsPipeline>(
-		    logical_device_, key.shader_stages, key.vertex_decl, key.pipeline_layout,
-		    key.depth_settings, key.attachment_blend_settings, key.topology, key.render_pass);
+	{
+		const InternedProgram &program = interned_programs_[key.program_id];
+		pipeline                       = std::make_unique<lz::GraphicsPipeline>(
+		    logical_device_, program.shader_stages, vertex_declarations_[key.vertex_decl_id], program.pipeline_layout,
+		    key.depth_settings, key.cull_mode, attachment_blend_settings_[key.attachment_blend_settings_id], key.topology,
+		    key.render_pass, extended_dynamic_state_);
+	}
 	return pipeline.get();
 }
 
 PipelineCache::ComputePipelineKey::ComputePipelineKey()
 {
-	compute_shader = nullptr;
+	program_id = 0;
+	hash       = 0;
 }
 
-bool PipelineCache::ComputePipelineKey::operator<(const ComputePipelineKey &other) const
+void PipelineCache::ComputePipelineKey::update_hash()
 {
-	return std::tie(compute_shader, pipeline_layout) <
-	       std::tie(other.compute_shader, other.pipeline_layout);
+	hash = 0;
+	hash_combine(hash, program_id);
+}
+
+bool PipelineCache::ComputePipelineKey::operator==(const ComputePipelineKey &other) const
+{
+	return program_id == other.program_id;
 }
 
 lz::ComputePipeline *PipelineCache::get_compute_pipeline(const ComputePipelineKey &key)
 {
 	auto &pipeline = compute_pipeline_cache_[key];
 	if (!pipeline)
-		pipeline = std::make_unique<lz::ComputePipeline>(logical_device_, key.compute_shader, key.pipeline_layout);
+	{
+		const InternedProgram &program = interned_programs_[key.program_id];
+		pipeline                       = std::make_unique<lz::ComputePipeline>(
+		    logical_device_, program.modules[0], program.pipeline_layout, program.shader_stages[0].specialization_constants,
+		    program.descriptor_buffer);
+	}
 	return pipeline.get();
 }
 }        // namespace lz
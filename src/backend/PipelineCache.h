@@ -1,8 +1,10 @@
 #pragma once
 #include <map>
+#include <set>
 
 #include "Config.h"
 #include "DescriptorSetCache.h"
+#include "FlatHashMap.h"
 #include "Pipeline.h"
 #include "VertexDeclaration.h"
 
@@ -13,10 +15,11 @@ struct ShaderStageInfo
 {
 	vk::ShaderStageFlagBits stage;
 	vk::ShaderModule        module;
+	SpecializationConstants specialization_constants;        // only the constants the stage declares
 
 	bool operator<(const ShaderStageInfo &other) const
 	{
-		return std::tie(stage, module) < std::tie(other.stage, other.module);
+		return std::tie(stage, module, specialization_constants) < std::tie(other.stage, other.module, other.specialization_constants);
 	}
 };
 
@@ -29,16 +32,30 @@ class PipelineCache
 	{
 		vk::PipelineLayout                   pipeline_layout;
 		std::vector<vk::DescriptorSetLayout> descriptor_set_layouts;
+		bool                                 descriptor_buffer = false;        // sets are bound through the descriptor buffer
 	};
 
+	// GraphicsPipelineState: Interned vertex declaration and attachment blend settings of a pass and its cull mode,
+	// interned once when the pass is created so binds only put the ids in the key
+	struct GraphicsPipelineState
+	{
+		uint32_t          vertex_decl_id               = 0;
+		uint32_t          attachment_blend_settings_id = 0;
+		vk::CullModeFlags cull_mode                    = vk::CullModeFlagBits::eNone;
+	};
+
+	// InternGraphicsPipelineState: State bind_graphics_pipeline takes, the ids stay valid across clear()
+	GraphicsPipelineState intern_graphics_pipeline_state(const std::vector<lz::BlendSettings> &attachment_blend_settings,
+	                                                     const lz::VertexDeclaration          &vertex_declaration,
+	                                                     vk::CullModeFlags                     cull_mode = vk::CullModeFlagBits::eNone);
+
 	PipelineInfo bind_graphics_pipeline(
-	    vk::CommandBuffer                     command_buffer,
-	    vk::RenderPass                        render_pass,
-	    lz::DepthSettings                     depth_settings,
-	    const std::vector<lz::BlendSettings> &attachment_blend_settings,
-	    const lz::VertexDeclaration          &vertex_declaration,
-	    vk::PrimitiveTopology                 topology,
-	    const lz::ShaderProgram              *shader_program);
+	    vk::CommandBuffer        command_buffer,
+	    vk::RenderPass           render_pass,
+	    lz::DepthSettings        depth_settings,
+	    GraphicsPipelineState    pipeline_state,
+	    vk::PrimitiveTopology    topology,
+	    const lz::ShaderProgram *shader_program);
 
 	PipelineInfo bind_compute_pipeline(
 	    vk::CommandBuffer command_buffer,
@@ -46,52 +63,172 @@ class PipelineCache
 
 	void clear();
 
-  private:
+	// EnableExtendedDynamicState: Builds pipelines with dynamic cull mode and depth state, bind_graphics_pipeline sets them
+	// on the command buffer so pipelines that only differ in those share one pipeline, called before any pipeline is built
+	void enable_extended_dynamic_state(const vk::DispatchLoaderDynamic &loader);
+
+	// EnableDescriptorBuffer: Builds compute pipelines that do not use the bindless set for VK_EXT_descriptor_buffer,
+	// their sets are bound with DescriptorSetCache::bind_descriptor_set, called before any pipeline is built
+	void enable_descriptor_buffer();
+
+	// GetPipelineDepthSettings: The depth settings a pipeline bound with the given ones is built and looked up with
+	lz::DepthSettings get_pipeline_depth_settings(lz::DepthSettings depth_settings) const;
+
+	// GetPipelineCullMode: The cull mode a pipeline bound with the given one is built and looked up with
+	vk::CullModeFlags get_pipeline_cull_mode(vk::CullModeFlags cull_mode) const;
+
+	// GetGraphicsPipelinesCount: Number of cached graphics pipelines, the render area is dynamic so resizes do not add any
+	size_t get_graphics_pipelines_count() const;
+
+	// SetSpecializationConstants: Values pipelines specialize their stages with, each stage takes the constants its
+	// reflection declares so stages without them keep sharing pipelines
+	void set_specialization_constants(const SpecializationConstants &specialization_constants);
+
+	const SpecializationConstants &get_specialization_constants() const;
+
+	// EvictPipelines: Moves the pipelines built from any of the shader modules out of the cache, the caller destroys them
+	// once no frame in flight uses them, pipeline layouts are kept and the programs using the modules are interned again
+	// under recycled ids
+	void evict_pipelines(const std::set<vk::ShaderModule>                     &shader_modules,
+	                     std::vector<std::unique_ptr<lz::GraphicsPipeline>> &graphics_pipelines,
+	                     std::vector<std::unique_ptr<lz::ComputePipeline>>  &compute_pipelines);
+
+	// InternVertexDeclaration: Id graphics pipeline keys refer to the declaration with, equal declarations share one id
+	uint32_t intern_vertex_declaration(const lz::VertexDeclaration &vertex_declaration);
+
+	// InternBlendSettings: Id graphics pipeline keys refer to the attachment blend settings with, compared on every field
+	uint32_t intern_blend_settings(const std::vector<lz::BlendSettings> &attachment_blend_settings);
+
+	// Keys the cached objects are looked up by, only compared on the CPU
+	// - Keys are small and flat, the stages, layout, vertex declaration and blend settings of a pipeline are interned
+	//   once and keys hold their ids
+	// - update_hash() hashes every field once the key is filled, lookups compare the cached hash before the key
 	struct PipelineLayoutKey
 	{
 		std::vector<vk::DescriptorSetLayout> set_layouts;
+		size_t                               hash = 0;
 
-		bool operator<(const PipelineLayoutKey &other) const;
+		void update_hash();
+		bool operator==(const PipelineLayoutKey &other) const;
 	};
 
-	vk::UniquePipelineLayout create_pipeline_layout(const std::vector<vk::DescriptorSetLayout> &set_layouts /*, push constant ranges*/);
-
-	vk::PipelineLayout get_pipeline_layout(const PipelineLayoutKey &key);
-
 	struct GraphicsPipelineKey
 	{
 		GraphicsPipelineKey();
 
-		std::vector<ShaderStageInfo>   shader_stages;
-		lz::VertexDeclaration          vertex_decl;
-		vk::PipelineLayout             pipeline_layout;
-		vk::Extent2D                   extent;
-		vk::RenderPass                 render_pass;
-		lz::DepthSettings              depth_settings;
-		std::vector<lz::BlendSettings> attachment_blend_settings;
-		vk::PrimitiveTopology          topology;
-
-		bool operator<(const GraphicsPipelineKey &other) const;
+		uint32_t              program_id;        // stages and pipeline layout
+		uint32_t              vertex_decl_id;
+		uint32_t              attachment_blend_settings_id;
+		vk::RenderPass        render_pass;
+		lz::DepthSettings     depth_settings;
+		vk::CullModeFlags     cull_mode;
+		vk::PrimitiveTopology topology;
+		size_t                hash;
+
+		void update_hash();
+		bool operator==(const GraphicsPipelineKey &other) const;
 	};
 
-	lz::GraphicsPipeline *get_graphics_pipeline(const GraphicsPipelineKey &key);
-
 	struct ComputePipelineKey
 	{
 		ComputePipelineKey();
 
-		vk::ShaderModule   compute_shader;
-		vk::PipelineLayout pipeline_layout;
+		uint32_t program_id;        // module, specialization constants, pipeline layout and descriptor buffer use
+		size_t   hash;
+
+		void update_hash();
+		bool operator==(const ComputePipelineKey &other) const;
+	};
+
+	// KeyHash: Returns the hash update_hash() cached in the key
+	struct KeyHash
+	{
+		template <typename Key>
+		size_t operator()(const Key &key) const
+		{
+			return key.hash;
+		}
+	};
+
+	// InternProgram: Id of the interned stages and pipeline layout of the program, interned again if its modules changed
+	uint32_t intern_program(const lz::ShaderProgram *shader_program);
+
+	// InternComputeShader: Id of the interned compute stage, its pipeline layout and whether it binds the descriptor buffer
+	uint32_t intern_compute_shader(lz::Shader *compute_shader);
+
+	// GetProgramStages: Stages of an interned program with the constants each of them is specialized with
+	const std::vector<ShaderStageInfo> &get_program_stages(uint32_t program_id) const;
+
+	// GetStageSpecializationConstants: The configured values of the constants the shader declares
+	SpecializationConstants get_stage_specialization_constants(const lz::Shader *shader) const;
+
+	// MakeGraphicsPipelineKey: Key bind_graphics_pipeline looks the pipeline of an interned program up with
+	GraphicsPipelineKey make_graphics_pipeline_key(vk::RenderPass render_pass, lz::DepthSettings depth_settings,
+	                                               GraphicsPipelineState pipeline_state, vk::PrimitiveTopology topology,
+	                                               uint32_t program_id) const;
+
+	// MakeComputePipelineKey: Key bind_compute_pipeline looks the pipeline of an interned compute shader up with
+	ComputePipelineKey make_compute_pipeline_key(uint32_t program_id) const;
+
+  private:
+	// InternedProgram: Everything a pipeline takes from its shaders, built the first time a pass binds the program
+	struct InternedProgram
+	{
+		std::vector<vk::ShaderModule> modules;        // the program is interned again once its shaders are reloaded
+		std::vector<ShaderStageInfo>  shader_stages;
+		vk::PipelineLayout            pipeline_layout;
+		bool                          descriptor_buffer = false;
+	};
 
-		bool operator<(const ComputePipelineKey &other) const;
+	struct VertexDeclarationHash
+	{
+		size_t operator()(const lz::VertexDeclaration &vertex_declaration) const;
+	};
+
+	struct BlendSettingsHash
+	{
+		size_t operator()(const std::vector<lz::BlendSettings> &attachment_blend_settings) const;
 	};
 
+	vk::UniquePipelineLayout create_pipeline_layout(const std::vector<vk::DescriptorSetLayout> &set_layouts /*, push constant ranges*/);
+
+	vk::PipelineLayout get_pipeline_layout(const PipelineLayoutKey &key);
+
+	lz::GraphicsPipeline *get_graphics_pipeline(const GraphicsPipelineKey &key);
+
 	lz::ComputePipeline *get_compute_pipeline(const ComputePipelineKey &key);
 
-	std::map<GraphicsPipelineKey, std::unique_ptr<lz::GraphicsPipeline>> graphics_pipeline_cache_;
-	std::map<ComputePipelineKey, std::unique_ptr<lz::ComputePipeline>>   compute_pipeline_cache_;
-	std::map<PipelineLayoutKey, vk::UniquePipelineLayout>                pipeline_layout_cache_;
-	lz::DescriptorSetCache                                              *descriptor_set_cache_;
+	uint32_t add_interned_program(InternedProgram program);
+
+	// RecycleProgram: Frees the slot of a program no cached pipeline and no lookup refers to anymore
+	void recycle_program(uint32_t program_id);
+
+	FlatHashMap<GraphicsPipelineKey, std::unique_ptr<lz::GraphicsPipeline>, KeyHash> graphics_pipeline_cache_;
+	FlatHashMap<ComputePipelineKey, std::unique_ptr<lz::ComputePipeline>, KeyHash>   compute_pipeline_cache_;
+	FlatHashMap<PipelineLayoutKey, vk::UniquePipelineLayout, KeyHash>                pipeline_layout_cache_;
+
+	// ids index the vectors, slots of evicted or respecialized programs go to the free list once no cached pipeline
+	// keys them and are handed to the next program interned, freed slots hold no modules
+	FlatHashMap<const lz::ShaderProgram *, uint32_t>                         program_ids_;
+	FlatHashMap<const lz::Shader *, uint32_t>                                compute_shader_ids_;
+	std::vector<InternedProgram>                                             interned_programs_;
+	std::vector<uint32_t>                                                    free_program_ids_;
+
+	// declarations and blend settings are few and held by passes as GraphicsPipelineState, clear() keeps them
+	FlatHashMap<lz::VertexDeclaration, uint32_t, VertexDeclarationHash>      vertex_declaration_ids_;
+	std::vector<lz::VertexDeclaration>                                       vertex_declarations_;
+	FlatHashMap<std::vector<lz::BlendSettings>, uint32_t, BlendSettingsHash> blend_settings_ids_;
+	std::vector<std::vector<lz::BlendSettings>>                              attachment_blend_settings_;
+
+	lz::DescriptorSetCache *descriptor_set_cache_;
+	SpecializationConstants specialization_constants_;
+
+	// set when the device has VK_EXT_extended_dynamic_state, the loader records the state commands
+	bool                      extended_dynamic_state_;
+	vk::DispatchLoaderDynamic loader_;
+
+	// set when the device has VK_EXT_descriptor_buffer
+	bool descriptor_buffer_;
 
 	vk::Device logical_device_;
 };
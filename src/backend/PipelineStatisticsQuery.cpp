@@ -0,0 +1,111 @@
+#include "PipelineStatisticsQuery.h"
+
+namespace lz
+{
+PipelineStatisticsQuery::PipelineStatisticsQuery(vk::Device logical_device, uint32_t max_query_count,
+                                                 vk::QueryPipelineStatisticFlags statistic_flags)
+{
+	// results are written in the order of the flag bits, PipelineStatistic follows the same order
+	for (uint32_t statistic_index = 0; statistic_index < uint32_t(PipelineStatistic::eCount); statistic_index++)
+	{
+		const auto statistic = PipelineStatistic(statistic_index);
+		if (statistic_flags & get_statistic_flag(statistic))
+		{
+			enabled_statistics_.push_back(statistic);
+		}
+	}
+
+	const auto query_pool_info = vk::QueryPoolCreateInfo()
+	                                 .setQueryType(vk::QueryType::ePipelineStatistics)
+	                                 .setQueryCount(max_query_count)
+	                                 .setPipelineStatistics(statistic_flags);
+	this->query_pool_ = logical_device.createQueryPoolUnique(query_pool_info);
+	this->statistics_datas_.resize(max_query_count);
+	this->query_results_.resize(max_query_count * (enabled_statistics_.size() + 1));        // values and availability per query
+	this->curr_query_index_ = 0;
+	this->query_active_     = false;
+}
+
+void PipelineStatisticsQuery::reset_query_pool(vk::CommandBuffer command_buffer)
+{
+	command_buffer.resetQueryPool(query_pool_.get(), 0, static_cast<uint32_t>(statistics_datas_.size()));
+	curr_query_index_ = 0;
+}
+
+void PipelineStatisticsQuery::begin_query(vk::CommandBuffer command_buffer, size_t query_name)
+{
+	assert(curr_query_index_ < statistics_datas_.size() && !query_active_);
+	command_buffer.beginQuery(query_pool_.get(), curr_query_index_, vk::QueryControlFlags());
+	statistics_datas_[curr_query_index_].query_name = query_name;
+	query_active_                                   = true;
+}
+
+void PipelineStatisticsQuery::end_query(vk::CommandBuffer command_buffer)
+{
+	assert(query_active_);
+	command_buffer.endQuery(query_pool_.get(), curr_query_index_);
+	curr_query_index_++;
+	query_active_ = false;
+}
+
+PipelineStatisticsQuery::QueryResult PipelineStatisticsQuery::query_results(vk::Device logical_device)
+{
+	QueryResult res;
+	res.data      = statistics_datas_.data();
+	res.size      = curr_query_index_;
+	res.available = false;
+	if (curr_query_index_ == 0)
+	{
+		return res;
+	}
+
+	const size_t stride = enabled_statistics_.size() + 1;
+	std::fill(query_results_.begin(), query_results_.end(), 0);
+	const auto query_res = logical_device.getQueryPoolResults(query_pool_.get(), 0, curr_query_index_,
+	                                                          query_results_.size() * sizeof(std::uint64_t),
+	                                                          query_results_.data(), stride * sizeof(std::uint64_t),
+	                                                          vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability);
+
+	res.available = query_res == vk::Result::eSuccess;
+	for (uint32_t query_index = 0; query_index < curr_query_index_ && res.available; query_index++)
+	{
+		res.available = query_results_[query_index * stride + enabled_statistics_.size()] != 0;
+	}
+
+	if (res.available)
+	{
+		for (uint32_t query_index = 0; query_index < curr_query_index_; query_index++)
+		{
+			auto &statistics = statistics_datas_[query_index].statistics;
+			statistics.fill(0);
+			for (size_t value_index = 0; value_index < enabled_statistics_.size(); value_index++)
+			{
+				statistics[size_t(enabled_statistics_[value_index])] = query_results_[query_index * stride + value_index];
+			}
+		}
+	}
+	return res;
+}
+
+vk::QueryPipelineStatisticFlagBits PipelineStatisticsQuery::get_statistic_flag(PipelineStatistic statistic)
+{
+	switch (statistic)
+	{
+		case PipelineStatistic::eVertexInvocations:
+			return vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations;
+		case PipelineStatistic::eClippingPrimitives:
+			return vk::QueryPipelineStatisticFlagBits::eClippingPrimitives;
+		case PipelineStatistic::eFragmentInvocations:
+			return vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations;
+		case PipelineStatistic::eComputeInvocations:
+			return vk::QueryPipelineStatisticFlagBits::eComputeShaderInvocations;
+		case PipelineStatistic::eTaskInvocations:
+			return vk::QueryPipelineStatisticFlagBits::eTaskShaderInvocationsEXT;
+		case PipelineStatistic::eMeshInvocations:
+			return vk::QueryPipelineStatisticFlagBits::eMeshShaderInvocationsEXT;
+		default:
+			assert(false);
+			return vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations;
+	}
+}
+}        // namespace lz
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Config.h"
+#include "ProfilerTask.h"
+
+namespace lz
+{
+// PipelineStatisticsQuery: Pool of pipeline statistics queries, one query per profiled task
+// - Only the statistics in statistic_flags are collected, results of the others stay zero
+// - Queries must not overlap, every begin_query has to be ended before the next one begins
+struct PipelineStatisticsQuery
+{
+	PipelineStatisticsQuery(vk::Device logical_device, uint32_t max_query_count, vk::QueryPipelineStatisticFlags statistic_flags);
+
+	void reset_query_pool(vk::CommandBuffer command_buffer);
+
+	void begin_query(vk::CommandBuffer command_buffer, size_t query_name);
+
+	void end_query(vk::CommandBuffer command_buffer);
+
+	struct QueryResult
+	{
+		struct StatisticsData
+		{
+			size_t             query_name;
+			PipelineStatistics statistics;
+		};
+
+		const StatisticsData *data;
+		size_t                size;
+		bool                  available;        // false while the GPU has not finished every query yet
+	};
+
+	// Reads the statistics without waiting, check QueryResult::available before using the data
+	QueryResult query_results(vk::Device logical_device);
+
+	// Returns the Vulkan flag a statistic is collected with
+	static vk::QueryPipelineStatisticFlagBits get_statistic_flag(PipelineStatistic statistic);
+
+  private:
+	std::vector<PipelineStatistic>           enabled_statistics_;        // in the order results are written
+	std::vector<uint64_t>                    query_results_;
+	std::vector<QueryResult::StatisticsData> statistics_datas_;
+	vk::UniqueQueryPool                      query_pool_;
+	uint32_t                                 curr_query_index_;
+	bool                                     query_active_;
+};
+}        // namespace lz
@@ -81,13 +81,18 @@ vk::Extent2D PresentQueue::get_image_size()
 }
 
 InFlightQueue::InFlightQueue(lz::Core *core, lz::WindowDesc window_desc, uint32_t in_flight_count,
-                             vk::PresentModeKHR preferred_mode)
+                             vk::PresentModeKHR preferred_mode) :
+    cpu_profiler_(lz::CpuProfiler::get())
 {
 	this->core_            = core;
 	this->window_desc_     = window_desc;
 	this->in_flight_count_ = in_flight_count;
 	this->preferred_mode_  = preferred_mode;
-	this->memory_pool_     = std::make_unique<lz::ShaderMemoryPool>(core->get_dynamic_memory_alignment());
+	this->memory_pool_     = std::make_unique<lz::ShaderMemoryPool>(core, in_flight_count);
+
+	// one more query pool than frames in flight so that readback can lag behind by a frame without dropping it
+	this->gpu_profiler_ = std::make_unique<lz::GpuProfiler>(core->get_physical_device(), core->get_logical_device(),
+	                                                        512, in_flight_count + 1, core->get_pipeline_statistic_flags());
 
 	present_queue_.reset(new PresentQueue(core, window_desc, in_flight_count, preferred_mode));
 	init_frame_resources();
@@ -118,12 +123,6 @@ void InFlightQueue::init_frame_resources()
 		frame.command_buffer = std::move(core_->allocate_command_buffers(1)[0]);
 		core_->set_object_debug_name(frame.command_buffer.get(),
 		                             std::string("Frame") + std::to_string(frame_index) + " command buffer");
-		frame.shader_memory_buffer = std::make_unique<lz::Buffer>(
-		    core_->get_physical_device(), core_->get_logical_device(), 100000000,
-		    vk::BufferUsageFlagBits::eUniformBuffer,
-		    vk::MemoryPropertyFlagBits::eHostCoherent);
-		frame.gpu_profiler = std::make_unique<lz::GpuProfiler>(core_->get_physical_device(),
-		                                                       core_->get_logical_device(), 512);
 		frames_.push_back(std::move(frame));
 	}
 	frame_index_ = 0;
@@ -157,7 +156,8 @@ InFlightQueue::FrameInfo InFlightQueue::begin_frame()
 
 	{
 		auto gpu_gathering_task = cpu_profiler_.start_scoped_task("GpuPrfGathering", lz::Colors::amethyst);
-		curr_frame.gpu_profiler->gather_timestamps();
+		gpu_profiler_->gather_timestamps();
+		gpu_profiler_->take_resolved_frames(last_frame_gpu_resolved_frames_);
 	}
 
 	auto &swapchain_view_proxy_id = swapchain_image_view_proxies_[curr_swapchain_image_view_];
@@ -167,7 +167,14 @@ InFlightQueue::FrameInfo InFlightQueue::begin_frame()
 	}
 	core_->get_render_graph()->add_pass(lz::RenderGraph::FrameSyncBeginPassDesc());
 
-	memory_pool_->map_buffer(curr_frame.shader_memory_buffer.get());
+	memory_pool_->begin_frame(static_cast<uint32_t>(frame_index_));
+	if (core_->get_descriptor_buffer())
+	{
+		core_->get_descriptor_buffer()->begin_frame(static_cast<uint32_t>(frame_index_));
+	}
+
+	// the fence of this frame signaled, material slots released in frames that are now finished can be recycled
+	core_->process_pending_material_updates();
 
 	FrameInfo frame_info;
 	frame_info.memory_pool                   = memory_pool_.get();
@@ -188,12 +195,13 @@ void InFlightQueue::end_frame()
 	                                       .setFlags(vk::CommandBufferUsageFlagBits::eSimultaneousUse);
 	curr_frame.command_buffer->begin(buffer_begin_info);
 	{
-		auto gpuFrame = curr_frame.gpu_profiler->start_scoped_frame(curr_frame.command_buffer.get());
-		core_->get_render_graph()->execute(curr_frame.command_buffer.get(), &cpu_profiler_, curr_frame.gpu_profiler.get());
+		auto gpuFrame = gpu_profiler_->start_scoped_frame(curr_frame.command_buffer.get());
+		core_->get_render_graph()->execute(curr_frame.command_buffer.get(), &cpu_profiler_, gpu_profiler_.get());
 	}
 	curr_frame.command_buffer->end();
 
-	memory_pool_->unmap_buffer();
+	memory_pool_->end_frame();
+	core_->get_descriptor_set_cache()->end_frame();
 
 	{
 		{
@@ -229,7 +237,22 @@ const std::vector<lz::ProfilerTask> &InFlightQueue::get_last_frame_cpu_profiler_
 
 const std::vector<lz::ProfilerTask> &InFlightQueue::get_last_frame_gpu_profiler_data()
 {
-	return frames_[frame_index_].gpu_profiler->get_profiler_tasks();
+	return gpu_profiler_->get_profiler_tasks();
+}
+
+const std::vector<std::vector<lz::ProfilerTask>> &InFlightQueue::get_last_frame_gpu_resolved_frames() const
+{
+	return last_frame_gpu_resolved_frames_;
+}
+
+GpuProfiler &InFlightQueue::get_gpu_profiler()
+{
+	return *gpu_profiler_;
+}
+
+const ShaderMemoryPool *InFlightQueue::get_memory_pool() const
+{
+	return memory_pool_.get();
 }
 
 CpuProfiler &InFlightQueue::get_cpu_profiler()
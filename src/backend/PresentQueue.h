@@ -68,10 +68,19 @@ struct InFlightQueue
 
 	const std::vector<lz::ProfilerTask> &get_last_frame_gpu_profiler_data();
 
+	// GetLastFrameGpuResolvedFrames: GPU tasks of every frame whose results arrived during the last begin_frame(), a
+	// recorded frame shows up here exactly once
+	const std::vector<std::vector<lz::ProfilerTask>> &get_last_frame_gpu_resolved_frames() const;
+
 	CpuProfiler &get_cpu_profiler();
 
+	const ShaderMemoryPool *get_memory_pool() const;
+
+	GpuProfiler &get_gpu_profiler();
+
   private:
 	std::unique_ptr<lz::ShaderMemoryPool>                            memory_pool_;
+	std::unique_ptr<lz::GpuProfiler>                                 gpu_profiler_;
 	std::map<lz::ImageView *, lz::RenderGraph::ImageViewProxyUnique> swapchain_image_view_proxies_;
 
 	lz::WindowDesc     window_desc_;
@@ -84,9 +93,7 @@ struct InFlightQueue
 		vk::UniqueSemaphore rendering_finished_semaphore;
 		vk::UniqueFence     in_flight_fence;
 
-		vk::UniqueCommandBuffer          command_buffer;
-		std::unique_ptr<lz::Buffer>      shader_memory_buffer;
-		std::unique_ptr<lz::GpuProfiler> gpu_profiler;
+		vk::UniqueCommandBuffer command_buffer;
 	};
 
 	std::vector<FrameResources> frames_;
@@ -95,9 +102,11 @@ struct InFlightQueue
 	lz::Core                     *core_;
 	lz::ImageView                *curr_swapchain_image_view_;
 	std::unique_ptr<PresentQueue> present_queue_;
-	lz::CpuProfiler               cpu_profiler_;
+	lz::CpuProfiler              &cpu_profiler_;
 	std::vector<lz::ProfilerTask> last_frame_cpu_profiler_tasks_;
 
+	std::vector<std::vector<lz::ProfilerTask>> last_frame_gpu_resolved_frames_;
+
 	size_t profiler_frame_id_;
 };
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <string>
 
 namespace lz
@@ -34,6 +35,41 @@ static constexpr uint32_t silver     = RGBA_LE(0xbdc3c7ffu);
 static constexpr uint32_t imgui_text = RGBA_LE(0xF2F5FAFFu);
 }        // namespace Colors
 
+// PipelineStatistic: Counters collected per GPU task when pipeline statistics queries are enabled
+enum class PipelineStatistic : uint32_t
+{
+	eVertexInvocations,
+	eClippingPrimitives,
+	eFragmentInvocations,
+	eComputeInvocations,
+	eTaskInvocations,
+	eMeshInvocations,
+	eCount
+};
+
+inline const char *get_pipeline_statistic_name(PipelineStatistic statistic)
+{
+	switch (statistic)
+	{
+		case PipelineStatistic::eVertexInvocations:
+			return "Vertex invocations";
+		case PipelineStatistic::eClippingPrimitives:
+			return "Clipping primitives";
+		case PipelineStatistic::eFragmentInvocations:
+			return "Fragment invocations";
+		case PipelineStatistic::eComputeInvocations:
+			return "Compute invocations";
+		case PipelineStatistic::eTaskInvocations:
+			return "Task invocations";
+		case PipelineStatistic::eMeshInvocations:
+			return "Mesh invocations";
+		default:
+			return "Unknown";
+	}
+}
+
+using PipelineStatistics = std::array<uint64_t, size_t(PipelineStatistic::eCount)>;
+
 struct ProfilerTask
 {
 	double      start_time;
@@ -41,6 +77,14 @@ struct ProfilerTask
 	std::string name;
 	uint32_t    color;
 
+	// filled by CpuProfiler only, nested tasks and tasks of other threads overlap the tasks they run alongside
+	uint32_t thread_index = 0;
+	uint32_t depth        = 0;
+
+	// filled by GpuProfiler only, zero for statistics the device does not expose
+	bool               has_pipeline_statistics = false;
+	PipelineStatistics pipeline_statistics{};
+
 	double get_length() const
 	{
 		return end_time - start_time;
@@ -2,8 +2,11 @@
 
 #include "Buffer.h"
 #include "Core.h"
+#include "DescriptorSetCache.h"
+#include "EngineConfig.h"
 #include "GpuProfiler.h"
 #include "ImageView.h"
+#include "MemoryTracker.h"
 
 namespace lz
 {
@@ -25,17 +28,12 @@ ImageCache::ImageCache(vk::PhysicalDevice physical_device, vk::Device logical_de
 
 void ImageCache::release()
 {
-	for (auto &cache_entry : image_cache_)
-	{
-		cache_entry.second.used_count = 0;
-	}
+	image_cache_.release();
 }
 
 lz::ImageData *ImageCache::get_image(ImageKey image_key)
 {
-	auto &cache_entry = image_cache_[image_key];
-	if (cache_entry.used_count + 1 > cache_entry.images.size())
-	{
+	lz::Image *image = image_cache_.get(image_key, [&]() {
 		vk::ImageCreateInfo image_create_info;
 		if (image_key.size.z == glm::u32(-1))
 		{
@@ -52,17 +50,29 @@ lz::ImageData *ImageCache::get_image(ImageKey image_key)
 			                                                  image_key.usage_flags);
 		}
 
+		MemoryTracker::ScopedCategory memory_category(MemoryCategory::eRenderGraph);
+
 		auto new_image = std::make_unique<lz::Image>(physical_device_, logical_device_, image_create_info);
 		Core::set_object_debug_name(logical_device_, loader_, new_image->get_image_data()->get_handle(),
 		                            image_key.debug_name);
-		cache_entry.images.emplace_back(std::move(new_image));
-	}
-	return cache_entry.images[cache_entry.used_count++]->get_image_data();
+		return new_image;
+	});
+	return image->get_image_data();
 }
 
-ImageCache::ImageCacheEntry::ImageCacheEntry() :
-    used_count(0)
+void ImageCache::evict_unused(uint64_t max_unused_frames, std::vector<std::unique_ptr<lz::Image>> &evicted_images)
 {
+	image_cache_.evict_unused(max_unused_frames, evicted_images);
+}
+
+size_t ImageCache::get_images_count() const
+{
+	return image_cache_.get_resources_count();
+}
+
+vk::DeviceSize ImageCache::get_memory_size() const
+{
+	return image_cache_.get_memory_size();
 }
 
 bool ImageViewCache::ImageViewKey::operator<(const ImageViewKey &other) const
@@ -89,6 +99,22 @@ lz::ImageView *ImageViewCache::get_image_view(ImageViewKey image_view_key)
 	return image_view.get();
 }
 
+void ImageViewCache::evict_image_views(const std::set<const lz::ImageData *> &images, std::set<const lz::ImageView *> &evicted_views)
+{
+	for (auto it = image_view_cache_.begin(); it != image_view_cache_.end();)
+	{
+		if (images.count(it->first.image) > 0)
+		{
+			evicted_views.insert(it->second.get());
+			it = image_view_cache_.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
 BufferCache::BufferCache(vk::PhysicalDevice physical_device, vk::Device logical_device) :
     physical_device_(physical_device),
     logical_device_(logical_device)
@@ -102,31 +128,37 @@ bool BufferCache::BufferKey::operator<(const BufferKey &other) const
 
 void BufferCache::release()
 {
-	for (auto &cache_entry : buffer_cache_)
-	{
-		cache_entry.second.used_count = 0;
-	}
+	buffer_cache_.release();
 }
 
 lz::Buffer *BufferCache::get_buffer(BufferKey buffer_key)
 {
-	auto &cache_entry = buffer_cache_[buffer_key];
-	if (cache_entry.used_count + 1 > cache_entry.buffers.size())
-	{
-		auto new_buffer = std::make_unique<lz::Buffer>(
+	return buffer_cache_.get(buffer_key, [&]() {
+		MemoryTracker::ScopedCategory memory_category(MemoryCategory::eRenderGraph);
+
+		return std::make_unique<lz::Buffer>(
 		    physical_device_,
 		    logical_device_,
 		    buffer_key.element_size * buffer_key.elements_count,
-		    vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndirectBuffer,
+		    vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndirectBuffer |
+		        vk::BufferUsageFlagBits::eShaderDeviceAddress,
 		    vk::MemoryPropertyFlagBits::eDeviceLocal);
-		cache_entry.buffers.emplace_back(std::move(new_buffer));
-	}
-	return cache_entry.buffers[cache_entry.used_count++].get();
+	});
+}
+
+void BufferCache::evict_unused(uint64_t max_unused_frames, std::vector<std::unique_ptr<lz::Buffer>> &evicted_buffers)
+{
+	buffer_cache_.evict_unused(max_unused_frames, evicted_buffers);
 }
 
-BufferCache::BufferCacheEntry::BufferCacheEntry() :
-    used_count(0)
+size_t BufferCache::get_buffers_count() const
 {
+	return buffer_cache_.get_resources_count();
+}
+
+vk::DeviceSize BufferCache::get_memory_size() const
+{
+	return buffer_cache_.get_memory_size();
 }
 
 RenderGraph::ImageHandleInfo::ImageHandleInfo()
@@ -201,10 +233,13 @@ RenderGraph::BufferProxyId RenderGraph::BufferHandleInfo::id() const
 }
 
 RenderGraph::RenderGraph(vk::PhysicalDevice physical_device, vk::Device logical_device,
-                         vk::DispatchLoaderDynamic loader) :
+                         vk::DispatchLoaderDynamic loader, lz::DescriptorSetCache *descriptor_set_cache,
+                         bool extended_dynamic_state) :
     physical_device_(physical_device),
     logical_device_(logical_device),
     loader_(loader),
+    descriptor_set_cache_(descriptor_set_cache),
+    extended_dynamic_state_(extended_dynamic_state),
     render_pass_cache_(logical_device),
     framebuffer_cache_(logical_device),
     image_cache_(physical_device, logical_device, loader),
@@ -504,7 +539,7 @@ void RenderGraph::add_pass(RenderPassDesc &render_pass_desc)
 
 void RenderGraph::clear()
 {
-	*this = RenderGraph(physical_device_, logical_device_, loader_);
+	*this = RenderGraph(physical_device_, logical_device_, loader_, descriptor_set_cache_, extended_dynamic_state_);
 }
 
 RenderGraph::ComputePassDesc::ComputePassDesc()
@@ -834,6 +869,15 @@ void RenderGraph::execute(vk::CommandBuffer command_buffer, lz::CpuProfiler *cpu
 				framebuffer_cache_.begin_pass(command_buffer, color_attachments,
 				                              depth_present ? (&depth_attachment) : nullptr, render_pass,
 				                              render_pass_desc.render_area_extent);
+
+				// viewport and scissor come from begin_pass, pipelines bound by the pass override the cull mode and depth state
+				if (extended_dynamic_state_)
+				{
+					command_buffer.setCullModeEXT(vk::CullModeFlagBits::eNone, loader_);
+					command_buffer.setDepthTestEnableEXT(depth_present, loader_);
+					command_buffer.setDepthWriteEnableEXT(depth_present, loader_);
+					command_buffer.setDepthCompareOpEXT(vk::CompareOp::eLess, loader_);
+				}
 				pass_context.command_buffer_ = command_buffer;
 				render_pass_desc.record_func(pass_context);
 				framebuffer_cache_.end_pass(command_buffer);
@@ -1075,7 +1119,44 @@ void RenderGraph::execute(vk::CommandBuffer command_buffer, lz::CpuProfiler *cpu
 
 	flush_external_images(command_buffer, cpu_profiler, gpu_profiler);
 
+	last_executed_passes_.resize(tasks_.size());
+	for (size_t task_index = 0; task_index < tasks_.size(); ++task_index)
+	{
+		const auto &task          = tasks_[task_index];
+		auto       &executed_pass = last_executed_passes_[task_index];
+		switch (task.type)
+		{
+			case Task::Types::eRenderPass:
+				executed_pass.type = "RenderPass";
+				executed_pass.name = render_pass_descs_[task.index].profiler_task_name;
+				break;
+			case Task::Types::eComputePass:
+				executed_pass.type = "ComputePass";
+				executed_pass.name = compute_pass_descs_[task.index].profiler_task_name;
+				break;
+			case Task::Types::eTransferPass:
+				executed_pass.type = "TransferPass";
+				executed_pass.name = transfer_pass_descs_[task.index].profiler_task_name;
+				break;
+			case Task::Types::eImagePresent:
+				executed_pass.type = "ImagePresent";
+				executed_pass.name = "ImagePresent";
+				break;
+			case Task::Types::eFrameSyncBegin:
+				executed_pass.type = "FrameSync";
+				executed_pass.name = "FrameSyncBegin";
+				break;
+			case Task::Types::eFrameSyncEnd:
+				executed_pass.type = "FrameSync";
+				executed_pass.name = "FrameSyncEnd";
+				break;
+		}
+	}
+
+	evict_unused_resources();
+
 	render_pass_descs_.clear();
+	compute_pass_descs_.clear();
 	transfer_pass_descs_.clear();
 	image_present_descs_.clear();
 	frame_sync_begin_descs_.clear();
@@ -1083,6 +1164,67 @@ void RenderGraph::execute(vk::CommandBuffer command_buffer, lz::CpuProfiler *cpu
 	tasks_.clear();
 }
 
+void RenderGraph::evict_unused_resources()
+{
+	frame_index_++;
+	destroy_retired_resources();
+
+	RetiredResources retired;
+	image_cache_.evict_unused(RENDER_GRAPH_EVICTION_FRAMES, retired.images);
+	buffer_cache_.evict_unused(RENDER_GRAPH_EVICTION_FRAMES, retired.buffers);
+	if (retired.images.empty() && retired.buffers.empty())
+	{
+		return;
+	}
+
+	retired.retire_frame = frame_index_ + MAX_FRAMES_IN_FLIGHT;
+	retired_resources_.emplace_back(std::move(retired));
+}
+
+void RenderGraph::destroy_retired_resources()
+{
+	while (!retired_resources_.empty() && retired_resources_.front().retire_frame <= frame_index_)
+	{
+		auto &retired = retired_resources_.front();
+
+		// views, framebuffers and descriptor sets are keyed by pointer, they have to go before the address can be reused
+		std::set<const lz::ImageData *> images;
+		for (const auto &image : retired.images)
+		{
+			images.insert(image->get_image_data());
+		}
+		std::set<const lz::Buffer *> buffers;
+		for (const auto &buffer : retired.buffers)
+		{
+			buffers.insert(buffer.get());
+		}
+
+		std::set<const lz::ImageView *> image_views;
+		image_view_cache_.evict_image_views(images, image_views);
+		framebuffer_cache_.evict_framebuffers(image_views);
+		if (descriptor_set_cache_)
+		{
+			descriptor_set_cache_->evict_descriptor_sets(image_views, buffers);
+		}
+
+		retired_resources_.pop_front();
+	}
+}
+
+RenderGraph::CacheStats RenderGraph::get_cache_stats() const
+{
+	CacheStats stats;
+	stats.images_count  = image_cache_.get_images_count();
+	stats.images_bytes  = image_cache_.get_memory_size();
+	stats.buffers_count = buffer_cache_.get_buffers_count();
+	stats.buffers_bytes = buffer_cache_.get_memory_size();
+	for (const auto &retired : retired_resources_)
+	{
+		stats.retired_count += retired.images.size() + retired.buffers.size();
+	}
+	return stats;
+}
+
 void RenderGraph::flush_external_images(vk::CommandBuffer command_buffer_, lz::CpuProfiler *cpu_profiler,
                                         lz::GpuProfiler *gpu_profiler)
 {
@@ -1346,37 +1488,7 @@ void RenderGraph::flush_image_transition_barriers(lz::ImageData *image_data, vk:
                                                   vk::PipelineStageFlags &             dst_stage,
                                                   std::vector<vk::ImageMemoryBarrier> &image_barriers)
 {
-	if (is_image_barrier_needed(src_usage_type, dst_usage_type) && range.layerCount > 0 && range.levelCount > 0)
-	{
-		const auto src_image_access_pattern = get_src_image_access_pattern(src_usage_type);
-		const auto dst_image_access_pattern = get_dst_image_access_pattern(dst_usage_type);
-		auto       image_barrier            = vk::ImageMemoryBarrier()
-		                         .setSrcAccessMask(src_image_access_pattern.access_mask)
-		                         .setDstAccessMask(dst_image_access_pattern.access_mask)
-		                         .setOldLayout(src_image_access_pattern.layout)
-		                         .setNewLayout(dst_image_access_pattern.layout)
-		                         .setSubresourceRange(range)
-		                         .setImage(image_data->get_handle());
-
-		if (src_image_access_pattern.queue_family_type == dst_image_access_pattern.queue_family_type)
-		{
-			image_barrier
-			    .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
-			    .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
-		}
-		else
-		{
-			// TODO: transfer queue
-			image_barrier
-			    .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
-			    .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
-		}
-
-		src_stage |= src_image_access_pattern.stage;
-		dst_stage |= dst_image_access_pattern.stage;
-
-		image_barriers.push_back(image_barrier);
-	}
+	add_image_barrier(image_data->get_handle(), range, src_usage_type, dst_usage_type, src_stage, dst_stage, image_barriers);
 }
 
 void RenderGraph::add_image_transition_barriers(lz::ImageView *image_view, ImageUsageTypes dst_usage_type,
@@ -1427,34 +1539,7 @@ void RenderGraph::flush_buffer_transition_barriers(lz::Buffer *buffer, BufferUsa
                                                    vk::PipelineStageFlags &              dst_stage,
                                                    std::vector<vk::BufferMemoryBarrier> &buffer_barriers)
 {
-	if (is_buffer_barrier_needed(src_usage_type, dst_usage_type))
-	{
-		const auto src_buffer_access_pattern = get_src_buffer_access_pattern(src_usage_type);
-		const auto dst_buffer_access_pattern = get_dst_buffer_access_pattern(dst_usage_type);
-		auto       buffer_barrier            = vk::BufferMemoryBarrier()
-		                          .setSrcAccessMask(src_buffer_access_pattern.access_mask)
-		                          .setOffset(0)
-		                          .setSize(VK_WHOLE_SIZE)
-		                          .setDstAccessMask(dst_buffer_access_pattern.access_mask)
-		                          .setBuffer(buffer->get_handle());
-
-		if (src_buffer_access_pattern.queue_family_type == dst_buffer_access_pattern.queue_family_type)
-		{
-			buffer_barrier.setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
-			    .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
-		}
-		else
-		{
-			// TODO: transfer queue
-			buffer_barrier
-			    .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
-			    .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
-		}
-
-		src_stage |= src_buffer_access_pattern.stage;
-		dst_stage |= dst_buffer_access_pattern.stage;
-		buffer_barriers.push_back(buffer_barrier);
-	}
+	add_buffer_barrier(buffer->get_handle(), src_usage_type, dst_usage_type, src_stage, dst_stage, buffer_barriers);
 }
 
 void RenderGraph::add_buffer_barriers(lz::Buffer *buffer, BufferUsageTypes dstUsageType, size_t dst_task_index,
@@ -1558,6 +1643,11 @@ void RenderGraph::resolve_buffers()
 	}
 }
 
+const std::vector<RenderGraph::ExecutedPass> &RenderGraph::get_last_executed_passes() const
+{
+	return last_executed_passes_;
+}
+
 lz::Buffer *RenderGraph::get_resolved_buffer(size_t task_index, BufferProxyId buffer_proxy_id)
 {
 	return buffer_proxies_.get(buffer_proxy_id).resolved_buffer;
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <deque>
 #include <functional>
+#include <set>
 
 #include "Config.h"
 #include "Image.h"
@@ -9,12 +11,14 @@
 #include "Handles.h"
 #include "Pool.h"
 #include "RenderPassCache.h"
+#include "ResourceCache.h"
 #include "Synchronization.h"
 
 namespace lz
 {
 class GpuProfiler;
 class Buffer;
+class DescriptorSetCache;
 class RenderGraph;
 
 template <typename Base>
@@ -62,23 +66,22 @@ class ImageCache
 
 	ImageCache(vk::PhysicalDevice physical_device, vk::Device logical_device, vk::DispatchLoaderDynamic loader);
 
+	// starts a new frame, all cached images become available again
 	void release();
 
 	lz::ImageData *get_image(ImageKey image_key);
 
-  private:
-	struct ImageCacheEntry
-	{
-		ImageCacheEntry();
+	// moves out images that were not requested during the last max_unused_frames frames
+	void evict_unused(uint64_t max_unused_frames, std::vector<std::unique_ptr<lz::Image>> &evicted_images);
 
-		std::vector<std::unique_ptr<lz::Image>> images;
-		size_t                                  used_count;
-	};
+	size_t         get_images_count() const;
+	vk::DeviceSize get_memory_size() const;
 
-	std::map<ImageKey, ImageCacheEntry> image_cache_;
-	vk::PhysicalDevice                  physical_device_;
-	vk::Device                          logical_device_;
-	vk::DispatchLoaderDynamic           loader_;
+  private:
+	lz::ResourceCache<ImageKey, lz::Image> image_cache_;
+	vk::PhysicalDevice                     physical_device_;
+	vk::Device                             logical_device_;
+	vk::DispatchLoaderDynamic              loader_;
 };
 
 class ImageViewCache
@@ -97,6 +100,9 @@ class ImageViewCache
 
 	lz::ImageView *get_image_view(ImageViewKey image_view_key);
 
+	// destroys every view of the given images and returns the destroyed view pointers
+	void evict_image_views(const std::set<const lz::ImageData *> &images, std::set<const lz::ImageView *> &evicted_views);
+
   private:
 	std::map<ImageViewKey, std::unique_ptr<lz::ImageView>> image_view_cache_;
 	vk::PhysicalDevice                                     physical_device_;
@@ -116,22 +122,21 @@ class BufferCache
 		bool operator<(const BufferKey &other) const;
 	};
 
+	// starts a new frame, all cached buffers become available again
 	void release();
 
 	lz::Buffer *get_buffer(BufferKey buffer_key);
 
-  private:
-	struct BufferCacheEntry
-	{
-		BufferCacheEntry();
+	// moves out buffers that were not requested during the last max_unused_frames frames
+	void evict_unused(uint64_t max_unused_frames, std::vector<std::unique_ptr<lz::Buffer>> &evicted_buffers);
 
-		std::vector<std::unique_ptr<lz::Buffer>> buffers;
-		size_t                                   used_count;
-	};
+	size_t         get_buffers_count() const;
+	vk::DeviceSize get_memory_size() const;
 
-	std::map<BufferKey, BufferCacheEntry> buffer_cache_;
-	vk::PhysicalDevice                    physical_device_;
-	vk::Device                            logical_device_;
+  private:
+	lz::ResourceCache<BufferKey, lz::Buffer> buffer_cache_;
+	vk::PhysicalDevice                       physical_device_;
+	vk::Device                               logical_device_;
 };
 
 class RenderGraph
@@ -202,7 +207,20 @@ class RenderGraph
 	};
 
   public:
-	RenderGraph(vk::PhysicalDevice physical_device, vk::Device logical_device, vk::DispatchLoaderDynamic loader);
+	// extended_dynamic_state: the device has VK_EXT_extended_dynamic_state, every render pass then sets no culling and a
+	// default depth state before recording
+	RenderGraph(vk::PhysicalDevice physical_device, vk::Device logical_device, vk::DispatchLoaderDynamic loader,
+	            lz::DescriptorSetCache *descriptor_set_cache, bool extended_dynamic_state = false);
+
+	struct CacheStats
+	{
+		size_t         images_count  = 0;
+		vk::DeviceSize images_bytes  = 0;
+		size_t         buffers_count = 0;
+		vk::DeviceSize buffers_bytes = 0;
+		size_t         retired_count = 0;        // evicted resources waiting for in-flight frames to retire
+	};
+	CacheStats get_cache_stats() const;
 
 	using ImageProxyUnique     = UniqueHandle<ImageHandleInfo, RenderGraph>;
 	using ImageViewProxyUnique = UniqueHandle<ImageViewHandleInfo, RenderGraph>;
@@ -402,6 +420,16 @@ class RenderGraph
 
 	void execute(vk::CommandBuffer command_buffer, lz::CpuProfiler *cpu_profiler, lz::GpuProfiler *gpu_profiler);
 
+	// ExecutedPass: A pass of the last executed frame, named as in the profilers
+	struct ExecutedPass
+	{
+		const char *type;
+		std::string name;
+	};
+
+	// GetLastExecutedPasses: Passes of the last executed frame in execution order
+	const std::vector<ExecutedPass> &get_last_executed_passes() const;
+
   private:
 	void flush_external_images(vk::CommandBuffer command_buffer, lz::CpuProfiler *cpu_profiler, lz::GpuProfiler *gpu_profiler);
 
@@ -510,6 +538,18 @@ class RenderGraph
 		size_t index;
 	};
 
+	// evicted transient resources are destroyed once every frame that may still use them has retired
+	struct RetiredResources
+	{
+		std::vector<std::unique_ptr<lz::Image>>  images;
+		std::vector<std::unique_ptr<lz::Buffer>> buffers;
+		uint64_t                                 retire_frame;
+	};
+	std::deque<RetiredResources> retired_resources_;
+	uint64_t                     frame_index_ = 0;
+	void                         evict_unused_resources();
+	void                         destroy_retired_resources();
+
 	ImageCache     image_cache_;
 	ImageProxyPool image_proxies_;
 
@@ -546,9 +586,13 @@ class RenderGraph
 	std::vector<FrameSyncBeginPassDesc> frame_sync_begin_descs_;
 	std::vector<FrameSyncEndPassDesc>   frame_sync_end_descs_;
 
+	std::vector<ExecutedPass> last_executed_passes_;
+
 	vk::Device                logical_device_;
 	vk::PhysicalDevice        physical_device_;
 	vk::DispatchLoaderDynamic loader_;
+	lz::DescriptorSetCache   *descriptor_set_cache_;
+	bool                      extended_dynamic_state_;
 	size_t                    image_allocations_ = 0;
 };
 }        // namespace lz
@@ -106,6 +106,33 @@ bool FramebufferCache::FramebufferKey::operator<(const FramebufferKey &other) co
 	                                                                                                  other.color_attachment_views, other.depth_attachment_view, other.extent.width, other.extent.height);
 }
 
+void FramebufferCache::evict_framebuffers(const std::set<const lz::ImageView *> &image_views)
+{
+	if (image_views.empty())
+	{
+		return;
+	}
+
+	for (auto it = framebuffer_cache_.begin(); it != framebuffer_cache_.end();)
+	{
+		const auto &key        = it->first;
+		bool        uses_views = image_views.count(key.depth_attachment_view) > 0;
+		for (auto image_view : key.color_attachment_views)
+		{
+			uses_views |= image_view && image_views.count(image_view) > 0;
+		}
+
+		if (uses_views)
+		{
+			it = framebuffer_cache_.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
 lz::Framebuffer *FramebufferCache::get_framebuffer(FramebufferKey key)
 {
 	auto &framebuffer = framebuffer_cache_[key];
@@ -1,5 +1,6 @@
 #pragma once
 #include <map>
+#include <set>
 
 #include "Framebuffer.h"
 #include "ImageView.h"
@@ -53,6 +54,9 @@ class FramebufferCache
 
 	FramebufferCache(vk::Device logical_device);
 
+	// destroys every framebuffer that uses one of the given image views
+	void evict_framebuffers(const std::set<const lz::ImageView *> &image_views);
+
   private:
 	struct FramebufferKey
 	{
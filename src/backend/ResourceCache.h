@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace lz
+{
+// ResourceCache: Per-key pools of transient resources, the bookkeeping shared by the render graph image and buffer caches
+// - A frame hands out the resources of a key front to back, a key requested n times in a frame keeps n resources
+// - Every resource remembers the frame it was last handed out in, resources unused for a number of frames are moved out
+//   and keys left without resources are erased, so per-size keys of a resize drag do not accumulate
+// - Resource only needs get_memory_size, nothing here touches the device
+template <typename Key, typename Resource>
+class ResourceCache
+{
+  public:
+	// Release: Starts a new frame, all cached resources become available again
+	void release()
+	{
+		frame_index_++;
+		for (auto &cache_entry : cache_)
+		{
+			cache_entry.second.used_count = 0;
+		}
+	}
+
+	// Get: Hands out the next resource of the key this frame, create makes a std::unique_ptr<Resource> when the key has
+	// none left
+	template <typename CreateFunc>
+	Resource *get(const Key &key, CreateFunc &&create)
+	{
+		auto &cache_entry = cache_[key];
+		if (cache_entry.used_count + 1 > cache_entry.resources.size())
+		{
+			cache_entry.resources.emplace_back(create());
+			cache_entry.last_used_frames.push_back(frame_index_);
+		}
+		cache_entry.last_used_frames[cache_entry.used_count] = frame_index_;
+		return cache_entry.resources[cache_entry.used_count++].get();
+	}
+
+	// EvictUnused: Moves out resources that were not handed out during the last max_unused_frames frames
+	void evict_unused(uint64_t max_unused_frames, std::vector<std::unique_ptr<Resource>> &evicted_resources)
+	{
+		for (auto it = cache_.begin(); it != cache_.end();)
+		{
+			// resources of an entry are handed out front to back, so the stale ones are always at the back
+			auto &cache_entry = it->second;
+			while (!cache_entry.resources.empty() && frame_index_ - cache_entry.last_used_frames.back() > max_unused_frames)
+			{
+				evicted_resources.emplace_back(std::move(cache_entry.resources.back()));
+				cache_entry.resources.pop_back();
+				cache_entry.last_used_frames.pop_back();
+			}
+
+			if (cache_entry.resources.empty())
+			{
+				it = cache_.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+	size_t get_resources_count() const
+	{
+		size_t resources_count = 0;
+		for (const auto &cache_entry : cache_)
+		{
+			resources_count += cache_entry.second.resources.size();
+		}
+		return resources_count;
+	}
+
+	size_t get_keys_count() const
+	{
+		return cache_.size();
+	}
+
+	uint64_t get_memory_size() const
+	{
+		uint64_t memory_size = 0;
+		for (const auto &cache_entry : cache_)
+		{
+			for (const auto &resource : cache_entry.second.resources)
+			{
+				memory_size += resource->get_memory_size();
+			}
+		}
+		return memory_size;
+	}
+
+  private:
+	struct CacheEntry
+	{
+		std::vector<std::unique_ptr<Resource>> resources;
+		std::vector<uint64_t>                  last_used_frames;
+		size_t                                 used_count = 0;
+	};
+
+	std::map<Key, CacheEntry> cache_;
+	uint64_t                  frame_index_ = 0;
+};
+}        // namespace lz
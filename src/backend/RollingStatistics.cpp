@@ -0,0 +1,135 @@
+#include "RollingStatistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace lz
+{
+RollingStatistics::RollingStatistics(const uint32_t window_frames) :
+    window_frames_(std::max(window_frames, 1u))
+{
+	clear();
+}
+
+void RollingStatistics::set_window_frames(const uint32_t window_frames)
+{
+	window_frames_ = std::max(window_frames, 1u);
+	clear();
+}
+
+uint32_t RollingStatistics::get_window_frames() const
+{
+	return window_frames_;
+}
+
+void RollingStatistics::add_sample(const uint64_t frame_index, const double value)
+{
+	samples_.emplace_back(frame_index, value);
+	sum_ += value;
+	buckets_[get_bucket_index(value)]++;
+
+	while (!min_queue_.empty() && min_queue_.back().second >= value)
+	{
+		min_queue_.pop_back();
+	}
+	min_queue_.emplace_back(frame_index, value);
+
+	while (!max_queue_.empty() && max_queue_.back().second <= value)
+	{
+		max_queue_.pop_back();
+	}
+	max_queue_.emplace_back(frame_index, value);
+}
+
+void RollingStatistics::expire(const uint64_t frame_index)
+{
+	const uint64_t first_frame_index = frame_index + 1 >= window_frames_ ? frame_index + 1 - window_frames_ : 0;
+
+	while (!samples_.empty() && samples_.front().first < first_frame_index)
+	{
+		sum_ -= samples_.front().second;
+		buckets_[get_bucket_index(samples_.front().second)]--;
+		samples_.pop_front();
+	}
+	while (!min_queue_.empty() && min_queue_.front().first < first_frame_index)
+	{
+		min_queue_.pop_front();
+	}
+	while (!max_queue_.empty() && max_queue_.front().first < first_frame_index)
+	{
+		max_queue_.pop_front();
+	}
+
+	// keeps the rounding error of the running sum from outliving the samples it came from
+	if (samples_.empty())
+	{
+		sum_ = 0.0;
+	}
+}
+
+void RollingStatistics::clear()
+{
+	samples_.clear();
+	min_queue_.clear();
+	max_queue_.clear();
+	buckets_.fill(0);
+	sum_ = 0.0;
+}
+
+size_t RollingStatistics::get_samples_count() const
+{
+	return samples_.size();
+}
+
+double RollingStatistics::get_mean() const
+{
+	return samples_.empty() ? 0.0 : sum_ / double(samples_.size());
+}
+
+double RollingStatistics::get_min() const
+{
+	return min_queue_.empty() ? 0.0 : min_queue_.front().second;
+}
+
+double RollingStatistics::get_max() const
+{
+	return max_queue_.empty() ? 0.0 : max_queue_.front().second;
+}
+
+double RollingStatistics::get_percentile(const double fraction) const
+{
+	if (samples_.empty())
+	{
+		return 0.0;
+	}
+
+	const size_t rank = std::clamp<size_t>(size_t(std::ceil(fraction * double(samples_.size()))), 1, samples_.size());
+
+	size_t samples_below = 0;
+	for (uint32_t bucket_index = 0; bucket_index < buckets_count; bucket_index++)
+	{
+		samples_below += buckets_[bucket_index];
+		if (samples_below >= rank)
+		{
+			return std::clamp(get_bucket_value(bucket_index), get_min(), get_max());
+		}
+	}
+	return get_max();
+}
+
+uint32_t RollingStatistics::get_bucket_index(const double value)
+{
+	if (!(value > min_value))
+	{
+		return 0;
+	}
+	const double bucket = std::log10(value / min_value) * double(buckets_per_decade);
+	return std::min(uint32_t(bucket), buckets_count - 1);
+}
+
+double RollingStatistics::get_bucket_value(const uint32_t bucket_index)
+{
+	// geometric middle of the bucket
+	return min_value * std::pow(10.0, (double(bucket_index) + 0.5) / double(buckets_per_decade));
+}
+}        // namespace lz
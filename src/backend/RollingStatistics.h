@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+
+namespace lz
+{
+// RollingStatistics: Mean, min, max and percentiles of the samples added during the last frames
+// - Adding a sample and expiring old ones is O(1) amortized, nothing rescans the window
+// - Min and max are kept in monotonic queues, percentiles come from a histogram with logarithmic buckets
+//   and are accurate to about 4% of the value
+// - Samples are tagged with the frame they belong to, a frame may add any number of samples or none
+// - The bucket range suits timings in milliseconds, from 1 us to 10 s
+class RollingStatistics
+{
+  public:
+	explicit RollingStatistics(uint32_t window_frames = 300);
+
+	// SetWindowFrames: Changes the number of frames kept, drops all samples
+	void set_window_frames(uint32_t window_frames);
+
+	uint32_t get_window_frames() const;
+
+	void add_sample(uint64_t frame_index, double value);
+
+	// Expire: Drops samples of frames that left the window ending at frame_index
+	void expire(uint64_t frame_index);
+
+	void clear();
+
+	size_t get_samples_count() const;
+
+	double get_mean() const;
+
+	double get_min() const;
+
+	double get_max() const;
+
+	// GetPercentile: Value below which the given fraction of the samples falls, fraction in [0, 1]
+	double get_percentile(double fraction) const;
+
+  private:
+	using Sample = std::pair<uint64_t, double>;
+
+	// buckets cover [min_value, min_value * 10^decades_count), values outside land in the first or last bucket
+	static constexpr double   min_value          = 1e-3;
+	static constexpr uint32_t buckets_per_decade = 32;
+	static constexpr uint32_t decades_count      = 7;
+	static constexpr uint32_t buckets_count      = buckets_per_decade * decades_count;
+
+	static uint32_t get_bucket_index(double value);
+
+	static double get_bucket_value(uint32_t bucket_index);
+
+	uint32_t                            window_frames_;
+	std::deque<Sample>                  samples_;
+	std::deque<Sample>                  min_queue_;
+	std::deque<Sample>                  max_queue_;
+	std::array<uint32_t, buckets_count> buckets_;
+	double                              sum_;
+};
+}        // namespace lz
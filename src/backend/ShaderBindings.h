@@ -0,0 +1,62 @@
+#pragma once
+
+#include "ShaderProgram.h"
+
+#include "glm/glm.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lz
+{
+class Buffer;
+class ImageView;
+class Sampler;
+
+// ShaderBindingType: Kind of descriptor a generated binding describes
+enum class ShaderBindingType
+{
+	eUniformBuffer,
+	eStorageBuffer,
+	eImageSampler,
+	eStorageImage
+};
+
+// StridedElement: Array element followed by the padding its SPIR-V array stride adds, e.g. a float of a std140 array
+template <typename ElementType, size_t Stride>
+struct StridedElement
+{
+	static_assert(Stride > sizeof(ElementType), "elements without padding are declared as plain arrays");
+
+	ElementType value;
+	uint8_t     padding[Stride - sizeof(ElementType)];
+};
+
+// Shader bindings: Structs and binding indices generated from the reflection of the GLSL shaders at build time
+// - LingzeShaderBindings writes shader_bindings/<dir>/<file>.h for every shader listed in CMakeLists.txt, e.g.
+//   lz::shader_bindings::mesh_shading::drawcull_comp::UboData for the UboData block of MeshShading/drawcull.comp
+// - Every resource becomes a struct with its type, set and binding as constants, uniform blocks hold their members
+//   with explicit padding and static asserts on every offset, storage buffers name the element of their runtime array
+// - Renderers bind with the constants instead of looking resources up by name, a shader edit that moves a member or a
+//   binding fails the build instead of corrupting data at runtime
+template <typename Binding>
+StorageBufferBinding make_storage_buffer_binding(lz::Buffer *buffer, vk::DeviceSize offset = 0, vk::DeviceSize size = VK_WHOLE_SIZE)
+{
+	static_assert(Binding::type == ShaderBindingType::eStorageBuffer, "the binding is not a storage buffer");
+	return StorageBufferBinding(buffer, Binding::binding, offset, size);
+}
+
+template <typename Binding>
+ImageSamplerBinding make_image_sampler_binding(lz::ImageView *image_view, lz::Sampler *sampler)
+{
+	static_assert(Binding::type == ShaderBindingType::eImageSampler, "the binding is not a combined image sampler");
+	return ImageSamplerBinding(image_view, sampler, Binding::binding);
+}
+
+template <typename Binding>
+StorageImageBinding make_storage_image_binding(lz::ImageView *image_view)
+{
+	static_assert(Binding::type == ShaderBindingType::eStorageImage, "the binding is not a storage image");
+	return StorageImageBinding(image_view, Binding::binding);
+}
+}        // namespace lz
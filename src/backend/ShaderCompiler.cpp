@@ -0,0 +1,166 @@
+#include "ShaderCompiler.h"
+
+#include "CpuProfiler.h"
+#include "Logging.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace lz
+{
+ShaderCompiler::ShaderCompiler(const uint32_t threads_count) :
+    job_(nullptr),
+    jobs_count_(0),
+    next_job_index_(0),
+    finished_jobs_count_(0),
+    stopping_(false)
+{
+	// hardware_concurrency() may report 0 when it is unknown
+	const uint32_t hardware_threads_count = std::thread::hardware_concurrency();
+	const uint32_t workers_count          = threads_count > 0 ? threads_count : std::max(hardware_threads_count, 2u) - 1;
+
+	for (uint32_t worker_index = 0; worker_index < workers_count; worker_index++)
+	{
+		workers_.emplace_back([this]() { worker_loop(); });
+	}
+}
+
+ShaderCompiler::~ShaderCompiler()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stopping_ = true;
+	}
+	work_condition_.notify_all();
+	for (auto &worker : workers_)
+	{
+		worker.join();
+	}
+}
+
+uint32_t ShaderCompiler::get_threads_count() const
+{
+	return uint32_t(workers_.size());
+}
+
+std::vector<ShaderCompiler::CompileResult> ShaderCompiler::compile(const std::vector<ShaderSource> &shader_sources)
+{
+	std::vector<CompileResult> results(shader_sources.size());
+	run_batch(shader_sources.size(), [&](const size_t source_index) {
+		const auto &source = shader_sources[source_index];
+		auto        task   = CpuProfiler::get().start_scoped_task(source.get_name(), Colors::amethyst);
+		try
+		{
+			results[source_index].bytecode = Shader::get_bytecode(source.file, source.defines, &results[source_index].dependencies);
+		}
+		catch (const std::exception &e)
+		{
+			results[source_index].error = e.what();
+		}
+	});
+	return results;
+}
+
+std::vector<std::vector<uint32_t>> ShaderCompiler::compile_bytecode(const std::vector<ShaderSource> &shader_sources)
+{
+	std::vector<std::vector<uint32_t>> bytecodes(shader_sources.size());
+	run_batch(shader_sources.size(), [&](const size_t source_index) {
+		const auto &source      = shader_sources[source_index];
+		auto        task        = CpuProfiler::get().start_scoped_task(source.get_name(), Colors::amethyst);
+		bytecodes[source_index] = Shader::get_bytecode(source.file, source.defines);
+	});
+	return bytecodes;
+}
+
+std::vector<std::unique_ptr<lz::Shader>> ShaderCompiler::create_shaders(vk::Device logical_device, const std::vector<ShaderSource> &shader_sources)
+{
+	const auto start_time = std::chrono::steady_clock::now();
+
+	std::vector<std::unique_ptr<lz::Shader>> shaders(shader_sources.size());
+	run_batch(shader_sources.size(), [&](const size_t source_index) {
+		auto task             = CpuProfiler::get().start_scoped_task(shader_sources[source_index].get_name(), Colors::amethyst);
+		shaders[source_index] = std::make_unique<lz::Shader>(logical_device, shader_sources[source_index]);
+	});
+
+	const double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+	LOGI("Compiled {} shaders on {} threads in {:.1f} ms", shader_sources.size(), workers_.size(), elapsed_ms);
+	return shaders;
+}
+
+void ShaderCompiler::run_batch(const size_t jobs_count, const Job &job)
+{
+	if (jobs_count == 0)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> batch_lock(batch_mutex_);
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		job_                 = &job;
+		jobs_count_          = jobs_count;
+		next_job_index_      = 0;
+		finished_jobs_count_ = 0;
+		errors_.assign(jobs_count, nullptr);
+	}
+	work_condition_.notify_all();
+
+	std::exception_ptr error;
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		done_condition_.wait(lock, [this]() { return finished_jobs_count_ == jobs_count_; });
+
+		// empties the queue so idle workers keep waiting
+		job_            = nullptr;
+		jobs_count_     = 0;
+		next_job_index_ = 0;
+
+		const auto failed_job = std::find_if(errors_.begin(), errors_.end(), [](const std::exception_ptr &job_error) { return bool(job_error); });
+		if (failed_job != errors_.end())
+		{
+			error = *failed_job;
+		}
+	}
+
+	if (error)
+	{
+		std::rethrow_exception(error);
+	}
+}
+
+void ShaderCompiler::worker_loop()
+{
+	CpuProfiler::get().set_thread_name("Shader compiler");
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (true)
+	{
+		work_condition_.wait(lock, [this]() { return stopping_ || next_job_index_ < jobs_count_; });
+		if (stopping_)
+		{
+			return;
+		}
+
+		const size_t job_index = next_job_index_++;
+		const Job   &job       = *job_;
+		lock.unlock();
+
+		std::exception_ptr error;
+		try
+		{
+			job(job_index);
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+
+		lock.lock();
+		errors_[job_index] = error;
+		if (++finished_jobs_count_ == jobs_count_)
+		{
+			done_condition_.notify_all();
+		}
+	}
+}
+}        // namespace lz
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "ShaderProgram.h"
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lz
+{
+// ShaderCompiler: Job queue that compiles shader stages on worker threads
+// - A batch takes every stage a renderer needs, its files are compiled in parallel and the call returns once
+//   all of them are done, so pipelines are only created from complete sets of shaders
+// - glslang is initialized once per process, every job parses with its own TShader and TProgram
+// - One batch runs at a time, batches submitted from several threads are serialized
+// - When jobs fail the batch still waits for the rest, then rethrows the error of the first failed file
+class ShaderCompiler
+{
+  public:
+	// threads_count of 0 uses one worker per hardware thread, minus the calling thread
+	explicit ShaderCompiler(uint32_t threads_count = 0);
+	~ShaderCompiler();
+
+	ShaderCompiler(const ShaderCompiler &)            = delete;
+	ShaderCompiler &operator=(const ShaderCompiler &) = delete;
+
+	uint32_t get_threads_count() const;
+
+	// CompileResult: Output for one file, error is set instead when it failed to compile
+	struct CompileResult
+	{
+		std::vector<uint32_t> bytecode;
+		std::set<std::string> dependencies;
+		std::string           error;
+	};
+
+	// Compile: Compiles every source and reports failures per source instead of throwing, used for hot reload
+	std::vector<CompileResult> compile(const std::vector<ShaderSource> &shader_sources);
+
+	// CompileBytecode: Returns the SPIR-V of every source in the order of shader_sources
+	std::vector<std::vector<uint32_t>> compile_bytecode(const std::vector<ShaderSource> &shader_sources);
+
+	// CreateShaders: Compiles the sources, creates their shader modules and reflects them on the workers
+	std::vector<std::unique_ptr<lz::Shader>> create_shaders(vk::Device logical_device, const std::vector<ShaderSource> &shader_sources);
+
+  private:
+	using Job = std::function<void(size_t)>;
+
+	// RunBatch: Calls job with every index below jobs_count on the workers and waits for all of them
+	void run_batch(size_t jobs_count, const Job &job);
+
+	void worker_loop();
+
+	// held for the whole batch so batches never interleave
+	std::mutex batch_mutex_;
+
+	std::mutex                      mutex_;
+	std::condition_variable         work_condition_;
+	std::condition_variable         done_condition_;
+	const Job                      *job_;
+	size_t                          jobs_count_;
+	size_t                          next_job_index_;
+	size_t                          finished_jobs_count_;
+	std::vector<std::exception_ptr> errors_;
+	bool                            stopping_;
+
+	std::vector<std::thread> workers_;
+};
+}        // namespace lz
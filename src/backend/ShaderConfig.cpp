@@ -0,0 +1,182 @@
+#include "ShaderConfig.h"
+
+#include "Logging.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace lz
+{
+ShaderConfig::DeviceLimits ShaderConfig::query_limits(vk::PhysicalDevice physical_device, const bool mesh_shader_supported)
+{
+	DeviceLimits limits;
+
+	const auto  properties_chain = physical_device.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceSubgroupProperties>();
+	const auto &device_limits    = properties_chain.get<vk::PhysicalDeviceProperties2>().properties.limits;
+
+	limits.subgroup_size                     = properties_chain.get<vk::PhysicalDeviceSubgroupProperties>().subgroupSize;
+	limits.max_compute_workgroup_invocations = device_limits.maxComputeWorkGroupInvocations;
+	limits.max_compute_workgroup_size        = std::min(device_limits.maxComputeWorkGroupSize[0], device_limits.maxComputeWorkGroupSize[1]);
+
+	// the mesh shader properties may only be chained when the extension is enabled
+	if (mesh_shader_supported)
+	{
+		const auto  mesh_properties_chain = physical_device.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceMeshShaderPropertiesEXT>();
+		const auto &mesh_properties       = mesh_properties_chain.get<vk::PhysicalDeviceMeshShaderPropertiesEXT>();
+
+		limits.max_task_workgroup_size    = std::min(mesh_properties.maxTaskWorkGroupSize[0], mesh_properties.maxTaskWorkGroupInvocations);
+		limits.max_mesh_workgroup_size    = std::min(mesh_properties.maxMeshWorkGroupSize[0], mesh_properties.maxMeshWorkGroupInvocations);
+		limits.max_mesh_output_vertices   = mesh_properties.maxMeshOutputVertices;
+		limits.max_mesh_output_primitives = mesh_properties.maxMeshOutputPrimitives;
+	}
+	return limits;
+}
+
+ShaderConfig ShaderConfig::select(const DeviceLimits &limits)
+{
+	ShaderConfig config;
+
+	const uint32_t subgroup_size = std::max(limits.subgroup_size, 1u);
+	config.task_workgroup_size   = std::min({subgroup_size, limits.max_task_workgroup_size, uint32_t(MAX_TASK_WGSIZE)});
+	config.mesh_workgroup_size   = std::min(subgroup_size, limits.max_mesh_workgroup_size);
+
+	config.compute_workgroup_size = subgroup_size;
+	while (config.compute_workgroup_size > 1 &&
+	       (config.compute_workgroup_size * config.compute_workgroup_size > limits.max_compute_workgroup_invocations ||
+	        config.compute_workgroup_size > limits.max_compute_workgroup_size))
+	{
+		config.compute_workgroup_size /= 2;
+	}
+
+	// meshoptimizer needs the triangle limit to be a multiple of 4
+	config.meshlet_max_vertices  = std::min(uint32_t(MESHLET_MAX_VERTICES), limits.max_mesh_output_vertices);
+	config.meshlet_max_triangles = std::min(uint32_t(MESHLET_MAX_TRIANGLES), limits.max_mesh_output_primitives) & ~3u;
+	return config;
+}
+
+bool ShaderConfig::fits(const DeviceLimits &limits) const
+{
+	// the task workgroup has to stay within one subgroup for the ballot compaction
+	const bool task_fits    = task_workgroup_size > 0 && limits.subgroup_size % task_workgroup_size == 0 &&
+	                          task_workgroup_size <= limits.max_task_workgroup_size && task_workgroup_size <= MAX_TASK_WGSIZE;
+	const bool mesh_fits    = mesh_workgroup_size > 0 && mesh_workgroup_size <= limits.max_mesh_workgroup_size;
+	const bool compute_fits = compute_workgroup_size > 0 && compute_workgroup_size <= limits.max_compute_workgroup_size &&
+	                          compute_workgroup_size * compute_workgroup_size <= limits.max_compute_workgroup_invocations;
+
+	// Meshlet stores both counts in 8 bits and meshoptimizer needs the triangle limit to be a multiple of 4
+	const bool meshlet_fits = meshlet_max_vertices > 0 && meshlet_max_vertices <= std::min(255u, limits.max_mesh_output_vertices) &&
+	                          meshlet_max_triangles > 0 && meshlet_max_triangles % 4 == 0 &&
+	                          meshlet_max_triangles <= std::min(255u, limits.max_mesh_output_primitives) &&
+	                          meshlet_cone_weight >= 0.0f && meshlet_cone_weight <= 1.0f;
+
+	return task_fits && mesh_fits && compute_fits && meshlet_fits;
+}
+
+SpecializationConstants ShaderConfig::get_specialization_constants() const
+{
+	return {{TASK_WGSIZE_ID, task_workgroup_size},
+	        {MESH_WGSIZE_ID, mesh_workgroup_size},
+	        {COMPUTE_WGSIZE_ID, compute_workgroup_size},
+	        {COMPUTE_WGSIZE_Y_ID, compute_workgroup_size}};
+}
+
+ShaderDefines ShaderConfig::get_meshlet_defines() const
+{
+	return {{"MESHLET_MAX_VERTICES", std::to_string(meshlet_max_vertices)},
+	        {"MESHLET_MAX_TRIANGLES", std::to_string(meshlet_max_triangles)}};
+}
+
+Json::Value ShaderConfig::to_json() const
+{
+	Json::Value json;
+	json["task_workgroup_size"]    = task_workgroup_size;
+	json["mesh_workgroup_size"]    = mesh_workgroup_size;
+	json["compute_workgroup_size"] = compute_workgroup_size;
+	json["meshlet_max_vertices"]   = meshlet_max_vertices;
+	json["meshlet_max_triangles"]  = meshlet_max_triangles;
+	json["meshlet_cone_weight"]    = meshlet_cone_weight;
+	return json;
+}
+
+bool ShaderConfig::from_json(const Json::Value &json, ShaderConfig &config)
+{
+	for (const char *name : {"task_workgroup_size", "mesh_workgroup_size", "compute_workgroup_size", "meshlet_max_vertices",
+	                         "meshlet_max_triangles", "meshlet_cone_weight"})
+	{
+		if (!json[name].isNumeric())
+		{
+			return false;
+		}
+	}
+
+	config.task_workgroup_size    = json["task_workgroup_size"].asUInt();
+	config.mesh_workgroup_size    = json["mesh_workgroup_size"].asUInt();
+	config.compute_workgroup_size = json["compute_workgroup_size"].asUInt();
+	config.meshlet_max_vertices   = json["meshlet_max_vertices"].asUInt();
+	config.meshlet_max_triangles  = json["meshlet_max_triangles"].asUInt();
+	config.meshlet_cone_weight    = json["meshlet_cone_weight"].asFloat();
+	return true;
+}
+
+std::string ShaderConfig::get_device_profile_path(vk::PhysicalDevice physical_device)
+{
+	const auto properties = physical_device.getProperties();
+	return fmt::format("device_profiles/{:04x}_{:04x}.json", properties.vendorID, properties.deviceID);
+}
+
+bool ShaderConfig::load_profile(const std::string &file_path, ShaderConfig &config)
+{
+	std::ifstream file(file_path);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	Json::Value             profile;
+	Json::CharReaderBuilder reader;
+	std::string             errors;
+	if (!Json::parseFromStream(reader, file, &profile, &errors))
+	{
+		LOGW("Failed to parse device profile {}: {}", file_path, errors);
+		return false;
+	}
+	if (!from_json(profile["shader_config"], config))
+	{
+		LOGW("Device profile {} has no complete shader config", file_path);
+		return false;
+	}
+	return true;
+}
+
+bool ShaderConfig::save_profile(const std::string &file_path, vk::PhysicalDevice physical_device, const Json::Value &extra) const
+{
+	const auto properties = physical_device.getProperties();
+
+	// the measurements are kept next to the configuration so a profile can be compared with a later run
+	Json::Value profile = extra.isObject() ? extra : Json::Value(Json::objectValue);
+
+	profile["device"]         = properties.deviceName.data();
+	profile["vendor_id"]      = properties.vendorID;
+	profile["device_id"]      = properties.deviceID;
+	profile["driver_version"] = properties.driverVersion;
+	profile["shader_config"]  = to_json();
+
+	const auto      directory = std::filesystem::path(file_path).parent_path();
+	std::error_code error;
+	if (!directory.empty())
+	{
+		std::filesystem::create_directories(directory, error);
+	}
+
+	std::ofstream file(file_path);
+	if (!file.is_open())
+	{
+		LOGE("Failed to write device profile {}", file_path);
+		return false;
+	}
+	file << profile.toStyledString();
+	return true;
+}
+}        // namespace lz
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Config.h"
+#include "EngineConfig.h"
+#include "ShaderProgram.h"
+
+#include "json/json.h"
+
+#include <string>
+
+namespace lz
+{
+// ShaderConfig: Workgroup sizes and meshlet limits of the mesh shading shaders, chosen for the device at startup
+// - The defaults are the values of EngineConfig.h, select() fits them to the subgroup size and mesh shader limits
+// - Workgroup sizes reach the shaders as specialization constants, the PipelineCache specializes every pipeline with them
+// - Meshlet limits size the mesh shader output layout, which SPIR-V takes as literals, so they reach it as defines
+// - A per-device profile written by the auto-tuner replaces the selected values when it fits the device
+struct ShaderConfig
+{
+	uint32_t task_workgroup_size    = TASK_WGSIZE;
+	uint32_t mesh_workgroup_size    = MESH_WGSIZE;
+	uint32_t compute_workgroup_size = COMPUTE_WGSIZE;
+	uint32_t meshlet_max_vertices   = MESHLET_MAX_VERTICES;
+	uint32_t meshlet_max_triangles  = MESHLET_MAX_TRIANGLES;
+	float    meshlet_cone_weight    = MESHLET_CONE_WEIGHT;
+
+	// DeviceLimits: Properties of the device the configuration is fitted to
+	struct DeviceLimits
+	{
+		uint32_t subgroup_size                     = 32;
+		uint32_t max_compute_workgroup_invocations = 1024;
+		uint32_t max_compute_workgroup_size        = 1024;
+		uint32_t max_task_workgroup_size           = 128;
+		uint32_t max_mesh_workgroup_size           = 128;
+		uint32_t max_mesh_output_vertices          = 256;
+		uint32_t max_mesh_output_primitives        = 256;
+	};
+
+	// QueryLimits: Reads the limits of the device, the mesh shader limits are only read when mesh shaders are enabled
+	static DeviceLimits query_limits(vk::PhysicalDevice physical_device, bool mesh_shader_supported);
+
+	// Select: Fits the defaults to the limits
+	// - The task shader compacts visible meshlets with subgroup ballots, its workgroup is exactly one subgroup
+	// - The depth pyramid dispatches square compute workgroups, the compute size is capped so they stay in the limits
+	static ShaderConfig select(const DeviceLimits &limits);
+
+	// Fits: Whether the shaders can be built with this configuration on a device with the given limits
+	bool fits(const DeviceLimits &limits) const;
+
+	// GetSpecializationConstants: Workgroup sizes by the constant ids of EngineConfig.h
+	SpecializationConstants get_specialization_constants() const;
+
+	// GetMeshletDefines: Meshlet limits for the mesh shader output layout
+	ShaderDefines get_meshlet_defines() const;
+
+	Json::Value to_json() const;
+
+	// FromJson: Reads a configuration written by to_json(), returns false if a value is missing
+	static bool from_json(const Json::Value &json, ShaderConfig &config);
+
+	// GetDeviceProfilePath: Profile file of a device, named by its vendor and device ids
+	// - Stored as JSON: {"device": "...", "vendor_id": 4318, "device_id": 8712, "driver_version": 0, "shader_config": {...}}
+	static std::string get_device_profile_path(vk::PhysicalDevice physical_device);
+
+	// LoadProfile: Reads the configuration of a device profile, returns false if there is none or it is invalid
+	static bool load_profile(const std::string &file_path, ShaderConfig &config);
+
+	// SaveProfile: Writes the configuration as the profile of the device, extra holds the measurements it was chosen by
+	bool save_profile(const std::string &file_path, vk::PhysicalDevice physical_device, const Json::Value &extra = Json::Value()) const;
+};
+}        // namespace lz
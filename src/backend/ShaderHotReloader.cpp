@@ -0,0 +1,279 @@
+#include "ShaderHotReloader.h"
+
+#include "Core.h"
+#include "CpuProfiler.h"
+#include "EngineConfig.h"
+#include "Logging.h"
+#include "ShaderCompiler.h"
+#include "ShaderProgram.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+namespace lz
+{
+namespace
+{
+// how often the watcher checks modification times, an edit is picked up within this delay after saving
+constexpr std::chrono::milliseconds poll_interval(250);
+}        // namespace
+
+ShaderHotReloader &ShaderHotReloader::get()
+{
+	static ShaderHotReloader reloader;
+	return reloader;
+}
+
+ShaderHotReloader::ShaderHotReloader() :
+    core_(nullptr),
+    reload_all_requested_(false),
+    stopping_(false),
+    frame_index_(0)
+{
+}
+
+void ShaderHotReloader::start(lz::Core *core)
+{
+	assert(!watch_thread_.joinable());
+	core_ = core;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stopping_             = false;
+		reload_all_requested_ = false;
+	}
+	watch_thread_ = std::thread([this]() { watch_loop(); });
+}
+
+void ShaderHotReloader::stop()
+{
+	if (watch_thread_.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stopping_ = true;
+		}
+		watch_condition_.notify_all();
+		watch_thread_.join();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		compiled_sources_.clear();
+	}
+	retired_objects_.clear();
+	file_times_.clear();
+	core_ = nullptr;
+}
+
+void ShaderHotReloader::reload_all()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		reload_all_requested_ = true;
+	}
+	watch_condition_.notify_all();
+}
+
+void ShaderHotReloader::update()
+{
+	frame_index_++;
+	destroy_retired_objects();
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (compiled_sources_.empty() || !core_)
+	{
+		return;
+	}
+
+	// shaders are reloaded in place, renderers and their render graph tasks keep the same Shader and ShaderProgram pointers
+	RetiredObjects             retired;
+	std::set<vk::ShaderModule> replaced_modules;
+	std::set<lz::Shader *>     reloaded_shaders;
+	for (const auto &compiled_source : compiled_sources_)
+	{
+		// every shader of the source may have been destroyed while it compiled
+		const auto source_it = sources_.find(compiled_source.source);
+		if (source_it == sources_.end())
+		{
+			continue;
+		}
+
+		for (const auto shader : source_it->second.shaders)
+		{
+			replaced_modules.insert(shader->get_module()->get_handle());
+			retired.shader_modules.push_back(shader->reload(core_->get_logical_device(), compiled_source.bytecode, compiled_source.dependencies));
+			reloaded_shaders.insert(shader);
+		}
+		source_it->second.dependencies = compiled_source.dependencies;
+	}
+	compiled_sources_.clear();
+
+	size_t updated_programs_count = 0;
+	for (const auto program : programs_)
+	{
+		const bool uses_reloaded_shader = std::any_of(program->shaders.begin(), program->shaders.end(),
+		                                              [&](lz::Shader *shader) { return reloaded_shaders.count(shader) > 0; });
+		if (uses_reloaded_shader)
+		{
+			program->update();
+			updated_programs_count++;
+		}
+	}
+
+	core_->get_pipeline_cache()->evict_pipelines(replaced_modules, retired.graphics_pipelines, retired.compute_pipelines);
+	LOGI("Reloaded {} shaders used by {} programs, {} pipelines will be rebuilt", reloaded_shaders.size(), updated_programs_count,
+	     retired.graphics_pipelines.size() + retired.compute_pipelines.size());
+
+	retired.retire_frame = frame_index_ + MAX_FRAMES_IN_FLIGHT;
+	retired_objects_.emplace_back(std::move(retired));
+}
+
+void ShaderHotReloader::add_shader(lz::Shader *shader)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto                       &source = sources_[shader->get_source()];
+	source.shaders.push_back(shader);
+	source.dependencies = shader->get_dependencies();
+}
+
+void ShaderHotReloader::remove_shader(lz::Shader *shader)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	const auto                  source_it = sources_.find(shader->get_source());
+	if (source_it == sources_.end())
+	{
+		return;
+	}
+
+	auto &shaders = source_it->second.shaders;
+	shaders.erase(std::remove(shaders.begin(), shaders.end(), shader), shaders.end());
+	if (shaders.empty())
+	{
+		sources_.erase(source_it);
+	}
+}
+
+void ShaderHotReloader::add_program(lz::ShaderProgram *program)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	programs_.insert(program);
+}
+
+void ShaderHotReloader::remove_program(lz::ShaderProgram *program)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	programs_.erase(program);
+}
+
+void ShaderHotReloader::watch_loop()
+{
+	CpuProfiler::get().set_thread_name("Shader watcher");
+
+	while (true)
+	{
+		bool reload_all = false;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			watch_condition_.wait_for(lock, poll_interval, [this]() { return stopping_ || reload_all_requested_; });
+			if (stopping_)
+			{
+				return;
+			}
+			reload_all            = reload_all_requested_;
+			reload_all_requested_ = false;
+		}
+
+		const auto changed_sources = find_changed_sources(reload_all);
+		if (changed_sources.empty())
+		{
+			continue;
+		}
+
+		LOGI("Recompiling {} changed shaders", changed_sources.size());
+		auto results = core_->get_shader_compiler()->compile(changed_sources);
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		for (size_t source_index = 0; source_index < changed_sources.size(); source_index++)
+		{
+			auto &result = results[source_index];
+			if (!result.error.empty())
+			{
+				LOGE("Keeping the previous version of {}: {}", changed_sources[source_index].get_name(), result.error);
+				continue;
+			}
+
+			// a newer compilation of the same source replaces one update() has not applied yet
+			auto compiled_it = std::find_if(compiled_sources_.begin(), compiled_sources_.end(), [&](const CompiledSource &compiled_source) {
+				return compiled_source.source == changed_sources[source_index];
+			});
+			if (compiled_it == compiled_sources_.end())
+			{
+				compiled_it = compiled_sources_.insert(compiled_sources_.end(), CompiledSource());
+			}
+			compiled_it->source       = changed_sources[source_index];
+			compiled_it->bytecode     = std::move(result.bytecode);
+			compiled_it->dependencies = std::move(result.dependencies);
+		}
+	}
+}
+
+std::vector<ShaderSource> ShaderHotReloader::find_changed_sources(const bool reload_all)
+{
+	// copied so the file system is not touched while shaders wait to register
+	std::map<ShaderSource, std::set<std::string>> source_dependencies;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		for (const auto &[shader_source, source] : sources_)
+		{
+			source_dependencies[shader_source] = source.dependencies;
+		}
+	}
+
+	std::set<std::string> files;
+	for (const auto &[shader_source, dependencies] : source_dependencies)
+	{
+		files.insert(dependencies.begin(), dependencies.end());
+	}
+
+	std::set<std::string> changed_files;
+	for (const auto &file : files)
+	{
+		// editors may replace the file while saving it, it is checked again on the next poll
+		std::error_code error;
+		const auto      write_time = std::filesystem::last_write_time(file, error);
+		if (error)
+		{
+			continue;
+		}
+
+		// the first time a file is seen only records its time
+		const auto [time_it, inserted] = file_times_.emplace(file, write_time);
+		if (!inserted && time_it->second != write_time)
+		{
+			time_it->second = write_time;
+			changed_files.insert(file);
+		}
+	}
+
+	std::vector<ShaderSource> changed_sources;
+	for (const auto &[shader_source, dependencies] : source_dependencies)
+	{
+		const bool changed = std::any_of(dependencies.begin(), dependencies.end(),
+		                                 [&](const std::string &file) { return changed_files.count(file) > 0; });
+		if (reload_all || changed)
+		{
+			changed_sources.push_back(shader_source);
+		}
+	}
+	return changed_sources;
+}
+
+void ShaderHotReloader::destroy_retired_objects()
+{
+	while (!retired_objects_.empty() && retired_objects_.front().retire_frame <= frame_index_)
+	{
+		retired_objects_.pop_front();
+	}
+}
+}        // namespace lz
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Pipeline.h"
+#include "ShaderModule.h"
+#include "ShaderProgram.h"
+
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lz
+{
+class Core;
+
+// ShaderHotReloader: Recompiles shaders whose files changed and swaps them in without waiting for the device
+// - Shaders loaded from files and the programs built from them register themselves, the files each shader includes
+//   are reported by the glslang includer and form the dependency graph that is watched
+// - A background thread polls the modification times of every file in the graph, a change recompiles only the
+//   shaders that are or include that file, a shader that fails to compile keeps its previous module
+// - update() swaps the new bytecode into the existing Shader objects between frames, recombines the set layouts of the
+//   programs using them and evicts only their pipelines from the PipelineCache
+// - Replaced modules and evicted pipelines are destroyed once every frame that may still use them has retired
+class ShaderHotReloader
+{
+  public:
+	// Get: Returns the process-wide reloader, shaders register from their constructors without access to App
+	static ShaderHotReloader &get();
+
+	// Start: Begins watching on a background thread, shaders are recompiled with the core's ShaderCompiler
+	void start(lz::Core *core);
+
+	// Stop: Joins the watcher thread and destroys the retired objects, the device must be idle
+	void stop();
+
+	// ReloadAll: Recompiles every registered shader on the next poll as if all of its files changed
+	void reload_all();
+
+	// Update: Applies the shaders compiled since the last call, call once per frame before any command is recorded
+	void update();
+
+	void add_shader(lz::Shader *shader);
+
+	void remove_shader(lz::Shader *shader);
+
+	void add_program(lz::ShaderProgram *program);
+
+	void remove_program(lz::ShaderProgram *program);
+
+  private:
+	ShaderHotReloader();
+
+	// WatchedSource: Shaders loaded from one source file with the same defines and the files the last compilation read
+	struct WatchedSource
+	{
+		std::vector<lz::Shader *> shaders;
+		std::set<std::string>     dependencies;
+	};
+
+	struct CompiledSource
+	{
+		ShaderSource          source;
+		std::vector<uint32_t> bytecode;
+		std::set<std::string> dependencies;
+	};
+
+	// objects replaced by a reload are destroyed once every frame that may still use them has retired
+	struct RetiredObjects
+	{
+		std::vector<std::unique_ptr<lz::ShaderModule>>     shader_modules;
+		std::vector<std::unique_ptr<lz::GraphicsPipeline>> graphics_pipelines;
+		std::vector<std::unique_ptr<lz::ComputePipeline>>  compute_pipelines;
+		uint64_t                                           retire_frame;
+	};
+
+	void watch_loop();
+
+	// FindChangedSources: Sources whose dependencies were modified since the previous poll, called on the watcher
+	std::vector<ShaderSource> find_changed_sources(bool reload_all);
+
+	void destroy_retired_objects();
+
+	lz::Core *core_;
+
+	std::mutex                            mutex_;
+	std::condition_variable               watch_condition_;
+	std::map<ShaderSource, WatchedSource> sources_;
+	std::set<lz::ShaderProgram *>         programs_;
+	std::vector<CompiledSource>           compiled_sources_;
+	bool                                  reload_all_requested_;
+	bool                                  stopping_;
+	std::thread                           watch_thread_;
+
+	// only touched by the watcher thread
+	std::map<std::string, std::filesystem::file_time_type> file_times_;
+
+	uint64_t                   frame_index_;
+	std::deque<RetiredObjects> retired_objects_;
+};
+}        // namespace lz
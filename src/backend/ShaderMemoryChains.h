@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace lz
+{
+// ShaderMemoryChains: Per-frame chains of blocks, the allocation bookkeeping of the shader memory pool
+// - Every frame in flight owns a chain that is rewound when the frame begins, allocations are aligned to the dynamic
+//   uniform offset alignment
+// - When an allocation does not fit, the next block of the chain is used, a new block twice the size is added if needed
+// - A frame that needed several blocks gets them merged into one large enough block the next time it begins
+// - Blocks that stay mostly empty for shrink_frames frames are halved down to the initial size, the frames are counted
+//   over all chains so the window does not stretch with the number of frames in flight
+// - Block only needs a uint32_t size member, blocks are made and freed by the caller's callbacks so nothing here touches
+//   the device
+template <typename Block>
+class ShaderMemoryChains
+{
+  public:
+	struct Allocation
+	{
+		Block   *block;
+		uint32_t offset;
+		uint32_t size;        // aligned size
+	};
+
+	ShaderMemoryChains(uint32_t frames_count, uint32_t alignment, uint32_t initial_block_size, uint32_t shrink_frames) :
+	    alignment_(alignment),
+	    initial_block_size_(initial_block_size),
+	    shrink_frames_(shrink_frames)
+	{
+		frames_.resize(frames_count);
+	}
+
+	// BeginFrame: Rewinds the chain of the given frame, create makes a Block of a size and release frees a vector of them
+	template <typename CreateFunc, typename ReleaseFunc>
+	void begin_frame(uint32_t frame_index, CreateFunc &&create, ReleaseFunc &&release)
+	{
+		FrameChain &chain = frames_[frame_index];
+		frame_number_++;
+
+		if (chain.blocks.empty())
+		{
+			chain.blocks.push_back(create(initial_block_size_));
+		}
+		else if (chain.blocks.size() > 1)
+		{
+			// the frame overflowed its first block last time, merge the chain into one block with some headroom
+			uint32_t merged_size = initial_block_size_;
+			while (merged_size < chain.used_size + chain.used_size / 4)
+			{
+				merged_size *= 2;
+			}
+			resize_chain(chain, merged_size, create, release);
+		}
+		else if (chain.blocks[0].size > initial_block_size_ && chain.used_size < chain.blocks[0].size / 4)
+		{
+			// a chain begins once every frames_count frames, the idle time is the distance in frames since low use was seen
+			if (chain.low_use_start_frame == 0)
+			{
+				chain.low_use_start_frame = frame_number_;
+			}
+			else if (frame_number_ - chain.low_use_start_frame >= shrink_frames_)
+			{
+				resize_chain(chain, chain.blocks[0].size / 2, create, release);
+			}
+		}
+		else
+		{
+			chain.low_use_start_frame = 0;
+		}
+
+		curr_frame_            = &chain;
+		curr_block_index_      = 0;
+		prev_blocks_used_size_ = 0;
+		curr_offset_           = 0;
+	}
+
+	// Allocate: Aligned range of the current frame, moves to the next block of the chain when the current one is full
+	template <typename CreateFunc>
+	Allocation allocate(uint32_t size, CreateFunc &&create)
+	{
+		const uint32_t aligned_size = align_size(size, alignment_);
+
+		if (curr_offset_ + aligned_size > curr_frame_->blocks[curr_block_index_].size)
+		{
+			prev_blocks_used_size_ += curr_offset_;
+			curr_block_index_++;
+			if (curr_block_index_ == curr_frame_->blocks.size())
+			{
+				uint32_t block_size = curr_frame_->blocks.back().size * 2;
+				while (block_size < aligned_size)
+				{
+					block_size *= 2;
+				}
+				curr_frame_->blocks.push_back(create(block_size));
+			}
+			curr_offset_ = 0;
+		}
+
+		Allocation allocation;
+		allocation.block  = &curr_frame_->blocks[curr_block_index_];
+		allocation.offset = curr_offset_;
+		allocation.size   = aligned_size;
+		curr_offset_ += aligned_size;
+		return allocation;
+	}
+
+	// EndFrame: Records the memory used by the frame
+	void end_frame()
+	{
+		curr_frame_->used_size = prev_blocks_used_size_ + curr_offset_;
+		last_frame_used_size_  = curr_frame_->used_size;
+		peak_used_size_        = std::max(peak_used_size_, last_frame_used_size_);
+		curr_frame_            = nullptr;
+	}
+
+	// Release: Frees the blocks of every frame
+	template <typename ReleaseFunc>
+	void release(ReleaseFunc &&release_blocks)
+	{
+		for (auto &frame : frames_)
+		{
+			if (!frame.blocks.empty())
+			{
+				release_blocks(frame.blocks);
+				frame.blocks.clear();
+			}
+		}
+	}
+
+	// GetCurrentBlock: Block the last allocation of the current frame was made from
+	const Block *get_current_block() const
+	{
+		return &curr_frame_->blocks[curr_block_index_];
+	}
+
+	uint32_t get_alignment() const
+	{
+		return alignment_;
+	}
+
+	size_t get_blocks_count(uint32_t frame_index) const
+	{
+		return frames_[frame_index].blocks.size();
+	}
+
+	uint32_t get_last_frame_used_size() const
+	{
+		return last_frame_used_size_;
+	}
+
+	uint32_t get_peak_used_size() const
+	{
+		return peak_used_size_;
+	}
+
+	uint64_t get_allocated_size() const
+	{
+		uint64_t allocated_size = 0;
+		for (const auto &frame : frames_)
+		{
+			for (const auto &block : frame.blocks)
+			{
+				allocated_size += block.size;
+			}
+		}
+		return allocated_size;
+	}
+
+	static uint32_t align_size(uint32_t size, uint32_t alignment)
+	{
+		uint32_t res_size = size;
+		if (res_size % alignment != 0)
+		{
+			res_size += (alignment - (res_size % alignment));
+		}
+		return res_size;
+	}
+
+  private:
+	struct FrameChain
+	{
+		std::vector<Block> blocks;
+		uint32_t           used_size           = 0;
+		uint64_t           low_use_start_frame = 0;        // 0 while the chain is not mostly empty
+	};
+
+	template <typename CreateFunc, typename ReleaseFunc>
+	void resize_chain(FrameChain &chain, uint32_t size, CreateFunc &&create, ReleaseFunc &&release)
+	{
+		release(chain.blocks);
+		chain.blocks.clear();
+		chain.blocks.push_back(create(size));
+		chain.low_use_start_frame = 0;
+	}
+
+	uint32_t                alignment_;
+	uint32_t                initial_block_size_;
+	uint32_t                shrink_frames_;
+	std::vector<FrameChain> frames_;
+	FrameChain             *curr_frame_            = nullptr;
+	size_t                  curr_block_index_      = 0;
+	uint32_t                prev_blocks_used_size_ = 0;
+	uint32_t                curr_offset_           = 0;
+	uint32_t                last_frame_used_size_  = 0;
+	uint32_t                peak_used_size_        = 0;
+	uint64_t                frame_number_          = 0;        // frames begun on any chain, the first one is 1
+};
+}        // namespace lz
@@ -1,40 +1,79 @@
 #include "ShaderMemoryPool.h"
 
+#include "Core.h"
+#include "DescriptorSetCache.h"
+#include "EngineConfig.h"
+#include "Logging.h"
+#include "MemoryTracker.h"
 #include "ShaderProgram.h"
 
+#include <set>
+
 namespace lz
 {
-ShaderMemoryPool::ShaderMemoryPool(uint32_t alignment)
+ShaderMemoryPool::ShaderMemoryPool(lz::Core *core, uint32_t frames_count) :
+    core_(core),
+    chains_(frames_count, core->get_dynamic_memory_alignment(), SHADER_MEMORY_INITIAL_BLOCK_SIZE, SHADER_MEMORY_SHRINK_FRAMES),
+    curr_set_info_(nullptr),
+    dst_memory_(nullptr),
+    curr_offset_(0),
+    curr_size_(0)
 {
-	this->alignment_ = alignment;
 }
 
-void ShaderMemoryPool::map_buffer(lz::Buffer *buffer)
+ShaderMemoryPool::~ShaderMemoryPool()
 {
-	this->buffer_  = buffer;
-	dst_memory_    = this->buffer_->map();
+	chains_.release([this](std::vector<Block> &blocks) { release_blocks(blocks); });
+}
+
+void ShaderMemoryPool::begin_frame(uint32_t frame_index)
+{
+	chains_.begin_frame(
+	    frame_index, [this](uint32_t size) { return create_block(size); },
+	    [this](std::vector<Block> &blocks) { release_blocks(blocks); });
+
+	dst_memory_    = nullptr;
 	curr_offset_   = 0;
 	curr_size_     = 0;
 	curr_set_info_ = nullptr;
 }
 
-void ShaderMemoryPool::unmap_buffer()
+void ShaderMemoryPool::end_frame()
 {
-	buffer_->unmap();
-	buffer_     = nullptr;
+	chains_.end_frame();
 	dst_memory_ = nullptr;
 }
 
 lz::Buffer *ShaderMemoryPool::get_buffer() const
 {
-	return buffer_;
+	return chains_.get_current_block()->buffer.get();
+}
+
+vk::DeviceSize ShaderMemoryPool::get_last_frame_used_size() const
+{
+	return chains_.get_last_frame_used_size();
+}
+
+vk::DeviceSize ShaderMemoryPool::get_peak_used_size() const
+{
+	return chains_.get_peak_used_size();
+}
+
+vk::DeviceSize ShaderMemoryPool::get_allocated_size() const
+{
+	return chains_.get_allocated_size();
 }
 
 ShaderMemoryPool::SetDynamicUniformBindings ShaderMemoryPool::begin_set(const lz::DescriptorSetLayoutKey *set_info)
 {
 	this->curr_set_info_ = set_info;
-	curr_size_ += curr_set_info_->get_total_constant_buffer_size();
-	curr_size_ = align_size(curr_size_, alignment_);
+
+	// overflow moves the set to the next block of the chain, allocating it if the chain is exhausted
+	const auto allocation = chains_.allocate(curr_set_info_->get_total_constant_buffer_size(),
+	                                         [this](uint32_t size) { return create_block(size); });
+	dst_memory_  = allocation.block->mapped_data;
+	curr_offset_ = allocation.offset;
+	curr_size_   = allocation.offset + allocation.size;
 
 	SetDynamicUniformBindings dynamic_bindings;
 	dynamic_bindings.dynamic_offset = curr_offset_;
@@ -59,17 +98,34 @@ ShaderMemoryPool::SetDynamicUniformBindings ShaderMemoryPool::begin_set(const lz
 
 void ShaderMemoryPool::end_set()
 {
-	curr_offset_   = curr_size_;
 	curr_set_info_ = nullptr;
 }
 
-uint32_t ShaderMemoryPool::align_size(uint32_t size, uint32_t alignment)
+ShaderMemoryPool::Block ShaderMemoryPool::create_block(uint32_t size)
 {
-	uint32_t res_size = size;
-	if (res_size % alignment != 0)
+	MemoryTracker::ScopedCategory memory_category(MemoryCategory::eShaderMemory);
+	LOGD("Shader memory pool allocates a block of {} bytes", size);
+
+	Block block;
+	block.size   = size;
+	block.buffer = std::make_unique<lz::Buffer>(
+	    core_->get_physical_device(), core_->get_logical_device(), size,
+	    vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress,        // descriptor buffers address the blocks
+	    vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+	block.mapped_data = block.buffer->map();
+	return block;
+}
+
+void ShaderMemoryPool::release_blocks(std::vector<Block> &blocks)
+{
+	std::set<const lz::Buffer *> buffers;
+	for (auto &block : blocks)
 	{
-		res_size += (alignment - (res_size % alignment));
+		block.buffer->unmap();
+		buffers.insert(block.buffer.get());
 	}
-	return res_size;
+
+	// cached descriptor sets are keyed by buffer pointer and must not outlive the blocks
+	core_->get_descriptor_set_cache()->evict_descriptor_sets({}, buffers);
 }
 }        // namespace lz
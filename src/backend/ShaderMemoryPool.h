@@ -1,21 +1,45 @@
 #pragma once
 
+#include "Buffer.h"
 #include "Config.h"
+#include "ShaderBindings.h"
+#include "ShaderMemoryChains.h"
 #include "ShaderProgram.h"
 
 namespace lz
 {
+class Core;
+
+// ShaderMemoryPool: Per-frame allocator for dynamic uniform data
+// - Every frame in flight owns a chain of persistently mapped blocks that is rewound when the frame begins
+// - When a set does not fit, the next block of the chain is used, a new block twice the size is added if needed
+// - A frame that needed several blocks gets them merged into one large enough block the next time it begins
+// - Blocks that stay mostly empty for SHADER_MEMORY_SHRINK_FRAMES frames are halved down to the initial size
+// - The chain bookkeeping lives in ShaderMemoryChains, this class creates the buffers and fills the sets
 class ShaderMemoryPool
 {
   public:
-	ShaderMemoryPool(uint32_t alignment);
+	ShaderMemoryPool(lz::Core *core, uint32_t frames_count);
+	~ShaderMemoryPool();
 
-	void map_buffer(lz::Buffer *buffer);
+	// BeginFrame: Rewinds the chain of the given frame, its previous GPU work must be complete
+	void begin_frame(uint32_t frame_index);
 
-	void unmap_buffer();
+	// EndFrame: Records the memory used by the frame
+	void end_frame();
 
+	// GetBuffer: Returns the block that the current set is allocated from
 	lz::Buffer *get_buffer() const;
 
+	// GetLastFrameUsedSize: Returns the bytes used by the last finished frame, its high-water mark
+	vk::DeviceSize get_last_frame_used_size() const;
+
+	// GetPeakUsedSize: Returns the highest per-frame usage seen so far
+	vk::DeviceSize get_peak_used_size() const;
+
+	// GetAllocatedSize: Returns the total size of all blocks of all frames
+	vk::DeviceSize get_allocated_size() const;
+
 	struct SetDynamicUniformBindings
 	{
 		std::vector<UniformBufferBinding> uniform_buffer_bindings;
@@ -37,6 +61,19 @@ class ShaderMemoryPool
 		return (BufferType *) ((char *) dst_memory_ + total_offset);
 	}
 
+	// GetUniformBufferData: Data of a uniform block generated from the shader reflection, found by its binding index
+	template <typename BufferType>
+	BufferType *get_uniform_buffer_data()
+	{
+		static_assert(BufferType::type == lz::ShaderBindingType::eUniformBuffer, "the binding is not a uniform buffer");
+		assert(curr_set_info_->get_set_id() == BufferType::set);
+		const auto *buffer_info = curr_set_info_->find_uniform_buffer(BufferType::binding);
+		assert(buffer_info && buffer_info->size == sizeof(BufferType));
+		const size_t total_offset = curr_offset_ + buffer_info->offset_in_set;
+		assert(total_offset + sizeof(BufferType) <= curr_size_);
+		return (BufferType *) ((char *) dst_memory_ + total_offset);
+	}
+
 	template <typename BufferType>
 	BufferType *get_uniform_buffer_data(std::string bufferName)
 	{
@@ -64,10 +101,18 @@ class ShaderMemoryPool
 	}
 
   private:
-	static uint32_t align_size(uint32_t size, uint32_t alignment);
+	struct Block
+	{
+		std::unique_ptr<lz::Buffer> buffer;
+		void                       *mapped_data;
+		uint32_t                    size;
+	};
+
+	Block create_block(uint32_t size);
+	void  release_blocks(std::vector<Block> &blocks);
 
-	uint32_t                          alignment_;
-	lz::Buffer                       *buffer_;
+	lz::Core                         *core_;
+	lz::ShaderMemoryChains<Block>     chains_;
 	const lz::DescriptorSetLayoutKey *curr_set_info_;
 	void                             *dst_memory_;
 	uint32_t                          curr_offset_;
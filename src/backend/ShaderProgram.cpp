@@ -1,13 +1,17 @@
 #include "ShaderProgram.h"
 #include "Logging.h"
 
+#include "ShaderHotReloader.h"
 #include "ShaderModule.h"
+#include "StartupProfiler.h"
 
 // Include glslang headers
 #include <glslang/Public/ResourceLimits.h>
 #include <glslang/Public/ShaderLang.h>
 #include <glslang/SPIRV/GlslangToSpv.h>
 #include <iostream>
+#include <mutex>
+#include <tuple>
 
 namespace lz
 {
@@ -268,6 +272,15 @@ DescriptorSetLayoutKey::UniformBufferData DescriptorSetLayoutKey::get_uniform_bu
 	return uniform_buffer_datum_[uniform_buffer_id.id_];
 }
 
+const DescriptorSetLayoutKey::UniformBufferData *DescriptorSetLayoutKey::find_uniform_buffer(uint32_t shader_binding_index) const
+{
+	if (shader_binding_index >= uniform_buffer_binding_indices_.size() || uniform_buffer_binding_indices_[shader_binding_index] == size_t(-1))
+	{
+		return nullptr;
+	}
+	return &uniform_buffer_datum_[uniform_buffer_binding_indices_[shader_binding_index]];
+}
+
 UniformBufferBinding DescriptorSetLayoutKey::make_uniform_buffer_binding(
     std::string buffer_name, lz::Buffer *buffer,
     vk::DeviceSize offset, vk::DeviceSize size) const
@@ -681,6 +694,7 @@ void DescriptorSetLayoutKey::rebuild_index()
 
 	uniform_buffer_name_to_ids_.clear();
 	uniform_buffer_binding_to_ids_.clear();
+	uniform_buffer_binding_indices_.clear();
 	this->size_ = 0;
 	for (size_t uniform_buffer_index = 0; uniform_buffer_index < uniform_buffer_datum_.size(); ++uniform_buffer_index)
 	{
@@ -689,6 +703,12 @@ void DescriptorSetLayoutKey::rebuild_index()
 		uniform_buffer_name_to_ids_[uniform_buffer_data.name]                    = uniform_buffer_id;
 		uniform_buffer_binding_to_ids_[uniform_buffer_data.shader_binding_index] = uniform_buffer_id;
 		this->size_ += uniform_buffer_data.size;
+
+		if (uniform_buffer_data.shader_binding_index >= uniform_buffer_binding_indices_.size())
+		{
+			uniform_buffer_binding_indices_.resize(uniform_buffer_data.shader_binding_index + 1, size_t(-1));
+		}
+		uniform_buffer_binding_indices_[uniform_buffer_data.shader_binding_index] = uniform_buffer_index;
 	}
 
 	image_sampler_name_to_ids_.clear();
@@ -766,9 +786,13 @@ std::string readShaderFile(const std::string &filename)
 }
 
 // Initialize glslang (call once)
-static bool glslangInitialized = false;
+// - Shaders are compiled from ShaderCompiler workers, the first ones may get here at the same time
+static std::mutex glslangMutex;
+static bool       glslangInitialized = false;
+
 static void initializeGlslang()
 {
+	std::lock_guard<std::mutex> lock(glslangMutex);
 	if (!glslangInitialized)
 	{
 		glslang::InitializeProcess();
@@ -913,12 +937,48 @@ const TBuiltInResource *getDefaultResources()
 }
 
 // Modified get_bytecode method that can both load precompiled SPIR-V and compile GLSL to SPIR-V
-const std::vector<uint32_t> Shader::get_bytecode(std::string filename)
+ShaderSource::ShaderSource(const char *file) :
+    file(file)
+{
+}
+
+ShaderSource::ShaderSource(std::string file, ShaderDefines defines) :
+    file(std::move(file)), defines(std::move(defines))
+{
+}
+
+std::string ShaderSource::get_name() const
+{
+	std::string name = file.substr(file.find_last_of("/\\") + 1);
+	for (const auto &[define_name, define_value] : defines)
+	{
+		name += " " + define_name + "=" + define_value;
+	}
+	return name;
+}
+
+bool ShaderSource::operator<(const ShaderSource &other) const
+{
+	return std::tie(file, defines) < std::tie(other.file, other.defines);
+}
+
+bool ShaderSource::operator==(const ShaderSource &other) const
+{
+	return std::tie(file, defines) == std::tie(other.file, other.defines);
+}
+
+const std::vector<uint32_t> Shader::get_bytecode(std::string filename, const ShaderDefines &defines, std::set<std::string> *dependencies)
 {
 	// Check if file is a precompiled SPIR-V (.spv) or a GLSL source file
 	const std::string extension          = filename.substr(filename.find_last_of('.') + 1);
 	const bool        isPrecompiledSpirv = (extension == "spv");
 
+	if (dependencies)
+	{
+		dependencies->clear();
+		dependencies->insert(filename);
+	}
+
 	if (isPrecompiledSpirv)
 	{
 		// Handle precompiled SPIR-V file
@@ -940,6 +1000,7 @@ const std::vector<uint32_t> Shader::get_bytecode(std::string filename)
 	else
 	{
 		LOGI("Compiling GLSL shader: {}", filename);
+		StartupProfiler::ScopedPhase startup_phase("GLSL compilation");
 		// Handle GLSL source file - compile to SPIR-V using glslang
 		// Initialize glslang
 		initializeGlslang();
@@ -953,6 +1014,14 @@ const std::vector<uint32_t> Shader::get_bytecode(std::string filename)
 		const char      *shaderStrings[1] = {shaderSource.c_str()};
 		shader.setStrings(shaderStrings, 1);
 
+		// defines go into the preamble, it is parsed after #version like defines given on the command line
+		std::string preamble;
+		for (const auto &[define_name, define_value] : defines)
+		{
+			preamble += "#define " + define_name + " " + define_value + "\n";
+		}
+		shader.setPreamble(preamble.c_str());
+
 		// Set up compiler options
 		int                               clientInputSemanticsVersion = 460;        // Use GLSL 4.60 by default
 		glslang::EShTargetClientVersion   vulkanClientVersion         = glslang::EShTargetVulkan_1_2;
@@ -989,6 +1058,12 @@ const std::vector<uint32_t> Shader::get_bytecode(std::string filename)
 			throw std::runtime_error("Failed to link GLSL program: " + filename + "\n" + program.getInfoLog() + "\n" + program.getInfoDebugLog());
 		}
 
+		if (dependencies)
+		{
+			const auto included_files = includer.getIncludedFiles();
+			dependencies->insert(included_files.begin(), included_files.end());
+		}
+
 		// Generate SPIR-V
 		std::vector<uint32_t> spirv;
 		glslang::GlslangToSpv(*program.getIntermediate(stage), spirv);
@@ -997,17 +1072,48 @@ const std::vector<uint32_t> Shader::get_bytecode(std::string filename)
 	}
 }
 
-Shader::Shader(vk::Device logical_device, std::string shader_file)
+Shader::Shader(vk::Device logical_device, const ShaderSource &source) :
+    source_(source)
 {
-	const auto bytecode = get_bytecode(shader_file);
+	const auto bytecode = get_bytecode(source.file, source.defines, &dependencies_);
 	init(logical_device, bytecode);
+	ShaderHotReloader::get().add_shader(this);
 }
 
-Shader::Shader(vk::Device logical_device, const std::vector<uint32_t> &bytecode)
+Shader::Shader(vk::Device logical_device, const std::vector<uint32_t> &bytecode) :
+    source_(std::string())
 {
 	init(logical_device, bytecode);
 }
 
+Shader::~Shader()
+{
+	if (!source_.file.empty())
+	{
+		ShaderHotReloader::get().remove_shader(this);
+	}
+}
+
+std::unique_ptr<lz::ShaderModule> Shader::reload(vk::Device logical_device, const std::vector<uint32_t> &bytecode,
+                                                 const std::set<std::string> &dependencies)
+{
+	auto prev_shader_module = std::move(shader_module_);
+	descriptor_set_layout_keys_.clear();
+	init(logical_device, bytecode);
+	dependencies_ = dependencies;
+	return prev_shader_module;
+}
+
+const ShaderSource &Shader::get_source() const
+{
+	return source_;
+}
+
+const std::set<std::string> &Shader::get_dependencies() const
+{
+	return dependencies_;
+}
+
 lz::ShaderModule *Shader::get_module()
 {
 	return shader_module_.get();
@@ -1033,9 +1139,32 @@ glm::uvec3 Shader::get_local_size()
 	return local_size_;
 }
 
+const std::vector<uint32_t> &Shader::get_specialization_constant_ids() const
+{
+	return specialization_constant_ids_;
+}
+
+std::vector<DescriptorSetLayoutKey> Shader::reflect_set_layouts(const std::vector<uint32_t> &bytecode)
+{
+	Shader shader;
+	shader.reflect(bytecode);
+	return std::move(shader.descriptor_set_layout_keys_);
+}
+
+Shader::Shader() :
+    source_(std::string())
+{
+}
+
 void Shader::init(vk::Device logical_device, const std::vector<uint32_t> &bytecode)
 {
+	StartupProfiler::ScopedPhase startup_phase("Shader reflection");
 	shader_module_.reset(new ShaderModule(logical_device, bytecode));
+	reflect(bytecode);
+}
+
+void Shader::reflect(const std::vector<uint32_t> &bytecode)
+{
 	local_size_ = glm::uvec3(0);
 	spirv_cross::Compiler compiler(bytecode.data(), bytecode.size());
 
@@ -1086,6 +1215,13 @@ void Shader::init(vk::Device logical_device, const std::vector<uint32_t> &byteco
 		}
 	}
 
+	// local sizes given with local_size_x_id are reported here too, local_size_ then holds their defaults
+	specialization_constant_ids_.clear();
+	for (const auto &specialization_constant : compiler.get_specialization_constants())
+	{
+		specialization_constant_ids_.push_back(specialization_constant.constant_id);
+	}
+
 	spirv_cross::ShaderResources resources = compiler.get_shader_resources();
 
 	struct SetResources
@@ -1247,14 +1383,33 @@ void Shader::init(vk::Device logical_device, const std::vector<uint32_t> &byteco
 	}
 }
 
-ShaderProgram::ShaderProgram(std::initializer_list<Shader *> shaders)
+ShaderProgram::ShaderProgram(std::initializer_list<Shader *> shaders) :
+    shaders(shaders)
+{
+	update();
+	ShaderHotReloader::get().add_program(this);
+}
+
+ShaderProgram::ShaderProgram(const std::vector<Shader *> &shaders) :
+    shaders(shaders)
+{
+	update();
+	ShaderHotReloader::get().add_program(this);
+}
+
+ShaderProgram::~ShaderProgram()
+{
+	ShaderHotReloader::get().remove_program(this);
+}
+
+void ShaderProgram::update()
 {
 	size_t max_sets_count = 0;
 	for (auto &shader : shaders)
 	{
-		this->shaders.push_back(shader);
 		max_sets_count = std::max(max_sets_count, shader->get_sets_count());
 	}
+	combined_descriptor_set_layout_keys.clear();
 	combined_descriptor_set_layout_keys.resize(max_sets_count);
 	for (size_t set_index = 0; set_index < combined_descriptor_set_layout_keys.size(); ++set_index)
 	{
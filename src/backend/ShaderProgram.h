@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <map>
 #include <set>
+#include <string>
 
 #include "Buffer.h"
 #include "ShaderModule.h"
@@ -238,6 +239,9 @@ class DescriptorSetLayoutKey
 
 	UniformBufferData get_uniform_buffer_info(UniformBufferId uniform_buffer_id) const;
 
+	// FindUniformBuffer: Uniform buffer at a binding index without hashing or copying, nullptr when the set has none there
+	const UniformBufferData *find_uniform_buffer(uint32_t shader_binding_index) const;
+
 	UniformBufferBinding make_uniform_buffer_binding(std::string buffer_name, lz::Buffer *buffer,
 	                                                 vk::DeviceSize offset = 0,
 	                                                 vk::DeviceSize size   = VK_WHOLE_SIZE) const;
@@ -332,16 +336,55 @@ class DescriptorSetLayoutKey
 	std::map<uint32_t, StorageBufferId>    storage_buffer_binding_to_ids_;
 	std::map<std::string, StorageImageId>  storage_image_name_to_ids_;
 	std::map<uint32_t, StorageImageId>     storage_image_binding_to_ids_;
+
+	// index into uniform_buffer_datum_ by binding index, size_t(-1) where the set has no uniform buffer
+	std::vector<size_t> uniform_buffer_binding_indices_;
+};
+
+// ShaderDefines: Preprocessor defines a shader is compiled with, name to value
+using ShaderDefines = std::map<std::string, std::string>;
+
+// SpecializationConstants: Values of specialization constants by constant_id
+using SpecializationConstants = std::map<uint32_t, uint32_t>;
+
+// ShaderSource: A shader file and the defines it is compiled with, identifies one variant of the file
+struct ShaderSource
+{
+	ShaderSource(const char *file);
+	ShaderSource(std::string file, ShaderDefines defines = ShaderDefines());
+
+	// GetName: File name followed by the defines, for logs and profiler tasks
+	std::string get_name() const;
+
+	bool operator<(const ShaderSource &other) const;
+	bool operator==(const ShaderSource &other) const;
+
+	std::string   file;
+	ShaderDefines defines;
 };
 
 class Shader
 {
   public:
-	Shader(vk::Device logical_device, std::string shader_file);
+	// Shaders loaded from a file register with the ShaderHotReloader and are recompiled when the file or its includes change
+	Shader(vk::Device logical_device, const ShaderSource &source);
 
 	Shader(vk::Device logical_device, const std::vector<uint32_t> &bytecode);
 
-	static const std::vector<uint32_t> get_bytecode(std::string filename);
+	~Shader();
+
+	// GetBytecode: Loads SPIR-V or compiles GLSL with the defines prepended, dependencies receives the file and every file it includes
+	static const std::vector<uint32_t> get_bytecode(std::string filename, const ShaderDefines &defines = ShaderDefines(),
+	                                                std::set<std::string> *dependencies = nullptr);
+
+	// Reload: Replaces the module and the reflected layouts in place, returns the previous module for deferred deletion
+	std::unique_ptr<lz::ShaderModule> reload(vk::Device logical_device, const std::vector<uint32_t> &bytecode,
+	                                         const std::set<std::string> &dependencies);
+
+	// GetSource: File and defines the shader was compiled from, the file is empty for shaders created from bytecode
+	const ShaderSource &get_source() const;
+
+	const std::set<std::string> &get_dependencies() const;
 
 	lz::ShaderModule *get_module();
 
@@ -353,14 +396,29 @@ class Shader
 
 	glm::uvec3 get_local_size();
 
+	// GetSpecializationConstantIds: constant_id of every specialization constant the stage declares, workgroup sizes included
+	const std::vector<uint32_t> &get_specialization_constant_ids() const;
+
+	// ReflectSetLayouts: Descriptor set layouts of a stage without creating its module, for tools that run without a device
+	static std::vector<DescriptorSetLayoutKey> reflect_set_layouts(const std::vector<uint32_t> &bytecode);
+
   private:
+	Shader();
+
 	void init(vk::Device logical_device, const std::vector<uint32_t> &bytecode);
 
+	// Reflect: Reads the stage, workgroup size, specialization constants and set layouts of the bytecode
+	void reflect(const std::vector<uint32_t> &bytecode);
+
 	std::vector<DescriptorSetLayoutKey> descriptor_set_layout_keys_;
 	vk::ShaderStageFlagBits             stage_flag_bits_;
 
 	std::unique_ptr<lz::ShaderModule> shader_module_;
 	glm::uvec3                        local_size_;
+	std::vector<uint32_t>             specialization_constant_ids_;
+
+	ShaderSource          source_;
+	std::set<std::string> dependencies_;
 };
 
 class ShaderProgram
@@ -368,6 +426,16 @@ class ShaderProgram
   public:
 	ShaderProgram(std::initializer_list<Shader *> shaders);
 
+	explicit ShaderProgram(const std::vector<Shader *> &shaders);
+
+	~ShaderProgram();
+
+	ShaderProgram(const ShaderProgram &)            = delete;
+	ShaderProgram &operator=(const ShaderProgram &) = delete;
+
+	// Update: Recombines the set layouts of the stages after one of them was reloaded
+	void update();
+
 	size_t get_sets_count();
 
 	const DescriptorSetLayoutKey *get_set_info(size_t set_index);
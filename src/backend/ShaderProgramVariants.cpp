@@ -0,0 +1,62 @@
+#include "ShaderProgramVariants.h"
+
+#include "Core.h"
+#include "Logging.h"
+
+namespace lz
+{
+ShaderProgramVariants::ShaderProgramVariants(lz::Core *core, std::vector<std::string> stage_files) :
+    core_(core),
+    stage_files_(std::move(stage_files))
+{
+}
+
+lz::ShaderProgram *ShaderProgramVariants::get_program(const ShaderDefines &defines)
+{
+	return get_variant(defines).program.get();
+}
+
+lz::Shader *ShaderProgramVariants::get_shader(const ShaderDefines &defines, const size_t stage_index)
+{
+	return get_variant(defines).shaders[stage_index].get();
+}
+
+size_t ShaderProgramVariants::get_variants_count() const
+{
+	return variants_.size();
+}
+
+void ShaderProgramVariants::clear()
+{
+	variants_.clear();
+}
+
+ShaderProgramVariants::Variant &ShaderProgramVariants::get_variant(const ShaderDefines &defines)
+{
+	const auto variant_it = variants_.find(defines);
+	if (variant_it != variants_.end())
+	{
+		return *variant_it->second;
+	}
+
+	std::vector<ShaderSource> sources;
+	for (const auto &stage_file : stage_files_)
+	{
+		sources.emplace_back(stage_file, defines);
+	}
+
+	// cached only once every stage compiled, a variant that failed is compiled again on the next request
+	auto variant     = std::make_unique<Variant>();
+	variant->shaders = core_->get_shader_compiler()->create_shaders(core_->get_logical_device(), sources);
+
+	std::vector<lz::Shader *> shaders;
+	for (const auto &shader : variant->shaders)
+	{
+		shaders.push_back(shader.get());
+	}
+	variant->program = std::make_unique<lz::ShaderProgram>(shaders);
+
+	LOGI("Compiled shader variant {}, {} variants cached", sources.front().get_name(), variants_.size() + 1);
+	return *variants_.emplace(defines, std::move(variant)).first->second;
+}
+}        // namespace lz
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "ShaderProgram.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lz
+{
+class Core;
+
+// ShaderProgramVariants: Permutations of one set of shader stages, each compiled with its own defines
+// - A variant is compiled the first time its defines are requested, all of its stages in one ShaderCompiler batch,
+//   and cached until clear() so switching back to it is free
+// - Every variant has its own shader modules, the PipelineCache keys pipelines by module so each variant gets its own
+//   pipelines without the cache knowing about variants
+// - Variant shaders register with the ShaderHotReloader under their defines, editing a file reloads every variant of it
+class ShaderProgramVariants
+{
+  public:
+	ShaderProgramVariants(lz::Core *core, std::vector<std::string> stage_files);
+
+	ShaderProgramVariants(const ShaderProgramVariants &)            = delete;
+	ShaderProgramVariants &operator=(const ShaderProgramVariants &) = delete;
+
+	// GetProgram: Program of the variant with these defines, compiled on first use
+	lz::ShaderProgram *get_program(const ShaderDefines &defines);
+
+	// GetShader: Stage of the variant with these defines in the order of the stage files, compiled on first use
+	lz::Shader *get_shader(const ShaderDefines &defines, size_t stage_index = 0);
+
+	size_t get_variants_count() const;
+
+	// Clear: Destroys every variant, the device must be idle
+	void clear();
+
+  private:
+	struct Variant
+	{
+		std::vector<std::unique_ptr<lz::Shader>> shaders;
+		std::unique_ptr<lz::ShaderProgram>       program;
+	};
+
+	Variant &get_variant(const ShaderDefines &defines);
+
+	lz::Core                                         *core_;
+	std::vector<std::string>                          stage_files_;
+	std::map<ShaderDefines, std::unique_ptr<Variant>> variants_;
+};
+}        // namespace lz
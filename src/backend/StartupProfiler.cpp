@@ -0,0 +1,211 @@
+#include "StartupProfiler.h"
+
+#include "Logging.h"
+
+#include <algorithm>
+#include <bit>
+#include <fstream>
+#include <map>
+
+namespace lz
+{
+// phases opened on this thread and not closed yet, innermost last
+static thread_local std::vector<size_t> open_phases;
+
+StartupProfiler::ScopedPhase::ScopedPhase(const char *name) :
+    phase_index_(StartupProfiler::get().begin_phase(name))
+{
+}
+
+StartupProfiler::ScopedPhase::~ScopedPhase()
+{
+	StartupProfiler::get().end_phase(phase_index_);
+}
+
+StartupProfiler &StartupProfiler::get()
+{
+	static StartupProfiler profiler;
+	return profiler;
+}
+
+StartupProfiler::StartupProfiler() :
+    recording_(false),
+    start_time_(clock::now()),
+    total_ms_(0.0)
+{
+}
+
+void StartupProfiler::begin()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	phases_.clear();
+	thread_indices_.clear();
+	start_time_ = clock::now();
+	total_ms_   = 0.0;
+	recording_  = true;
+}
+
+void StartupProfiler::finish(const std::string &report_file)
+{
+	if (!recording_.exchange(false))
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		total_ms_ = get_time_ms();
+	}
+	const Json::Value report = build_report();
+	print_summary(report);
+
+	std::ofstream file(report_file);
+	if (!file.is_open())
+	{
+		LOGE("Failed to write {}", report_file);
+		return;
+	}
+	file << report.toStyledString();
+	LOGI("Startup report written to {}", report_file);
+}
+
+bool StartupProfiler::is_recording() const
+{
+	return recording_;
+}
+
+size_t StartupProfiler::begin_phase(const char *name)
+{
+	if (!recording_)
+	{
+		return size_t(-1);
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	Phase phase;
+	phase.name         = name;
+	phase.thread_index = get_thread_index();
+	phase.depth        = uint32_t(open_phases.size());
+	phase.parent_index = open_phases.empty() ? size_t(-1) : open_phases.back();
+	phase.start_ms     = get_time_ms();
+	phase.end_ms       = -1.0;
+
+	const size_t phase_index = phases_.size();
+	phases_.push_back(phase);
+	open_phases.push_back(phase_index);
+	return phase_index;
+}
+
+void StartupProfiler::end_phase(const size_t phase_index)
+{
+	if (phase_index == size_t(-1))
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	if (!open_phases.empty() && open_phases.back() == phase_index)
+	{
+		open_phases.pop_back();
+	}
+	// phases from before the last begin() were cleared
+	if (phase_index < phases_.size())
+	{
+		phases_[phase_index].end_ms = get_time_ms();
+	}
+}
+
+Json::Value StartupProfiler::build_report() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	struct PhaseTotals
+	{
+		uint32_t count        = 0;
+		double   total_ms     = 0.0;
+		double   max_ms       = 0.0;
+		uint32_t threads_mask = 0;        // bit per thread index, indices past 31 share the last bit
+	};
+	std::map<std::string, PhaseTotals> totals;
+
+	Json::Value report;
+	report["total_ms"]      = total_ms_;
+	report["threads_count"] = uint32_t(thread_indices_.size());
+	report["phases"]        = Json::Value(Json::arrayValue);
+	for (const auto &phase : phases_)
+	{
+		// phases still open at finish() are cut at the end of startup
+		const double end_ms      = phase.end_ms < 0.0 ? total_ms_ : phase.end_ms;
+		const double duration_ms = end_ms - phase.start_ms;
+
+		Json::Value json_phase;
+		json_phase["name"]        = phase.name;
+		json_phase["thread"]      = phase.thread_index;
+		json_phase["depth"]       = phase.depth;
+		json_phase["parent"]      = phase.parent_index == size_t(-1) ? Json::Value() : Json::Value(Json::UInt64(phase.parent_index));
+		json_phase["start_ms"]    = phase.start_ms;
+		json_phase["duration_ms"] = duration_ms;
+		report["phases"].append(json_phase);
+
+		auto &phase_totals = totals[phase.name];
+		phase_totals.count++;
+		phase_totals.total_ms += duration_ms;
+		phase_totals.max_ms = std::max(phase_totals.max_ms, duration_ms);
+		phase_totals.threads_mask |= 1u << std::min(phase.thread_index, 31u);
+	}
+
+	for (const auto &[name, phase_totals] : totals)
+	{
+		Json::Value &json_totals = report["totals"][name];
+		json_totals["count"]     = phase_totals.count;
+		json_totals["total_ms"]  = phase_totals.total_ms;
+		json_totals["max_ms"]    = phase_totals.max_ms;
+		json_totals["threads"]   = uint32_t(std::popcount(phase_totals.threads_mask));
+	}
+	return report;
+}
+
+double StartupProfiler::get_time_ms() const
+{
+	return std::chrono::duration<double, std::milli>(clock::now() - start_time_).count();
+}
+
+uint32_t StartupProfiler::get_thread_index()
+{
+	// threads are numbered in the order they first record a phase, 0 is usually the main thread
+	auto it = thread_indices_.find(std::this_thread::get_id());
+	if (it == thread_indices_.end())
+	{
+		it = thread_indices_.emplace(std::this_thread::get_id(), uint32_t(thread_indices_.size())).first;
+	}
+	return it->second;
+}
+
+void StartupProfiler::print_summary(const Json::Value &report) const
+{
+	struct Row
+	{
+		std::string name;
+		double      total_ms;
+		double      max_ms;
+		uint32_t    count;
+		uint32_t    threads;
+	};
+	std::vector<Row> rows;
+	for (const auto &name : report["totals"].getMemberNames())
+	{
+		const Json::Value &totals = report["totals"][name];
+		rows.push_back({name, totals["total_ms"].asDouble(), totals["max_ms"].asDouble(), totals["count"].asUInt(), totals["threads"].asUInt()});
+	}
+	std::sort(rows.begin(), rows.end(), [](const Row &left, const Row &right) { return left.total_ms > right.total_ms; });
+
+	LOGI("Startup took {:.1f} ms on {} threads", report["total_ms"].asDouble(), report["threads_count"].asUInt());
+	LOGI("{:<32} {:>10} {:>10} {:>7} {:>8}", "phase", "total ms", "max ms", "count", "threads");
+	for (const auto &row : rows)
+	{
+		LOGI("{:<32} {:>10.1f} {:>10.1f} {:>7} {:>8}", row.name, row.total_ms, row.max_ms, row.count, row.threads);
+	}
+}
+}        // namespace lz
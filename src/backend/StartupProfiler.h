@@ -0,0 +1,84 @@
+#pragma once
+
+#include "json/json.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace lz
+{
+// StartupProfiler: Records the phases of application startup and the threads they ran on
+// - Recording runs from begin() to finish(), phases outside that window cost one atomic load and are dropped
+// - Phases nest per thread, a phase started while another is open on the same thread becomes its child
+// - finish() prints a summary aggregated by phase name and writes every phase to a JSON report,
+//   totals of a phase include the phases nested in it
+class StartupProfiler
+{
+  public:
+	// ScopedPhase: Records a phase from construction to destruction
+	class ScopedPhase
+	{
+	  public:
+		ScopedPhase(const char *name);
+		~ScopedPhase();
+
+		ScopedPhase(const ScopedPhase &)            = delete;
+		ScopedPhase &operator=(const ScopedPhase &) = delete;
+
+	  private:
+		size_t phase_index_;
+	};
+
+	// Get: Returns the process-wide profiler, phases are recorded from loaders and shaders without access to App
+	static StartupProfiler &get();
+
+	// Begin: Starts recording, times are reported relative to this call
+	void begin();
+
+	// Finish: Stops recording, prints the summary and writes the report
+	void finish(const std::string &report_file);
+
+	bool is_recording() const;
+
+	// BeginPhase: Opens a phase on the calling thread, returns an index for end_phase or size_t(-1) when not recording
+	size_t begin_phase(const char *name);
+
+	void end_phase(size_t phase_index);
+
+	// BuildReport: Per-phase records and totals aggregated by name
+	Json::Value build_report() const;
+
+  private:
+	StartupProfiler();
+
+	using clock = std::chrono::steady_clock;
+
+	struct Phase
+	{
+		const char *name;
+		uint32_t    thread_index;
+		uint32_t    depth;
+		size_t      parent_index;        // size_t(-1) for top level phases
+		double      start_ms;
+		double      end_ms;              // negative while the phase is open
+	};
+
+	double get_time_ms() const;
+
+	uint32_t get_thread_index();
+
+	void print_summary(const Json::Value &report) const;
+
+	mutable std::mutex                            mutex_;
+	std::atomic<bool>                             recording_;
+	clock::time_point                             start_time_;
+	double                                        total_ms_;
+	std::vector<Phase>                            phases_;
+	std::unordered_map<std::thread::id, uint32_t> thread_indices_;
+};
+}        // namespace lz
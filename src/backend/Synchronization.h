@@ -500,4 +500,85 @@ static bool is_buffer_barrier_needed(const BufferUsageTypes src_usage_type, cons
 	// could be smarter
 	return true;
 }
+
+/**
+ * @brief Append the barrier transitioning an image subresource range between two usage types, if one is needed
+ * @param src_stage Accumulates the source stages of the appended barriers
+ * @param dst_stage Accumulates the destination stages of the appended barriers
+ */
+static void add_image_barrier(vk::Image image, vk::ImageSubresourceRange range, const ImageUsageTypes src_usage_type,
+                              const ImageUsageTypes dst_usage_type, vk::PipelineStageFlags &src_stage,
+                              vk::PipelineStageFlags &dst_stage, std::vector<vk::ImageMemoryBarrier> &image_barriers)
+{
+	if (is_image_barrier_needed(src_usage_type, dst_usage_type) && range.layerCount > 0 && range.levelCount > 0)
+	{
+		const auto src_image_access_pattern = get_src_image_access_pattern(src_usage_type);
+		const auto dst_image_access_pattern = get_dst_image_access_pattern(dst_usage_type);
+		auto       image_barrier            = vk::ImageMemoryBarrier()
+		                         .setSrcAccessMask(src_image_access_pattern.access_mask)
+		                         .setDstAccessMask(dst_image_access_pattern.access_mask)
+		                         .setOldLayout(src_image_access_pattern.layout)
+		                         .setNewLayout(dst_image_access_pattern.layout)
+		                         .setSubresourceRange(range)
+		                         .setImage(image);
+
+		if (src_image_access_pattern.queue_family_type == dst_image_access_pattern.queue_family_type)
+		{
+			image_barrier
+			    .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+			    .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+		}
+		else
+		{
+			// TODO: transfer queue
+			image_barrier
+			    .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+			    .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+		}
+
+		src_stage |= src_image_access_pattern.stage;
+		dst_stage |= dst_image_access_pattern.stage;
+
+		image_barriers.push_back(image_barrier);
+	}
+}
+
+/**
+ * @brief Append the barrier between two usage types of a whole buffer, if one is needed
+ * @param src_stage Accumulates the source stages of the appended barriers
+ * @param dst_stage Accumulates the destination stages of the appended barriers
+ */
+static void add_buffer_barrier(vk::Buffer buffer, const BufferUsageTypes src_usage_type, const BufferUsageTypes dst_usage_type,
+                               vk::PipelineStageFlags &src_stage, vk::PipelineStageFlags &dst_stage,
+                               std::vector<vk::BufferMemoryBarrier> &buffer_barriers)
+{
+	if (is_buffer_barrier_needed(src_usage_type, dst_usage_type))
+	{
+		const auto src_buffer_access_pattern = get_src_buffer_access_pattern(src_usage_type);
+		const auto dst_buffer_access_pattern = get_dst_buffer_access_pattern(dst_usage_type);
+		auto       buffer_barrier            = vk::BufferMemoryBarrier()
+		                          .setSrcAccessMask(src_buffer_access_pattern.access_mask)
+		                          .setOffset(0)
+		                          .setSize(VK_WHOLE_SIZE)
+		                          .setDstAccessMask(dst_buffer_access_pattern.access_mask)
+		                          .setBuffer(buffer);
+
+		if (src_buffer_access_pattern.queue_family_type == dst_buffer_access_pattern.queue_family_type)
+		{
+			buffer_barrier.setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+			    .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+		}
+		else
+		{
+			// TODO: transfer queue
+			buffer_barrier
+			    .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+			    .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+		}
+
+		src_stage |= src_buffer_access_pattern.stage;
+		dst_stage |= dst_buffer_access_pattern.stage;
+		buffer_barriers.push_back(buffer_barrier);
+	}
+}
 }        // namespace lz
@@ -10,7 +10,7 @@ TimestampQuery::TimestampQuery(vk::PhysicalDevice physical_device, vk::Device lo
 	                                 .setQueryCount(max_timestamp_count);
 	this->query_pool_ = logical_device.createQueryPoolUnique(query_pool_info);
 	this->timestamp_datas_.resize(max_timestamp_count);
-	this->query_results_.resize(max_timestamp_count);
+	this->query_results_.resize(max_timestamp_count * 2);        // value and availability per query
 	this->curr_timestamp_index_ = 0;
 	this->timestamp_period_     = physical_device.getProperties().limits.timestampPeriod;
 }
@@ -32,23 +32,35 @@ void TimestampQuery::add_timestamp(vk::CommandBuffer command_buffer, size_t time
 
 TimestampQuery::QueryResult TimestampQuery::query_results(vk::Device logical_device)
 {
+	QueryResult res;
+	res.data      = timestamp_datas_.data();
+	res.size      = curr_timestamp_index_;
+	res.available = false;
+	if (curr_timestamp_index_ == 0)
+	{
+		return res;
+	}
+
 	std::fill(query_results_.begin(), query_results_.end(), 0);
 	const auto query_res = logical_device.getQueryPoolResults(query_pool_.get(), 0, curr_timestamp_index_,
 	                                                          query_results_.size() * sizeof(std::uint64_t),
-	                                                          query_results_.data(), sizeof(std::uint64_t),
-	                                                          vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
-	// assert(queryRes == vk::Result::eSuccess);
-	if (query_res == vk::Result::eSuccess)
+	                                                          query_results_.data(), 2 * sizeof(std::uint64_t),
+	                                                          vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability);
+
+	// eNotReady means some queries are still pending, the availability words tell which
+	res.available = query_res == vk::Result::eSuccess;
+	for (uint32_t timestamp_index = 0; timestamp_index < curr_timestamp_index_ && res.available; timestamp_index++)
+	{
+		res.available = query_results_[timestamp_index * 2 + 1] != 0;
+	}
+
+	if (res.available)
 	{
 		for (uint32_t timestamp_index = 0; timestamp_index < curr_timestamp_index_; timestamp_index++)
 		{
-			timestamp_datas_[timestamp_index].time = (query_results_[timestamp_index] - query_results_[0]) * double(timestamp_period_ / 1e9);        // in seconds
+			timestamp_datas_[timestamp_index].time = (query_results_[timestamp_index * 2] - query_results_[0]) * double(timestamp_period_ / 1e9);        // in seconds
 		}
 	}
-
-	QueryResult res;
-	res.data = timestamp_datas_.data();
-	res.size = curr_timestamp_index_;
 	return res;
 }
 }        // namespace lz
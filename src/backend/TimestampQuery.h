@@ -22,8 +22,10 @@ struct TimestampQuery
 
 		const TimestampData *data;
 		size_t               size;
+		bool                 available;        // false while the GPU has not written every timestamp yet
 	};
 
+	// Reads the timestamps without waiting, check QueryResult::available before using the data
 	QueryResult query_results(vk::Device logical_device);
 
   private:
@@ -38,6 +38,11 @@ bool VertexDeclaration::operator<(const VertexDeclaration &other) const
 	                                                                other.binding_descriptors_, other.vertex_attributes_);
 }
 
+bool VertexDeclaration::operator==(const VertexDeclaration &other) const
+{
+	return binding_descriptors_ == other.binding_descriptors_ && vertex_attributes_ == other.vertex_attributes_;
+}
+
 vk::Format VertexDeclaration::convert_attrib_type_to_format(AttribTypes attrib_type)
 {
 	switch (attrib_type)
@@ -44,6 +44,8 @@ class VertexDeclaration
 
 	bool operator<(const VertexDeclaration &other) const;
 
+	bool operator==(const VertexDeclaration &other) const;
+
   private:
 	static vk::Format convert_attrib_type_to_format(AttribTypes attrib_type);
 
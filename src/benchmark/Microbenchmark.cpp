@@ -0,0 +1,161 @@
+#include "Microbenchmark.h"
+
+#include "backend/Logging.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+
+namespace lz
+{
+MicrobenchmarkSuite::MicrobenchmarkSuite(const MicrobenchmarkSettings &settings) :
+    settings_(settings),
+    sink_(0)
+{
+}
+
+void MicrobenchmarkSuite::add(Microbenchmark benchmark)
+{
+	benchmarks_.push_back(std::move(benchmark));
+}
+
+Json::Value MicrobenchmarkSuite::run()
+{
+	std::sort(benchmarks_.begin(), benchmarks_.end(),
+	          [](const Microbenchmark &left, const Microbenchmark &right) { return left.name < right.name; });
+
+	Json::Value report;
+	report["settings"]["filter"]            = settings_.filter;
+	report["settings"]["warmup_iterations"] = settings_.warmup_iterations;
+	report["settings"]["min_iterations"]    = settings_.min_iterations;
+	report["settings"]["min_time_ms"]       = settings_.min_time_ms;
+	report["benchmarks"]                    = Json::Value(Json::arrayValue);
+
+	LOGI("{:<48} {:>10} {:>14} {:>14} {:>14}", "benchmark", "iterations", "mean ns", "median ns", "ns/item");
+	for (const auto &benchmark : benchmarks_)
+	{
+		if (!settings_.filter.empty() && benchmark.name.find(settings_.filter) == std::string::npos)
+		{
+			continue;
+		}
+
+		Json::Value result = run_benchmark(benchmark);
+		LOGI("{:<48} {:>10} {:>14.0f} {:>14.0f} {:>14.2f}", benchmark.name, result["iterations"].asUInt(),
+		     result["mean_ns"].asDouble(), result["median_ns"].asDouble(), result["ns_per_item"].asDouble());
+		report["benchmarks"].append(result);
+	}
+
+	std::ofstream file(settings_.report_file);
+	if (file.is_open())
+	{
+		file << report.toStyledString();
+		LOGI("Microbenchmark report written to {}", settings_.report_file);
+	}
+	else
+	{
+		LOGE("Failed to write {}", settings_.report_file);
+	}
+	return report;
+}
+
+Json::Value MicrobenchmarkSuite::run_benchmark(const Microbenchmark &benchmark)
+{
+	using hrc = std::chrono::high_resolution_clock;
+
+	const uint32_t warmup_iterations = benchmark.max_iterations > 0 ? std::min(settings_.warmup_iterations, 1u) : settings_.warmup_iterations;
+	for (uint32_t iteration = 0; iteration < warmup_iterations; iteration++)
+	{
+		if (benchmark.setup)
+		{
+			benchmark.setup();
+		}
+		sink_ = sink_ + benchmark.run();
+	}
+
+	const uint32_t max_iterations = benchmark.max_iterations > 0 ? benchmark.max_iterations : settings_.max_iterations;
+	const uint32_t min_iterations = std::min(settings_.min_iterations, max_iterations);
+
+	std::vector<double> samples;
+	uint64_t            items_count = 0;
+	double              total_time  = 0.0;
+	while (samples.size() < max_iterations &&
+	       (samples.size() < min_iterations || total_time < settings_.min_time_ms * 1e6))
+	{
+		if (benchmark.setup)
+		{
+			benchmark.setup();
+		}
+
+		const auto     start_time = hrc::now();
+		const uint64_t items      = benchmark.run();
+		const auto     end_time   = hrc::now();
+
+		sink_       = sink_ + items;
+		items_count = items;
+
+		const double sample = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count());
+		samples.push_back(sample);
+		total_time += sample;
+	}
+
+	std::sort(samples.begin(), samples.end());
+	const double mean     = total_time / double(samples.size());
+	const double variance = std::accumulate(samples.begin(), samples.end(), 0.0, [mean](double sum, double sample) {
+		                        return sum + (sample - mean) * (sample - mean);
+	                        }) /
+	                        double(samples.size());
+
+	Json::Value result;
+	result["name"]                = benchmark.name;
+	result["iterations"]          = Json::UInt64(samples.size());
+	result["items_per_iteration"] = Json::UInt64(items_count);
+	result["mean_ns"]             = mean;
+	result["median_ns"]           = samples[samples.size() / 2];
+	result["min_ns"]              = samples.front();
+	result["max_ns"]              = samples.back();
+	result["stddev_ns"]           = std::sqrt(variance);
+	result["ns_per_item"]         = items_count > 0 ? mean / double(items_count) : mean;
+	return result;
+}
+
+bool MicrobenchmarkSuite::parse_command_line(int argc, char **argv, MicrobenchmarkSettings &settings)
+{
+	for (int arg_index = 1; arg_index < argc; arg_index++)
+	{
+		const std::string arg       = argv[arg_index];
+		const bool        has_value = arg_index + 1 < argc;
+		if (arg == "--filter" && has_value)
+		{
+			settings.filter = argv[++arg_index];
+		}
+		else if (arg == "--report" && has_value)
+		{
+			settings.report_file = argv[++arg_index];
+		}
+		else if (arg == "--warmup" && has_value)
+		{
+			settings.warmup_iterations = uint32_t(std::stoul(argv[++arg_index]));
+		}
+		else if (arg == "--min-iterations" && has_value)
+		{
+			settings.min_iterations = uint32_t(std::stoul(argv[++arg_index]));
+		}
+		else if (arg == "--min-time" && has_value)
+		{
+			settings.min_time_ms = std::stod(argv[++arg_index]);
+		}
+		else if (arg == "--device")
+		{
+			settings.device = true;
+		}
+		else
+		{
+			LOGE("Unknown option {}, usage: [--filter name] [--report file] [--warmup n] [--min-iterations n] [--min-time ms] [--device]", arg);
+			return false;
+		}
+	}
+	return true;
+}
+}        // namespace lz
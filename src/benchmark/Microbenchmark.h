@@ -0,0 +1,71 @@
+#pragma once
+
+#include "json/json.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace lz
+{
+// Microbenchmark: A fixture timed over repeated iterations
+// - CPU-only unless it was registered for a run with --device
+// - setup runs before every iteration and is not timed, use it to restore inputs that run consumes
+// - run returns the number of items it processed, used for the per-item time in the report
+struct Microbenchmark
+{
+	std::string               name;
+	std::function<void()>     setup;
+	std::function<uint64_t()> run;
+
+	// caps the iterations of slow fixtures such as file loading, 0 uses the suite setting
+	uint32_t max_iterations = 0;
+};
+
+// MicrobenchmarkSettings: Parameters shared by every fixture of a run, filled from the command line
+struct MicrobenchmarkSettings
+{
+	// only fixtures whose name contains the filter are run
+	std::string filter;
+	std::string report_file = "microbenchmark_report.json";
+
+	// iterations run before timing starts
+	uint32_t warmup_iterations = 2;
+
+	// every fixture runs at least min_iterations and for at least min_time_ms
+	uint32_t min_iterations = 10;
+	uint32_t max_iterations = 100000;
+	double   min_time_ms    = 250.0;
+
+	// creates a Vulkan device for the fixtures that record or upload real work, they are not registered otherwise
+	bool device = false;
+};
+
+// MicrobenchmarkSuite: Runs registered fixtures and writes their timings as JSON
+// - Fixtures are reported sorted by name so reports of different runs can be diffed
+// - Times are reported in nanoseconds per iteration: mean, median, min, max and standard deviation
+class MicrobenchmarkSuite
+{
+  public:
+	explicit MicrobenchmarkSuite(const MicrobenchmarkSettings &settings);
+
+	void add(Microbenchmark benchmark);
+
+	// Run: Times every fixture that passes the filter, returns the report
+	Json::Value run();
+
+	// ParseCommandLine: Reads --filter, --report, --warmup, --min-iterations, --min-time and --device, returns false on bad
+	// options
+	static bool parse_command_line(int argc, char **argv, MicrobenchmarkSettings &settings);
+
+  private:
+	Json::Value run_benchmark(const Microbenchmark &benchmark);
+
+	MicrobenchmarkSettings      settings_;
+	std::vector<Microbenchmark> benchmarks_;
+
+	// results of run are accumulated here so the compiler can not discard the work
+	volatile uint64_t sink_;
+};
+}        // namespace lz
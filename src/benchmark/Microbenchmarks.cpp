@@ -0,0 +1,2428 @@
+#include "Microbenchmark.h"
+
+#include "backend/AutoTuner.h"
+#include "backend/Buffer.h"
+#include "backend/Core.h"
+#include "backend/CpuProfiler.h"
+#include "backend/DescriptorRing.h"
+#include "backend/DescriptorSetCache.h"
+#include "backend/EngineConfig.h"
+#include "backend/FlatHashMap.h"
+#include "backend/Image.h"
+#include "backend/Logging.h"
+#include "backend/MemoryTracker.h"
+#include "backend/PipelineCache.h"
+#include "backend/Pool.h"
+#include "backend/RenderPass.h"
+#include "backend/ResourceCache.h"
+#include "backend/ShaderBindings.h"
+#include "backend/ShaderCompiler.h"
+#include "backend/ShaderConfig.h"
+#include "backend/ShaderMemoryChains.h"
+#include "backend/Synchronization.h"
+#include "render/BindlessSlotTable.h"
+#include "render/MaterialParameterStore.h"
+#include "render/MaterialSystem.h"
+#include "render/RenderContext.h"
+#include "scene/Mesh.h"
+#include "scene/MeshLoader.h"
+
+#include "shader_bindings/MeshShading/drawcull_late.comp.h"
+#include "stb_image_write.h"
+
+#include <GLFW/glfw3.h>
+#define GLFW_EXPOSE_NATIVE_WIN32
+#include <GLFW/glfw3native.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+// CPU microbenchmarks of engine subsystems
+// - Without --device nothing here creates a Vulkan instance or device, handles and resource pointers used as cache keys
+//   are fake values that are only compared and never dereferenced
+// - With --device a Core on a hidden window is created first, fixtures taking it record and upload real work
+// - Meshes come from data/Meshes and the glTF sample assets when they are present, synthetic grids otherwise
+
+namespace
+{
+template <typename HandleType>
+HandleType make_fake_handle(uint64_t value)
+{
+	return HandleType(reinterpret_cast<typename HandleType::CType>(value));
+}
+
+template <typename ResourceType>
+ResourceType *make_fake_pointer(uint64_t value)
+{
+	return reinterpret_cast<ResourceType *>(uintptr_t(value * 64));
+}
+
+// DeviceContext: The Core fixtures run with --device share, created on a hidden window the way an app creates its own
+// - Declared before the suite in main so the resources fixtures keep in their captures are freed while the device lives
+class DeviceContext
+{
+  public:
+	DeviceContext()
+	{
+		if (!glfwInit())
+		{
+			throw std::runtime_error("GLFW initialization failed");
+		}
+		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		window_ = glfwCreateWindow(64, 64, "LingzeMicrobenchmarks", nullptr, nullptr);
+		if (!window_)
+		{
+			glfwTerminate();
+			throw std::runtime_error("GLFW window creation failed");
+		}
+
+		lz::WindowDesc window_desc = {};
+		window_desc.h_instance     = GetModuleHandle(NULL);
+		window_desc.h_wnd          = glfwGetWin32Window(window_);
+
+		const char *instance_extensions[] = {"VK_KHR_surface", "VK_KHR_win32_surface"};
+		core_ = std::make_unique<lz::Core>(instance_extensions, uint32_t(std::size(instance_extensions)), &window_desc, false);
+	}
+
+	~DeviceContext()
+	{
+		core_->wait_idle();
+		core_.reset();
+		glfwDestroyWindow(window_);
+		glfwTerminate();
+	}
+
+	DeviceContext(const DeviceContext &)            = delete;
+	DeviceContext &operator=(const DeviceContext &) = delete;
+
+	lz::Core *get_core() const
+	{
+		return core_.get();
+	}
+
+  private:
+	GLFWwindow               *window_ = nullptr;
+	std::unique_ptr<lz::Core> core_;
+};
+
+// MakeGridSubMesh: A grid of quads with every triangle owning its vertices, the worst case for vertex remapping
+lz::SubMesh make_grid_sub_mesh(uint32_t quads_per_side)
+{
+	lz::SubMesh sub_mesh;
+	for (uint32_t y = 0; y < quads_per_side; y++)
+	{
+		for (uint32_t x = 0; x < quads_per_side; x++)
+		{
+			const glm::vec3 corners[4] = {{float(x), 0.0f, float(y)}, {float(x + 1), 0.0f, float(y)},
+			                              {float(x), 0.0f, float(y + 1)}, {float(x + 1), 0.0f, float(y + 1)}};
+			for (uint32_t corner : {0, 2, 1, 1, 2, 3})
+			{
+				sub_mesh.indices.push_back(uint32_t(sub_mesh.vertices.size()));
+				sub_mesh.vertices.push_back({corners[corner], glm::vec3(0.0f, 1.0f, 0.0f),
+				                             glm::vec2(corners[corner].x, corners[corner].z) / float(quads_per_side)});
+			}
+		}
+	}
+	return sub_mesh;
+}
+
+// MergeSubMeshes: Concatenates the submeshes of a mesh so a whole model is processed as one
+lz::SubMesh merge_sub_meshes(const lz::Mesh &mesh)
+{
+	lz::SubMesh merged;
+	for (size_t sub_mesh_index = 0; sub_mesh_index < mesh.get_sub_mesh_count(); sub_mesh_index++)
+	{
+		const auto    &sub_mesh    = mesh.get_sub_mesh(sub_mesh_index);
+		const uint32_t base_vertex = uint32_t(merged.vertices.size());
+		merged.vertices.insert(merged.vertices.end(), sub_mesh.vertices.begin(), sub_mesh.vertices.end());
+		for (uint32_t index : sub_mesh.indices)
+		{
+			merged.indices.push_back(base_vertex + index);
+		}
+	}
+	return merged;
+}
+
+struct MeshInput
+{
+	std::string name;
+	lz::SubMesh sub_mesh;
+};
+
+std::vector<MeshInput> load_mesh_inputs()
+{
+	std::vector<MeshInput> inputs;
+	inputs.push_back({"grid_256", make_grid_sub_mesh(256)});
+
+	for (const char *file_name : {"bunny.obj", "dragon_.obj", "buddha.obj"})
+	{
+		const std::string file_path = std::string(DATA_DIR "Meshes/") + file_name;
+		if (!std::filesystem::exists(file_path))
+		{
+			LOGW("Skipping mesh fixtures for missing {}", file_path);
+			continue;
+		}
+		lz::ObjMeshLoader loader;
+		inputs.push_back({std::filesystem::path(file_name).stem().string(), merge_sub_meshes(loader.load(file_path))});
+	}
+	return inputs;
+}
+
+void add_loader_benchmarks(lz::MicrobenchmarkSuite &suite)
+{
+	for (const char *file_name : {"bunny.obj", "dragon_.obj", "buddha.obj"})
+	{
+		const std::string file_path = std::string(DATA_DIR "Meshes/") + file_name;
+		if (!std::filesystem::exists(file_path))
+		{
+			continue;
+		}
+
+		lz::Microbenchmark benchmark;
+		benchmark.name           = std::string("loader/obj/") + std::filesystem::path(file_name).stem().string();
+		benchmark.max_iterations = 10;
+		benchmark.run            = [file_path]() {
+			lz::ObjMeshLoader loader;
+			return uint64_t(loader.load(file_path).get_total_index_count());
+		};
+		suite.add(benchmark);
+	}
+
+	for (const char *file_name : {"Sponza/glTF/Sponza.gltf", "DamagedHelmet/glTF/DamagedHelmet.gltf"})
+	{
+		const std::string file_path = std::string(GLTF_DIR) + file_name;
+		if (!std::filesystem::exists(file_path))
+		{
+			LOGW("Skipping glTF loader fixture for missing {}, see data/clone_gltf_assets.sh", file_path);
+			continue;
+		}
+
+		lz::Microbenchmark benchmark;
+		benchmark.name           = std::string("loader/gltf/") + std::filesystem::path(file_name).stem().string();
+		benchmark.max_iterations = 3;
+		benchmark.run            = [file_path]() {
+			lz::GltfMeshLoader loader;
+			return uint64_t(loader.load(file_path).get_total_index_count());
+		};
+		suite.add(benchmark);
+	}
+}
+
+void add_mesh_benchmarks(lz::MicrobenchmarkSuite &suite)
+{
+	for (auto &input : load_mesh_inputs())
+	{
+		auto source    = std::make_shared<lz::SubMesh>(std::move(input.sub_mesh));
+		auto optimized = std::make_shared<lz::SubMesh>(*source);
+		optimized->optimize();
+
+		// optimize works in place, every iteration starts from a fresh copy of the loaded data
+		auto               working = std::make_shared<lz::SubMesh>();
+		lz::Microbenchmark optimize_benchmark;
+		optimize_benchmark.name  = "submesh_optimize/" + input.name;
+		optimize_benchmark.setup = [source, working]() { *working = *source; };
+		optimize_benchmark.run   = [working]() {
+			working->optimize();
+			return uint64_t(working->indices.size() / 3);
+		};
+		suite.add(optimize_benchmark);
+
+		auto meshlets     = std::make_shared<std::vector<lz::render::Meshlet>>();
+		auto meshlet_data = std::make_shared<std::vector<uint32_t>>();
+		lz::Microbenchmark meshlet_benchmark;
+		meshlet_benchmark.name  = "meshlets/" + input.name;
+		meshlet_benchmark.setup = [meshlets, meshlet_data]() {
+			meshlets->clear();
+			meshlet_data->clear();
+		};
+		meshlet_benchmark.run = [optimized, meshlets, meshlet_data]() {
+			return uint64_t(lz::render::RenderContext::build_meshlets(
+			    optimized->vertices.data(), uint32_t(optimized->vertices.size()), optimized->indices.data(),
+			    uint32_t(optimized->indices.size()), 0, 0, *meshlets, *meshlet_data));
+		};
+		suite.add(meshlet_benchmark);
+	}
+}
+
+void add_descriptor_set_cache_benchmarks(lz::MicrobenchmarkSuite &suite)
+{
+	using DescriptorSetKey = lz::DescriptorSetCache::DescriptorSetKey;
+
+	// a frame worth of sets: a few layouts, each bound to many buffer and texture combinations
+	const uint32_t layouts_count = 8;
+	const uint32_t sets_count    = 4096;
+
+	auto keys = std::make_shared<std::vector<DescriptorSetKey>>();
+	for (uint32_t set_index = 0; set_index < sets_count; set_index++)
+	{
+		DescriptorSetKey key;
+		key.layout = make_fake_handle<vk::DescriptorSetLayout>(1 + set_index % layouts_count);
+		key.bindings.uniform_buffer_bindings.push_back(
+		    lz::UniformBufferBinding(make_fake_pointer<lz::Buffer>(1), 0, (set_index % 64) * 256, 256));
+		for (uint32_t binding = 1; binding < 5; binding++)
+		{
+			key.bindings.storage_buffer_bindings.push_back(
+			    lz::StorageBufferBinding(make_fake_pointer<lz::Buffer>(2 + binding), binding, 0, VK_WHOLE_SIZE));
+		}
+		key.bindings.image_sampler_bindings.push_back(
+		    lz::ImageSamplerBinding(make_fake_pointer<lz::ImageView>(1000 + set_index / layouts_count),
+		                            make_fake_pointer<lz::Sampler>(1), 5));
+		keys->push_back(key);
+	}
+
+	auto cache = std::make_shared<std::map<DescriptorSetKey, uint32_t>>();
+	for (uint32_t key_index = 0; key_index < keys->size(); key_index++)
+	{
+		(*cache)[(*keys)[key_index]] = key_index;
+	}
+
+	auto lookup_order = std::make_shared<std::vector<uint32_t>>(keys->size());
+	std::iota(lookup_order->begin(), lookup_order->end(), 0);
+	std::shuffle(lookup_order->begin(), lookup_order->end(), std::mt19937(42));
+
+	lz::Microbenchmark benchmark;
+	benchmark.name = "descriptor_set_cache/lookup";
+	benchmark.run  = [keys, cache, lookup_order]() {
+		uint64_t found = 0;
+		for (uint32_t key_index : *lookup_order)
+		{
+			found += cache->find((*keys)[key_index]) != cache->end();
+		}
+		return found;
+	};
+	suite.add(benchmark);
+
+	// every new binding combination copies its key into the cache, on top of allocating and updating the set on the device
+	benchmark.name = "descriptor_set_cache/miss";
+	benchmark.run  = [keys]() {
+		std::map<DescriptorSetKey, uint32_t> cold_cache;
+		for (uint32_t key_index = 0; key_index < keys->size(); key_index++)
+		{
+			cold_cache.emplace((*keys)[key_index], key_index);
+		}
+		return uint64_t(cold_cache.size());
+	};
+	suite.add(benchmark);
+}
+
+void add_descriptor_buffer_benchmarks(lz::MicrobenchmarkSuite &suite, lz::Core *core)
+{
+	// bookkeeping of the ring DescriptorBuffer binds sets from, not the cost of a bind: every set is filled with a stamp
+	// where vkGetDescriptorEXT would write its descriptors, the command buffer is emulated by the block and set offsets the
+	// binds leave bound
+	struct FakeBlock
+	{
+		char          *mapped_data;
+		vk::DeviceSize size;
+	};
+	using Ring = lz::DescriptorRing<FakeBlock>;
+
+	const vk::DeviceSize alignment          = 64;        // a device typical descriptorBufferOffsetAlignment
+	const vk::DeviceSize initial_block_size = 4096;
+	const uint32_t       frames_count       = MAX_FRAMES_IN_FLIGHT;
+
+	lz::Microbenchmark benchmark;
+	benchmark.name = "descriptor_buffer/ring_bookkeeping";
+	benchmark.run  = [=]() {
+		std::vector<std::unique_ptr<char[]>> memory;
+
+		auto create_block = [&memory](vk::DeviceSize size) {
+			memory.push_back(std::make_unique<char[]>(size));
+			return FakeBlock{memory.back().get(), size};
+		};
+		auto release_blocks = [](std::vector<FakeBlock> &) {};
+
+		// three sets per dispatch, a frame of them overflows the initial block many times over
+		const uint32_t       frame_runs             = 8;
+		const uint32_t       command_buffers_count  = 4;
+		const uint32_t       dispatches_count       = 64;
+		const vk::DeviceSize set_sizes[]            = {192, 64, 320};
+		const auto           bind_point             = vk::PipelineBindPoint::eCompute;
+		const auto           pipeline_layout        = make_fake_handle<vk::PipelineLayout>(1);
+		uint32_t             stamp                  = 0;
+		uint64_t             bound_sets_count       = 0;
+		uint32_t             block_moves_count      = 0;
+		uint32_t             late_block_moves_count = 0;
+
+		Ring ring(frames_count, alignment, initial_block_size, create_block);
+		for (uint32_t frame = 0; frame < frame_runs; frame++)
+		{
+			ring.begin_frame(frame % frames_count, create_block, release_blocks);
+			for (uint32_t command_buffer_index = 0; command_buffer_index < command_buffers_count; command_buffer_index++)
+			{
+				const auto command_buffer = make_fake_handle<vk::CommandBuffer>(1 + command_buffer_index);
+
+				const char                        *bound_block = nullptr;
+				std::map<uint32_t, vk::DeviceSize> bound_offsets;
+				std::map<uint32_t, uint32_t>       bound_stamps;
+				for (uint32_t dispatch = 0; dispatch < dispatches_count; dispatch++)
+				{
+					for (uint32_t set_index = 0; set_index < 3; set_index++)
+					{
+						const auto allocation = ring.allocate_set(command_buffer, bind_point, pipeline_layout, set_index,
+						                                          set_sizes[set_index], create_block);
+						if (allocation.offset % alignment != 0)
+						{
+							throw std::runtime_error("descriptor_buffer: a set offset is not aligned");
+						}
+						stamp++;
+						std::fill_n(reinterpret_cast<uint32_t *>(allocation.data), set_sizes[set_index] / sizeof(uint32_t), stamp);
+						bound_stamps[set_index] = stamp;
+
+						// the device sees the block of the last bind and the offsets set since
+						if (allocation.bind_block)
+						{
+							if (bound_block)
+							{
+								block_moves_count++;
+								late_block_moves_count += frame >= frames_count;
+							}
+							bound_block = ring.get_current_block().mapped_data;
+							bound_offsets.clear();
+							for (const auto &bound_set : ring.get_bound_sets())
+							{
+								bound_offsets[bound_set.set_index] = bound_set.offset;
+							}
+						}
+						else if (!bound_block)
+						{
+							throw std::runtime_error("descriptor_buffer: a new command buffer did not get the block bound");
+						}
+						else
+						{
+							bound_offsets[set_index] = allocation.offset;
+						}
+						bound_sets_count++;
+
+						// every set bound in the command buffer still reads the descriptors last written for it
+						for (const auto &[bound_set_index, bound_stamp] : bound_stamps)
+						{
+							const auto     offset_it = bound_offsets.find(bound_set_index);
+							const uint32_t words     = uint32_t(set_sizes[bound_set_index] / sizeof(uint32_t));
+							const auto    *set_data  = offset_it != bound_offsets.end() ? reinterpret_cast<const uint32_t *>(bound_block + offset_it->second) : nullptr;
+							if (!set_data || set_data[0] != bound_stamp || set_data[words - 1] != bound_stamp)
+							{
+								throw std::runtime_error("descriptor_buffer: set " + std::to_string(bound_set_index) +
+								                         " lost its descriptors when the ring moved to another block");
+							}
+						}
+					}
+				}
+			}
+		}
+
+		// overflowed chains are merged once their frames begin again, later frames never move
+		for (uint32_t frame = 0; frame < frames_count; frame++)
+		{
+			if (ring.get_blocks_count(frame) != 1)
+			{
+				throw std::runtime_error("descriptor_buffer: an overflowed chain was not merged");
+			}
+		}
+		if (block_moves_count == 0 || late_block_moves_count != 0)
+		{
+			throw std::runtime_error("descriptor_buffer: " + std::to_string(block_moves_count) + " block moves, " +
+			                         std::to_string(late_block_moves_count) + " of them after the chains were merged");
+		}
+		return bound_sets_count;
+	};
+	suite.add(benchmark);
+
+	if (!core || !core->descriptor_buffer_supported())
+	{
+		return;
+	}
+
+	// the culling pass of GpuDrivenRenderer recorded the two ways a compute set can be bound, each run is a frame of
+	// dispatches whose storage buffers cycle through a few scenes and whose uniform data moves with a dynamic offset:
+	// the descriptor buffer writes every set into the ring, the set cache looks its few sets up and binds them
+	const uint32_t dispatches_count = 256;
+	const uint32_t scenes_count     = 4;
+	const char    *storage_names[]  = {"MeshData", "MeshDrawData", "VisibleMeshDrawCommand", "VisibleMeshDrawCommandCount"};
+
+	struct BindState
+	{
+		std::vector<std::unique_ptr<lz::Shader>> shaders;
+		std::unique_ptr<lz::PipelineCache>       descriptor_buffer_cache;
+		std::unique_ptr<lz::PipelineCache>       set_cache_cache;
+		std::unique_ptr<lz::Buffer>              uniform_buffer;
+		std::vector<std::unique_ptr<lz::Buffer>> storage_buffers;
+		std::vector<lz::DescriptorSetBindings>   scene_bindings;
+		std::vector<vk::UniqueCommandBuffer>     command_buffers;
+		uint32_t                                 frame_index = 0;
+	};
+	auto bind_state     = std::make_shared<BindState>();
+	bind_state->shaders = core->get_shader_compiler()->create_shaders(core->get_logical_device(), {SHADER_GLSL_DIR "GpuDriven/Culling.comp"});
+
+	bind_state->descriptor_buffer_cache = std::make_unique<lz::PipelineCache>(core->get_logical_device(), core->get_descriptor_set_cache());
+	bind_state->descriptor_buffer_cache->enable_descriptor_buffer();
+	bind_state->set_cache_cache = std::make_unique<lz::PipelineCache>(core->get_logical_device(), core->get_descriptor_set_cache());
+
+	// buffers are addressed by the descriptors of the ring, the set cache path does not mind the usage
+	const vk::DeviceSize uniform_range = 256;
+	bind_state->uniform_buffer         = std::make_unique<lz::Buffer>(
+	    core->get_physical_device(), core->get_logical_device(), uniform_range * dispatches_count,
+	    vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress, vk::MemoryPropertyFlagBits::eDeviceLocal);
+	const lz::DescriptorSetLayoutKey *set_info = bind_state->shaders[0]->get_set_info(0);
+	for (uint32_t scene_index = 0; scene_index < scenes_count; scene_index++)
+	{
+		std::vector<lz::StorageBufferBinding> storage_buffer_bindings;
+		for (const char *storage_name : storage_names)
+		{
+			bind_state->storage_buffers.push_back(std::make_unique<lz::Buffer>(
+			    core->get_physical_device(), core->get_logical_device(), 1 << 16,
+			    vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress, vk::MemoryPropertyFlagBits::eDeviceLocal));
+			storage_buffer_bindings.push_back(set_info->make_storage_buffer_binding(storage_name, bind_state->storage_buffers.back().get()));
+		}
+		bind_state->scene_bindings.push_back(lz::DescriptorSetBindings()
+		                                         .set_uniform_buffer_bindings({set_info->make_uniform_buffer_binding("UboData", bind_state->uniform_buffer.get(), 0, uniform_range)})
+		                                         .set_storage_buffer_bindings(storage_buffer_bindings));
+	}
+	bind_state->command_buffers = core->allocate_command_buffers(2);
+
+	// one frame of binds with the pipelines of the given cache, the command buffer is recorded and never submitted so
+	// the ring of the frame can be rewound right away
+	const auto record_frame = [bind_state, dispatches_count, uniform_range, core](lz::PipelineCache &pipeline_cache, vk::CommandBuffer command_buffer,
+	                                                                              const std::string &name, bool expect_descriptor_buffer) {
+		lz::DescriptorSetCache *descriptor_set_cache = core->get_descriptor_set_cache();
+		if (expect_descriptor_buffer)
+		{
+			core->get_descriptor_buffer()->begin_frame(bind_state->frame_index);
+			bind_state->frame_index = (bind_state->frame_index + 1) % MAX_FRAMES_IN_FLIGHT;
+		}
+
+		lz::Shader                       *shader   = bind_state->shaders[0].get();
+		const lz::DescriptorSetLayoutKey *set_info = shader->get_set_info(0);
+		command_buffer.begin(vk::CommandBufferBeginInfo().setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+		const auto pipeline_info = pipeline_cache.bind_compute_pipeline(command_buffer, shader);
+		if (pipeline_info.descriptor_buffer != expect_descriptor_buffer)
+		{
+			command_buffer.end();
+			throw std::runtime_error(name + ": the pipeline does not bind its sets the way the fixture measures");
+		}
+		for (uint32_t dispatch = 0; dispatch < dispatches_count; dispatch++)
+		{
+			descriptor_set_cache->bind_descriptor_set(command_buffer, vk::PipelineBindPoint::eCompute, pipeline_info.pipeline_layout,
+			                                          pipeline_info.descriptor_buffer, 0, *set_info,
+			                                          bind_state->scene_bindings[dispatch % bind_state->scene_bindings.size()],
+			                                          {uint32_t(dispatch * uniform_range)});
+		}
+		command_buffer.end();
+
+		// every bind went down the measured path
+		descriptor_set_cache->end_frame();
+		const auto &stats = descriptor_set_cache->get_last_frame_stats();
+		if (stats.descriptor_buffer_sets_count != (expect_descriptor_buffer ? dispatches_count : 0) ||
+		    stats.lookups_count != (expect_descriptor_buffer ? 0 : dispatches_count))
+		{
+			throw std::runtime_error(name + ": " + std::to_string(stats.descriptor_buffer_sets_count) + " sets written to the descriptor buffer and " +
+			                         std::to_string(stats.lookups_count) + " looked up for " + std::to_string(dispatches_count) + " binds");
+		}
+		return uint64_t(dispatches_count);
+	};
+
+	lz::Microbenchmark descriptor_buffer_benchmark;
+	descriptor_buffer_benchmark.name = "descriptor_buffer/write_bind_descriptor_buffer";
+	descriptor_buffer_benchmark.run  = [bind_state, record_frame]() {
+		return record_frame(*bind_state->descriptor_buffer_cache, bind_state->command_buffers[0].get(), "descriptor_buffer/write_bind_descriptor_buffer", true);
+	};
+	suite.add(descriptor_buffer_benchmark);
+
+	lz::Microbenchmark set_cache_benchmark;
+	set_cache_benchmark.name = "descriptor_buffer/write_bind_set_cache";
+	set_cache_benchmark.run  = [bind_state, record_frame]() {
+		return record_frame(*bind_state->set_cache_cache, bind_state->command_buffers[1].get(), "descriptor_buffer/write_bind_set_cache", false);
+	};
+	suite.add(set_cache_benchmark);
+}
+
+void add_pipeline_cache_benchmarks(lz::MicrobenchmarkSuite &suite, lz::Core *core)
+{
+	using GraphicsPipelineKey = lz::PipelineCache::GraphicsPipelineKey;
+	using ComputePipelineKey  = lz::PipelineCache::ComputePipelineKey;
+	using PipelineLayoutKey   = lz::PipelineCache::PipelineLayoutKey;
+	using KeyHash             = lz::PipelineCache::KeyHash;
+
+	const uint32_t pipelines_count = 512;
+
+	// program ids stand for interned programs, the vertex declaration and blend settings are interned for real
+	auto interner = std::make_shared<lz::PipelineCache>(vk::Device(), nullptr);
+
+	auto graphics_keys = std::make_shared<std::vector<GraphicsPipelineKey>>();
+	auto compute_keys  = std::make_shared<std::vector<ComputePipelineKey>>();
+	for (uint32_t pipeline_index = 0; pipeline_index < pipelines_count; pipeline_index++)
+	{
+		GraphicsPipelineKey key;
+		key.program_id                   = pipeline_index;
+		key.vertex_decl_id               = interner->intern_vertex_declaration(lz::Mesh::get_vertex_declaration());
+		key.attachment_blend_settings_id = interner->intern_blend_settings({lz::BlendSettings::opaque()});
+		key.render_pass                  = make_fake_handle<vk::RenderPass>(1 + pipeline_index % 4);
+		key.depth_settings               = pipeline_index % 2 ? lz::DepthSettings::enabled() : lz::DepthSettings::disabled();
+		key.topology                     = vk::PrimitiveTopology::eTriangleList;
+		key.update_hash();
+		graphics_keys->push_back(key);
+
+		ComputePipelineKey compute_key;
+		compute_key.program_id = pipelines_count + pipeline_index;
+		compute_key.update_hash();
+		compute_keys->push_back(compute_key);
+	}
+
+	auto graphics_cache = std::make_shared<lz::FlatHashMap<GraphicsPipelineKey, uint32_t, KeyHash>>();
+	auto compute_cache  = std::make_shared<lz::FlatHashMap<ComputePipelineKey, uint32_t, KeyHash>>();
+	for (uint32_t pipeline_index = 0; pipeline_index < pipelines_count; pipeline_index++)
+	{
+		(*graphics_cache)[(*graphics_keys)[pipeline_index]] = pipeline_index;
+		(*compute_cache)[(*compute_keys)[pipeline_index]]   = pipeline_index;
+	}
+
+	lz::Microbenchmark graphics_benchmark;
+	graphics_benchmark.name = "pipeline_cache/graphics_key_lookup";
+	graphics_benchmark.run  = [graphics_keys, graphics_cache]() {
+		uint64_t found = 0;
+		for (const auto &key : *graphics_keys)
+		{
+			found += graphics_cache->find(key) != nullptr;
+		}
+		return found;
+	};
+	suite.add(graphics_benchmark);
+
+	lz::Microbenchmark compute_benchmark;
+	compute_benchmark.name = "pipeline_cache/compute_key_lookup";
+	compute_benchmark.run  = [compute_keys, compute_cache]() {
+		uint64_t found = 0;
+		for (const auto &key : *compute_keys)
+		{
+			found += compute_cache->find(key) != nullptr;
+		}
+		return found;
+	};
+	suite.add(compute_benchmark);
+
+	// 10k cached pipelines over a few programs, vertex layouts, blend modes, render passes and topologies, every lookup
+	// builds its key with make_graphics_pipeline_key as bind_graphics_pipeline does: passes intern their declaration and
+	// blend settings once, every bind puts the ids in the key and hashes it
+	const uint32_t large_pipelines_count = 10000;
+
+	struct PassState
+	{
+		uint32_t                                 program_id;
+		lz::PipelineCache::GraphicsPipelineState pipeline_state;
+		vk::RenderPass                           render_pass;
+		lz::DepthSettings                        depth_settings;
+		vk::PrimitiveTopology                    topology;
+	};
+	const lz::BlendSettings     blend_modes[] = {lz::BlendSettings::opaque(), lz::BlendSettings::add(), lz::BlendSettings::mixed(),
+	                                             lz::BlendSettings::alpha_blend()};
+	const vk::PrimitiveTopology topologies[]  = {vk::PrimitiveTopology::eTriangleList, vk::PrimitiveTopology::eTriangleStrip,
+	                                             vk::PrimitiveTopology::eLineList, vk::PrimitiveTopology::ePointList};
+
+	auto large_interner = std::make_shared<lz::PipelineCache>(vk::Device(), nullptr);
+	auto pass_states    = std::make_shared<std::vector<PassState>>();
+	for (uint32_t pipeline_index = 0; pipeline_index < large_pipelines_count; pipeline_index++)
+	{
+		lz::VertexDeclaration vertex_declaration;
+		vertex_declaration.add_vertex_input_binding(0, 32 + 16 * (pipeline_index % 2));
+		vertex_declaration.add_vertex_attribute(0, 0, lz::VertexDeclaration::AttribTypes::eVec3, 0);
+		vertex_declaration.add_vertex_attribute(0, 12, lz::VertexDeclaration::AttribTypes::eVec3, 1);
+
+		PassState pass_state;
+		pass_state.program_id     = pipeline_index / 16;
+		pass_state.pipeline_state = large_interner->intern_graphics_pipeline_state({blend_modes[pipeline_index / 2 % 4]}, vertex_declaration);
+		pass_state.render_pass    = make_fake_handle<vk::RenderPass>(1 + pipeline_index / 8 % 2);
+		pass_state.depth_settings = lz::DepthSettings::enabled();
+		pass_state.topology       = topologies[pipeline_index % 16 / 4 % 4];
+		pass_states->push_back(pass_state);
+	}
+
+	auto       large_cache = std::make_shared<lz::FlatHashMap<GraphicsPipelineKey, uint32_t, KeyHash>>();
+	const auto make_key    = [](const lz::PipelineCache &pipeline_cache, const PassState &pass_state) {
+		return pipeline_cache.make_graphics_pipeline_key(pass_state.render_pass, pass_state.depth_settings, pass_state.pipeline_state,
+		                                                 pass_state.topology, pass_state.program_id);
+	};
+	for (uint32_t pipeline_index = 0; pipeline_index < large_pipelines_count; pipeline_index++)
+	{
+		(*large_cache)[make_key(*large_interner, (*pass_states)[pipeline_index])] = pipeline_index;
+	}
+	if (large_cache->size() != large_pipelines_count)
+	{
+		throw std::runtime_error("pipeline_cache/lookup_10k: " + std::to_string(large_pipelines_count) + " distinct pass states keyed " +
+		                         std::to_string(large_cache->size()) + " pipelines");
+	}
+
+	lz::Microbenchmark large_benchmark;
+	large_benchmark.name = "pipeline_cache/lookup_10k";
+	large_benchmark.run  = [pass_states, large_interner, large_cache, make_key]() {
+		uint64_t found = 0;
+		for (uint32_t pipeline_index = 0; pipeline_index < uint32_t(pass_states->size()); pipeline_index++)
+		{
+			const uint32_t *cached_index = large_cache->find(make_key(*large_interner, (*pass_states)[pipeline_index]));
+			if (!cached_index || *cached_index != pipeline_index)
+			{
+				throw std::runtime_error("pipeline_cache/lookup_10k: pass state " + std::to_string(pipeline_index) + " found the wrong pipeline");
+			}
+			found++;
+		}
+		return found;
+	};
+	suite.add(large_benchmark);
+
+	// every field of every key tells keys apart on its own, copies compare equal and hash the same, interning compares
+	// whole declarations and blend states
+	lz::Microbenchmark equality_benchmark;
+	equality_benchmark.name = "pipeline_cache/key_equality";
+	equality_benchmark.run  = []() {
+		uint64_t   checks = 0;
+		const auto expect = [&checks](bool condition, const std::string &failure) {
+			checks++;
+			if (!condition)
+			{
+				throw std::runtime_error("pipeline_cache/key_equality: " + failure);
+			}
+		};
+
+		lz::PipelineCache pipeline_cache(vk::Device(), nullptr);
+
+		GraphicsPipelineKey graphics_key;
+		graphics_key.program_id                   = 1;
+		graphics_key.vertex_decl_id               = pipeline_cache.intern_vertex_declaration(lz::Mesh::get_vertex_declaration());
+		graphics_key.attachment_blend_settings_id = pipeline_cache.intern_blend_settings({lz::BlendSettings::opaque()});
+		graphics_key.render_pass                  = make_fake_handle<vk::RenderPass>(1);
+		graphics_key.depth_settings               = lz::DepthSettings::enabled();
+		graphics_key.topology                     = vk::PrimitiveTopology::eTriangleList;
+		graphics_key.update_hash();
+
+		const std::vector<std::pair<std::string, std::function<void(GraphicsPipelineKey &)>>> graphics_perturbations = {
+		    {"program_id", [](GraphicsPipelineKey &key) { key.program_id++; }},
+		    {"vertex_decl_id", [](GraphicsPipelineKey &key) { key.vertex_decl_id++; }},
+		    {"attachment_blend_settings_id", [](GraphicsPipelineKey &key) { key.attachment_blend_settings_id++; }},
+		    {"render_pass", [](GraphicsPipelineKey &key) { key.render_pass = make_fake_handle<vk::RenderPass>(2); }},
+		    {"depth_func", [](GraphicsPipelineKey &key) { key.depth_settings.depth_func = vk::CompareOp::eGreater; }},
+		    {"depth write_enable", [](GraphicsPipelineKey &key) { key.depth_settings.write_enable = false; }},
+		    {"topology", [](GraphicsPipelineKey &key) { key.topology = vk::PrimitiveTopology::eLineList; }}};
+
+		lz::FlatHashMap<GraphicsPipelineKey, uint32_t, KeyHash> graphics_cache;
+		graphics_cache[graphics_key] = 0;
+
+		GraphicsPipelineKey graphics_copy = graphics_key;
+		graphics_copy.update_hash();
+		expect(graphics_copy == graphics_key && graphics_copy.hash == graphics_key.hash, "copied graphics keys differ");
+		for (const auto &perturbation : graphics_perturbations)
+		{
+			GraphicsPipelineKey key = graphics_key;
+			perturbation.second(key);
+			key.update_hash();
+			expect(!(key == graphics_key), perturbation.first + " does not tell graphics keys apart");
+			expect(key.hash != graphics_key.hash, perturbation.first + " does not change the graphics key hash");
+			graphics_cache[key] = uint32_t(graphics_cache.size());
+		}
+		expect(graphics_cache.size() == graphics_perturbations.size() + 1, "graphics keys differing in one field share pipelines");
+
+		ComputePipelineKey compute_key;
+		compute_key.program_id = 1;
+		compute_key.update_hash();
+		ComputePipelineKey compute_copy = compute_key;
+		compute_copy.update_hash();
+		expect(compute_copy == compute_key && compute_copy.hash == compute_key.hash, "copied compute keys differ");
+		compute_copy.program_id++;
+		compute_copy.update_hash();
+		expect(!(compute_copy == compute_key) && compute_copy.hash != compute_key.hash, "program_id does not tell compute keys apart");
+
+		// a set the shader leaves empty is a null layout and still counts
+		PipelineLayoutKey layout_key;
+		layout_key.set_layouts = {make_fake_handle<vk::DescriptorSetLayout>(1), make_fake_handle<vk::DescriptorSetLayout>(2)};
+		layout_key.update_hash();
+		PipelineLayoutKey layout_copy = layout_key;
+		layout_copy.update_hash();
+		expect(layout_copy == layout_key && layout_copy.hash == layout_key.hash, "copied layout keys differ");
+		layout_copy.set_layouts[1] = make_fake_handle<vk::DescriptorSetLayout>(3);
+		layout_copy.update_hash();
+		expect(!(layout_copy == layout_key) && layout_copy.hash != layout_key.hash, "set layouts do not tell layout keys apart");
+		layout_copy = layout_key;
+		layout_copy.set_layouts.push_back(nullptr);
+		layout_copy.update_hash();
+		expect(!(layout_copy == layout_key) && layout_copy.hash != layout_key.hash, "an empty trailing set does not tell layout keys apart");
+
+		const auto make_declaration = [](uint32_t stride, uint32_t offset, lz::VertexDeclaration::AttribTypes attrib_type, uint32_t location) {
+			lz::VertexDeclaration vertex_declaration;
+			vertex_declaration.add_vertex_input_binding(0, stride);
+			vertex_declaration.add_vertex_attribute(0, offset, attrib_type, location);
+			return vertex_declaration;
+		};
+		const uint32_t declaration_id = pipeline_cache.intern_vertex_declaration(make_declaration(32, 0, lz::VertexDeclaration::AttribTypes::eVec3, 0));
+		expect(pipeline_cache.intern_vertex_declaration(make_declaration(32, 0, lz::VertexDeclaration::AttribTypes::eVec3, 0)) == declaration_id,
+		       "equal vertex declarations interned twice");
+		std::set<uint32_t> declaration_ids = {declaration_id,
+		                                      pipeline_cache.intern_vertex_declaration(make_declaration(48, 0, lz::VertexDeclaration::AttribTypes::eVec3, 0)),
+		                                      pipeline_cache.intern_vertex_declaration(make_declaration(32, 4, lz::VertexDeclaration::AttribTypes::eVec3, 0)),
+		                                      pipeline_cache.intern_vertex_declaration(make_declaration(32, 0, lz::VertexDeclaration::AttribTypes::eVec4, 0)),
+		                                      pipeline_cache.intern_vertex_declaration(make_declaration(32, 0, lz::VertexDeclaration::AttribTypes::eVec3, 1))};
+		expect(declaration_ids.size() == 5, "vertex declarations differing in one field share an id");
+
+		// the ordering of BlendSettings ignores the write mask and the alpha factors, interning must not
+		lz::BlendSettings red_only = lz::BlendSettings::opaque();
+		red_only.blend_state.setColorWriteMask(vk::ColorComponentFlagBits::eR);
+		lz::BlendSettings premultiplied_alpha = lz::BlendSettings::alpha_blend();
+		premultiplied_alpha.blend_state.setSrcAlphaBlendFactor(vk::BlendFactor::eOne);
+		premultiplied_alpha.blend_state.setDstAlphaBlendFactor(vk::BlendFactor::eOneMinusSrcAlpha);
+
+		const uint32_t opaque_id = pipeline_cache.intern_blend_settings({lz::BlendSettings::opaque()});
+		expect(pipeline_cache.intern_blend_settings({lz::BlendSettings::opaque()}) == opaque_id, "equal blend settings interned twice");
+		std::set<uint32_t> blend_settings_ids = {opaque_id,
+		                                         pipeline_cache.intern_blend_settings({red_only}),
+		                                         pipeline_cache.intern_blend_settings({lz::BlendSettings::alpha_blend()}),
+		                                         pipeline_cache.intern_blend_settings({premultiplied_alpha}),
+		                                         pipeline_cache.intern_blend_settings({lz::BlendSettings::opaque(), lz::BlendSettings::opaque()})};
+		expect(blend_settings_ids.size() == 5, "blend settings differing in one field share an id");
+
+		// passes keep their interned state across clear(), the ids must keep naming the same declaration and blend settings
+		const auto pipeline_state = pipeline_cache.intern_graphics_pipeline_state({red_only}, make_declaration(48, 0, lz::VertexDeclaration::AttribTypes::eVec3, 0));
+		pipeline_cache.clear();
+		const auto cleared_state = pipeline_cache.intern_graphics_pipeline_state({red_only}, make_declaration(48, 0, lz::VertexDeclaration::AttribTypes::eVec3, 0));
+		expect(cleared_state.vertex_decl_id == pipeline_state.vertex_decl_id &&
+		           cleared_state.attachment_blend_settings_id == pipeline_state.attachment_blend_settings_id,
+		       "clear() changed the ids of interned pipeline state");
+		expect(pipeline_cache.intern_blend_settings({lz::BlendSettings::opaque()}) == opaque_id, "clear() dropped interned blend settings");
+
+		// entries stay reachable after erase_if compacts the map
+		lz::FlatHashMap<uint32_t, uint32_t> values;
+		for (uint32_t value = 0; value < 1000; value++)
+		{
+			values[value * 64] = value;
+		}
+		expect(values.erase_if([](const auto &entry) { return entry.value % 3 == 0; }) == 334, "erase_if removed the wrong entries");
+		for (uint32_t value = 0; value < 1000; value++)
+		{
+			const uint32_t *found = values.find(value * 64);
+			expect(value % 3 == 0 ? found == nullptr : found && *found == value, "entry " + std::to_string(value) + " lost by erase_if");
+		}
+		return checks;
+	};
+	suite.add(equality_benchmark);
+
+	if (!core)
+	{
+		return;
+	}
+
+	// real programs and render passes bound across many render areas, viewport and scissor are dynamic so only the
+	// first extent may build pipelines, with extended dynamic state the passes differing in cull mode and depth state
+	// share theirs
+	struct ResizeState
+	{
+		std::vector<std::unique_ptr<lz::Shader>>        shaders;
+		std::vector<std::unique_ptr<lz::ShaderProgram>> programs;
+		std::vector<std::unique_ptr<lz::RenderPass>>    render_passes;
+		std::unique_ptr<lz::PipelineCache>              static_cache;
+		std::unique_ptr<lz::PipelineCache>              dynamic_cache;
+		std::vector<vk::UniqueCommandBuffer>            command_buffers;
+		size_t                                          static_pipelines_count  = 0;
+		size_t                                          dynamic_pipelines_count = 0;
+	};
+	struct ResizePass
+	{
+		uint32_t                                 program_index;
+		uint32_t                                 render_pass_index;
+		lz::DepthSettings                        depth_settings;
+		lz::PipelineCache::GraphicsPipelineState static_state;
+		lz::PipelineCache::GraphicsPipelineState dynamic_state;
+	};
+
+	auto resize_state     = std::make_shared<ResizeState>();
+	resize_state->shaders = core->get_shader_compiler()->create_shaders(
+	    core->get_logical_device(), {SHADER_GLSL_DIR "Simple/Simple.vert", SHADER_GLSL_DIR "Simple/Simple.frag",
+	                                 SHADER_GLSL_DIR "Common/screen_quad.vert", SHADER_GLSL_DIR "Common/mip_builder.frag"});
+	for (size_t shader_index = 0; shader_index < resize_state->shaders.size(); shader_index += 2)
+	{
+		resize_state->programs.push_back(std::make_unique<lz::ShaderProgram>(
+		    std::vector<lz::Shader *>{resize_state->shaders[shader_index].get(), resize_state->shaders[shader_index + 1].get()}));
+	}
+
+	const lz::RenderPass::AttachmentDesc color_attachment = {vk::Format::eR8G8B8A8Unorm, vk::AttachmentLoadOp::eClear, vk::ClearColorValue()};
+	const lz::RenderPass::AttachmentDesc depth_attachment = {vk::Format::eD32Sfloat, vk::AttachmentLoadOp::eClear, vk::ClearDepthStencilValue(1.0f, 0)};
+	const lz::RenderPass::AttachmentDesc no_depth         = {vk::Format::eUndefined, vk::AttachmentLoadOp::eDontCare, vk::ClearValue()};
+	resize_state->render_passes.push_back(std::make_unique<lz::RenderPass>(core->get_logical_device(), std::vector{color_attachment}, depth_attachment));
+	resize_state->render_passes.push_back(std::make_unique<lz::RenderPass>(core->get_logical_device(), std::vector{color_attachment}, no_depth));
+
+	resize_state->static_cache = std::make_unique<lz::PipelineCache>(core->get_logical_device(), core->get_descriptor_set_cache());
+	if (core->extended_dynamic_state_supported())
+	{
+		resize_state->dynamic_cache = std::make_unique<lz::PipelineCache>(core->get_logical_device(), core->get_descriptor_set_cache());
+		resize_state->dynamic_cache->enable_extended_dynamic_state(core->get_dynamic_loader());
+	}
+	resize_state->command_buffers = core->allocate_command_buffers(1);
+
+	auto       resize_passes = std::make_shared<std::vector<ResizePass>>();
+	const auto add_pass      = [&](uint32_t program_index, uint32_t render_pass_index, lz::DepthSettings depth_settings, vk::CullModeFlags cull_mode) {
+		ResizePass pass;
+		pass.program_index     = program_index;
+		pass.render_pass_index = render_pass_index;
+		pass.depth_settings    = depth_settings;
+		pass.static_state      = resize_state->static_cache->intern_graphics_pipeline_state({lz::BlendSettings::opaque()}, lz::VertexDeclaration(), cull_mode);
+		if (resize_state->dynamic_cache)
+		{
+			pass.dynamic_state = resize_state->dynamic_cache->intern_graphics_pipeline_state({lz::BlendSettings::opaque()}, lz::VertexDeclaration(), cull_mode);
+		}
+		resize_passes->push_back(pass);
+	};
+	for (uint32_t program_index = 0; program_index < uint32_t(resize_state->programs.size()); program_index++)
+	{
+		add_pass(program_index, 0, lz::DepthSettings::enabled(), vk::CullModeFlagBits::eBack);
+		add_pass(program_index, 0, lz::DepthSettings::enabled(), vk::CullModeFlagBits::eNone);
+		add_pass(program_index, 0, lz::DepthSettings::disabled(), vk::CullModeFlagBits::eBack);
+		add_pass(program_index, 1, lz::DepthSettings::disabled(), vk::CullModeFlagBits::eNone);
+	}
+
+	lz::Microbenchmark resize_benchmark;
+	resize_benchmark.name = "pipeline_cache/resize_stress";
+	resize_benchmark.run  = [resize_state, resize_passes]() {
+		const uint32_t extents_count = 256;
+		uint64_t       binds         = 0;
+
+		vk::CommandBuffer command_buffer = resize_state->command_buffers[0].get();
+		command_buffer.begin(vk::CommandBufferBeginInfo().setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+		for (uint32_t extent_index = 0; extent_index < extents_count; extent_index++)
+		{
+			const vk::Extent2D extent(64 + 37 * extent_index % 4032, 64 + 53 * extent_index % 2112);
+			command_buffer.setViewport(0, {vk::Viewport(0.0f, 0.0f, float(extent.width), float(extent.height), 0.0f, 1.0f)});
+			command_buffer.setScissor(0, {vk::Rect2D({0, 0}, extent)});
+
+			for (const auto &pass : *resize_passes)
+			{
+				const lz::ShaderProgram *program     = resize_state->programs[pass.program_index].get();
+				vk::RenderPass           render_pass = resize_state->render_passes[pass.render_pass_index]->get_handle();
+				resize_state->static_cache->bind_graphics_pipeline(command_buffer, render_pass, pass.depth_settings, pass.static_state,
+				                                                   vk::PrimitiveTopology::eTriangleList, program);
+				if (resize_state->dynamic_cache)
+				{
+					resize_state->dynamic_cache->bind_graphics_pipeline(command_buffer, render_pass, pass.depth_settings, pass.dynamic_state,
+					                                                    vk::PrimitiveTopology::eTriangleList, program);
+				}
+				binds++;
+			}
+
+			// the first run builds the pipelines of the first extent, every later extent and run must find them
+			const size_t static_count  = resize_state->static_cache->get_graphics_pipelines_count();
+			const size_t dynamic_count = resize_state->dynamic_cache ? resize_state->dynamic_cache->get_graphics_pipelines_count() : 0;
+			if (!resize_state->static_pipelines_count)
+			{
+				resize_state->static_pipelines_count  = static_count;
+				resize_state->dynamic_pipelines_count = dynamic_count;
+			}
+			if (static_count != resize_state->static_pipelines_count || dynamic_count != resize_state->dynamic_pipelines_count)
+			{
+				throw std::runtime_error("pipeline_cache/resize_stress: extent " + std::to_string(extent.width) + "x" + std::to_string(extent.height) +
+				                         " grew the cache from " + std::to_string(resize_state->static_pipelines_count) + " to " +
+				                         std::to_string(static_count) + " pipelines");
+			}
+		}
+		command_buffer.end();
+
+		if (resize_state->static_pipelines_count != resize_passes->size())
+		{
+			throw std::runtime_error("pipeline_cache/resize_stress: " + std::to_string(resize_passes->size()) + " distinct passes built " +
+			                         std::to_string(resize_state->static_pipelines_count) + " pipelines");
+		}
+		if (resize_state->dynamic_cache && resize_state->dynamic_pipelines_count >= resize_state->static_pipelines_count)
+		{
+			throw std::runtime_error("pipeline_cache/resize_stress: dynamic cull mode and depth state did not share any pipeline");
+		}
+		return binds;
+	};
+	suite.add(resize_benchmark);
+}
+
+void add_memory_tracker_benchmarks(lz::MicrobenchmarkSuite &suite, lz::Core *core)
+{
+	// allocations with fake memory handles, a spread of texture and geometry sizes registered from a thread per category
+	// the way uploads tag their allocations with a scoped category
+	struct FakeAllocation
+	{
+		lz::MemoryCategory category;
+		vk::DeviceSize     size;
+	};
+	auto allocations = std::make_shared<std::vector<FakeAllocation>>();
+	for (uint32_t allocation_index = 0; allocation_index < 256; allocation_index++)
+	{
+		allocations->push_back({lz::MemoryCategory::eMaterials, vk::DeviceSize(64u << (allocation_index % 6)) * (64u << (allocation_index % 5)) * 4});
+		allocations->push_back({lz::MemoryCategory::eScene, vk::DeviceSize(allocation_index + 1) * 4096 + allocation_index * 12});
+	}
+
+	// one iteration registers every allocation, checks the per category and total arithmetic and releases everything again
+	lz::Microbenchmark benchmark;
+	benchmark.name = "memory_tracker/threaded_category_totals";
+	benchmark.run  = [allocations]() {
+		lz::MemoryTracker &tracker           = lz::MemoryTracker::get();
+		const auto         baseline_stats    = tracker.get_category_stats();
+		const auto         baseline_total    = tracker.get_total_bytes();
+		const uint64_t     first_fake_memory = 1ull << 40;
+
+		std::array<vk::DeviceSize, size_t(lz::MemoryCategory::eCount)> expected_bytes{};
+		std::array<size_t, size_t(lz::MemoryCategory::eCount)>         expected_counts{};
+		std::vector<std::thread>                                       threads;
+		for (lz::MemoryCategory category : {lz::MemoryCategory::eMaterials, lz::MemoryCategory::eScene})
+		{
+			for (const auto &allocation : *allocations)
+			{
+				if (allocation.category == category)
+				{
+					expected_bytes[size_t(category)] += allocation.size;
+					expected_counts[size_t(category)]++;
+				}
+			}
+			threads.emplace_back([allocations, category, first_fake_memory]() {
+				lz::MemoryTracker::ScopedCategory memory_category(category);
+				for (size_t allocation_index = 0; allocation_index < allocations->size(); allocation_index++)
+				{
+					if ((*allocations)[allocation_index].category == category)
+					{
+						lz::MemoryTracker::get().register_allocation(make_fake_handle<vk::DeviceMemory>(first_fake_memory + allocation_index),
+						                                             (*allocations)[allocation_index].size, 0);
+					}
+				}
+			});
+		}
+		for (auto &thread : threads)
+		{
+			thread.join();
+		}
+
+		const auto     stats       = tracker.get_category_stats();
+		vk::DeviceSize total_bytes = 0;
+		for (size_t category_index = 0; category_index < stats.size(); category_index++)
+		{
+			const vk::DeviceSize bytes = stats[category_index].bytes - baseline_stats[category_index].bytes;
+			const size_t         count = stats[category_index].allocations_count - baseline_stats[category_index].allocations_count;
+			if (bytes != expected_bytes[category_index] || count != expected_counts[category_index])
+			{
+				throw std::runtime_error(std::string("memory_tracker: ") + lz::MemoryTracker::get_category_name(lz::MemoryCategory(category_index)) +
+				                         " tracks " + std::to_string(bytes) + " bytes instead of " + std::to_string(expected_bytes[category_index]));
+			}
+			total_bytes += bytes;
+		}
+		if (tracker.get_total_bytes() - baseline_total != total_bytes)
+		{
+			throw std::runtime_error("memory_tracker: the total does not match the sum of the categories");
+		}
+
+		for (size_t allocation_index = 0; allocation_index < allocations->size(); allocation_index++)
+		{
+			tracker.unregister_allocation(make_fake_handle<vk::DeviceMemory>(first_fake_memory + allocation_index));
+		}
+		if (tracker.get_total_bytes() != baseline_total)
+		{
+			throw std::runtime_error("memory_tracker: released allocations are still tracked");
+		}
+		return uint64_t(allocations->size());
+	};
+	suite.add(benchmark);
+
+	if (!core)
+	{
+		return;
+	}
+
+	// the scene a device run uploads, Sponza when the sample assets are there and a grid with a material of two generated
+	// textures otherwise
+	std::shared_ptr<lz::Mesh> mesh;
+	const std::string         sponza_path = std::string(GLTF_DIR) + "Sponza/glTF/Sponza.gltf";
+	if (std::filesystem::exists(sponza_path))
+	{
+		lz::GltfMeshLoader loader;
+		mesh = std::make_shared<lz::Mesh>(loader.load(sponza_path));
+	}
+	else
+	{
+		LOGW("Uploading a generated grid instead of missing {}, see data/clone_gltf_assets.sh", sponza_path);
+		auto material  = std::make_shared<lz::Material>();
+		material->name = "memory_tracker_grid";
+		uint8_t fill   = 0x80;
+		for (auto *texture : {&material->diffuse_texture, &material->normal_texture})
+		{
+			*texture             = std::make_shared<lz::Texture>();
+			(*texture)->width    = 256;
+			(*texture)->height   = 256;
+			(*texture)->channels = 4;
+			(*texture)->data.assign(256 * 256 * 4, fill++);
+		}
+		lz::SubMesh sub_mesh   = make_grid_sub_mesh(64);
+		sub_mesh.material_name = material->name;
+		mesh                   = std::make_shared<lz::Mesh>();
+		mesh->add_sub_mesh(sub_mesh);
+		mesh->add_material(material);
+	}
+
+	// the material system creates an image per distinct texture content, textures with equal texels share a slot
+	std::set<std::pair<uint64_t, uint64_t>> texture_contents;
+	vk::DeviceSize                          texel_bytes = 0;
+	if (core->bindless_supported())
+	{
+		for (const auto &material : mesh->get_materials())
+		{
+			for (const auto &texture : {material->diffuse_texture, material->normal_texture, material->metallic_roughness_texture,
+			                            material->emissive_texture, material->occlusion_texture})
+			{
+				if (texture && !texture->data.empty() && texture->width > 0 && texture->height > 0 && texture->channels > 0 &&
+				    texture_contents.insert({texture->get_content_hash(), texture->get_content_digest()}).second)
+				{
+					texel_bytes += texture->data.size();
+				}
+			}
+		}
+	}
+	const size_t texture_images_count = texture_contents.size();
+
+	// one iteration creates a buffer and an image under a category of its own, then uploads the scene through a render
+	// context and the material system and tears everything down again, checking the categories the real allocations
+	// land in after every step
+	lz::Microbenchmark device_benchmark;
+	device_benchmark.name           = "memory_tracker/scene_upload";
+	device_benchmark.max_iterations = 5;
+	device_benchmark.run            = [core, mesh, texture_images_count, texel_bytes]() {
+		lz::MemoryTracker &tracker  = lz::MemoryTracker::get();
+		const auto         baseline = tracker.get_category_stats();
+		auto expect_delta = [&](lz::MemoryCategory category, size_t allocations_count, vk::DeviceSize min_bytes,
+		                        vk::DeviceSize max_bytes, const char *step) {
+			const auto           stats = tracker.get_category_stats()[size_t(category)];
+			const size_t         count = stats.allocations_count - baseline[size_t(category)].allocations_count;
+			const vk::DeviceSize bytes = stats.bytes - baseline[size_t(category)].bytes;
+			if (count != allocations_count || bytes < min_bytes || bytes > max_bytes)
+			{
+				throw std::runtime_error(std::string("memory_tracker: ") + lz::MemoryTracker::get_category_name(category) + " gained " +
+				                         std::to_string(count) + " allocations of " + std::to_string(bytes) + " bytes after " + step +
+				                         ", expected " + std::to_string(allocations_count));
+			}
+		};
+
+		{
+			lz::MemoryTracker::ScopedCategory memory_category(lz::MemoryCategory::eRenderGraph);
+			lz::Buffer buffer(core->get_physical_device(), core->get_logical_device(), 1 << 20, vk::BufferUsageFlagBits::eStorageBuffer,
+			                  vk::MemoryPropertyFlagBits::eDeviceLocal);
+			lz::Image  image(core->get_physical_device(), core->get_logical_device(),
+			                 lz::Image::create_info_2d(glm::uvec2(512, 512), 1, 1, vk::Format::eR8G8B8A8Unorm, vk::ImageUsageFlagBits::eSampled));
+			const vk::DeviceSize bytes = buffer.get_memory_size() + image.get_memory_size();
+			expect_delta(lz::MemoryCategory::eRenderGraph, 2, bytes, bytes, "creating a buffer and an image");
+			expect_delta(lz::MemoryCategory::eGeneral, 0, 0, 0, "creating a buffer and an image under another category");
+		}
+		expect_delta(lz::MemoryCategory::eRenderGraph, 0, 0, 0, "destroying the buffer and the image");
+
+		{
+			lz::Scene scene;
+			scene.create_entity("Scene")->add_component<lz::StaticMeshComponent>()->set_mesh(mesh.get());
+
+			// registering a material creates its texture images right away, the texels follow with the pending updates
+			lz::render::RenderContext render_context(core);
+			render_context.collect_draw_commands(&scene);
+			expect_delta(lz::MemoryCategory::eMaterials, texture_images_count, texel_bytes, UINT64_MAX, "registering the materials");
+
+			// every staged buffer keeps its host visible staging copy next to the device local one
+			render_context.build_meshlet_data();
+			render_context.create_gpu_resources();
+			render_context.create_meshlet_buffer();
+			const vk::DeviceSize device_bytes =
+			    render_context.get_global_vertex_buffer().get_memory_size() + render_context.get_global_index_buffer().get_memory_size() +
+			    render_context.get_mesh_draw_buffer().get_memory_size() + render_context.get_mesh_info_buffer().get_memory_size() +
+			    render_context.get_mesh_let_buffer().get_memory_size() + render_context.get_mesh_let_data_buffer().get_memory_size();
+			expect_delta(lz::MemoryCategory::eScene, 12, device_bytes, UINT64_MAX, "uploading the scene buffers");
+
+			core->process_pending_material_updates();
+			expect_delta(lz::MemoryCategory::eMaterials, texture_images_count, texel_bytes, UINT64_MAX, "uploading the texels, their staging buffers are freed");
+			expect_delta(lz::MemoryCategory::eGeneral, 0, 0, 0, "uploading the scene");
+		}
+		expect_delta(lz::MemoryCategory::eScene, 0, 0, 0, "destroying the render context");
+
+		// released texture images are freed once the frames that could still sample them passed their fence
+		for (uint32_t frame = 0; frame <= MAX_FRAMES_IN_FLIGHT; frame++)
+		{
+			core->process_pending_material_updates();
+		}
+		expect_delta(lz::MemoryCategory::eMaterials, 0, 0, 0, "retiring the released materials");
+		return uint64_t(2 + 12 + texture_images_count);
+	};
+	suite.add(device_benchmark);
+}
+
+void add_render_graph_benchmarks(lz::MicrobenchmarkSuite &suite)
+{
+	// a frame shaped like the mesh shading renderer: culling passes over shared buffers, a depth pyramid
+	// built mip by mip and render passes sampling it
+	struct ImageUse
+	{
+		uint32_t            image_index;
+		uint32_t            base_mip;
+		uint32_t            mips_count;
+		lz::ImageUsageTypes usage_type;
+	};
+	struct BufferUse
+	{
+		uint32_t             buffer_index;
+		lz::BufferUsageTypes usage_type;
+	};
+	struct Pass
+	{
+		std::vector<ImageUse>  image_uses;
+		std::vector<BufferUse> buffer_uses;
+	};
+
+	const uint32_t pyramid_mips  = 12;
+	const uint32_t images_count  = 4;
+	const uint32_t buffers_count = 16;
+
+	auto passes = std::make_shared<std::vector<Pass>>();
+	for (uint32_t view = 0; view < 4; view++)
+	{
+		Pass early_cull;
+		for (uint32_t buffer_index = 0; buffer_index < 8; buffer_index++)
+		{
+			early_cull.buffer_uses.push_back({buffer_index, lz::BufferUsageTypes::eComputeShaderReadWrite});
+		}
+		passes->push_back(early_cull);
+
+		Pass early_draw;
+		early_draw.image_uses.push_back({1, 0, 1, lz::ImageUsageTypes::eColorAttachment});
+		early_draw.image_uses.push_back({2, 0, 1, lz::ImageUsageTypes::eDepthAttachment});
+		for (uint32_t buffer_index = 0; buffer_index < 4; buffer_index++)
+		{
+			early_draw.buffer_uses.push_back({buffer_index, lz::BufferUsageTypes::eIndirectBuffer});
+		}
+		for (uint32_t buffer_index = 8; buffer_index < buffers_count; buffer_index++)
+		{
+			early_draw.buffer_uses.push_back({buffer_index, lz::BufferUsageTypes::eGraphicsShaderReadWrite});
+		}
+		passes->push_back(early_draw);
+
+		for (uint32_t mip = 0; mip < pyramid_mips; mip++)
+		{
+			Pass reduce;
+			reduce.image_uses.push_back(mip == 0 ? ImageUse{2, 0, 1, lz::ImageUsageTypes::eComputeShaderRead} :
+			                                       ImageUse{0, mip - 1, 1, lz::ImageUsageTypes::eComputeShaderRead});
+			reduce.image_uses.push_back({0, mip, 1, lz::ImageUsageTypes::eComputeShaderReadWrite});
+			passes->push_back(reduce);
+		}
+
+		Pass late_cull;
+		late_cull.image_uses.push_back({0, 0, pyramid_mips, lz::ImageUsageTypes::eComputeShaderRead});
+		for (uint32_t buffer_index = 0; buffer_index < 8; buffer_index++)
+		{
+			late_cull.buffer_uses.push_back({buffer_index, lz::BufferUsageTypes::eComputeShaderReadWrite});
+		}
+		passes->push_back(late_cull);
+
+		Pass late_draw;
+		late_draw.image_uses.push_back({1, 0, 1, lz::ImageUsageTypes::eColorAttachment});
+		late_draw.image_uses.push_back({2, 0, 1, lz::ImageUsageTypes::eDepthAttachment});
+		late_draw.image_uses.push_back({3, 0, 1, lz::ImageUsageTypes::eGraphicsShaderRead});
+		passes->push_back(late_draw);
+	}
+	Pass present;
+	present.image_uses.push_back({1, 0, 1, lz::ImageUsageTypes::ePresent});
+	passes->push_back(present);
+
+	lz::Microbenchmark benchmark;
+	benchmark.name = "render_graph/barriers";
+	benchmark.run  = [passes, images_count, buffers_count, pyramid_mips]() {
+		// last usage of every image subresource and buffer, the state the render graph scans tasks for
+		std::vector<std::vector<lz::ImageUsageTypes>> image_usages(images_count, std::vector<lz::ImageUsageTypes>(pyramid_mips, lz::ImageUsageTypes::eNone));
+		std::vector<lz::BufferUsageTypes>             buffer_usages(buffers_count, lz::BufferUsageTypes::eNone);
+		std::vector<vk::ImageMemoryBarrier>           image_barriers;
+		std::vector<vk::BufferMemoryBarrier>          buffer_barriers;
+
+		uint64_t barriers_count = 0;
+		for (const auto &pass : *passes)
+		{
+			vk::PipelineStageFlags src_stage;
+			vk::PipelineStageFlags dst_stage;
+			image_barriers.clear();
+			buffer_barriers.clear();
+
+			for (const auto &image_use : pass.image_uses)
+			{
+				const auto image = make_fake_handle<vk::Image>(1 + image_use.image_index);
+				auto       range = vk::ImageSubresourceRange()
+				                 .setAspectMask(vk::ImageAspectFlagBits::eColor)
+				                 .setBaseArrayLayer(0)
+				                 .setLayerCount(1)
+				                 .setBaseMipLevel(image_use.base_mip)
+				                 .setLevelCount(0);
+
+				// mips with the same last usage are merged into one barrier like RenderGraph does
+				auto &mip_usages = image_usages[image_use.image_index];
+				auto  prev_usage = lz::ImageUsageTypes::eNone;
+				for (uint32_t mip = image_use.base_mip; mip < image_use.base_mip + image_use.mips_count; mip++)
+				{
+					if (mip_usages[mip] != prev_usage)
+					{
+						lz::add_image_barrier(image, range, prev_usage, image_use.usage_type, src_stage, dst_stage, image_barriers);
+						range.setBaseMipLevel(mip).setLevelCount(0);
+						prev_usage = mip_usages[mip];
+					}
+					range.levelCount++;
+					mip_usages[mip] = image_use.usage_type;
+				}
+				lz::add_image_barrier(image, range, prev_usage, image_use.usage_type, src_stage, dst_stage, image_barriers);
+			}
+
+			for (const auto &buffer_use : pass.buffer_uses)
+			{
+				lz::add_buffer_barrier(make_fake_handle<vk::Buffer>(1 + buffer_use.buffer_index), buffer_usages[buffer_use.buffer_index],
+				                       buffer_use.usage_type, src_stage, dst_stage, buffer_barriers);
+				buffer_usages[buffer_use.buffer_index] = buffer_use.usage_type;
+			}
+			barriers_count += image_barriers.size() + buffer_barriers.size();
+		}
+		return barriers_count;
+	};
+	suite.add(benchmark);
+
+	// the transient images of a frame at the current window size, the way the render graph caches them
+	struct TransientImage
+	{
+		uint64_t get_memory_size() const
+		{
+			return memory_size;
+		}
+		uint64_t memory_size;
+	};
+	using TransientKey   = std::pair<uint32_t, uint32_t>;
+	using TransientCache = lz::ResourceCache<TransientKey, TransientImage>;
+
+	// one iteration drags the window through a new size every frame, then holds the last size until everything the drag
+	// created was evicted and its in-flight frames retired, like RenderGraph::evict_unused_resources
+	lz::Microbenchmark resize_benchmark;
+	resize_benchmark.name = "render_graph/resize_storm";
+	resize_benchmark.run  = []() {
+		constexpr uint32_t storm_frames  = 600;
+		constexpr uint32_t settle_frames = RENDER_GRAPH_EVICTION_FRAMES + MAX_FRAMES_IN_FLIGHT + 2;
+
+		// evicted images wait for the frames in flight in batches tagged with their retire frame
+		TransientCache                                                                cache;
+		std::deque<std::pair<uint64_t, std::vector<std::unique_ptr<TransientImage>>>> retired;
+
+		uint64_t max_bytes       = 0;
+		uint64_t max_frame_bytes = 0;
+		size_t   max_count       = 0;
+		uint64_t frame           = 0;
+		for (uint32_t frame_offset = 0; frame_offset < storm_frames + settle_frames; frame_offset++)
+		{
+			const uint32_t width  = 640 + std::min(frame_offset, storm_frames) * 3;
+			const uint32_t height = 360 + std::min(frame_offset, storm_frames) * 2;
+
+			// color, depth and the depth pyramid, which has half the size
+			cache.release();
+			uint64_t frame_bytes = 0;
+			for (const TransientKey &key : {TransientKey{width, height}, TransientKey{width, height}, TransientKey{width / 2, height / 2}})
+			{
+				const uint64_t memory_size = uint64_t(key.first) * key.second * 4;
+				cache.get(key, [memory_size]() { return std::make_unique<TransientImage>(TransientImage{memory_size}); });
+				frame_bytes += memory_size;
+			}
+			max_frame_bytes = std::max(max_frame_bytes, frame_bytes);
+
+			frame++;
+			while (!retired.empty() && retired.front().first <= frame)
+			{
+				retired.pop_front();
+			}
+			std::vector<std::unique_ptr<TransientImage>> evicted;
+			cache.evict_unused(RENDER_GRAPH_EVICTION_FRAMES, evicted);
+			if (!evicted.empty())
+			{
+				retired.emplace_back(frame + MAX_FRAMES_IN_FLIGHT, std::move(evicted));
+			}
+
+			uint64_t retired_bytes = 0;
+			size_t   retired_count = 0;
+			for (const auto &retired_images : retired)
+			{
+				for (const auto &image : retired_images.second)
+				{
+					retired_bytes += image->get_memory_size();
+				}
+				retired_count += retired_images.second.size();
+			}
+			max_bytes = std::max(max_bytes, cache.get_memory_size() + retired_bytes);
+			max_count = std::max(max_count, cache.get_resources_count() + retired_count);
+		}
+
+		// at most the frames within the eviction window plus the frames in flight are alive at once
+		const uint64_t live_frames = RENDER_GRAPH_EVICTION_FRAMES + MAX_FRAMES_IN_FLIGHT + 2;
+		if (max_count > 3 * live_frames || max_bytes > max_frame_bytes * live_frames)
+		{
+			throw std::runtime_error("render_graph: the resize storm kept " + std::to_string(max_count) + " images alive");
+		}
+		if (cache.get_resources_count() != 3 || cache.get_keys_count() != 2 || !retired.empty())
+		{
+			throw std::runtime_error("render_graph: images of old window sizes survived once the resize settled");
+		}
+		return uint64_t(storm_frames + settle_frames);
+	};
+	suite.add(resize_benchmark);
+}
+
+void add_pool_benchmarks(lz::MicrobenchmarkSuite &suite)
+{
+	struct PoolElement
+	{
+		uint64_t payload[4];
+	};
+	using ElementPool = Utils::Pool<PoolElement>;
+
+	const uint32_t elements_count = 16384;
+
+	lz::Microbenchmark churn_benchmark;
+	churn_benchmark.name = "pool/add_release";
+	churn_benchmark.run  = [elements_count]() {
+		ElementPool                  pool;
+		std::vector<ElementPool::Id> ids;
+		ids.reserve(elements_count);
+		for (uint32_t element_index = 0; element_index < elements_count; element_index++)
+		{
+			ids.push_back(pool.add(PoolElement{{element_index}}));
+		}
+		// release every other element and fill the holes again, as proxies of a rebuilt graph do
+		for (uint32_t element_index = 0; element_index < elements_count; element_index += 2)
+		{
+			pool.release(ids[element_index]);
+		}
+		for (uint32_t element_index = 0; element_index < elements_count; element_index += 2)
+		{
+			ids[element_index] = pool.add(PoolElement{{element_index}});
+		}
+		return uint64_t(elements_count + elements_count);
+	};
+	suite.add(churn_benchmark);
+
+	auto sparse_pool = std::make_shared<ElementPool>();
+	std::vector<ElementPool::Id> sparse_ids;
+	for (uint32_t element_index = 0; element_index < elements_count; element_index++)
+	{
+		sparse_ids.push_back(sparse_pool->add(PoolElement{{element_index}}));
+	}
+	for (uint32_t element_index = 0; element_index < elements_count; element_index += 3)
+	{
+		sparse_pool->release(sparse_ids[element_index]);
+	}
+
+	lz::Microbenchmark iterate_benchmark;
+	iterate_benchmark.name = "pool/iterate_sparse";
+	iterate_benchmark.run  = [sparse_pool]() {
+		uint64_t sum = 0;
+		for (auto &element : *sparse_pool)
+		{
+			sum += element.payload[0];
+		}
+		return sum > 0 ? uint64_t(sparse_pool->get_size()) : 0;
+	};
+	suite.add(iterate_benchmark);
+}
+
+void add_shader_memory_benchmarks(lz::MicrobenchmarkSuite &suite)
+{
+	// blocks only carry their size, the chains never look into the memory
+	struct FakeBlock
+	{
+		uint32_t size;
+	};
+	using Chains = lz::ShaderMemoryChains<FakeBlock>;
+
+	const uint32_t alignment          = 256;        // the largest minUniformBufferOffsetAlignment of common devices
+	const uint32_t initial_block_size = 1u << 16;
+	const uint32_t shrink_frames      = 8;
+	const uint32_t frames_count       = MAX_FRAMES_IN_FLIGHT;
+
+	auto create_block   = [](uint32_t size) { return FakeBlock{size}; };
+	auto release_blocks = [](std::vector<FakeBlock> &) {};
+
+	lz::Microbenchmark alignment_benchmark;
+	alignment_benchmark.name = "shader_memory/alignment";
+	alignment_benchmark.run  = [=]() {
+		Chains chains(frames_count, alignment, initial_block_size, shrink_frames);
+
+		// set sizes of uniform blocks are rarely a multiple of the alignment
+		const uint32_t sets_count = 4096;
+		std::mt19937   random(7);
+		for (uint32_t frame = 0; frame < 4; frame++)
+		{
+			chains.begin_frame(frame % frames_count, create_block, release_blocks);
+			const FakeBlock *prev_block = nullptr;
+			uint32_t         prev_end   = 0;
+			for (uint32_t set_index = 0; set_index < sets_count; set_index++)
+			{
+				const uint32_t set_size   = 4 + random() % 1020;
+				const auto     allocation = chains.allocate(set_size, create_block);
+				if (allocation.offset % alignment != 0 || allocation.size % alignment != 0 || allocation.size < set_size)
+				{
+					throw std::runtime_error("shader_memory: a dynamic offset is not aligned");
+				}
+				if (allocation.offset + allocation.size > allocation.block->size)
+				{
+					throw std::runtime_error("shader_memory: a set overruns its block");
+				}
+				if (allocation.block == prev_block && allocation.offset < prev_end)
+				{
+					throw std::runtime_error("shader_memory: two sets of a frame overlap");
+				}
+				prev_block = allocation.block;
+				prev_end   = allocation.offset + allocation.size;
+			}
+			chains.end_frame();
+		}
+		return uint64_t(4 * sets_count);
+	};
+	suite.add(alignment_benchmark);
+
+	lz::Microbenchmark overflow_benchmark;
+	overflow_benchmark.name = "shader_memory/overflow_growth";
+	overflow_benchmark.run  = [=]() {
+		Chains chains(frames_count, alignment, initial_block_size, shrink_frames);
+
+		// three initial blocks worth of sets overflow the first block into a doubled one and then a quadrupled one
+		const uint32_t set_size   = 1024;
+		const uint32_t sets_count = 3 * initial_block_size / set_size;
+		chains.begin_frame(0, create_block, release_blocks);
+		uint32_t prev_block_size = initial_block_size;
+		for (uint32_t set_index = 0; set_index < sets_count; set_index++)
+		{
+			const auto allocation = chains.allocate(set_size, create_block);
+			if (allocation.block->size != prev_block_size && allocation.block->size != prev_block_size * 2)
+			{
+				throw std::runtime_error("shader_memory: an overflow block is not twice the size of the previous one");
+			}
+			prev_block_size = allocation.block->size;
+		}
+		chains.end_frame();
+		if (chains.get_blocks_count(0) != 2 || chains.get_last_frame_used_size() != sets_count * set_size)
+		{
+			throw std::runtime_error("shader_memory: the overflowing frame did not chain exactly one doubled block");
+		}
+
+		// a set larger than twice the last block gets a block of the next power of two that holds it
+		chains.begin_frame(1, create_block, release_blocks);
+		const auto large_allocation = chains.allocate(5 * initial_block_size, create_block);
+		chains.end_frame();
+		if (large_allocation.block->size != 8 * initial_block_size || large_allocation.offset != 0)
+		{
+			throw std::runtime_error("shader_memory: an oversized set did not get a block large enough");
+		}
+
+		// the next time the frames begin their chains are merged into one block with headroom that needs no overflow
+		for (uint32_t frame = 0; frame < frames_count; frame++)
+		{
+			chains.begin_frame(frame, create_block, release_blocks);
+			for (uint32_t set_index = 0; set_index < sets_count; set_index++)
+			{
+				chains.allocate(set_size, create_block);
+			}
+			chains.end_frame();
+			if (chains.get_blocks_count(frame) != 1)
+			{
+				throw std::runtime_error("shader_memory: an overflowed chain was not merged");
+			}
+		}
+		if (chains.get_allocated_size() != 4 * initial_block_size + 8 * initial_block_size)
+		{
+			throw std::runtime_error("shader_memory: merged blocks are not the smallest power of two with headroom");
+		}
+		return uint64_t(3 * sets_count + 1);
+	};
+	suite.add(overflow_benchmark);
+
+	lz::Microbenchmark reuse_benchmark;
+	reuse_benchmark.name = "shader_memory/reuse_across_frames";
+	reuse_benchmark.run  = [=]() {
+		Chains   chains(frames_count, alignment, initial_block_size, shrink_frames);
+		uint32_t created_blocks = 0;
+
+		auto count_blocks = [&created_blocks](uint32_t size) {
+			created_blocks++;
+			return FakeBlock{size};
+		};
+
+		// a steady frame rewinds its chain and hands out the same offsets without allocating
+		const uint32_t steady_frames = 256;
+		const uint32_t sets_count    = 128;
+		for (uint32_t frame = 0; frame < steady_frames; frame++)
+		{
+			chains.begin_frame(frame % frames_count, count_blocks, release_blocks);
+			for (uint32_t set_index = 0; set_index < sets_count; set_index++)
+			{
+				const auto allocation = chains.allocate(300, count_blocks);
+				if (allocation.offset != set_index * 512)
+				{
+					throw std::runtime_error("shader_memory: a rewound frame did not reuse its block from the start");
+				}
+			}
+			chains.end_frame();
+		}
+		if (created_blocks != frames_count || chains.get_allocated_size() != frames_count * initial_block_size)
+		{
+			throw std::runtime_error("shader_memory: steady frames allocated new blocks");
+		}
+
+		// a spike grows one frame, sustained low use afterwards halves it back down to the initial size but not below
+		const uint32_t spike_frame = steady_frames;
+		chains.begin_frame(spike_frame % frames_count, count_blocks, release_blocks);
+		chains.allocate(3 * initial_block_size, count_blocks);
+		chains.end_frame();
+
+		// the spiking chain is merged into one block of four initial sizes the next time it begins and sees its low use
+		// the time after, each halving then waits shrink_frames frames of the pool, rounded up to the next time the chain
+		// begins, and not shrink_frames times that chain begins
+		const uint32_t chain_window  = (shrink_frames + frames_count - 1) / frames_count * frames_count;
+		const uint32_t merge_frame   = spike_frame + frames_count;
+		const uint32_t first_shrink  = merge_frame + frames_count + chain_window;
+		const uint32_t second_shrink = first_shrink + frames_count + chain_window;
+		const uint32_t last_frame    = second_shrink + 4 * shrink_frames;
+		for (uint32_t frame = spike_frame + 1; frame <= last_frame; frame++)
+		{
+			chains.begin_frame(frame % frames_count, count_blocks, release_blocks);
+			chains.allocate(300, count_blocks);
+			chains.end_frame();
+
+			const uint32_t spike_chain_size = frame < merge_frame ? 5 : frame < first_shrink ? 4 : frame < second_shrink ? 2 : 1;
+			if (chains.get_allocated_size() != uint64_t(frames_count - 1 + spike_chain_size) * initial_block_size)
+			{
+				throw std::runtime_error("shader_memory: the spiking chain was not halved exactly on frames " + std::to_string(first_shrink) +
+				                         " and " + std::to_string(second_shrink) + ", frame " + std::to_string(frame) + " is off");
+			}
+		}
+		if (chains.get_peak_used_size() < 3 * initial_block_size)
+		{
+			throw std::runtime_error("shader_memory: the spike is missing from the peak");
+		}
+		return uint64_t(last_frame + 1);
+	};
+	suite.add(reuse_benchmark);
+}
+
+// ValidateNesting: Checks that every task of a thread lies inside the task one level up that was open when it started
+bool validate_nesting(const std::vector<lz::ProfilerTask> &tasks)
+{
+	std::vector<const lz::ProfilerTask *> open_tasks;
+	uint32_t                              thread_index = uint32_t(-1);
+	for (const auto &task : tasks)
+	{
+		if (task.thread_index != thread_index)
+		{
+			thread_index = task.thread_index;
+			open_tasks.clear();
+		}
+		while (open_tasks.size() > task.depth)
+		{
+			open_tasks.pop_back();
+		}
+		if (open_tasks.size() != task.depth)
+		{
+			return false;
+		}
+		if (!open_tasks.empty() && (task.start_time < open_tasks.back()->start_time || task.end_time > open_tasks.back()->end_time))
+		{
+			return false;
+		}
+		open_tasks.push_back(&task);
+	}
+	return true;
+}
+
+void add_cpu_profiler_benchmarks(lz::MicrobenchmarkSuite &suite)
+{
+	// outer tasks with two children, the second one nesting a third level, fits a thread buffer between two frames
+	const uint32_t outer_tasks_count = 256;
+	const uint32_t tasks_per_outer   = 4;
+
+	auto record_tasks = [outer_tasks_count]() {
+		auto &profiler = lz::CpuProfiler::get();
+		for (uint32_t outer_index = 0; outer_index < outer_tasks_count; outer_index++)
+		{
+			auto outer_task = profiler.start_scoped_task("Outer", lz::Colors::peter_river);
+			{
+				auto first_task = profiler.start_scoped_task("First", lz::Colors::emerald);
+			}
+			auto second_task = profiler.start_scoped_task("Second", lz::Colors::carrot);
+			auto third_task  = profiler.start_scoped_task("Third", lz::Colors::amethyst);
+		}
+	};
+
+	lz::Microbenchmark single_thread_benchmark;
+	single_thread_benchmark.name = "cpu_profiler/record_and_gather";
+	single_thread_benchmark.run  = [record_tasks, outer_tasks_count, tasks_per_outer]() {
+		auto        &profiler = lz::CpuProfiler::get();
+		const size_t frame_id = profiler.start_frame();
+		record_tasks();
+		profiler.end_frame(frame_id);
+		return uint64_t(outer_tasks_count * tasks_per_outer);
+	};
+	suite.add(single_thread_benchmark);
+
+	// records from 16 threads at once and checks that every task arrives with intact nesting,
+	// threads are recreated every iteration so buffer slots of exited threads get reused
+	lz::Microbenchmark threads_benchmark;
+	threads_benchmark.name           = "cpu_profiler/record_16_threads";
+	threads_benchmark.max_iterations = 50;
+	threads_benchmark.run            = [record_tasks, outer_tasks_count, tasks_per_outer]() {
+		const uint32_t threads_count = 16;
+
+		auto          &profiler             = lz::CpuProfiler::get();
+		const uint64_t dropped_events_count = profiler.get_dropped_events_count();
+		const size_t   frame_id             = profiler.start_frame();
+
+		std::atomic<bool>        started = false;
+		std::vector<std::thread> threads;
+		for (uint32_t thread_index = 0; thread_index < threads_count; thread_index++)
+		{
+			threads.emplace_back([&started, record_tasks]() {
+				while (!started)
+				{
+					std::this_thread::yield();
+				}
+				lz::CpuProfiler::get().set_thread_name("Worker");
+				record_tasks();
+			});
+		}
+		started = true;
+		for (auto &thread : threads)
+		{
+			thread.join();
+		}
+		profiler.end_frame(frame_id);
+
+		const auto    &tasks          = profiler.get_profiler_tasks();
+		const uint64_t expected_count = uint64_t(threads_count) * outer_tasks_count * tasks_per_outer;
+		if (tasks.size() != expected_count || profiler.get_dropped_events_count() != dropped_events_count)
+		{
+			throw std::runtime_error("cpu_profiler/record_16_threads gathered " + std::to_string(tasks.size()) +
+			                         " tasks, expected " + std::to_string(expected_count));
+		}
+		if (!validate_nesting(tasks))
+		{
+			throw std::runtime_error("cpu_profiler/record_16_threads gathered tasks with broken nesting");
+		}
+		return expected_count;
+	};
+	suite.add(threads_benchmark);
+}
+
+void add_shader_compiler_benchmarks(lz::MicrobenchmarkSuite &suite)
+{
+	// the MeshShading shader set, compiled from GLSL to SPIR-V without creating shader modules
+	const std::vector<lz::ShaderSource> shader_files = {SHADER_GLSL_DIR "MeshShading/drawcull.comp",
+	                                                    SHADER_GLSL_DIR "MeshShading/drawcull_late.comp",
+	                                                    SHADER_GLSL_DIR "MeshShading/depthreduce.comp",
+	                                                    SHADER_GLSL_DIR "MeshShading/meshlet.task",
+	                                                    SHADER_GLSL_DIR "MeshShading/meshlet.mesh",
+	                                                    SHADER_GLSL_DIR "MeshShading/meshlet.frag"};
+	for (const auto &shader_file : shader_files)
+	{
+		if (!std::filesystem::exists(shader_file.file))
+		{
+			LOGW("Skipping shader compiler fixtures for missing {}", shader_file.file);
+			return;
+		}
+	}
+
+	// 1, 2, 4, ... worker threads up to one per hardware thread, the report gives the wall-clock time of a batch
+	const uint32_t max_threads_count = std::max(std::thread::hardware_concurrency(), 1u);
+
+	std::vector<uint32_t> threads_counts;
+	for (uint32_t threads_count = 1; threads_count < max_threads_count; threads_count *= 2)
+	{
+		threads_counts.push_back(threads_count);
+	}
+	threads_counts.push_back(max_threads_count);
+
+	for (const uint32_t threads_count : threads_counts)
+	{
+		auto compiler = std::make_shared<lz::ShaderCompiler>(threads_count);
+
+		lz::Microbenchmark benchmark;
+		benchmark.name           = "shader_compiler/mesh_shading/threads_" + std::string(threads_count < 10 ? "0" : "") + std::to_string(threads_count);
+		benchmark.max_iterations = 10;
+		benchmark.run            = [compiler, shader_files]() {
+			const auto bytecodes = compiler->compile_bytecode(shader_files);
+			return uint64_t(bytecodes.size());
+		};
+		suite.add(benchmark);
+	}
+}
+
+// descriptor resources of a stage as "kind set.binding name", sorted so stages compare regardless of declaration order
+std::vector<std::string> reflect_resources(const std::vector<uint32_t> &bytecode)
+{
+	spirv_cross::Compiler        compiler(bytecode);
+	spirv_cross::ShaderResources resources = compiler.get_shader_resources();
+
+	std::vector<std::string> reflected;
+	auto                     add_resources = [&](const std::string &kind, const auto &kind_resources) {
+		for (const auto &resource : kind_resources)
+		{
+			reflected.push_back(kind + " " + std::to_string(compiler.get_decoration(resource.id, spv::DecorationDescriptorSet)) + "." +
+			                    std::to_string(compiler.get_decoration(resource.id, spv::DecorationBinding)) + " " + resource.name);
+		}
+	};
+	add_resources("uniform_buffer", resources.uniform_buffers);
+	add_resources("storage_buffer", resources.storage_buffers);
+	add_resources("sampled_image", resources.sampled_images);
+	add_resources("storage_image", resources.storage_images);
+	add_resources("push_constant", resources.push_constant_buffers);
+
+	std::sort(reflected.begin(), reflected.end());
+	return reflected;
+}
+
+void add_shader_variant_benchmarks(lz::MicrobenchmarkSuite &suite)
+{
+	// every culling permutation the MeshShading renderer can select, the first entry of each file has no defines
+	const std::vector<std::vector<lz::ShaderDefines>> stage_defines = {
+	    {{}, {{"OCCLUSION_CULL", "0"}}, {{"OCCLUSION_CULL", "1"}}},
+	    {{}, {{"CONE_CULL", "0"}, {"BACK_CULL", "0"}}, {{"CONE_CULL", "0"}, {"BACK_CULL", "1"}}, {{"CONE_CULL", "1"}, {"BACK_CULL", "0"}}},
+	    {{}, {{"CONE_CULL", "0"}, {"BACK_CULL", "0"}}, {{"CONE_CULL", "1"}, {"BACK_CULL", "0"}}, {{"DEBUG", "1"}}},
+	    {{}, {{"DEBUG", "1"}}}};
+	const std::vector<std::string> stage_files = {SHADER_GLSL_DIR "MeshShading/drawcull_late.comp",
+	                                              SHADER_GLSL_DIR "MeshShading/meshlet.task",
+	                                              SHADER_GLSL_DIR "MeshShading/meshlet.mesh",
+	                                              SHADER_GLSL_DIR "MeshShading/meshlet.frag"};
+
+	std::vector<lz::ShaderSource> sources;
+	std::vector<size_t>           default_source_indices;
+	for (size_t stage_index = 0; stage_index < stage_files.size(); stage_index++)
+	{
+		if (!std::filesystem::exists(stage_files[stage_index]))
+		{
+			LOGW("Skipping shader variant fixtures for missing {}", stage_files[stage_index]);
+			return;
+		}
+
+		const size_t default_source_index = sources.size();
+		for (const auto &defines : stage_defines[stage_index])
+		{
+			sources.emplace_back(stage_files[stage_index], defines);
+			default_source_indices.push_back(default_source_index);
+		}
+	}
+
+	// a variant only changes code, the set layouts the renderer binds must be the same for every permutation
+	auto compiler = std::make_shared<lz::ShaderCompiler>();
+
+	lz::Microbenchmark benchmark;
+	benchmark.name           = "shader_variants/mesh_shading_permutations";
+	benchmark.max_iterations = 10;
+	benchmark.run            = [compiler, sources, default_source_indices]() {
+		const auto bytecodes = compiler->compile_bytecode(sources);
+		for (size_t source_index = 0; source_index < sources.size(); source_index++)
+		{
+			const size_t default_source_index = default_source_indices[source_index];
+			if (reflect_resources(bytecodes[source_index]) != reflect_resources(bytecodes[default_source_index]))
+			{
+				throw std::runtime_error("shader_variants/mesh_shading_permutations: reflection of " + sources[source_index].get_name() +
+				                         " differs from " + sources[default_source_index].get_name());
+			}
+		}
+		return uint64_t(bytecodes.size());
+	};
+	suite.add(benchmark);
+}
+
+void add_shader_config_benchmarks(lz::MicrobenchmarkSuite &suite, lz::Core *core)
+{
+	if (!core)
+	{
+		return;
+	}
+
+	// limits of a few device classes, lavapipe reports the SIMD width of the host as its subgroup size
+	std::vector<lz::ShaderConfig::DeviceLimits> device_limits(4);
+	device_limits[0].subgroup_size              = 32;
+	device_limits[1].subgroup_size              = 64;
+	device_limits[2].subgroup_size              = 16;
+	device_limits[2].max_mesh_output_vertices   = 128;
+	device_limits[2].max_mesh_output_primitives = 98;
+	device_limits[3].subgroup_size              = 8;
+	device_limits[3].max_task_workgroup_size    = 128;
+	device_limits[3].max_mesh_workgroup_size    = 128;
+
+	// the mesh shading program and compute shaders the MeshShading renderer specializes, on a device without mesh
+	// shaders a screen quad program that declares no constants stands in for the mesh shading stages
+	std::vector<lz::ShaderSource> sources;
+	if (core->mesh_shader_supported())
+	{
+		sources = {SHADER_GLSL_DIR "MeshShading/meshlet.task",
+		           lz::ShaderSource(SHADER_GLSL_DIR "MeshShading/meshlet.mesh", lz::ShaderConfig().get_meshlet_defines()),
+		           SHADER_GLSL_DIR "MeshShading/meshlet.frag"};
+	}
+	else
+	{
+		sources = {SHADER_GLSL_DIR "Common/screen_quad.vert", SHADER_GLSL_DIR "Common/mip_builder.frag"};
+	}
+	const size_t graphics_stages_count = sources.size();
+	sources.push_back(SHADER_GLSL_DIR "MeshShading/drawcull.comp");
+	sources.push_back(SHADER_GLSL_DIR "MeshShading/depthreduce.comp");
+
+	// a pipeline cache of its own so the pipelines of the engine keep their configuration, no pipeline is built
+	struct SpecializationState
+	{
+		std::vector<std::unique_ptr<lz::Shader>> shaders;
+		std::unique_ptr<lz::ShaderProgram>       program;
+		std::unique_ptr<lz::PipelineCache>       pipeline_cache;
+		lz::PipelineCache::GraphicsPipelineState pipeline_state;
+	};
+	auto state     = std::make_shared<SpecializationState>();
+	state->shaders = core->get_shader_compiler()->create_shaders(core->get_logical_device(), sources);
+	std::vector<lz::Shader *> graphics_shaders;
+	for (size_t shader_index = 0; shader_index < graphics_stages_count; shader_index++)
+	{
+		graphics_shaders.push_back(state->shaders[shader_index].get());
+	}
+	state->program        = std::make_unique<lz::ShaderProgram>(graphics_shaders);
+	state->pipeline_cache = std::make_unique<lz::PipelineCache>(core->get_logical_device(), core->get_descriptor_set_cache());
+	state->pipeline_state = state->pipeline_cache->intern_graphics_pipeline_state({lz::BlendSettings::opaque()}, lz::VertexDeclaration());
+
+	lz::Microbenchmark benchmark;
+	benchmark.name = "shader_config/specialized_pipeline_keys";
+	benchmark.run  = [state, device_limits, graphics_stages_count]() {
+		lz::PipelineCache &pipeline_cache = *state->pipeline_cache;
+		uint64_t           stages_count   = 0;
+
+		// an interned stage is specialized with the configured value of every constant its reflection declares and with
+		// nothing else, so stages that declare none keep the same specialization in every configuration
+		auto check_stages = [&](uint32_t program_id, const std::vector<lz::Shader *> &shaders, const lz::SpecializationConstants &constants) {
+			const auto &stages = pipeline_cache.get_program_stages(program_id);
+			if (stages.size() != shaders.size())
+			{
+				throw std::runtime_error("shader_config/specialized_pipeline_keys interned a program with a stage missing");
+			}
+			for (size_t stage_index = 0; stage_index < stages.size(); stage_index++)
+			{
+				const auto &declared_ids    = shaders[stage_index]->get_specialization_constant_ids();
+				const auto &stage_constants = stages[stage_index].specialization_constants;
+				size_t      configured_ids  = 0;
+				for (uint32_t constant_id : declared_ids)
+				{
+					const auto constant_it = constants.find(constant_id);
+					if (constant_it == constants.end())
+					{
+						continue;
+					}
+					configured_ids++;
+					const auto stage_constant_it = stage_constants.find(constant_id);
+					if (stage_constant_it == stage_constants.end() || stage_constant_it->second != constant_it->second)
+					{
+						throw std::runtime_error("shader_config/specialized_pipeline_keys interned a stage without the configured value of constant " +
+						                         std::to_string(constant_id));
+					}
+				}
+				if (stage_constants.size() != configured_ids || stage_constants != pipeline_cache.get_stage_specialization_constants(shaders[stage_index]))
+				{
+					throw std::runtime_error("shader_config/specialized_pipeline_keys interned a stage with constants it does not declare");
+				}
+				stages_count++;
+			}
+		};
+
+		// stages interned for every configuration, a configuration selected for two devices must intern the same ones
+		std::map<lz::SpecializationConstants, std::vector<lz::ShaderStageInfo>> configuration_stages;
+		for (const auto &limits : device_limits)
+		{
+			const auto config = lz::ShaderConfig::select(limits);
+			if (!config.fits(limits))
+			{
+				throw std::runtime_error("shader_config/specialized_pipeline_keys selected a configuration outside the limits of subgroup size " +
+				                         std::to_string(limits.subgroup_size));
+			}
+			const auto constants = config.get_specialization_constants();
+			pipeline_cache.set_specialization_constants(constants);
+
+			// the key a bind looks the pipeline up with, the unchanged program keeps its id and the key its hash
+			auto bind_key = [&]() {
+				return pipeline_cache.make_graphics_pipeline_key(make_fake_handle<vk::RenderPass>(1), lz::DepthSettings::enabled(), state->pipeline_state,
+				                                                 vk::PrimitiveTopology::eTriangleList, pipeline_cache.intern_program(state->program.get()));
+			};
+			const auto key         = bind_key();
+			const auto rebuilt_key = bind_key();
+			if (!(rebuilt_key == key) || rebuilt_key.hash != key.hash)
+			{
+				throw std::runtime_error("shader_config/specialized_pipeline_keys built a different key for an unchanged program");
+			}
+			check_stages(key.program_id, state->program->shaders, constants);
+
+			std::vector<lz::ShaderStageInfo> stages      = pipeline_cache.get_program_stages(key.program_id);
+			std::vector<uint32_t>            program_ids = {key.program_id};
+			for (size_t shader_index = graphics_stages_count; shader_index < state->shaders.size(); shader_index++)
+			{
+				lz::Shader *compute_shader = state->shaders[shader_index].get();
+				const auto  compute_key    = pipeline_cache.make_compute_pipeline_key(pipeline_cache.intern_compute_shader(compute_shader));
+				if (pipeline_cache.intern_compute_shader(compute_shader) != compute_key.program_id)
+				{
+					throw std::runtime_error("shader_config/specialized_pipeline_keys interned an unchanged compute shader again");
+				}
+				check_stages(compute_key.program_id, {compute_shader}, constants);
+				program_ids.push_back(compute_key.program_id);
+				const auto &compute_stages = pipeline_cache.get_program_stages(compute_key.program_id);
+				stages.insert(stages.end(), compute_stages.begin(), compute_stages.end());
+			}
+
+			// no pipeline was built, the programs of the previous configuration gave their slots to these
+			if (*std::max_element(program_ids.begin(), program_ids.end()) >= program_ids.size())
+			{
+				throw std::runtime_error("shader_config/specialized_pipeline_keys did not recycle the ids of respecialized programs");
+			}
+
+			const auto configuration_it = configuration_stages.emplace(constants, stages).first;
+			if (configuration_it->second.size() != stages.size() ||
+			    !std::equal(stages.begin(), stages.end(), configuration_it->second.begin(),
+			                [](const lz::ShaderStageInfo &stage, const lz::ShaderStageInfo &other) { return !(stage < other) && !(other < stage); }))
+			{
+				throw std::runtime_error("shader_config/specialized_pipeline_keys specialized the same configuration differently");
+			}
+		}
+		return stages_count;
+	};
+	suite.add(benchmark);
+}
+
+void add_autotune_benchmarks(lz::MicrobenchmarkSuite &suite)
+{
+	// a discrete GPU, a device with small mesh outputs and lavapipe with its narrow subgroups
+	std::vector<lz::ShaderConfig::DeviceLimits> device_limits(3);
+	device_limits[1].max_mesh_output_vertices   = 128;
+	device_limits[1].max_mesh_output_primitives = 98;
+	device_limits[2].subgroup_size              = 8;
+
+	lz::Microbenchmark benchmark;
+	benchmark.name = "autotune/candidate_grid";
+	benchmark.run  = [device_limits]() {
+		size_t candidates_count = 0;
+		for (const auto &limits : device_limits)
+		{
+			const auto candidates = lz::AutoTuner::build_candidates(limits);
+			if (candidates.empty())
+			{
+				throw std::runtime_error("autotune/candidate_grid built no configuration for subgroup size " + std::to_string(limits.subgroup_size));
+			}
+
+			for (const auto &config : candidates)
+			{
+				// a profile is only loaded when it fits the device, every candidate has to pass the same check
+				lz::ShaderConfig loaded_config;
+				if (!config.fits(limits) || !lz::ShaderConfig::from_json(config.to_json(), loaded_config) ||
+				    loaded_config.to_json() != config.to_json())
+				{
+					throw std::runtime_error("autotune/candidate_grid produced a configuration that does not round-trip through a profile");
+				}
+			}
+			candidates_count += candidates.size();
+		}
+		return uint64_t(candidates_count);
+	};
+	suite.add(benchmark);
+}
+
+// WriteTexturedGltf: A glTF without geometry whose single material samples the given images, the images stay unnamed so
+// the loader names them texture_<index> and the names of two files collide
+void write_textured_gltf(const std::filesystem::path &file_path, const std::vector<std::string> &image_uris)
+{
+	std::string images;
+	std::string textures;
+	for (size_t image_index = 0; image_index < image_uris.size(); image_index++)
+	{
+		images += std::string(image_index ? "," : "") + "{\"uri\":\"" + image_uris[image_index] + "\"}";
+		textures += std::string(image_index ? "," : "") + "{\"source\":" + std::to_string(image_index) + "}";
+	}
+	std::ofstream file(file_path);
+	file << "{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[]}],\"images\":[" << images
+	     << "],\"textures\":[" << textures
+	     << "],\"materials\":[{\"pbrMetallicRoughness\":{\"baseColorTexture\":{\"index\":0}},\"normalTexture\":{\"index\":1}}]}";
+}
+
+void add_material_benchmarks(lz::MicrobenchmarkSuite &suite)
+{
+	// two scenes sharing one image, each with an image of its own, the shared image is texture_0 in the first scene and
+	// texture_1 in the second while texture_0 of the second scene is a different image
+	const auto directory = std::filesystem::temp_directory_path() / "lingze_texture_dedup";
+	std::filesystem::create_directories(directory);
+
+	constexpr int texture_size = 16;
+	auto write_image = [&](const std::string &file_name, uint8_t seed) {
+		std::vector<uint8_t> texels(texture_size * texture_size * 4);
+		for (size_t texel_index = 0; texel_index < texels.size(); texel_index++)
+		{
+			texels[texel_index] = uint8_t(texel_index * seed + seed);
+		}
+		if (!stbi_write_png((directory / file_name).string().c_str(), texture_size, texture_size, 4, texels.data(), texture_size * 4))
+		{
+			throw std::runtime_error("material: failed to write " + (directory / file_name).string());
+		}
+	};
+	write_image("shared.png", 3);
+	write_image("first.png", 5);
+	write_image("second.png", 7);
+	write_textured_gltf(directory / "first.gltf", {"shared.png", "first.png"});
+	write_textured_gltf(directory / "second.gltf", {"second.png", "shared.png"});
+
+	auto textures = std::make_shared<std::vector<std::shared_ptr<lz::Texture>>>();
+	for (const char *file_name : {"first.gltf", "second.gltf"})
+	{
+		lz::GltfMeshLoader loader;
+		const lz::Mesh     mesh = loader.load((directory / file_name).string());
+		for (const auto &material : mesh.get_materials())
+		{
+			textures->push_back(material->diffuse_texture);
+			textures->push_back(material->normal_texture);
+		}
+	}
+	if (textures->size() != 4 || (*textures)[0]->name != (*textures)[2]->name)
+	{
+		throw std::runtime_error("material: the generated scenes do not load as two materials with colliding texture names");
+	}
+
+	// one iteration registers the textures of both scenes in an empty table, the shared image takes a single slot
+	lz::Microbenchmark benchmark;
+	benchmark.name = "material/gltf_texture_dedup";
+	benchmark.run  = [textures]() {
+		lz::BindlessSlotTable slot_table(BINDLESS_RESOURCE_COUNT);
+		std::vector<uint32_t> texture_indices;
+		for (const auto &texture : *textures)
+		{
+			texture_indices.push_back(slot_table.acquire_texture(texture));
+		}
+
+		const size_t texture_bytes = size_t(texture_size) * texture_size * 4;
+		if (slot_table.get_texture_slot_count() != 3 || slot_table.get_texture_bytes() != 3 * texture_bytes ||
+		    texture_indices[0] != texture_indices[3] || texture_indices[0] == texture_indices[2] ||
+		    texture_indices[1] == texture_indices[2])
+		{
+			throw std::runtime_error("material: textures of the two scenes were not deduplicated by content");
+		}
+		return uint64_t(textures->size());
+	};
+	suite.add(benchmark);
+
+	// the table outlives the iterations, a long run loads and unloads many thousands of materials through it
+	struct StressState
+	{
+		lz::BindlessSlotTable                      slot_table{BINDLESS_RESOURCE_COUNT};
+		uint64_t                                   frame          = 0;
+		uint64_t                                   material_count = 0;
+		std::vector<std::shared_ptr<lz::Material>> live_materials;
+		std::shared_ptr<lz::Texture>               shared_texture;
+
+		// first frame each slot may be handed out again, checked whenever the slot is acquired
+		std::vector<uint64_t> texture_reuse_frames  = std::vector<uint64_t>(BINDLESS_RESOURCE_COUNT, 0);
+		std::vector<uint64_t> material_reuse_frames = std::vector<uint64_t>(BINDLESS_RESOURCE_COUNT, 0);
+	};
+	auto state = std::make_shared<StressState>();
+
+	constexpr uint32_t materials_per_frame = 32;
+	constexpr uint32_t frames_per_run      = 128;
+	auto make_texture = [](uint64_t seed) {
+		auto texture      = std::make_shared<lz::Texture>();
+		texture->width    = 8;
+		texture->height   = 8;
+		texture->channels = 4;
+		texture->data.resize(8 * 8 * 4);
+		for (size_t texel_index = 0; texel_index < texture->data.size(); texel_index++)
+		{
+			texture->data[texel_index] = uint8_t((seed * 2654435761u) >> (texel_index % 24));
+		}
+		texture->data[0] = uint8_t(seed);
+		texture->data[1] = uint8_t(seed >> 8);
+		texture->data[2] = uint8_t(seed >> 16);
+		return texture;
+	};
+	state->shared_texture = make_texture(0);
+
+	// one iteration runs frames that each register a batch of materials with a texture of their own and a texture shared
+	// by all of them, and release the batch of the previous frame, the way a streaming scene swaps its materials
+	lz::Microbenchmark stress_benchmark;
+	stress_benchmark.name = "material/load_unload_stress";
+	stress_benchmark.run  = [state, make_texture]() {
+		auto &slot_table = state->slot_table;
+		for (uint32_t frame_offset = 0; frame_offset < frames_per_run; frame_offset++)
+		{
+			// the fence of the frame signaled, slots released MAX_FRAMES_IN_FLIGHT frames ago are recycled
+			const uint64_t        frame = ++state->frame;
+			std::vector<uint32_t> freed_texture_slots;
+			slot_table.collect_retired_slots(frame, freed_texture_slots);
+
+			std::vector<std::shared_ptr<lz::Material>> released_materials = std::move(state->live_materials);
+			state->live_materials.clear();
+			for (uint32_t material_offset = 0; material_offset < materials_per_frame; material_offset++)
+			{
+				auto material             = std::make_shared<lz::Material>();
+				material->name            = "material_" + std::to_string(state->material_count++);
+				material->diffuse_texture = make_texture(state->material_count);
+				material->normal_texture  = state->shared_texture;
+
+				bool           new_material_slot = false;
+				const uint32_t material_index    = slot_table.acquire_material(material->name, &new_material_slot);
+				bool           new_texture_slot  = false;
+				const uint32_t texture_index     = slot_table.acquire_texture(material->diffuse_texture, &new_texture_slot);
+				slot_table.acquire_texture(material->normal_texture);
+				if (!new_material_slot || !new_texture_slot || material_index == UINT32_MAX || texture_index == UINT32_MAX)
+				{
+					throw std::runtime_error("material: the stress run ran out of slots at frame " + std::to_string(frame));
+				}
+				if (state->material_reuse_frames[material_index] > frame || state->texture_reuse_frames[texture_index] > frame)
+				{
+					throw std::runtime_error("material: a slot was reused while a frame in flight may still read it");
+				}
+
+				// texels are dropped once uploaded, releasing the texture has to find its slot anyway
+				material->diffuse_texture->data.clear();
+				material->diffuse_texture->data.shrink_to_fit();
+				state->live_materials.push_back(material);
+
+				// another scene loading the same image still shares the slot whose texels are gone
+				const auto reloaded_texture = make_texture(state->material_count);
+				bool       reloaded_slot    = false;
+				if (slot_table.acquire_texture(reloaded_texture, &reloaded_slot) != texture_index || reloaded_slot)
+				{
+					throw std::runtime_error("material: an identical texture took a new slot after the texels of the first were dropped");
+				}
+				slot_table.release_texture(reloaded_texture, frame + MAX_FRAMES_IN_FLIGHT);
+			}
+
+			const uint64_t retire_frame = frame + MAX_FRAMES_IN_FLIGHT;
+			for (const auto &material : released_materials)
+			{
+				const uint32_t material_index = slot_table.release_material(material->name, retire_frame);
+				const uint32_t texture_index  = slot_table.get_texture_index(material->diffuse_texture);
+				slot_table.release_texture(material->diffuse_texture, retire_frame);
+				slot_table.release_texture(material->normal_texture, retire_frame);
+				if (material_index == UINT32_MAX || texture_index == UINT32_MAX)
+				{
+					throw std::runtime_error("material: " + material->name + " did not release its slots");
+				}
+				state->material_reuse_frames[material_index] = retire_frame;
+				state->texture_reuse_frames[texture_index]    = retire_frame;
+			}
+		}
+
+		// only the last batch is alive, and slots never grow past the batches a frame in flight may still read
+		const uint32_t slot_limit    = materials_per_frame * (MAX_FRAMES_IN_FLIGHT + 2) + 1;
+		const size_t   texture_bytes = size_t(8) * 8 * 4;
+		if (slot_table.get_material_slot_count() != materials_per_frame ||
+		    slot_table.get_texture_slot_count() != materials_per_frame + 1 ||
+		    slot_table.get_texture_bytes() != (materials_per_frame + 1) * texture_bytes ||
+		    slot_table.get_allocated_material_slot_count() > slot_limit ||
+		    slot_table.get_allocated_texture_slot_count() > slot_limit ||
+		    slot_table.get_retired_slot_count() > 2 * materials_per_frame * (MAX_FRAMES_IN_FLIGHT + 1))
+		{
+			throw std::runtime_error("material: slot count or texture memory drifted after " + std::to_string(state->material_count) +
+			                         " materials");
+		}
+		return uint64_t(frames_per_run) * materials_per_frame;
+	};
+	suite.add(stress_benchmark);
+
+	// each iteration is a frame that edits materials and flushes the copy of that frame, the items of the fixture are the
+	// bytes written to the copy, so the report carries both the CPU time and the bytes uploaded per frame
+	constexpr uint32_t parameters_count = 10000;
+	constexpr uint32_t copies_count     = MAX_FRAMES_IN_FLIGHT + 1;
+	for (uint32_t edit_stride : {1u, 8u})
+	{
+		struct ParameterState
+		{
+			lz::MaterialParameterStore                   store{parameters_count, copies_count};
+			std::vector<std::vector<lz::MaterialParameters>> copies = std::vector<std::vector<lz::MaterialParameters>>(
+			    copies_count, std::vector<lz::MaterialParameters>(parameters_count));
+			uint64_t frame = 0;
+		};
+		auto parameter_state = std::make_shared<ParameterState>();
+
+		// every material starts out uploaded to every copy, later flushes only write what the frames edited
+		for (uint32_t material_index = 0; material_index < parameters_count; material_index++)
+		{
+			parameter_state->store.edit(material_index) = lz::MaterialParameters{};
+		}
+		for (uint32_t copy_index = 0; copy_index < copies_count; copy_index++)
+		{
+			parameter_state->store.flush(copy_index, parameter_state->copies[copy_index].data());
+		}
+
+		lz::Microbenchmark parameter_benchmark;
+		parameter_benchmark.name = "material/parameter_upload_bytes/" + std::string(edit_stride == 1 ? "all" : "every_8th") + "_of_10k";
+
+		// the copy flushed by the previous frame has to match the CPU copy for every material, checked outside the timing
+		parameter_benchmark.setup = [parameter_state]() {
+			if (parameter_state->frame < copies_count)
+			{
+				return;
+			}
+			const auto &copy = parameter_state->copies[(parameter_state->frame - 1) % copies_count];
+			for (uint32_t material_index = 0; material_index < parameters_count; material_index++)
+			{
+				if (memcmp(&copy[material_index], &parameter_state->store.get(material_index), sizeof(lz::MaterialParameters)) != 0)
+				{
+					throw std::runtime_error("material: parameter copy misses the edit of material " + std::to_string(material_index));
+				}
+			}
+		};
+		// a copy catches up on the edits of every frame since it was flushed last, and nothing else is written
+		const uint32_t edited_count   = (parameters_count + edit_stride - 1) / edit_stride;
+		const size_t   expected_bytes = std::min(parameters_count, edited_count * copies_count) * sizeof(lz::MaterialParameters);
+		parameter_benchmark.run       = [parameter_state, edit_stride, expected_bytes]() {
+			const uint64_t frame = parameter_state->frame++;
+			for (uint32_t material_index = uint32_t(frame % edit_stride); material_index < parameters_count; material_index += edit_stride)
+			{
+				lz::MaterialParameters &params = parameter_state->store.edit(material_index);
+				params.base_color_factor       = glm::vec4(float(frame), float(material_index), 0.0f, 1.0f);
+				params.metallic_factor         = float(frame % 7) / 7.0f;
+				params.diffuse_texture_index   = material_index;
+			}
+
+			const uint32_t copy_index = uint32_t(frame % copies_count);
+			parameter_state->store.flush(copy_index, parameter_state->copies[copy_index].data());
+
+			const size_t uploaded_bytes = parameter_state->store.get_last_flush_bytes();
+			if (frame >= copies_count && uploaded_bytes != expected_bytes)
+			{
+				throw std::runtime_error("material: flushed " + std::to_string(uploaded_bytes) + " bytes of parameters instead of " +
+				                         std::to_string(expected_bytes));
+			}
+			if (edit_stride == 1 && parameter_state->store.get_last_flush_ranges() != 1)
+			{
+				throw std::runtime_error("material: editing every material was not coalesced into a single range");
+			}
+			return uint64_t(uploaded_bytes);
+		};
+		suite.add(parameter_benchmark);
+	}
+}
+
+void add_shader_binding_benchmarks(lz::MicrobenchmarkSuite &suite)
+{
+	namespace draw_cull_late = lz::shader_bindings::mesh_shading::drawcull_late_comp;
+
+	const std::string shader_file = SHADER_GLSL_DIR "MeshShading/drawcull_late.comp";
+	if (!std::filesystem::exists(shader_file))
+	{
+		LOGW("Skipping shader binding fixtures for missing {}", shader_file);
+		return;
+	}
+
+	const auto set_layouts = lz::Shader::reflect_set_layouts(lz::Shader::get_bytecode(shader_file));
+	if (set_layouts.size() <= draw_cull_late::UboData::set)
+	{
+		throw std::runtime_error("shader_bindings: " + shader_file + " has no set " + std::to_string(draw_cull_late::UboData::set));
+	}
+	auto set_info = std::make_shared<lz::DescriptorSetLayoutKey>(set_layouts[draw_cull_late::UboData::set]);
+
+	// the generated constants have to describe the layout the engine reflects at runtime
+	auto check_storage_buffer = [&](const std::string &name, uint32_t binding, uint32_t array_stride) {
+		const auto storage_buffer_id = set_info->get_storage_buffer_id(name);
+		if (!storage_buffer_id.is_valid() || set_info->get_storage_buffer_info(storage_buffer_id).shader_binding_index != binding ||
+		    set_info->get_storage_buffer_info(storage_buffer_id).array_member_size != array_stride)
+		{
+			throw std::runtime_error("shader_bindings: generated " + name + " does not match the reflection of " + shader_file);
+		}
+	};
+	const auto *uniform_buffer_info = set_info->find_uniform_buffer(draw_cull_late::UboData::binding);
+	if (!uniform_buffer_info || uniform_buffer_info->name != "UboData" || uniform_buffer_info->size != sizeof(draw_cull_late::UboData))
+	{
+		throw std::runtime_error("shader_bindings: generated UboData does not match the reflection of " + shader_file);
+	}
+	check_storage_buffer("VisibleMeshTaskDrawCommandCount", draw_cull_late::VisibleMeshTaskDrawCommandCount::binding, 0);
+	check_storage_buffer("DrawVisibilityBuffer", draw_cull_late::DrawVisibilityBuffer::binding, draw_cull_late::DrawVisibilityBuffer::array_stride);
+	check_storage_buffer("CullStatisticsBuffer", draw_cull_late::CullStatisticsBuffer::binding, 0);
+	const auto image_sampler_id = set_info->get_image_sampler_id("depth_pyramid");
+	if (!image_sampler_id.is_valid() || set_info->get_image_sampler_info(image_sampler_id).shader_binding_index != draw_cull_late::depth_pyramid::binding)
+	{
+		throw std::runtime_error("shader_bindings: generated depth_pyramid does not match the reflection of " + shader_file);
+	}
+
+	// one iteration makes the lookups the late culling pass records every frame, by name and by generated binding index
+	auto buffer  = make_fake_pointer<lz::Buffer>(1);
+	auto view    = make_fake_pointer<lz::ImageView>(2);
+	auto sampler = make_fake_pointer<lz::Sampler>(3);
+
+	lz::Microbenchmark benchmark;
+	benchmark.name = "shader_bindings/string_lookups";
+	benchmark.run  = [set_info, buffer, view, sampler]() {
+		const auto uniform_buffer_info = set_info->get_uniform_buffer_info(set_info->get_uniform_buffer_id("UboData"));
+
+		std::vector<lz::StorageBufferBinding> storage_buffer_bindings;
+		storage_buffer_bindings.push_back(set_info->make_storage_buffer_binding("VisibleMeshTaskDrawCommandCount", buffer));
+		storage_buffer_bindings.push_back(set_info->make_storage_buffer_binding("DrawVisibilityBuffer", buffer));
+		storage_buffer_bindings.push_back(set_info->make_storage_buffer_binding("CullStatisticsBuffer", buffer));
+
+		std::vector<lz::ImageSamplerBinding> image_sampler_bindings;
+		image_sampler_bindings.push_back(set_info->make_image_sampler_binding("depth_pyramid", view, sampler));
+		return uint64_t(uniform_buffer_info.size > 0) + storage_buffer_bindings.size() + image_sampler_bindings.size();
+	};
+	suite.add(benchmark);
+
+	benchmark.name = "shader_bindings/index_lookups";
+	benchmark.run  = [set_info, buffer, view, sampler]() {
+		const auto *uniform_buffer_info = set_info->find_uniform_buffer(draw_cull_late::UboData::binding);
+
+		std::vector<lz::StorageBufferBinding> storage_buffer_bindings;
+		storage_buffer_bindings.push_back(lz::make_storage_buffer_binding<draw_cull_late::VisibleMeshTaskDrawCommandCount>(buffer));
+		storage_buffer_bindings.push_back(lz::make_storage_buffer_binding<draw_cull_late::DrawVisibilityBuffer>(buffer));
+		storage_buffer_bindings.push_back(lz::make_storage_buffer_binding<draw_cull_late::CullStatisticsBuffer>(buffer));
+
+		std::vector<lz::ImageSamplerBinding> image_sampler_bindings;
+		image_sampler_bindings.push_back(lz::make_image_sampler_binding<draw_cull_late::depth_pyramid>(view, sampler));
+		return uint64_t(uniform_buffer_info != nullptr) + storage_buffer_bindings.size() + image_sampler_bindings.size();
+	};
+	suite.add(benchmark);
+}
+}        // namespace
+
+int main(int argc, char **argv)
+{
+	lz::MicrobenchmarkSettings settings;
+	if (!lz::MicrobenchmarkSuite::parse_command_line(argc, argv, settings))
+	{
+		return -1;
+	}
+
+	try
+	{
+		std::unique_ptr<DeviceContext> device_context;
+		if (settings.device)
+		{
+			device_context = std::make_unique<DeviceContext>();
+		}
+		lz::Core *core = device_context ? device_context->get_core() : nullptr;
+
+		lz::MicrobenchmarkSuite suite(settings);
+		add_loader_benchmarks(suite);
+		add_mesh_benchmarks(suite);
+		add_descriptor_set_cache_benchmarks(suite);
+		add_descriptor_buffer_benchmarks(suite, core);
+		add_pipeline_cache_benchmarks(suite, core);
+		add_memory_tracker_benchmarks(suite, core);
+		add_render_graph_benchmarks(suite);
+		add_pool_benchmarks(suite);
+		add_shader_memory_benchmarks(suite);
+		add_cpu_profiler_benchmarks(suite);
+		add_shader_compiler_benchmarks(suite);
+		add_shader_variant_benchmarks(suite);
+		add_shader_config_benchmarks(suite, core);
+		add_autotune_benchmarks(suite);
+		add_shader_binding_benchmarks(suite);
+		add_material_benchmarks(suite);
+		suite.run();
+	}
+	catch (const std::exception &e)
+	{
+		LOGE("Microbenchmark exception: {}", e.what());
+		return -1;
+	}
+	return 0;
+}
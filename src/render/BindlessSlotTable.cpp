@@ -0,0 +1,245 @@
+#include "BindlessSlotTable.h"
+
+#include "MaterialSystem.h"
+
+namespace lz
+{
+BindlessSlotTable::BindlessSlotTable(uint32_t capacity) :
+    capacity_(capacity)
+{
+	texture_slots_.resize(capacity);
+	material_ref_counts_.resize(capacity, 0);
+}
+
+uint32_t BindlessSlotTable::acquire_texture(const std::shared_ptr<Texture> &texture, bool *new_slot)
+{
+	if (new_slot)
+	{
+		*new_slot = false;
+	}
+	if (!texture)
+	{
+		return UINT32_MAX;
+	}
+
+	auto reference_it = texture_references_.find(texture.get());
+	if (reference_it != texture_references_.end())
+	{
+		reference_it->second.ref_count++;
+		texture_slots_[reference_it->second.index].ref_count++;
+		return reference_it->second.index;
+	}
+
+	if (texture->data.empty() || texture->width <= 0 || texture->height <= 0 || texture->channels <= 0)
+	{
+		return UINT32_MAX;
+	}
+
+	uint32_t texture_index = find_texture_slot(*texture);
+	if (texture_index != UINT32_MAX)
+	{
+		texture_slots_[texture_index].ref_count++;
+		texture_references_[texture.get()] = {texture, texture_index, 1};
+		return texture_index;
+	}
+
+	texture_index = allocate_slot(free_texture_slots_, allocated_texture_slots_count_);
+	if (texture_index == UINT32_MAX)
+	{
+		return UINT32_MAX;
+	}
+
+	// the texels may be freed after upload, the slot keeps what later textures are compared with
+	TextureSlot &slot   = texture_slots_[texture_index];
+	slot.content_hash   = texture->get_content_hash();
+	slot.content_digest = texture->get_content_digest();
+	slot.width          = texture->width;
+	slot.height         = texture->height;
+	slot.channels       = texture->channels;
+	slot.ref_count      = 1;
+	texture_hash_to_slots_.emplace(slot.content_hash, texture_index);
+	texture_references_[texture.get()] = {texture, texture_index, 1};
+	texture_slot_count_++;
+	texture_bytes_ += get_texel_bytes(slot);
+
+	if (new_slot)
+	{
+		*new_slot = true;
+	}
+	return texture_index;
+}
+
+void BindlessSlotTable::release_texture(const std::shared_ptr<Texture> &texture, uint64_t retire_frame)
+{
+	auto reference_it = texture ? texture_references_.find(texture.get()) : texture_references_.end();
+	if (reference_it == texture_references_.end())
+	{
+		return;
+	}
+
+	const uint32_t texture_index = reference_it->second.index;
+	if (--reference_it->second.ref_count == 0)
+	{
+		texture_references_.erase(reference_it);
+	}
+	if (--texture_slots_[texture_index].ref_count > 0)
+	{
+		return;
+	}
+
+	TextureSlot &slot       = texture_slots_[texture_index];
+	auto         hash_range = texture_hash_to_slots_.equal_range(slot.content_hash);
+	for (auto it = hash_range.first; it != hash_range.second; ++it)
+	{
+		if (it->second == texture_index)
+		{
+			texture_hash_to_slots_.erase(it);
+			break;
+		}
+	}
+	texture_bytes_ -= get_texel_bytes(slot);
+	texture_slot_count_--;
+	slot = TextureSlot();
+
+	retired_texture_slots_.push_back({texture_index, retire_frame});
+}
+
+uint32_t BindlessSlotTable::get_texture_index(const std::shared_ptr<Texture> &texture) const
+{
+	auto reference_it = texture ? texture_references_.find(texture.get()) : texture_references_.end();
+	return reference_it != texture_references_.end() ? reference_it->second.index : UINT32_MAX;
+}
+
+uint32_t BindlessSlotTable::acquire_material(const std::string &material_name, bool *new_slot)
+{
+	if (new_slot)
+	{
+		*new_slot = false;
+	}
+
+	auto it = material_name_to_index_.find(material_name);
+	if (it != material_name_to_index_.end())
+	{
+		material_ref_counts_[it->second]++;
+		return it->second;
+	}
+
+	const uint32_t material_index = allocate_slot(free_material_slots_, allocated_material_slots_count_);
+	if (material_index == UINT32_MAX)
+	{
+		return UINT32_MAX;
+	}
+	material_name_to_index_[material_name] = material_index;
+	material_ref_counts_[material_index]   = 1;
+
+	if (new_slot)
+	{
+		*new_slot = true;
+	}
+	return material_index;
+}
+
+uint32_t BindlessSlotTable::release_material(const std::string &material_name, uint64_t retire_frame)
+{
+	auto it = material_name_to_index_.find(material_name);
+	if (it == material_name_to_index_.end())
+	{
+		return UINT32_MAX;
+	}
+
+	const uint32_t material_index = it->second;
+	if (--material_ref_counts_[material_index] > 0)
+	{
+		return UINT32_MAX;
+	}
+
+	// the name becomes available immediately, the slot itself is reused only after frames in flight retire
+	material_name_to_index_.erase(it);
+	retired_material_slots_.push_back({material_index, retire_frame});
+	return material_index;
+}
+
+uint32_t BindlessSlotTable::get_material_index(const std::string &material_name) const
+{
+	auto it = material_name_to_index_.find(material_name);
+	return it != material_name_to_index_.end() ? it->second : UINT32_MAX;
+}
+
+void BindlessSlotTable::collect_retired_slots(uint64_t frame, std::vector<uint32_t> &freed_texture_slots)
+{
+	// slots are retired in release order, so both queues are sorted by retire frame
+	while (!retired_texture_slots_.empty() && retired_texture_slots_.front().retire_frame <= frame)
+	{
+		freed_texture_slots.push_back(retired_texture_slots_.front().index);
+		free_texture_slots_.push_back(retired_texture_slots_.front().index);
+		retired_texture_slots_.pop_front();
+	}
+
+	while (!retired_material_slots_.empty() && retired_material_slots_.front().retire_frame <= frame)
+	{
+		free_material_slots_.push_back(retired_material_slots_.front().index);
+		retired_material_slots_.pop_front();
+	}
+}
+
+uint32_t BindlessSlotTable::get_texture_slot_count() const
+{
+	return texture_slot_count_;
+}
+
+uint32_t BindlessSlotTable::get_material_slot_count() const
+{
+	return uint32_t(material_name_to_index_.size());
+}
+
+uint32_t BindlessSlotTable::get_retired_slot_count() const
+{
+	return uint32_t(retired_texture_slots_.size() + retired_material_slots_.size());
+}
+
+uint32_t BindlessSlotTable::get_allocated_texture_slot_count() const
+{
+	return allocated_texture_slots_count_;
+}
+
+uint32_t BindlessSlotTable::get_allocated_material_slot_count() const
+{
+	return allocated_material_slots_count_;
+}
+
+size_t BindlessSlotTable::get_texture_bytes() const
+{
+	return texture_bytes_;
+}
+
+uint32_t BindlessSlotTable::find_texture_slot(const Texture &texture) const
+{
+	auto hash_range = texture_hash_to_slots_.equal_range(texture.get_content_hash());
+	for (auto it = hash_range.first; it != hash_range.second; ++it)
+	{
+		const TextureSlot &slot = texture_slots_[it->second];
+		if (slot.width == texture.width && slot.height == texture.height && slot.channels == texture.channels &&
+		    slot.content_digest == texture.get_content_digest())
+		{
+			return it->second;
+		}
+	}
+	return UINT32_MAX;
+}
+
+size_t BindlessSlotTable::get_texel_bytes(const TextureSlot &slot)
+{
+	return size_t(slot.width) * size_t(slot.height) * size_t(slot.channels);
+}
+
+uint32_t BindlessSlotTable::allocate_slot(std::vector<uint32_t> &free_slots, uint32_t &allocated_slots_count)
+{
+	if (!free_slots.empty())
+	{
+		const uint32_t index = free_slots.back();
+		free_slots.pop_back();
+		return index;
+	}
+	return allocated_slots_count < capacity_ ? allocated_slots_count++ : UINT32_MAX;
+}
+}        // namespace lz
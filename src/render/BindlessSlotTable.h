@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lz
+{
+class Texture;
+
+// BindlessSlotTable: Slot bookkeeping of the bindless texture and material tables, free of Vulkan so it also runs without a device
+// - Textures are deduplicated by content, the hash only finds candidate slots, dimensions, channel count and a second
+//   digest of the texels taken when the slot was filled are compared before a slot is shared, so a slot keeps matching
+//   after the texels were freed and a collision would have to hit both 64-bit hashes at once
+// - Acquired textures are found again by identity, so releasing a texture whose texels were freed still frees its slot
+// - Materials are deduplicated by name
+// - Slots are reference counted, a slot whose last reference is released is retired and only recycled once the frames
+//   that may still read it have retired
+class BindlessSlotTable
+{
+  public:
+	explicit BindlessSlotTable(uint32_t capacity);
+
+	// AcquireTexture: Slot holding the content of the texture, UINT32_MAX for textures without texels or a full table
+	// - new_slot is set when the slot was allocated for this texture, its image has to be created and uploaded
+	uint32_t acquire_texture(const std::shared_ptr<Texture> &texture, bool *new_slot = nullptr);
+
+	// ReleaseTexture: Drops a reference taken by acquire_texture, the slot is retired with retire_frame once unused
+	void release_texture(const std::shared_ptr<Texture> &texture, uint64_t retire_frame);
+
+	// GetTextureIndex: Slot the texture was acquired into, UINT32_MAX if it holds no reference
+	uint32_t get_texture_index(const std::shared_ptr<Texture> &texture) const;
+
+	// AcquireMaterial: Slot of the material with this name, UINT32_MAX for a full table
+	// - new_slot is set when the slot was allocated for this name, its textures and parameters have to be uploaded
+	uint32_t acquire_material(const std::string &material_name, bool *new_slot = nullptr);
+
+	// ReleaseMaterial: Drops a reference taken by acquire_material, returns the slot when it was retired with retire_frame
+	// and UINT32_MAX while it is still referenced, the textures of a retired material have to be released by the caller
+	uint32_t release_material(const std::string &material_name, uint64_t retire_frame);
+
+	// GetMaterialIndex: Slot of the material with this name, UINT32_MAX if none is registered
+	uint32_t get_material_index(const std::string &material_name) const;
+
+	// CollectRetiredSlots: Recycles the slots whose retire frame is not after frame, the images of the freed texture slots
+	// can be destroyed
+	void collect_retired_slots(uint64_t frame, std::vector<uint32_t> &freed_texture_slots);
+
+	// Number of slots holding a texture
+	uint32_t get_texture_slot_count() const;
+
+	// Number of slots holding a material
+	uint32_t get_material_slot_count() const;
+
+	// Number of texture and material slots waiting for their retire frame before they are recycled
+	uint32_t get_retired_slot_count() const;
+
+	// Highest number of texture and material slots ever handed out, retired slots are reused before it grows
+	uint32_t get_allocated_texture_slot_count() const;
+	uint32_t get_allocated_material_slot_count() const;
+
+	// Texel bytes of all slots holding a texture, what their images take in device memory before alignment
+	size_t get_texture_bytes() const;
+
+  private:
+	struct TextureSlot
+	{
+		uint64_t content_hash   = 0;
+		uint64_t content_digest = 0;
+		int      width          = 0;
+		int      height         = 0;
+		int      channels       = 0;
+		uint32_t ref_count      = 0;
+	};
+
+	// every texture object holding references, the pointer keeps the address from being reused while it is a key
+	struct TextureReference
+	{
+		std::shared_ptr<const Texture> texture;
+		uint32_t                       index;
+		uint32_t                       ref_count;
+	};
+
+	struct RetiredSlot
+	{
+		uint32_t index;
+		uint64_t retire_frame;
+	};
+
+	uint32_t find_texture_slot(const Texture &texture) const;
+	static size_t get_texel_bytes(const TextureSlot &slot);
+	uint32_t allocate_slot(std::vector<uint32_t> &free_slots, uint32_t &allocated_slots_count);
+
+	uint32_t capacity_;
+
+	std::vector<TextureSlot>                              texture_slots_;
+	std::unordered_multimap<uint64_t, uint32_t>           texture_hash_to_slots_;
+	std::unordered_map<const Texture *, TextureReference> texture_references_;
+	std::vector<uint32_t>                                 free_texture_slots_;
+	std::deque<RetiredSlot>                               retired_texture_slots_;
+	uint32_t                                              allocated_texture_slots_count_ = 0;
+	uint32_t                                              texture_slot_count_            = 0;
+	size_t                                                texture_bytes_                 = 0;
+
+	std::vector<uint32_t>                     material_ref_counts_;
+	std::unordered_map<std::string, uint32_t> material_name_to_index_;
+	std::vector<uint32_t>                     free_material_slots_;
+	std::deque<RetiredSlot>                   retired_material_slots_;
+	uint32_t                                  allocated_material_slots_count_ = 0;
+};
+}        // namespace lz
@@ -5,6 +5,30 @@
 
 namespace ImGuiUtils
 {
+namespace
+{
+constexpr std::array<const char *, 7> statistics_column_names = {"Task", "Samples", "Mean ms", "Min ms", "Max ms", "P95 ms", "P99 ms"};
+
+double get_statistics_column(const ProfilerGraph::TaskStatistics &statistics, const int column)
+{
+	switch (column)
+	{
+		case 1:
+			return double(statistics.samples_count);
+		case 2:
+			return statistics.mean_ms;
+		case 3:
+			return statistics.min_ms;
+		case 4:
+			return statistics.max_ms;
+		case 5:
+			return statistics.p95_ms;
+		default:
+			return statistics.p99_ms;
+	}
+}
+}        // namespace
+
 glm::vec2 vec2(ImVec2 vec)
 {
 	return glm::vec2(vec.x, vec.y);
@@ -30,13 +54,21 @@ void ProfilerGraph::load_frame_data(const lz::ProfilerTask *tasks, const size_t
 			curr_frame.tasks.push_back(tasks[task_index]);
 		else
 		{
-			if (tasks[task_index - 1].color != tasks[task_index].color || tasks[task_index - 1].name != tasks[task_index].name)
+			const auto &prev_task = tasks[task_index - 1];
+			const auto &task      = tasks[task_index];
+			if (prev_task.color != task.color || prev_task.name != task.name || prev_task.thread_index != task.thread_index ||
+			    prev_task.depth != task.depth)
 			{
 				curr_frame.tasks.push_back(tasks[task_index]);
 			}
 			else
 			{
-				curr_frame.tasks.back().end_time = tasks[task_index].end_time;
+				auto &merged_task    = curr_frame.tasks.back();
+				merged_task.end_time = tasks[task_index].end_time;
+				for (size_t statistic_index = 0; statistic_index < merged_task.pipeline_statistics.size(); statistic_index++)
+				{
+					merged_task.pipeline_statistics[statistic_index] += tasks[task_index].pipeline_statistics[statistic_index];
+				}
 			}
 		}
 	}
@@ -50,14 +82,33 @@ void ProfilerGraph::load_frame_data(const lz::ProfilerTask *tasks, const size_t
 		{
 			task_name_to_stats_index_[task.name] = task_stats_.size();
 			TaskStats taskStat;
-			taskStat.max_time = -1.0;
+			taskStat.name = task.name;
+			taskStat.time_ms.set_window_frames(statistics_window_frames_);
 			task_stats_.push_back(taskStat);
 		}
 		curr_frame.task_stats_index[task_index] = task_name_to_stats_index_[task.name];
 	}
+
+	// one sample per task name and frame, negative entries mark tasks that did not run this frame
+	frame_task_times_.assign(task_stats_.size(), -1.0);
+	for (size_t task_index = 0; task_index < curr_frame.tasks.size(); task_index++)
+	{
+		double &task_time = frame_task_times_[curr_frame.task_stats_index[task_index]];
+		task_time         = std::max(task_time, 0.0) + curr_frame.tasks[task_index].get_length() * 1000.0;
+	}
+	for (size_t stat_index = 0; stat_index < task_stats_.size(); stat_index++)
+	{
+		auto &time_ms = task_stats_[stat_index].time_ms;
+		if (frame_task_times_[stat_index] >= 0.0)
+		{
+			time_ms.add_sample(loaded_frames_count_, frame_task_times_[stat_index]);
+		}
+		time_ms.expire(loaded_frames_count_);
+	}
+	loaded_frames_count_++;
 	curr_frame_index_ = (curr_frame_index_ + 1) % frames_.size();
 
-	rebuild_task_stats(curr_frame_index_, 300 /*frames_.size()*/);
+	rebuild_task_stats();
 }
 
 void ProfilerGraph::render_timings(const int graph_width, const int legend_width, const int height, const int frame_index_offset)
@@ -70,33 +121,61 @@ void ProfilerGraph::render_timings(const int graph_width, const int legend_width
 	ImGui::Dummy(ImVec2(float(graph_width + legend_width), float(height)));
 }
 
-void ProfilerGraph::rebuild_task_stats(const size_t end_frame, const size_t frames_count)
+const std::vector<lz::ProfilerTask> &ProfilerGraph::get_frame_tasks(const int frame_index_offset) const
+{
+	const size_t frame_index = (curr_frame_index_ - frame_index_offset - 1 + 2 * frames_.size()) % frames_.size();
+	return frames_[frame_index].tasks;
+}
+
+std::vector<ProfilerGraph::TaskStatistics> ProfilerGraph::get_task_statistics() const
+{
+	std::vector<TaskStatistics> task_statistics;
+	for (const auto &task_stat : task_stats_)
+	{
+		const auto &time_ms = task_stat.time_ms;
+		if (time_ms.get_samples_count() == 0)
+		{
+			continue;
+		}
+
+		TaskStatistics statistics;
+		statistics.name          = task_stat.name;
+		statistics.samples_count = time_ms.get_samples_count();
+		statistics.mean_ms       = time_ms.get_mean();
+		statistics.min_ms        = time_ms.get_min();
+		statistics.max_ms        = time_ms.get_max();
+		statistics.p95_ms        = time_ms.get_percentile(0.95);
+		statistics.p99_ms        = time_ms.get_percentile(0.99);
+		task_statistics.push_back(statistics);
+	}
+	return task_statistics;
+}
+
+void ProfilerGraph::set_statistics_window(const uint32_t window_frames)
 {
+	statistics_window_frames_ = window_frames;
 	for (auto &task_stat : task_stats_)
 	{
-		task_stat.max_time        = -1.0f;
-		task_stat.priority_order  = size_t(-1);
-		task_stat.on_screen_index = size_t(-1);
+		task_stat.time_ms.set_window_frames(window_frames);
 	}
+}
 
-	for (size_t frame_number = 0; frame_number < frames_count; frame_number++)
+void ProfilerGraph::rebuild_task_stats()
+{
+	for (auto &task_stat : task_stats_)
 	{
-		const size_t frameIndex = (end_frame - 1 - frame_number + frames_.size()) % frames_.size();
-		auto        &frame      = frames_[frameIndex];
-		for (size_t task_index = 0; task_index < frame.tasks.size(); task_index++)
-		{
-			const auto &task  = frame.tasks[task_index];
-			auto       &stats = task_stats_[frame.task_stats_index[task_index]];
-			stats.max_time    = std::max(stats.max_time, task.end_time - task.start_time);
-		}
+		task_stat.priority_order  = size_t(-1);
+		task_stat.on_screen_index = size_t(-1);
 	}
+
+	// legend priority follows the longest time of each task over the statistics window
 	std::vector<size_t> stat_priorities;
 	stat_priorities.resize(task_stats_.size());
 	for (size_t stat_index = 0; stat_index < task_stats_.size(); stat_index++)
 		stat_priorities[stat_index] = stat_index;
 
 	std::sort(stat_priorities.begin(), stat_priorities.end(), [this](const size_t left, const size_t right) {
-		return task_stats_[left].max_time > task_stats_[right].max_time;
+		return task_stats_[left].time_ms.get_max() > task_stats_[right].time_ms.get_max();
 	});
 	for (size_t stat_number = 0; stat_number < task_stats_.size(); stat_number++)
 	{
@@ -124,12 +203,13 @@ void ProfilerGraph::render_graph(ImDrawList *draw_list, glm::vec2 graph_pos, glm
 		for (const auto task : frame.tasks)
 		{
 			constexpr float height_threshold  = 1.0f;
-			const float     task_start_height = (float(task.start_time) / max_frame_time) * graph_size.y;
-			const float     task_end_height   = (float(task.end_time) / max_frame_time) * graph_size.y;
+			const float     task_start_height = std::min(float(task.start_time) / max_frame_time, 1.0f) * graph_size.y;
+			const float     task_end_height   = std::min(float(task.end_time) / max_frame_time, 1.0f) * graph_size.y;
 			// taskMaxCosts[task.name] = std::max(taskMaxCosts[task.name], task.endTime - task.startTime);
+			// tasks of other threads overlap the main thread, they are outlined so both stay visible
 			if (abs(task_end_height - task_start_height) > height_threshold)
 				rect(draw_list, task_pos + glm::vec2(0.0f, -task_start_height),
-				     task_pos + glm::vec2(frame_width, -task_end_height), task.color, true);
+				     task_pos + glm::vec2(frame_width, -task_end_height), task.color, task.thread_index == 0);
 		}
 	}
 }
@@ -196,8 +276,9 @@ void ProfilerGraph::render_legend(ImDrawList *draw_list, glm::vec2 legend_pos, g
 		time_text << std::fixed << std::string("[") << (task_time_ms * 1000.0f);
 
 		text(draw_list, marker_right_rect_max + text_margin, text_color, time_text.str().c_str());
+		const std::string thread_prefix = task.thread_index != 0 ? "T" + std::to_string(task.thread_index) + " " : "";
 		text(draw_list, marker_right_rect_max + text_margin + glm::vec2(name_offset, 0.0f), text_color,
-		     (std::string("ms] ") + task.name).c_str());
+		     (std::string("ms] ") + thread_prefix + task.name).c_str());
 	}
 
 	/*
@@ -302,8 +383,17 @@ ProfilersWindow::ProfilersWindow() :
     cpu_graph(300),
     gpu_graph(300)
 {
-	stop_profiling          = false;
-	frame_offset            = 0;
+	stop_profiling           = false;
+	show_pipeline_statistics = false;
+	show_task_statistics     = false;
+	dump_report_requested    = false;
+	frame_offset             = 0;
+	statistics_window_frames = 300;
+	statistics_source        = 0;
+	freeze_statistics        = false;
+	compare_captures         = false;
+	sort_column_             = 2;
+	sort_descending_         = true;
 	frame_width             = 3;
 	frame_spacing           = 1;
 	use_colored_legend_text = true;
@@ -349,6 +439,9 @@ void ProfilersWindow::render()
 		// ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x - textSize);
 		ImGui::Checkbox("Colored legend text", &use_colored_legend_text);
 		ImGui::DragInt("Frame offset", &frame_offset, 1.0f, 0, 400);
+		ImGui::Checkbox("Pipeline statistics", &show_pipeline_statistics);
+		ImGui::Checkbox("Task statistics", &show_task_statistics);
+		dump_report_requested = ImGui::Button("Dump profiler report");
 		ImGui::NextColumn();
 
 		ImGui::SliderInt("Frame width", &frame_width, 1, 4);
@@ -365,6 +458,195 @@ void ProfilersWindow::render()
 	cpu_graph.frame_spacing           = frame_spacing;
 	cpu_graph.use_colored_legend_text = use_colored_legend_text;
 
+	if (show_pipeline_statistics)
+	{
+		render_pipeline_statistics();
+	}
+	if (show_task_statistics)
+	{
+		render_task_statistics();
+	}
+
 	ImGui::End();
 }
+
+void ProfilersWindow::render_pipeline_statistics() const
+{
+	constexpr int statistics_count = int(lz::PipelineStatistic::eCount);
+
+	ImGui::Columns(statistics_count + 2, "pipeline_statistics");
+	ImGui::Text("Pass");
+	ImGui::NextColumn();
+	ImGui::Text("ms");
+	ImGui::NextColumn();
+	for (int statistic_index = 0; statistic_index < statistics_count; statistic_index++)
+	{
+		ImGui::Text("%s", lz::get_pipeline_statistic_name(lz::PipelineStatistic(statistic_index)));
+		ImGui::NextColumn();
+	}
+
+	for (const auto &task : gpu_graph.get_frame_tasks(frame_offset))
+	{
+		ImGui::Text("%s", task.name.c_str());
+		ImGui::NextColumn();
+		ImGui::Text("%.3f", task.get_length() * 1000.0);
+		ImGui::NextColumn();
+		for (int statistic_index = 0; statistic_index < statistics_count; statistic_index++)
+		{
+			if (task.has_pipeline_statistics)
+				ImGui::Text("%llu", static_cast<unsigned long long>(task.pipeline_statistics[statistic_index]));
+			else
+				ImGui::Text("-");
+			ImGui::NextColumn();
+		}
+	}
+	ImGui::Columns(1);
+}
+
+void ProfilersWindow::render_task_statistics()
+{
+	ImGui::Separator();
+	ImGui::RadioButton("CPU tasks", &statistics_source, 0);
+	ImGui::SameLine();
+	ImGui::RadioButton("GPU tasks", &statistics_source, 1);
+	ImGui::SameLine();
+	ImGui::SetNextItemWidth(150.0f);
+	if (ImGui::SliderInt("Window frames", &statistics_window_frames, 30, 3000))
+	{
+		cpu_graph.set_statistics_window(uint32_t(statistics_window_frames));
+		gpu_graph.set_statistics_window(uint32_t(statistics_window_frames));
+	}
+
+	ImGui::Checkbox("Freeze", &freeze_statistics);
+	ImGui::SameLine();
+	if (ImGui::Button("Capture A"))
+	{
+		captured_statistics_[0] = shown_statistics_;
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Capture B"))
+	{
+		captured_statistics_[1] = shown_statistics_;
+	}
+	ImGui::SameLine();
+	ImGui::Checkbox("Compare A/B", &compare_captures);
+
+	if (!freeze_statistics)
+	{
+		shown_statistics_ = (statistics_source == 0 ? cpu_graph : gpu_graph).get_task_statistics();
+	}
+
+	if (compare_captures)
+	{
+		render_statistics_comparison();
+	}
+	else
+	{
+		render_statistics_table();
+	}
+}
+
+void ProfilersWindow::render_statistics_table()
+{
+	std::sort(shown_statistics_.begin(), shown_statistics_.end(),
+	          [this](const ProfilerGraph::TaskStatistics &left, const ProfilerGraph::TaskStatistics &right) {
+		          if (sort_column_ == 0)
+		          {
+			          return sort_descending_ ? left.name > right.name : left.name < right.name;
+		          }
+		          const double left_value  = get_statistics_column(left, sort_column_);
+		          const double right_value = get_statistics_column(right, sort_column_);
+		          return sort_descending_ ? left_value > right_value : left_value < right_value;
+	          });
+
+	// clicking a header sorts by that column, clicking it again flips the order
+	ImGui::Columns(int(statistics_column_names.size()), "task_statistics");
+	for (int column = 0; column < int(statistics_column_names.size()); column++)
+	{
+		std::string label = statistics_column_names[column];
+		if (sort_column_ == column)
+		{
+			label += sort_descending_ ? " v" : " ^";
+		}
+		if (ImGui::Selectable(label.c_str(), sort_column_ == column))
+		{
+			sort_descending_ = sort_column_ == column ? !sort_descending_ : column != 0;
+			sort_column_     = column;
+		}
+		ImGui::NextColumn();
+	}
+	ImGui::Separator();
+
+	for (const auto &statistics : shown_statistics_)
+	{
+		ImGui::Text("%s", statistics.name.c_str());
+		ImGui::NextColumn();
+		ImGui::Text("%zu", statistics.samples_count);
+		ImGui::NextColumn();
+		for (int column = 2; column < int(statistics_column_names.size()); column++)
+		{
+			ImGui::Text("%.3f", get_statistics_column(statistics, column));
+			ImGui::NextColumn();
+		}
+	}
+	ImGui::Columns(1);
+}
+
+void ProfilersWindow::render_statistics_comparison() const
+{
+	struct ComparisonRow
+	{
+		const ProfilerGraph::TaskStatistics *captures[2] = {nullptr, nullptr};
+	};
+	std::map<std::string, ComparisonRow> rows_by_name;
+	for (size_t capture_index = 0; capture_index < captured_statistics_.size(); capture_index++)
+	{
+		for (const auto &statistics : captured_statistics_[capture_index])
+		{
+			rows_by_name[statistics.name].captures[capture_index] = &statistics;
+		}
+	}
+
+	// largest mean regressions from A to B first, tasks missing from a capture last
+	std::vector<std::pair<std::string, ComparisonRow>> rows(rows_by_name.begin(), rows_by_name.end());
+	auto get_mean_delta = [](const ComparisonRow &row) {
+		return row.captures[0] && row.captures[1] ? row.captures[1]->mean_ms - row.captures[0]->mean_ms : -1e30;
+	};
+	std::stable_sort(rows.begin(), rows.end(), [&get_mean_delta](const auto &left, const auto &right) {
+		return get_mean_delta(left.second) > get_mean_delta(right.second);
+	});
+
+	constexpr std::array<const char *, 10> column_names = {"Task", "A mean", "B mean", "Delta mean", "A p95", "B p95",
+	                                                       "Delta p95", "A p99", "B p99", "Delta p99"};
+	ImGui::Columns(int(column_names.size()), "task_statistics_comparison");
+	for (const char *column_name : column_names)
+	{
+		ImGui::Text("%s", column_name);
+		ImGui::NextColumn();
+	}
+	ImGui::Separator();
+
+	for (const auto &[name, row] : rows)
+	{
+		ImGui::Text("%s", name.c_str());
+		ImGui::NextColumn();
+		for (const int column : {2, 5, 6})
+		{
+			for (const auto *capture : row.captures)
+			{
+				if (capture)
+					ImGui::Text("%.3f", get_statistics_column(*capture, column));
+				else
+					ImGui::Text("-");
+				ImGui::NextColumn();
+			}
+			if (row.captures[0] && row.captures[1])
+				ImGui::Text("%+.3f", get_statistics_column(*row.captures[1], column) - get_statistics_column(*row.captures[0], column));
+			else
+				ImGui::Text("-");
+			ImGui::NextColumn();
+		}
+	}
+	ImGui::Columns(1);
+}
 }        // namespace ImGuiUtils
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <chrono>
 #include <ios>
 #include <map>
@@ -7,6 +8,7 @@
 #include <vector>
 
 #include "backend/ProfilerTask.h"
+#include "backend/RollingStatistics.h"
 #include "imgui.h"
 
 #include "backend/Config.h"
@@ -29,8 +31,29 @@ class ProfilerGraph
 
 	void render_timings(int graph_width, int legend_width, int height, int frame_index_offset);
 
+	// Returns the tasks of a loaded frame, frame_index_offset counts back from the latest one
+	const std::vector<lz::ProfilerTask> &get_frame_tasks(int frame_index_offset) const;
+
+	// Rolling statistics of one task name over the statistics window, tasks recorded several times in a frame are summed
+	struct TaskStatistics
+	{
+		std::string name;
+		size_t      samples_count;
+		double      mean_ms;
+		double      min_ms;
+		double      max_ms;
+		double      p95_ms;
+		double      p99_ms;
+	};
+
+	// Returns the statistics of every task that ran during the statistics window
+	std::vector<TaskStatistics> get_task_statistics() const;
+
+	// Sets the number of frames statistics are kept for, restarts them
+	void set_statistics_window(uint32_t window_frames);
+
   private:
-	void rebuild_task_stats(size_t end_frame, size_t frames_count);
+	void rebuild_task_stats();
 
 	void render_graph(ImDrawList *draw_list, glm::vec2 graph_pos, glm::vec2 graph_size, size_t frame_index_offset) const;
 
@@ -52,16 +75,20 @@ class ProfilerGraph
 
 	struct TaskStats
 	{
-		double max_time;
-		size_t priority_order;
-		size_t on_screen_index;
+		std::string           name;
+		lz::RollingStatistics time_ms;
+		size_t                priority_order;
+		size_t                on_screen_index;
 	};
 
 	std::vector<TaskStats>        task_stats_;
 	std::map<std::string, size_t> task_name_to_stats_index_;
+	std::vector<double>           frame_task_times_;
+	uint32_t                      statistics_window_frames_ = 300;
 
 	std::vector<FrameData> frames_;
-	size_t                 curr_frame_index_ = 0;
+	size_t                 curr_frame_index_   = 0;
+	uint64_t               loaded_frames_count_ = 0;
 };
 
 class ProfilersWindow
@@ -72,6 +99,9 @@ class ProfilersWindow
 	void render();
 
 	bool          stop_profiling;
+	bool          show_pipeline_statistics;
+	bool          show_task_statistics;
+	bool          dump_report_requested;
 	int           frame_offset;
 	ProfilerGraph cpu_graph;
 	ProfilerGraph gpu_graph;
@@ -82,5 +112,25 @@ class ProfilersWindow
 	time_point prev_fps_frame_time;
 	size_t     fps_frames_count;
 	float      avg_frame_time;
+
+	// task statistics panel
+	int  statistics_window_frames;
+	int  statistics_source;        // 0 for CPU tasks, 1 for GPU tasks
+	bool freeze_statistics;
+	bool compare_captures;
+
+  private:
+	void render_pipeline_statistics() const;
+
+	void render_task_statistics();
+
+	void render_statistics_table();
+
+	void render_statistics_comparison() const;
+
+	int                                                       sort_column_;
+	bool                                                      sort_descending_;
+	std::vector<ProfilerGraph::TaskStatistics>                shown_statistics_;
+	std::array<std::vector<ProfilerGraph::TaskStatistics>, 2> captured_statistics_;
 };
 }        // namespace ImGuiUtils
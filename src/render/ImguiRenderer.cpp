@@ -43,6 +43,8 @@ ImGuiRenderer::ImGuiRenderer(lz::Core *core, GLFWwindow *window)
 
 	load_imgui_font();
 
+	pipeline_state_ = core_->get_pipeline_cache()->intern_graphics_pipeline_state({lz::BlendSettings::alpha_blend()},
+	                                                                               get_imgui_vertex_declaration());
 	image_space_sampler_.reset(new lz::Sampler(core_->get_logical_device(), vk::SamplerAddressMode::eClampToEdge,
 	                                           vk::Filter::eLinear, vk::SamplerMipmapMode::eNearest));
 	reload_shaders();
@@ -269,8 +271,7 @@ void ImGuiRenderer::render_frame(const lz::InFlightQueue::FrameInfo &frame_info,
 		                pass_context.get_command_buffer(),
 		                pass_context.get_render_pass()->get_handle(),
 		                lz::DepthSettings::disabled(),
-		                {lz::BlendSettings::alpha_blend()},
-		                get_imgui_vertex_declaration(),
+		                pipeline_state_,
 		                vk::PrimitiveTopology::eTriangleList,
 		                imgui_shader_.program.get());
 		            {
@@ -391,8 +392,12 @@ void ImGuiRenderer::process_input(GLFWwindow *window)
 
 void ImGuiRenderer::reload_shaders()
 {
-	imgui_shader_.vertex.reset(new lz::Shader(core_->get_logical_device(), SHADER_GLSL_DIR "ImGui/ImGui.vert"));
-	imgui_shader_.fragment.reset(new lz::Shader(core_->get_logical_device(), SHADER_GLSL_DIR "ImGui/ImGui.frag"));
+	auto shaders = core_->get_shader_compiler()->create_shaders(core_->get_logical_device(),
+	                                                            {SHADER_GLSL_DIR "ImGui/ImGui.vert",
+	                                                             SHADER_GLSL_DIR "ImGui/ImGui.frag"});
+
+	imgui_shader_.vertex   = std::move(shaders[0]);
+	imgui_shader_.fragment = std::move(shaders[1]);
 	imgui_shader_.program.reset(new lz::ShaderProgram({imgui_shader_.vertex.get(), imgui_shader_.fragment.get()}));
 }
 
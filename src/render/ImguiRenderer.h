@@ -115,8 +115,9 @@ class ImGuiRenderer
 	std::unique_ptr<lz::ImageView> font_image_view_;
 	std::unique_ptr<lz::Image>     font_image_;
 
-	std::unique_ptr<lz::Sampler> image_space_sampler_;
-	ImGuiContext                *imgui_context_;
-	lz::Core                    *core_;
+	std::unique_ptr<lz::Sampler>             image_space_sampler_;
+	ImGuiContext                            *imgui_context_;
+	lz::PipelineCache::GraphicsPipelineState pipeline_state_;        // vertex declaration and blend settings, interned once
+	lz::Core                                *core_;
 };
 }        // namespace lz::render
@@ -0,0 +1,88 @@
+#include "MaterialParameterStore.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace lz
+{
+MaterialParameterStore::MaterialParameterStore(uint32_t capacity, uint32_t copies_count) :
+    parameters_(capacity),
+    dirty_masks_(capacity, 0),
+    dirty_indices_(copies_count)
+{
+	// the copies a material is dirty in are tracked as bits
+	assert(copies_count <= 32);
+}
+
+MaterialParameters &MaterialParameterStore::edit(uint32_t material_index)
+{
+	// every copy has to receive the edit, each one catches up when its frame comes around
+	for (uint32_t i = 0; i < uint32_t(dirty_indices_.size()); i++)
+	{
+		uint32_t copy_bit = 1u << i;
+		if ((dirty_masks_[material_index] & copy_bit) == 0)
+		{
+			dirty_masks_[material_index] |= copy_bit;
+			dirty_indices_[i].push_back(material_index);
+		}
+	}
+	return parameters_[material_index];
+}
+
+const MaterialParameters &MaterialParameterStore::get(uint32_t material_index) const
+{
+	return parameters_[material_index];
+}
+
+void MaterialParameterStore::flush(uint32_t copy_index, MaterialParameters *mapped_params)
+{
+	std::vector<uint32_t> &dirty = dirty_indices_[copy_index];
+
+	last_flush_bytes_  = 0;
+	last_flush_ranges_ = 0;
+	if (dirty.empty())
+	{
+		return;
+	}
+
+	// coalesce dirty indices into contiguous ranges so that bulk edits turn into a few large copies
+	std::sort(dirty.begin(), dirty.end());
+
+	uint32_t copy_bit = 1u << copy_index;
+
+	size_t range_begin = 0;
+	while (range_begin < dirty.size())
+	{
+		size_t range_end = range_begin + 1;
+		while (range_end < dirty.size() && dirty[range_end] == dirty[range_end - 1] + 1)
+		{
+			range_end++;
+		}
+
+		uint32_t first_index = dirty[range_begin];
+		uint32_t count       = static_cast<uint32_t>(range_end - range_begin);
+		memcpy(mapped_params + first_index, parameters_.data() + first_index, sizeof(MaterialParameters) * count);
+
+		last_flush_bytes_ += sizeof(MaterialParameters) * count;
+		last_flush_ranges_++;
+		range_begin = range_end;
+	}
+
+	for (uint32_t material_index : dirty)
+	{
+		dirty_masks_[material_index] &= ~copy_bit;
+	}
+	dirty.clear();
+}
+
+size_t MaterialParameterStore::get_last_flush_bytes() const
+{
+	return last_flush_bytes_;
+}
+
+uint32_t MaterialParameterStore::get_last_flush_ranges() const
+{
+	return last_flush_ranges_;
+}
+}        // namespace lz
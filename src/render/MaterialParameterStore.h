@@ -0,0 +1,52 @@
+#pragma once
+
+#include "glm/glm.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lz
+{
+struct alignas(16) MaterialParameters
+{
+	glm::vec4 base_color_factor;
+	glm::vec3 emissive_factor;
+	float     metallic_factor;
+	float     roughness_factor;
+	uint32_t  diffuse_texture_index;
+	uint32_t  normal_texture_index;
+	uint32_t  metallic_roughness_texture_index;
+	uint32_t  emissive_texture_index;
+	uint32_t  occlusion_texture_index;
+};
+
+// MaterialParameterStore: CPU copy of the material parameters written to per-frame copies as dirty index ranges
+// - An edit marks the material dirty in every copy, each copy catches up when its frame comes around, so the GPU never
+//   reads a copy the CPU is updating
+// - Dirty indices of a copy are coalesced into contiguous ranges, bulk edits turn into a few large copies
+class MaterialParameterStore
+{
+  public:
+	MaterialParameterStore(uint32_t capacity, uint32_t copies_count);
+
+	// Edit: Parameters of the material for writing, the material is uploaded to every copy on its next flush
+	MaterialParameters &edit(uint32_t material_index);
+
+	const MaterialParameters &get(uint32_t material_index) const;
+
+	// Flush: Writes the materials edited since the last flush of the copy into its mapped memory
+	void flush(uint32_t copy_index, MaterialParameters *mapped_params);
+
+	// Bytes and contiguous ranges written by the last flush
+	size_t   get_last_flush_bytes() const;
+	uint32_t get_last_flush_ranges() const;
+
+  private:
+	std::vector<MaterialParameters>    parameters_;
+	std::vector<uint32_t>              dirty_masks_;
+	std::vector<std::vector<uint32_t>> dirty_indices_;
+	size_t                             last_flush_bytes_{0};
+	uint32_t                           last_flush_ranges_{0};
+};
+}        // namespace lz
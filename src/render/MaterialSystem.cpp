@@ -5,41 +5,71 @@
 #include "backend/ImageLoader.h"
 #include "backend/ImageView.h"
 #include "backend/Logging.h"
+#include "backend/MemoryTracker.h"
+#include "backend/StartupProfiler.h"
 
 #include "backend/PresentQueue.h"
 
 #include "backend/EngineConfig.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace lz
 {
-uint32_t MaterialSystem::allocate_texture_slot()
+// 64-bit multiply-xorshift hash over the texel bytes, seeded with the image dimensions and channel count
+static uint64_t hash_texel_data(const std::vector<unsigned char> &data, int width, int height, int channels, uint64_t seed)
 {
-	uint32_t index;
-	if (!free_texture_slots_.empty())
-	{
-		index = free_texture_slots_.back();
-		free_texture_slots_.pop_back();
-	}
-	else
+	constexpr uint64_t prime = 0x9E3779B97F4A7C15ull;
+
+	auto mix = [](uint64_t h, uint64_t value) {
+		h ^= value * prime;
+		h = (h << 31) | (h >> 33);
+		return h * 0xBF58476D1CE4E5B9ull;
+	};
+
+	uint64_t hash = mix(seed, static_cast<uint64_t>(width) << 32 | static_cast<uint32_t>(height));
+	hash          = mix(hash, static_cast<uint64_t>(channels) << 32 | data.size());
+
+	const size_t words_count = data.size() / sizeof(uint64_t);
+	for (size_t i = 0; i < words_count; ++i)
 	{
-		index = texture_count_++;
+		uint64_t word;
+		memcpy(&word, data.data() + i * sizeof(uint64_t), sizeof(uint64_t));
+		hash = mix(hash, word);
 	}
-	return index;
+
+	uint64_t tail = 0;
+	memcpy(&tail, data.data() + words_count * sizeof(uint64_t), data.size() - words_count * sizeof(uint64_t));
+	hash = mix(hash, tail);
+
+	// final avalanche so that nearby inputs spread across the whole range
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDull;
+	hash ^= hash >> 33;
+
+	// 0 is reserved as "not computed yet"
+	return hash != 0 ? hash : 1;
 }
-uint32_t MaterialSystem::allocate_material_slot()
+
+uint64_t Texture::get_content_hash() const
 {
-	uint32_t index;
-	if (!free_material_slots_.empty())
+	if (content_hash_ == 0)
 	{
-		index = free_material_slots_.back();
-		free_material_slots_.pop_back();
+		content_hash_ = hash_texel_data(data, width, height, channels, 0xCBF29CE484222325ull);
 	}
-	else
+	return content_hash_;
+}
+
+uint64_t Texture::get_content_digest() const
+{
+	if (content_digest_ == 0)
 	{
-		index = material_count_++;
+		content_digest_ = hash_texel_data(data, width, height, channels, 0x84222325CBF29CE4ull);
 	}
-	return index;
+	return content_digest_;
 }
+
 void MaterialSystem::update_material_parameters(const std::shared_ptr<Material> &material)
 {
 	uint32_t material_index = get_material_index(material->name);
@@ -57,7 +87,9 @@ void MaterialSystem::update_material_parameters(const std::shared_ptr<Material>
 }
 
 MaterialSystem::MaterialSystem(Core *core) :
-    core_(core)
+    core_(core),
+    slot_table_(BINDLESS_RESOURCE_COUNT),
+    material_parameters_(BINDLESS_RESOURCE_COUNT, MATERIAL_PARAMETERS_COPIES)
 {
 	texture_images_.resize(BINDLESS_RESOURCE_COUNT);
 	texture_views_.resize(BINDLESS_RESOURCE_COUNT);
@@ -81,21 +113,29 @@ MaterialSystem::MaterialSystem(Core *core) :
 
 	default_sampler_ = std::make_unique<Sampler>(core_->get_logical_device(), sampler_create_info);
 
-	material_parameters_buffer_ = std::make_unique<Buffer>(
-	    core_->get_physical_device(),
-	    core_->get_logical_device(),
-	    sizeof(MaterialParameters) * BINDLESS_RESOURCE_COUNT,
-	    vk::BufferUsageFlagBits::eStorageBuffer,
-	    vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
-	material_parameters_buffer_->map();
+	MemoryTracker::ScopedCategory memory_category(MemoryCategory::eMaterials);
 
+	// one copy per frame that can be in flight plus the one being written, so the GPU never reads a copy the CPU is updating
+	for (uint32_t i = 0; i < MATERIAL_PARAMETERS_COPIES; i++)
+	{
+		material_parameters_buffers_[i] = std::make_unique<Buffer>(
+		    core_->get_physical_device(),
+		    core_->get_logical_device(),
+		    sizeof(MaterialParameters) * BINDLESS_RESOURCE_COUNT,
+		    vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress,
+		    vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+		material_parameters_buffers_[i]->map();
+	}
 	materials_.resize(BINDLESS_RESOURCE_COUNT);
 
 	initialize();
 }
 MaterialSystem::~MaterialSystem()
 {
-	material_parameters_buffer_->unmap();
+	for (auto &buffer : material_parameters_buffers_)
+	{
+		buffer->unmap();
+	}
 }
 void MaterialSystem::initialize()
 {
@@ -156,17 +196,19 @@ uint32_t MaterialSystem::register_material(const std::shared_ptr<Material> &mate
 {
 	LOGD("Registering material : {}", material->name.c_str());
 
-	// check if material already exists
-	auto it = material_name_to_index_.find(material->name);
-	if (it != material_name_to_index_.end())
+	// a material registered before only gains a reference
+	bool           new_slot       = false;
+	const uint32_t material_index = slot_table_.acquire_material(material->name, &new_slot);
+	if (material_index == UINT32_MAX)
 	{
-		return it->second;
+		LOGW("Exceeded maximum material count, {} not registered", material->name);
+		return UINT32_MAX;
 	}
-
-	// allocate material slot
-	uint32_t material_index                 = allocate_material_slot();
-	materials_[material_index]              = material;
-	material_name_to_index_[material->name] = material_index;
+	if (!new_slot)
+	{
+		return material_index;
+	}
+	materials_[material_index] = material;
 
 	// update
 	upload_texture(material->diffuse_texture);
@@ -178,60 +220,79 @@ uint32_t MaterialSystem::register_material(const std::shared_ptr<Material> &mate
 
 	return material_index;
 }
-uint32_t MaterialSystem::get_material_index(const std::string &material_name) const
+void MaterialSystem::release_material(const std::string &material_name)
 {
-	auto it = material_name_to_index_.find(material_name);
-	if (it != material_name_to_index_.end())
+	if (slot_table_.get_material_index(material_name) == UINT32_MAX)
+	{
+		LOGW("Releasing unknown material {}", material_name);
+		return;
+	}
+
+	// frames up to the current one may read the slot, it is reused once they passed their fence
+	const uint32_t material_index = slot_table_.release_material(material_name, frame_index_ + MAX_FRAMES_IN_FLIGHT);
+	if (material_index == UINT32_MAX)
 	{
-		return it->second;
+		return;
 	}
-	return UINT32_MAX;
+
+	LOGD("Releasing material : {}", material_name);
+
+	std::shared_ptr<Material> material = std::move(materials_[material_index]);
+
+	release_texture(material->diffuse_texture);
+	release_texture(material->normal_texture);
+	release_texture(material->metallic_roughness_texture);
+	release_texture(material->emissive_texture);
+	release_texture(material->occlusion_texture);
 }
-uint32_t MaterialSystem::upload_texture(const std::shared_ptr<Texture> &texture)
+void MaterialSystem::release_texture(const std::shared_ptr<Texture> &texture)
 {
-	if (!texture)
+	slot_table_.release_texture(texture, frame_index_ + MAX_FRAMES_IN_FLIGHT);
+}
+void MaterialSystem::collect_retired_slots()
+{
+	std::vector<uint32_t> freed_texture_slots;
+	slot_table_.collect_retired_slots(frame_index_, freed_texture_slots);
+	for (uint32_t texture_index : freed_texture_slots)
 	{
-		return UINT32_MAX;
+		// the descriptor is left stale, partially bound descriptors are never read once no material references them
+		texture_views_[texture_index].reset();
+		texture_images_[texture_index].reset();
 	}
-
-	// Check for missing data
-	if (texture->data.empty() || texture->width <= 0 || texture->height <= 0 || texture->channels <= 0)
+}
+uint32_t MaterialSystem::get_material_index(const std::string &material_name) const
+{
+	return slot_table_.get_material_index(material_name);
+}
+uint32_t MaterialSystem::upload_texture(const std::shared_ptr<Texture> &texture)
+{
+	if (!texture)
 	{
-		LOGD("Texture has invalid dimensions or empty data: {}", texture->name);
 		return UINT32_MAX;
 	}
 
-	// check if texture already exists
-	if (!texture->name.empty())
+	// a texture with identical content shares its slot, names are not unique across files, and a texture acquired
+	// before keeps its slot even if its texels were freed since
+	bool           new_slot      = false;
+	const uint32_t texture_index = slot_table_.acquire_texture(texture, &new_slot);
+	if (texture_index == UINT32_MAX)
 	{
-		auto it = texture_name_to_index_.find(texture->name);
-		if (it != texture_name_to_index_.end())
+		// Check for missing data
+		if (texture->data.empty() || texture->width <= 0 || texture->height <= 0 || texture->channels <= 0)
 		{
-			return it->second;
+			LOGD("Texture has invalid dimensions or empty data: {}", texture->name);
+		}
+		else
+		{
+			LOGD("Exceeded maximum bindless resources limit");
 		}
-	}
-	else
-	{
-		LOGD("Texture has empty name, skipping upload");
 		return UINT32_MAX;
 	}
-
-	uint32_t texture_index = allocate_texture_slot();
-
-	if (texture_index >= BINDLESS_RESOURCE_COUNT)
+	if (!new_slot)
 	{
-		LOGD("Exceeded maximum bindless resources limit");
-		return UINT32_MAX;
+		return texture_index;
 	}
 
-	texture_name_to_index_[texture->name] = texture_index;
-
-	// create ImageTexelData
-	ImageTexelData texel_data;
-	texel_data.texels     = texture->data;
-	texel_data.base_size  = glm::uvec3(static_cast<uint32_t>(texture->width), static_cast<uint32_t>(texture->height), 1);
-	texel_data.texel_size = texture->width * texture->height * texture->channels;
-
 	vk::Format format;
 	switch (texture->channels)
 	{
@@ -250,6 +311,8 @@ uint32_t MaterialSystem::upload_texture(const std::shared_ptr<Texture> &texture)
 			break;
 	}
 
+	MemoryTracker::ScopedCategory memory_category(MemoryCategory::eMaterials);
+
 	auto image_create_info = Image::create_info_2d(
 	    glm::uvec2(texture->width, texture->height),
 	    1,
@@ -270,8 +333,9 @@ uint32_t MaterialSystem::upload_texture(const std::shared_ptr<Texture> &texture)
 
 	// submit texture data when processing update queue
 	UpdateRequest request;
-	request.type    = UpdateRequest::UpdateType::eTextureUpload;
-	request.texture = texture;
+	request.type          = UpdateRequest::UpdateType::eTextureUpload;
+	request.texture       = texture;
+	request.texture_index = texture_index;
 
 	// add to update queue
 	request_update(request);
@@ -284,6 +348,11 @@ void MaterialSystem::request_update(const UpdateRequest &request)
 }
 void MaterialSystem::process_pending_updates()
 {
+	// called by the in-flight queue once the fence of the frame about to be recorded signaled, so every frame up to
+	// frame_index_ + 1 - MAX_FRAMES_IN_FLIGHT has finished on the GPU
+	frame_index_++;
+	collect_retired_slots();
+
 	std::vector<UpdateRequest> updates;
 
 	{
@@ -296,6 +365,7 @@ void MaterialSystem::process_pending_updates()
 
 	if (updates.empty())
 	{
+		flush_material_parameters();
 		return;
 	}
 
@@ -310,21 +380,7 @@ void MaterialSystem::process_pending_updates()
 		if (request.type == UpdateRequest::UpdateType::eTextureUpload)
 		{
 			LOGD("Uploading texture: {}", request.texture->name);
-			uint32_t texture_index;
-			if (!request.texture->name.empty())
-			{
-				auto it = texture_name_to_index_.find(request.texture->name);
-				if (it == texture_name_to_index_.end())
-				{
-					LOGW("Texture {} not found in map", request.texture->name.c_str());
-					continue;
-				}
-				texture_index = it->second;
-			}
-			else
-			{
-				continue;
-			}
+			uint32_t texture_index = request.texture_index;
 
 			// Validate texture_index is within range
 			if (texture_index >= texture_images_.size() || texture_images_[texture_index] == nullptr || texture_views_[texture_index] == nullptr)
@@ -345,6 +401,8 @@ void MaterialSystem::process_pending_updates()
 
 			texel_data.texels = request.texture->data;
 
+			MemoryTracker::ScopedCategory memory_category(MemoryCategory::eMaterials);
+			StartupProfiler::ScopedPhase  startup_phase("Texture upload");
 			load_texel_data(
 			    core_,
 			    &texel_data,
@@ -377,9 +435,7 @@ void MaterialSystem::process_pending_updates()
 				continue;
 			}
 
-			MaterialParameters *mapped_params = static_cast<MaterialParameters *>(material_parameters_buffer_->get_mapped_data());
-
-			MaterialParameters &params              = mapped_params[material_index];
+			MaterialParameters &params              = material_parameters_.edit(material_index);
 			params.base_color_factor                = materials_[material_index]->base_color_factor;
 			params.metallic_factor                  = materials_[material_index]->metallic_factor;
 			params.roughness_factor                 = materials_[material_index]->roughness_factor;
@@ -392,6 +448,8 @@ void MaterialSystem::process_pending_updates()
 		}
 	}
 
+	flush_material_parameters();
+
 	// Update descriptor sets if we have any writes to perform
 	if (!descriptor_writes.empty())
 	{
@@ -412,7 +470,12 @@ const vk::UniqueDescriptorSet *MaterialSystem::get_bindless_descriptor_set() con
 }
 lz::Buffer *MaterialSystem::get_material_parameters_buffer() const
 {
-	return material_parameters_buffer_.get();
+	return material_parameters_buffers_[frame_index_ % MATERIAL_PARAMETERS_COPIES].get();
+}
+void MaterialSystem::flush_material_parameters()
+{
+	uint32_t copy_index = frame_index_ % MATERIAL_PARAMETERS_COPIES;
+	material_parameters_.flush(copy_index, static_cast<MaterialParameters *>(material_parameters_buffers_[copy_index]->get_mapped_data()));
 }
 lz::Sampler *MaterialSystem::get_default_sampler() const
 {
@@ -420,15 +483,6 @@ lz::Sampler *MaterialSystem::get_default_sampler() const
 }
 uint32_t MaterialSystem::get_texture_index(const std::shared_ptr<Texture> &texture) const
 {
-	if (texture == nullptr)
-	{
-		return UINT32_MAX;
-	}
-	auto it = texture_name_to_index_.find(texture->name);
-	if (it != texture_name_to_index_.end())
-	{
-		return it->second;
-	}
-	return UINT32_MAX;
+	return slot_table_.get_texture_index(texture);
 }
 }        // namespace lz
@@ -1,10 +1,14 @@
 #pragma once
 
 #include "backend/Config.h"
+#include "backend/EngineConfig.h"
 #include "backend/Image.h"
 #include "backend/ImageView.h"
 #include "backend/Sampler.h"
 #include "glm/glm.hpp"
+#include "render/BindlessSlotTable.h"
+#include "render/MaterialParameterStore.h"
+#include <array>
 #include <backend/StagedResources.h>
 #include <memory>
 #include <queue>
@@ -25,12 +29,24 @@ class Texture
 	Texture()  = default;
 	~Texture() = default;
 
+	// Hash of the decoded texel data, dimensions and channel count.
+	// Computed on first use and cached, so the texel data must not change after the first upload.
+	uint64_t get_content_hash() const;
+
+	// Second hash of the same content with another seed, together with the content hash it stands for the texels once
+	// they were freed after upload. Cached like the content hash.
+	uint64_t get_content_digest() const;
+
 	int                        width{-1};
 	int                        height{-1};
 	int                        channels{-1};
 	std::vector<unsigned char> data;
 	std::string                name;
 	std::string                uri;
+
+  private:
+	mutable uint64_t content_hash_{0};
+	mutable uint64_t content_digest_{0};
 };
 
 /**
@@ -56,19 +72,6 @@ class Material
 	glm::vec3 emissive_factor{0.0f};
 };
 
-struct alignas(16) MaterialParameters
-{
-	glm::vec4 base_color_factor;
-	glm::vec3 emissive_factor;
-	float     metallic_factor;
-	float     roughness_factor;
-	uint32_t  diffuse_texture_index;
-	uint32_t  normal_texture_index;
-	uint32_t  metallic_roughness_texture_index;
-	uint32_t  emissive_texture_index;
-	uint32_t  occlusion_texture_index;
-};
-
 struct UpdateRequest
 {
 	enum class UpdateType
@@ -81,6 +84,7 @@ struct UpdateRequest
 	UpdateType               type;
 	std::string              material_name;
 	std::shared_ptr<Texture> texture;
+	uint32_t                 texture_index{UINT32_MAX};
 };
 
 class MaterialSystem
@@ -90,6 +94,7 @@ class MaterialSystem
 	~MaterialSystem();
 
 	uint32_t                       register_material(const std::shared_ptr<Material> &material);
+	void                           release_material(const std::string &material_name);
 	uint32_t                       get_material_index(const std::string &material_name) const;
 	uint32_t                       upload_texture(const std::shared_ptr<Texture> &texture);
 	void                           request_update(const UpdateRequest &request);
@@ -100,8 +105,9 @@ class MaterialSystem
 
   private:
 	void     initialize();
-	uint32_t allocate_texture_slot();
-	uint32_t allocate_material_slot();
+	void     release_texture(const std::shared_ptr<Texture> &texture);
+	void     collect_retired_slots();
+	void     flush_material_parameters();
 	void     update_material_parameters(const std::shared_ptr<Material> &material);
 
 	uint32_t get_texture_index(const std::shared_ptr<Texture> &texture) const;
@@ -113,22 +119,24 @@ class MaterialSystem
 	vk::UniqueDescriptorPool      bindless_descriptor_pool_;
 	vk::UniqueDescriptorSet       bindless_descriptor_set_;
 
-	std::vector<std::unique_ptr<Image>>       texture_images_;
-	std::vector<std::unique_ptr<ImageView>>   texture_views_;
-	std::unordered_map<std::string, uint32_t> texture_name_to_index_;
-	uint32_t                                  texture_count_ = 0;
+	// textures are deduplicated by content and materials by name, each slot counts the references to it
+	lz::BindlessSlotTable                   slot_table_;
+	std::vector<std::unique_ptr<Image>>     texture_images_;
+	std::vector<std::unique_ptr<ImageView>> texture_views_;
 
 	std::unique_ptr<lz::Sampler> default_sampler_;
 
-	std::vector<std::shared_ptr<Material>>    materials_;
-	std::unordered_map<std::string, uint32_t> material_name_to_index_;
-	uint32_t                                  material_count_{0};
+	std::vector<std::shared_ptr<Material>> materials_;
+
+	// parameters are edited in a CPU copy and written to the per-frame buffers as dirty index ranges
+	static constexpr uint32_t MATERIAL_PARAMETERS_COPIES = MAX_FRAMES_IN_FLIGHT + 1;
 
-	std::unique_ptr<lz::Buffer> material_parameters_buffer_;
+	std::array<std::unique_ptr<lz::Buffer>, MATERIAL_PARAMETERS_COPIES> material_parameters_buffers_;
+	lz::MaterialParameterStore                                          material_parameters_;
 
 	std::queue<UpdateRequest> pending_updates_;
 
-	std::vector<uint32_t> free_texture_slots_;
-	std::vector<uint32_t> free_material_slots_;
+	// number of frames begun, released slots may still be read by frames in flight and are recycled once those retire
+	uint64_t frame_index_{0};
 };
 }        // namespace lz
\ No newline at end of file
@@ -32,6 +32,7 @@ MipBuilder::MipBuilder(lz::Core *core) :
     core_(core)
 {
 	image_space_sampler_.reset(new lz::Sampler(core_->get_logical_device(), vk::SamplerAddressMode::eClampToEdge, vk::Filter::eNearest, vk::SamplerMipmapMode::eNearest));
+	pipeline_state_ = core_->get_pipeline_cache()->intern_graphics_pipeline_state({lz::BlendSettings::opaque()}, lz::VertexDeclaration());
 	reload_shader();
 }
 void MipBuilder::build_mips(lz::RenderGraph *render_graph, lz::ShaderMemoryPool *memory_pool, const MippedImageProxy &mipped_proxy, FilterTypes filter_type)
@@ -57,8 +58,7 @@ void MipBuilder::build_mips(lz::RenderGraph *render_graph, lz::ShaderMemoryPool
 			            pass_context.get_command_buffer(),
 			            pass_context.get_render_pass()->get_handle(),
 			            lz::DepthSettings::disabled(),
-			            {lz::BlendSettings::opaque()},
-			            lz::VertexDeclaration(),
+			            pipeline_state_,
 			            vk::PrimitiveTopology::eTriangleFan,
 			            mip_level_builder_.shader_program.get());
 
@@ -83,8 +83,12 @@ void MipBuilder::build_mips(lz::RenderGraph *render_graph, lz::ShaderMemoryPool
 }
 void MipBuilder::reload_shader()
 {
-	mip_level_builder_.vertex_shader.reset(new lz::Shader(core_->get_logical_device(), SHADER_GLSL_DIR "Common/screen_quad.vert"));
-	mip_level_builder_.fragment_shader.reset(new lz::Shader(core_->get_logical_device(), SHADER_GLSL_DIR "Common/mip_builder.frag"));
+	auto shaders = core_->get_shader_compiler()->create_shaders(core_->get_logical_device(),
+	                                                            {SHADER_GLSL_DIR "Common/screen_quad.vert",
+	                                                             SHADER_GLSL_DIR "Common/mip_builder.frag"});
+
+	mip_level_builder_.vertex_shader   = std::move(shaders[0]);
+	mip_level_builder_.fragment_shader = std::move(shaders[1]);
 	mip_level_builder_.shader_program.reset(new lz::ShaderProgram({mip_level_builder_.vertex_shader.get(), mip_level_builder_.fragment_shader.get()}));
 }
 }        // namespace lz::render
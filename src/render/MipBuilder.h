@@ -1,5 +1,6 @@
 #pragma once
 
+#include "backend/PipelineCache.h"
 #include "backend/RenderGraph.h"
 #include "backend/Sampler.h"
 #include "backend/ShaderProgram.h"
@@ -68,7 +69,8 @@ class MipBuilder
 		std::unique_ptr<lz::ShaderProgram> shader_program;
 	} mip_level_builder_;
 
-	std::unique_ptr<lz::Sampler> image_space_sampler_;
-	lz::Core                    *core_;
+	std::unique_ptr<lz::Sampler>             image_space_sampler_;
+	lz::PipelineCache::GraphicsPipelineState pipeline_state_;
+	lz::Core                                *core_;
 };
 }        // namespace lz::render
\ No newline at end of file
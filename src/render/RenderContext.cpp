@@ -1,7 +1,9 @@
 #include "RenderContext.h"
 #include "backend/Core.h"
 #include "backend/Logging.h"
+#include "backend/MemoryTracker.h"
 #include "backend/PresentQueue.h"
+#include "backend/StartupProfiler.h"
 #include "scene/Mesh.h"
 
 #include "backend/EngineConfig.h"
@@ -17,10 +19,16 @@ RenderContext::RenderContext(lz::Core *core) :
 
 RenderContext::~RenderContext()
 {
+	for (const auto &material_name : registered_material_names_)
+	{
+		core_->release_material(material_name);
+	}
 }
 
 void RenderContext::collect_draw_commands(const lz::Scene *scene)
 {
+	lz::StartupProfiler::ScopedPhase startup_phase("Draw command collection");
+
 	// Clear previous data
 	global_vertices_.clear();
 	global_indices_.clear();
@@ -29,19 +37,33 @@ void RenderContext::collect_draw_commands(const lz::Scene *scene)
 	mesh_infos_.clear();
 	mesh_draws_.clear();
 
+	// the previous registrations are released after the new ones, materials still in the scene keep their slots
+	std::vector<std::string> previous_material_names = std::move(registered_material_names_);
+	registered_material_names_.clear();
+
 	// Collect renderable entities from the scene
 	for (const auto &entity : scene->get_root_entities())
 	{
 		process_entity(entity);
 	}
+
+	for (const auto &material_name : previous_material_names)
+	{
+		core_->release_material(material_name);
+	}
 }
 
 void RenderContext::build_meshlet_data()
 {
+	lz::StartupProfiler::ScopedPhase startup_phase("Meshlet building");
+
 	// Create a meshlet buffer
 	meshlets_.clear();
 	meshlet_data_datum_.clear();
 
+	// the limits and the padding follow the shader config the mesh shading pipelines are specialized with
+	const lz::ShaderConfig &shader_config = core_->get_shader_config();
+
 	// iterate through all the mesh draws
 	for (int i = 0; i < mesh_draws_.size(); ++i)
 	{
@@ -49,63 +71,14 @@ void RenderContext::build_meshlet_data()
 		auto        mesh_index = mesh_draw.mesh_index;
 		auto       &mesh_info  = mesh_infos_[mesh_index];
 
-		// build the meshlet data
-		std::vector<meshopt_Meshlet> tmp_meshlets(meshopt_buildMeshletsBound(mesh_info.index_count, MESHLET_MAX_VERTICES, MESHLET_MAX_TRIANGLES));
-		std::vector<unsigned int>    meshlet_vertices(tmp_meshlets.size() * MESHLET_MAX_VERTICES);
-		std::vector<unsigned char>   meshlet_triangles(tmp_meshlets.size() * MESHLET_MAX_TRIANGLES * 3);
-
-		tmp_meshlets.resize(meshopt_buildMeshlets(tmp_meshlets.data(),
-		                                          meshlet_vertices.data(), meshlet_triangles.data(),
-		                                          &global_indices_[mesh_info.index_offset], mesh_info.index_count,
-		                                          &global_vertices_[mesh_info.vertex_offset].pos.x, mesh_info.vertex_count, sizeof(Vertex),
-		                                          MESHLET_MAX_VERTICES, MESHLET_MAX_TRIANGLES, MESHLET_CONE_WEIGHT));
-
-
-		mesh_info.meshlet_count  = uint32_t(tmp_meshlets.size());
 		mesh_info.meshlet_offset = uint32_t(meshlets_.size());
-
-		for (auto &meshlet : tmp_meshlets)
-		{
-			uint32_t data_offset = uint32_t(meshlet_data_datum_.size());
-
-			for (size_t i = 0; i < meshlet.vertex_count; ++i)
-			{
-				meshlet_data_datum_.push_back(meshlet_vertices[meshlet.vertex_offset + i]);
-			}
-
-			const unsigned int *index_groups = reinterpret_cast<const unsigned int *>(&meshlet_triangles[0] + meshlet.triangle_offset);
-			// round up to multiple of 4
-			unsigned int index_group_count = (meshlet.triangle_count * 3 + 3) / 4;
-
-			for (size_t i = 0; i < index_group_count; ++i)
-			{
-				meshlet_data_datum_.push_back(index_groups[i]);
-			}
-
-			meshopt_Bounds bounds =
-			    meshopt_computeMeshletBounds(&meshlet_vertices[meshlet.vertex_offset],
-			                                 &meshlet_triangles[meshlet.triangle_offset],
-			                                 meshlet.triangle_count,
-			                                 &global_vertices_[mesh_info.vertex_offset].pos.x,
-			                                 mesh_info.vertex_count,
-			                                 sizeof(Vertex));
-
-			Meshlet m         = {};
-			m.sphere_bound    = glm::vec4(bounds.center[0], bounds.center[1], bounds.center[2], bounds.radius);
-			m.cone_axis[0]    = bounds.cone_axis_s8[0];
-			m.cone_axis[1]    = bounds.cone_axis_s8[1];
-			m.cone_axis[2]    = bounds.cone_axis_s8[2];
-			m.cone_cutoff     = bounds.cone_cutoff_s8;
-			m.data_offset     = data_offset;
-			m.vertex_offset   = mesh_info.vertex_offset;
-			m.triangle_count  = meshlet.triangle_count;
-			m.vertex_count    = meshlet.vertex_count;
-			m.mesh_draw_index = i;
-
-			meshlets_.push_back(m);
-		}
+		mesh_info.meshlet_count  = build_meshlets(&global_vertices_[mesh_info.vertex_offset], mesh_info.vertex_count,
+		                                          &global_indices_[mesh_info.index_offset], mesh_info.index_count,
+		                                          mesh_info.vertex_offset, i, meshlets_, meshlet_data_datum_,
+		                                          shader_config.meshlet_max_vertices, shader_config.meshlet_max_triangles,
+		                                          shader_config.meshlet_cone_weight);
 	}
-	while (meshlets_.size() % TASK_WGSIZE != 0)
+	while (meshlets_.size() % shader_config.task_workgroup_size != 0)
 	{
 		meshlets_.push_back(Meshlet{});
 	}
@@ -113,6 +86,65 @@ void RenderContext::build_meshlet_data()
 	meshlet_count_ = uint32_t(meshlets_.size());
 }
 
+uint32_t RenderContext::build_meshlets(const lz::Vertex *vertices, uint32_t vertex_count, const uint32_t *indices,
+                                       uint32_t index_count, uint32_t vertex_offset, uint32_t mesh_draw_index,
+                                       std::vector<Meshlet> &meshlets, std::vector<uint32_t> &meshlet_data,
+                                       uint32_t max_vertices, uint32_t max_triangles, float cone_weight)
+{
+	// build the meshlet data
+	std::vector<meshopt_Meshlet> tmp_meshlets(meshopt_buildMeshletsBound(index_count, max_vertices, max_triangles));
+	std::vector<unsigned int>    meshlet_vertices(tmp_meshlets.size() * max_vertices);
+	std::vector<unsigned char>   meshlet_triangles(tmp_meshlets.size() * max_triangles * 3);
+
+	tmp_meshlets.resize(meshopt_buildMeshlets(tmp_meshlets.data(),
+	                                          meshlet_vertices.data(), meshlet_triangles.data(),
+	                                          indices, index_count,
+	                                          &vertices[0].pos.x, vertex_count, sizeof(Vertex),
+	                                          max_vertices, max_triangles, cone_weight));
+
+	for (auto &meshlet : tmp_meshlets)
+	{
+		uint32_t data_offset = uint32_t(meshlet_data.size());
+
+		for (size_t i = 0; i < meshlet.vertex_count; ++i)
+		{
+			meshlet_data.push_back(meshlet_vertices[meshlet.vertex_offset + i]);
+		}
+
+		const unsigned int *index_groups = reinterpret_cast<const unsigned int *>(&meshlet_triangles[0] + meshlet.triangle_offset);
+		// round up to multiple of 4
+		unsigned int index_group_count = (meshlet.triangle_count * 3 + 3) / 4;
+
+		for (size_t i = 0; i < index_group_count; ++i)
+		{
+			meshlet_data.push_back(index_groups[i]);
+		}
+
+		meshopt_Bounds bounds =
+		    meshopt_computeMeshletBounds(&meshlet_vertices[meshlet.vertex_offset],
+		                                 &meshlet_triangles[meshlet.triangle_offset],
+		                                 meshlet.triangle_count,
+		                                 &vertices[0].pos.x,
+		                                 vertex_count,
+		                                 sizeof(Vertex));
+
+		Meshlet m         = {};
+		m.sphere_bound    = glm::vec4(bounds.center[0], bounds.center[1], bounds.center[2], bounds.radius);
+		m.cone_axis[0]    = bounds.cone_axis_s8[0];
+		m.cone_axis[1]    = bounds.cone_axis_s8[1];
+		m.cone_axis[2]    = bounds.cone_axis_s8[2];
+		m.cone_cutoff     = bounds.cone_cutoff_s8;
+		m.data_offset     = data_offset;
+		m.vertex_offset   = vertex_offset;
+		m.triangle_count  = meshlet.triangle_count;
+		m.vertex_count    = meshlet.vertex_count;
+		m.mesh_draw_index = mesh_draw_index;
+
+		meshlets.push_back(m);
+	}
+	return uint32_t(tmp_meshlets.size());
+}
+
 void RenderContext::process_entity(const std::shared_ptr<lz::Entity> &entity)
 {
 	// Check if the entity has a StaticMeshComponent
@@ -127,6 +159,7 @@ void RenderContext::process_entity(const std::shared_ptr<lz::Entity> &entity)
 		for (auto &material : materials)
 		{
 			core_->register_material(material);
+			registered_material_names_.push_back(material->name);
 		}
 		// Get the world transformation matrix
 		glm::mat4 model_matrix = transform->get_world_matrix();
@@ -175,6 +208,9 @@ void RenderContext::process_entity(const std::shared_ptr<lz::Entity> &entity)
 
 void RenderContext::create_gpu_resources()
 {
+	lz::MemoryTracker::ScopedCategory memory_category(lz::MemoryCategory::eScene);
+	lz::StartupProfiler::ScopedPhase  startup_phase("Scene buffer upload");
+
 	// Create global vertex and index buffers
 	auto physical_device = core_->get_physical_device();
 	auto logical_device  = core_->get_logical_device();
@@ -187,7 +223,7 @@ void RenderContext::create_gpu_resources()
 	global_vertex_buffer_ = std::make_unique<lz::StagedBuffer>(
 	    physical_device, logical_device,
 	    global_vertices_.size() * sizeof(lz::Vertex),
-	    vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
+	    vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress);
 
 	if (!global_vertices_.empty())
 	{
@@ -211,7 +247,7 @@ void RenderContext::create_gpu_resources()
 	mesh_draw_buffer_ = std::make_unique<lz::StagedBuffer>(
 	    physical_device, logical_device,
 	    mesh_draws_.size() * sizeof(MeshDraw),
-	    vk::BufferUsageFlagBits::eStorageBuffer);
+	    vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress);
 
 	if (!mesh_draws_.empty())
 	{
@@ -223,7 +259,7 @@ void RenderContext::create_gpu_resources()
 	mesh_info_buffer_ = std::make_unique<lz::StagedBuffer>(
 	    physical_device, logical_device,
 	    mesh_infos_.size() * sizeof(MeshInfo),
-	    vk::BufferUsageFlagBits::eStorageBuffer);
+	    vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress);
 
 	if (!mesh_infos_.empty())
 	{
@@ -237,6 +273,9 @@ void RenderContext::create_gpu_resources()
 
 void RenderContext::create_meshlet_buffer()
 {
+	lz::MemoryTracker::ScopedCategory memory_category(lz::MemoryCategory::eScene);
+	lz::StartupProfiler::ScopedPhase  startup_phase("Meshlet buffer upload");
+
 	// Create meshdraw, meshinfo, meshlet buffer
 	auto physical_device = core_->get_physical_device();
 	auto logical_device  = core_->get_logical_device();
@@ -249,7 +288,7 @@ void RenderContext::create_meshlet_buffer()
 	mesh_let_buffer_ = std::make_unique<lz::StagedBuffer>(
 	    physical_device, logical_device,
 	    meshlets_.size() * sizeof(Meshlet),
-	    vk::BufferUsageFlagBits::eStorageBuffer);
+	    vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress);
 
 	if (!meshlets_.empty())
 	{
@@ -261,7 +300,7 @@ void RenderContext::create_meshlet_buffer()
 	mesh_let_data_buffer_ = std::make_unique<lz::StagedBuffer>(
 	    physical_device, logical_device,
 	    meshlet_data_datum_.size() * sizeof(uint32_t),
-	    vk::BufferUsageFlagBits::eStorageBuffer);
+	    vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress);
 
 	if (!meshlet_data_datum_.empty())
 	{
@@ -273,4 +312,13 @@ void RenderContext::create_meshlet_buffer()
 	transfer_queue.end_command_buffer();
 }
 
+void RenderContext::rebuild_meshlets()
+{
+	build_meshlet_data();
+
+	// the mesh infos hold the meshlet ranges, they are uploaded again with the rest of the scene buffers
+	create_gpu_resources();
+	create_meshlet_buffer();
+}
+
 }        // namespace lz::render
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "backend/Camera.h"
 #include "backend/Config.h"
+#include "backend/EngineConfig.h"
 #include "backend/StagedResources.h"
 #include "scene/Entity.h"
 #include "scene/Scene.h"
@@ -11,6 +12,7 @@
 #include "glm/glm.hpp"
 
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace lz::render
@@ -83,6 +85,7 @@ struct MeshTaskDrawCommand
 	uint32_t group_count_z;
 
 	uint32_t meshlet_offset;
+	uint32_t meshlet_count;
 };
 
 /**
@@ -110,11 +113,29 @@ class RenderContext
 	 */
 	void build_meshlet_data();
 
+	/**
+	 * @brief Split one mesh into meshlets and append them with their vertex and packed triangle data
+	 * @param max_vertices, max_triangles Meshlet limits, the mesh shader must be compiled with the same ones
+	 * @param cone_weight How much meshoptimizer favours tight normal cones over compact meshlets
+	 * @return The number of meshlets appended
+	 */
+	static uint32_t build_meshlets(const lz::Vertex *vertices, uint32_t vertex_count, const uint32_t *indices,
+	                               uint32_t index_count, uint32_t vertex_offset, uint32_t mesh_draw_index,
+	                               std::vector<Meshlet> &meshlets, std::vector<uint32_t> &meshlet_data,
+	                               uint32_t max_vertices = MESHLET_MAX_VERTICES, uint32_t max_triangles = MESHLET_MAX_TRIANGLES,
+	                               float cone_weight = MESHLET_CONE_WEIGHT);
+
 	/**
 	 * @brief Create meshlet buffer
 	 */
 	void create_meshlet_buffer();
 
+	/**
+	 * @brief Rebuild the meshlets with the current shader config and upload them with the mesh infos that index them
+	 * The device must be idle, renderers have to recreate their render context resources afterwards
+	 */
+	void rebuild_meshlets();
+
 	lz::Buffer &get_global_vertex_buffer() const
 	{
 		return global_vertex_buffer_.get()->get_buffer();
@@ -155,6 +176,9 @@ class RenderContext
 
 	lz::Core *core_;
 
+	// every registration of a material is released again when the draw commands are recollected or the context goes away
+	std::vector<std::string> registered_material_names_;
+
 	// Collected draw commands
 	uint32_t                          draw_count_ = 0;
 	std::vector<MeshInfo>             mesh_infos_;
@@ -1,5 +1,6 @@
 #include "Mesh.h"
 #include "backend/Logging.h"
+#include "backend/StartupProfiler.h"
 #include "meshoptimizer.h"
 #include <algorithm>
 #include <limits>
@@ -44,6 +45,8 @@ void SubMesh::optimize()
 		return;
 	}
 
+	StartupProfiler::ScopedPhase startup_phase("SubMesh optimize");
+
 	size_t                index_count = indices.size();
 	std::vector<uint32_t> remap(index_count);
 	size_t                vertex_count = meshopt_generateVertexRemap(remap.data(), indices.data(), index_count,
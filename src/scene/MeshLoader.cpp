@@ -2,6 +2,7 @@
 #include <filesystem>
 
 #include "backend/Logging.h"
+#include "backend/StartupProfiler.h"
 
 #include "tiny_gltf.h"
 #include "tiny_obj_loader.h"
@@ -27,6 +28,8 @@ bool ObjMeshLoader::can_load(const std::string &file_name)
 
 Mesh ObjMeshLoader::load()
 {
+	StartupProfiler::ScopedPhase startup_phase("OBJ loading");
+
 	Mesh mesh;
 
 	tinyobj::attrib_t                attrib;
@@ -177,6 +180,8 @@ bool GltfMeshLoader::can_load(const std::string &file_name)
 
 Mesh GltfMeshLoader::load()
 {
+	StartupProfiler::ScopedPhase startup_phase("glTF loading");
+
 	tinygltf::Model    model;
 	tinygltf::TinyGLTF loader;
 	std::string        err;
@@ -186,6 +191,15 @@ Mesh GltfMeshLoader::load()
 	std::string ext = std::filesystem::path(file_path).extension().string();
 	std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
 
+	// images are decoded while the file is parsed, wrap the decoder to time them separately
+	loader.SetImageLoader(
+	    [](tinygltf::Image *image, const int image_index, std::string *err, std::string *warn, int req_width, int req_height,
+	       const unsigned char *bytes, int size, void *user_data) {
+		    StartupProfiler::ScopedPhase startup_phase("Texture decoding");
+		    return tinygltf::LoadImageData(image, image_index, err, warn, req_width, req_height, bytes, size, user_data);
+	    },
+	    nullptr);
+
 	if (ext == ".glb")
 	{
 		ret = loader.LoadBinaryFromFile(&model, &err, &warn, file_path);
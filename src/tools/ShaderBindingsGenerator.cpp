@@ -0,0 +1,457 @@
+#include "backend/Logging.h"
+#include "backend/ShaderProgram.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// LingzeShaderBindings: Writes the C++ bindings of GLSL shaders, the build runs it before the applications compile
+// - Usage: LingzeShaderBindings <glsl_dir> <output_dir> <shader>..., shaders are given relative to glsl_dir and
+//   MeshShading/drawcull.comp is written to <output_dir>/MeshShading/drawcull.comp.h
+// - Layouts come from the offsets and strides of the compiled SPIR-V, so std140, std430 and scalar blocks all map to
+//   plain C++ structs with explicit padding
+// - Buffer references become uint64_t device addresses, the blocks they point to are declared like storage buffers
+
+namespace
+{
+// ToIdentifier: Lower snake case of a directory or file name, MeshShading and drawcull.comp become mesh_shading and drawcull_comp
+std::string to_identifier(const std::string &name)
+{
+	std::string identifier;
+	for (size_t char_index = 0; char_index < name.size(); char_index++)
+	{
+		const unsigned char c = (unsigned char) name[char_index];
+		if (std::isupper(c))
+		{
+			if (char_index > 0 && std::islower((unsigned char) name[char_index - 1]))
+			{
+				identifier += '_';
+			}
+			identifier += char(std::tolower(c));
+		}
+		else if (std::isalnum(c))
+		{
+			identifier += char(c);
+		}
+		else
+		{
+			identifier += '_';
+		}
+	}
+	return identifier;
+}
+
+uint32_t align_up(uint32_t value, uint32_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+bool is_runtime_array(const spirv_cross::SPIRType &type)
+{
+	return !type.array.empty() && type.array_size_literal.back() && type.array.back() == 0;
+}
+
+class BindingsWriter
+{
+  public:
+	explicit BindingsWriter(const std::vector<uint32_t> &bytecode) :
+	    compiler_(bytecode)
+	{
+	}
+
+	// Write: Header text of the shader, its declarations are placed in namespace_name
+	std::string write(const std::string &shader_name, const std::string &namespace_name)
+	{
+		// blocks are declared with the structs of their members, images only carry their binding
+		struct ImageBinding
+		{
+			uint32_t    set;
+			uint32_t    binding;
+			std::string declaration;
+		};
+		std::vector<ImageBinding> image_bindings;
+
+		const spirv_cross::ShaderResources resources = compiler_.get_shader_resources();
+		for (const auto &buffer : resources.uniform_buffers)
+		{
+			const uint32_t set     = compiler_.get_decoration(buffer.id, spv::DecorationDescriptorSet);
+			const uint32_t binding = compiler_.get_decoration(buffer.id, spv::DecorationBinding);
+			write_struct(buffer.base_type_id, get_binding_constants("eUniformBuffer", set, binding));
+		}
+
+		for (const auto &buffer : resources.storage_buffers)
+		{
+			const uint32_t set     = compiler_.get_decoration(buffer.id, spv::DecorationDescriptorSet);
+			const uint32_t binding = compiler_.get_decoration(buffer.id, spv::DecorationBinding);
+			write_struct(buffer.base_type_id, get_binding_constants("eStorageBuffer", set, binding) + get_buffer_block_constants(buffer.base_type_id));
+		}
+
+		for (const auto &image_sampler : resources.sampled_images)
+		{
+			const uint32_t set     = compiler_.get_decoration(image_sampler.id, spv::DecorationDescriptorSet);
+			const uint32_t binding = compiler_.get_decoration(image_sampler.id, spv::DecorationBinding);
+			image_bindings.push_back({set, binding, "struct " + image_sampler.name + "\n{\n" + get_binding_constants("eImageSampler", set, binding) + "};\n"});
+		}
+
+		for (const auto &image : resources.storage_images)
+		{
+			const uint32_t set     = compiler_.get_decoration(image.id, spv::DecorationDescriptorSet);
+			const uint32_t binding = compiler_.get_decoration(image.id, spv::DecorationBinding);
+			image_bindings.push_back({set, binding, "struct " + image.name + "\n{\n" + get_binding_constants("eStorageImage", set, binding) + "};\n"});
+		}
+
+		std::sort(image_bindings.begin(), image_bindings.end(), [](const ImageBinding &a, const ImageBinding &b) {
+			return std::tie(a.set, a.binding) < std::tie(b.set, b.binding);
+		});
+
+		std::ostringstream header;
+		header << "// Generated by LingzeShaderBindings from " << shader_name << ", do not edit\n";
+		header << "#pragma once\n\n";
+		header << "#include \"backend/ShaderBindings.h\"\n\n";
+		header << "#include <cstddef>\n";
+		header << "#include <cstdint>\n\n";
+		header << "namespace " << namespace_name << "\n{\n";
+		header << structs_.str();
+		for (const auto &image_binding : image_bindings)
+		{
+			header << image_binding.declaration << "\n";
+		}
+		header << "}        // namespace " << namespace_name << "\n";
+		return header.str();
+	}
+
+  private:
+	// CppType: Declaration of a member without its name, array_suffix follows the name for padded matrix columns
+	struct CppType
+	{
+		std::string name;
+		std::string array_suffix;
+		uint32_t    size;
+		uint32_t    alignment;
+	};
+
+	struct StructInfo
+	{
+		std::string name;
+		uint32_t    size;
+		uint32_t    alignment;
+	};
+
+	static std::string get_binding_constants(const std::string &type, uint32_t set, uint32_t binding)
+	{
+		return "\tstatic constexpr ShaderBindingType type    = ShaderBindingType::" + type + ";\n" +
+		       "\tstatic constexpr uint32_t          set     = " + std::to_string(set) + ";\n" +
+		       "\tstatic constexpr uint32_t          binding = " + std::to_string(binding) + ";\n";
+	}
+
+	// GetBufferBlockConstants: The pod part of a buffer block is laid out as a struct, the runtime array at the end is described by its element
+	std::string get_buffer_block_constants(uint32_t type_id)
+	{
+		const auto &type      = compiler_.get_type(type_id);
+		std::string constants = "\tstatic constexpr uint32_t pod_size = " + std::to_string(compiler_.get_declared_struct_size(type)) + ";\n";
+
+		const uint32_t last_member_index = uint32_t(type.member_types.size() - 1);
+		const auto    &last_member_type  = compiler_.get_type(type.member_types[last_member_index]);
+		if (is_runtime_array(last_member_type))
+		{
+			const uint32_t array_stride = compiler_.type_struct_member_array_stride(type, last_member_index);
+			const CppType  element_type = get_element_type(type, last_member_index, compiler_.get_type(last_member_type.parent_type));
+			if (!element_type.array_suffix.empty())
+			{
+				throw std::runtime_error(compiler_.get_name(type.self) + ": runtime arrays of padded matrices are not supported");
+			}
+
+			constants += "\tstatic constexpr uint32_t array_stride = " + std::to_string(array_stride) + ";\n";
+			if (element_type.size == array_stride)
+			{
+				constants += "\tusing ArrayElement = " + element_type.name + ";\n";
+			}
+			else
+			{
+				constants += "\tusing ArrayElement = lz::StridedElement<" + element_type.name + ", " + std::to_string(array_stride) + ">;\n";
+			}
+		}
+		return constants;
+	}
+
+	static uint32_t get_scalar_size(const spirv_cross::SPIRType &type)
+	{
+		// booleans in buffers are 32 bit
+		return type.basetype == spirv_cross::SPIRType::Boolean ? 4 : type.width / 8;
+	}
+
+	static std::string get_scalar_type(const spirv_cross::SPIRType &type)
+	{
+		switch (type.basetype)
+		{
+			case spirv_cross::SPIRType::Boolean:
+			case spirv_cross::SPIRType::UInt:
+				return "uint32_t";
+			case spirv_cross::SPIRType::Int:
+				return "int32_t";
+			case spirv_cross::SPIRType::Float:
+				return "float";
+			case spirv_cross::SPIRType::Double:
+				return "double";
+			case spirv_cross::SPIRType::SByte:
+				return "int8_t";
+			case spirv_cross::SPIRType::UByte:
+				return "uint8_t";
+			case spirv_cross::SPIRType::Short:
+				return "int16_t";
+			// C++ has no half type, the bits are kept
+			case spirv_cross::SPIRType::UShort:
+			case spirv_cross::SPIRType::Half:
+				return "uint16_t";
+			case spirv_cross::SPIRType::Int64:
+				return "int64_t";
+			case spirv_cross::SPIRType::UInt64:
+				return "uint64_t";
+			default:
+				throw std::runtime_error("unsupported member type " + std::to_string(int(type.basetype)));
+		}
+	}
+
+	static std::string get_vector_type(const spirv_cross::SPIRType &type)
+	{
+		if (type.vecsize == 1)
+		{
+			return get_scalar_type(type);
+		}
+
+		const std::string vecsize = std::to_string(type.vecsize);
+		switch (type.basetype)
+		{
+			case spirv_cross::SPIRType::Float:
+				return "glm::vec" + vecsize;
+			case spirv_cross::SPIRType::Int:
+				return "glm::ivec" + vecsize;
+			case spirv_cross::SPIRType::Boolean:
+			case spirv_cross::SPIRType::UInt:
+				return "glm::uvec" + vecsize;
+			default:
+				return "glm::vec<" + vecsize + ", " + get_scalar_type(type) + ">";
+		}
+	}
+
+	// GetElementType: C++ type of a struct member with its array dimensions removed
+	CppType get_element_type(const spirv_cross::SPIRType &struct_type, uint32_t member_index, const spirv_cross::SPIRType &type)
+	{
+		// buffer references are device addresses, the block they point to is declared with the constants of a storage buffer
+		if (type.pointer)
+		{
+			if (type.storage != spv::StorageClassPhysicalStorageBuffer)
+			{
+				throw std::runtime_error(compiler_.get_name(struct_type.self) + ": only buffer reference pointers are supported");
+			}
+			const auto &pointee_type = compiler_.get_type(type.parent_type);
+			write_struct(pointee_type.self, get_buffer_block_constants(pointee_type.self));
+			return {"uint64_t", std::string(), 8, 8};
+		}
+
+		if (type.basetype == spirv_cross::SPIRType::Struct)
+		{
+			const StructInfo struct_info = write_struct(type.self, std::string());
+			return {struct_info.name, std::string(), struct_info.size, struct_info.alignment};
+		}
+
+		const uint32_t scalar_size = get_scalar_size(type);
+		const CppType  column_type = {get_vector_type(type), std::string(), scalar_size * type.vecsize, scalar_size};
+		if (type.columns == 1)
+		{
+			return column_type;
+		}
+
+		if (compiler_.has_member_decoration(struct_type.self, member_index, spv::DecorationRowMajor))
+		{
+			throw std::runtime_error(compiler_.get_name(struct_type.self) + ": row major matrices are not supported");
+		}
+		if (type.basetype != spirv_cross::SPIRType::Float)
+		{
+			throw std::runtime_error(compiler_.get_name(struct_type.self) + ": only float matrices are supported");
+		}
+
+		const uint32_t matrix_stride = compiler_.type_struct_member_matrix_stride(struct_type, member_index);
+		if (matrix_stride == column_type.size)
+		{
+			const std::string size = type.columns == type.vecsize ? std::to_string(type.columns) : std::to_string(type.columns) + "x" + std::to_string(type.vecsize);
+			return {"glm::mat" + size, std::string(), matrix_stride * type.columns, scalar_size};
+		}
+
+		// columns padded to their stride, e.g. a mat3 of a std140 block
+		return {"lz::StridedElement<" + column_type.name + ", " + std::to_string(matrix_stride) + ">", "[" + std::to_string(type.columns) + "]",
+		        matrix_stride * type.columns, scalar_size};
+	}
+
+	// GetMemberType: C++ type of a struct member, arrays whose stride differs from their element size become StridedElement arrays
+	CppType get_member_type(const spirv_cross::SPIRType &struct_type, uint32_t member_index)
+	{
+		const auto &type = compiler_.get_type(struct_type.member_types[member_index]);
+		if (type.array.empty())
+		{
+			return get_element_type(struct_type, member_index, type);
+		}
+
+		const std::string struct_name = compiler_.get_name(struct_type.self);
+		if (type.array.size() > 1)
+		{
+			throw std::runtime_error(struct_name + ": arrays of arrays are not supported");
+		}
+		if (!type.array_size_literal.back())
+		{
+			throw std::runtime_error(struct_name + ": arrays sized by specialization constants are not supported");
+		}
+
+		const CppType element_type = get_element_type(struct_type, member_index, compiler_.get_type(type.parent_type));
+		if (!element_type.array_suffix.empty())
+		{
+			throw std::runtime_error(struct_name + ": arrays of padded matrices are not supported");
+		}
+
+		const uint32_t array_size   = type.array.back();
+		const uint32_t array_stride = compiler_.type_struct_member_array_stride(struct_type, member_index);
+		if (array_stride == element_type.size)
+		{
+			return {element_type.name, "[" + std::to_string(array_size) + "]", array_stride * array_size, element_type.alignment};
+		}
+		return {"lz::StridedElement<" + element_type.name + ", " + std::to_string(array_stride) + ">", "[" + std::to_string(array_size) + "]",
+		        array_stride * array_size, element_type.alignment};
+	}
+
+	// WriteStruct: Declares a struct and the structs of its members, constants are placed before the members of binding blocks
+	StructInfo write_struct(uint32_t type_id, const std::string &constants)
+	{
+		const auto &type = compiler_.get_type(type_id);
+
+		const auto struct_it = structs_info_.find(type.self);
+		if (struct_it != structs_info_.end())
+		{
+			return struct_it->second;
+		}
+
+		// glslang declares a struct once per layout it is used with, later declarations get a suffix
+		std::string name = compiler_.get_name(type.self);
+		if (name.empty())
+		{
+			name = "Struct" + std::to_string(type.self);
+		}
+		for (uint32_t suffix = 1; struct_names_.count(name) > 0; suffix++)
+		{
+			name = compiler_.get_name(type.self) + "_" + std::to_string(suffix);
+		}
+		struct_names_.insert(name);
+
+		std::ostringstream members;
+		std::ostringstream asserts;
+		uint32_t           curr_offset = 0;
+		uint32_t           alignment   = 1;
+		for (uint32_t member_index = 0; member_index < type.member_types.size(); member_index++)
+		{
+			const std::string member_name = compiler_.get_member_name(type.self, member_index);
+			if (is_runtime_array(compiler_.get_type(type.member_types[member_index])))
+			{
+				continue;
+			}
+
+			const uint32_t offset = compiler_.type_struct_member_offset(type, member_index);
+			if (offset < curr_offset)
+			{
+				throw std::runtime_error(name + "::" + member_name + " overlaps the member before it");
+			}
+			if (offset > curr_offset)
+			{
+				members << "\tuint8_t padding_" << curr_offset << "[" << offset - curr_offset << "];\n";
+			}
+
+			const CppType member_type = get_member_type(type, member_index);
+			members << "\t" << member_type.name << " " << member_name << member_type.array_suffix << ";\n";
+			asserts << "static_assert(offsetof(" << name << ", " << member_name << ") == " << offset << ");\n";
+
+			curr_offset = offset + member_type.size;
+			alignment   = std::max(alignment, member_type.alignment);
+		}
+
+		// C++ rounds the size up to the alignment of the members, the padding makes it explicit
+		const uint32_t declared_size = uint32_t(compiler_.get_declared_struct_size(type));
+		const uint32_t size          = align_up(std::max(declared_size, curr_offset), alignment);
+		if (curr_offset > 0 && size > curr_offset)
+		{
+			members << "\tuint8_t padding_" << curr_offset << "[" << size - curr_offset << "];\n";
+		}
+		if (curr_offset > 0)
+		{
+			asserts << "static_assert(sizeof(" << name << ") == " << size << ");\n";
+		}
+
+		std::ostringstream declaration;
+		declaration << "struct " << name << "\n{\n";
+		declaration << constants;
+		if (!constants.empty() && curr_offset > 0)
+		{
+			declaration << "\n";
+		}
+		declaration << members.str() << "};\n";
+		declaration << asserts.str() << "\n";
+		structs_ << declaration.str();
+
+		const StructInfo struct_info = {name, size, alignment};
+		structs_info_[type.self]     = struct_info;
+		return struct_info;
+	}
+
+	spirv_cross::Compiler compiler_;
+
+	// declarations of every struct in the order they were written, a struct follows the structs of its members
+	std::ostringstream             structs_;
+	std::map<uint32_t, StructInfo> structs_info_;
+	std::set<std::string>          struct_names_;
+};
+}        // namespace
+
+int main(int argc, char **argv)
+{
+	if (argc < 4)
+	{
+		LOGE("Usage: LingzeShaderBindings <glsl_dir> <output_dir> <shader>...");
+		return -1;
+	}
+
+	const std::filesystem::path glsl_dir   = argv[1];
+	const std::filesystem::path output_dir = argv[2];
+	try
+	{
+		for (int arg_index = 3; arg_index < argc; arg_index++)
+		{
+			const std::filesystem::path shader   = argv[arg_index];
+			const auto                  bytecode = lz::Shader::get_bytecode((glsl_dir / shader).string());
+
+			const std::string namespace_name = "lz::shader_bindings::" + to_identifier(shader.parent_path().generic_string()) + "::" +
+			                                   to_identifier(shader.filename().string());
+			BindingsWriter    writer(bytecode);
+			const std::string header = writer.write(shader.generic_string(), namespace_name);
+
+			const std::filesystem::path header_path = output_dir / (shader.string() + ".h");
+			std::filesystem::create_directories(header_path.parent_path());
+			std::ofstream file(header_path);
+			file << header;
+			if (!file)
+			{
+				throw std::runtime_error("failed to write " + header_path.string());
+			}
+		}
+	}
+	catch (const std::exception &e)
+	{
+		LOGE("Shader bindings generation failed: {}", e.what());
+		return -1;
+	}
+	return 0;
+}